@@ -23,6 +23,11 @@
 
 #include <stddef.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "vkd3d_common.h"
 #include "vkd3d_memory.h"
 
 enum hash_map_entry_flag
@@ -39,15 +44,49 @@ struct hash_map_entry
 typedef uint32_t (*pfn_hash_func)(const void* key);
 typedef bool (*pfn_hash_compare_func)(const void *key, const struct hash_map_entry *entry);
 
-/* Open-addressing hash table */
+/* Control bytes. Occupied slots store the low 7 bits of the mixed hash,
+ * so that a single byte compare rejects almost all non-matching slots. */
+#define HASH_MAP_CTRL_EMPTY     0x80u
+#define HASH_MAP_CTRL_DELETED   0xfeu
+
+/* Slots are probed in aligned groups of this many control bytes. */
+#define HASH_MAP_GROUP_SIZE     16u
+
+/* Header of a table allocation. Control bytes follow the header,
+ * entries follow the control bytes. */
+struct hash_map_table
+{
+    uint32_t entry_count;
+    uint32_t padding[3];
+};
+
+/* Open-addressing hash table with power-of-two capacity. Entries are stored
+ * in a flat array, so callers can iterate over all slots and check the
+ * HASH_MAP_ENTRY_OCCUPIED flag. Groups are probed linearly, and removal
+ * shifts later entries back into the hole, so ordinary maps never contain
+ * tombstones. Removal may move other entries, so pointers to entries are
+ * only stable until the next insertion or removal.
+ *
+ * In read-mostly mode, readers may look up entries without locking between
+ * hash_map_read_begin and hash_map_read_end, while writers must still be
+ * serialized by the caller. Entries never move there, so removal leaves a
+ * tombstone instead. Tombstones are only reclaimed once they use up the
+ * growth budget, by rehashing into a new table of the same size, which
+ * waits for active readers to leave. */
 struct hash_map
 {
     pfn_hash_func hash_func;
     pfn_hash_compare_func compare_func;
+    struct hash_map_table *table;
+    uint8_t *ctrl;
     void *entries;
     size_t entry_size;
     uint32_t entry_count;
     uint32_t used_count;
+    uint32_t growth_left;
+    bool read_mostly;
+    uint32_t epoch;
+    uint32_t reader_count[2];
 };
 
 static inline struct hash_map_entry *hash_map_get_entry(const struct hash_map *hash_map, uint32_t entry_idx)
@@ -55,152 +94,489 @@ static inline struct hash_map_entry *hash_map_get_entry(const struct hash_map *h
     return void_ptr_offset(hash_map->entries, hash_map->entry_size * entry_idx);
 }
 
-static inline uint32_t hash_map_get_entry_idx(const struct hash_map *hash_map, uint32_t hash_value)
+static inline uint32_t hash_map_next_entry_idx(const struct hash_map *hash_map, uint32_t entry_idx)
 {
-    return hash_value % hash_map->entry_count;
+    return (entry_idx + 1) & (hash_map->entry_count - 1);
 }
 
-static inline uint32_t hash_map_next_entry_idx(const struct hash_map *hash_map, uint32_t entry_idx)
+static inline uint32_t hash_map_mix_hash(uint32_t hash_value)
 {
-    uint32_t next_idx = entry_idx + 1;
-    return next_idx < hash_map->entry_count ? next_idx : 0;
+    /* Callers mostly use hash_combine, which leaves the low bits poorly
+     * distributed for pointer-like keys. Since we mask instead of using
+     * a prime modulus, run the value through a proper finalizer. */
+    hash_value ^= hash_value >> 16;
+    hash_value *= 0x85ebca6bu;
+    hash_value ^= hash_value >> 13;
+    hash_value *= 0xc2b2ae35u;
+    hash_value ^= hash_value >> 16;
+    return hash_value;
 }
 
-static inline uint32_t hash_map_next_size(uint32_t old_size)
+static inline uint8_t hash_map_hash_ctrl(uint32_t mixed_hash)
 {
-    /* This yields a sequence of primes and numbers with two
-     * relatively large prime factors for any reasonable hash
-     * table size */
-    return old_size ? (old_size * 2 + 5) : 37;
+    return mixed_hash & 0x7f;
 }
 
-static inline bool hash_map_grow(struct hash_map *hash_map)
+static inline uint32_t hash_map_hash_group(uint32_t mixed_hash, uint32_t entry_count)
 {
-    uint32_t i, old_count, new_count;
-    void *new_entries, *old_entries;
+    return (mixed_hash >> 7) & (entry_count / HASH_MAP_GROUP_SIZE - 1);
+}
 
-    old_count = hash_map->entry_count;
-    old_entries = hash_map->entries;
+#ifndef __SSE2__
+static inline uint32_t hash_map_swar_mask(uint64_t high_bits)
+{
+    /* Gathers the high bit of each byte into the low 8 bits. */
+    return (uint32_t)(((high_bits >> 7) * 0x0102040810204080ull) >> 56);
+}
 
-    new_count = hash_map_next_size(hash_map->entry_count);
+static inline uint32_t hash_map_swar_match(uint64_t bytes, uint8_t ctrl)
+{
+    uint64_t x = bytes ^ (0x0101010101010101ull * ctrl);
 
-    if (!(new_entries = vkd3d_calloc(new_count, hash_map->entry_size)))
-        return false;
+    /* Exact zero byte test, no false positives from borrows. */
+    return hash_map_swar_mask(~(((x & 0x7f7f7f7f7f7f7f7full) + 0x7f7f7f7f7f7f7f7full) | x | 0x7f7f7f7f7f7f7f7full));
+}
+#endif
 
-    hash_map->entry_count = new_count;
-    hash_map->entries = new_entries;
+static inline uint32_t hash_map_group_match(const uint8_t *group, uint8_t ctrl)
+{
+#ifdef __SSE2__
+    __m128i ctrl_bytes = _mm_load_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_bytes, _mm_set1_epi8((char)ctrl)));
+#else
+    uint64_t lo, hi;
+
+    memcpy(&lo, group, sizeof(lo));
+    memcpy(&hi, group + sizeof(lo), sizeof(hi));
+    return hash_map_swar_match(lo, ctrl) | (hash_map_swar_match(hi, ctrl) << 8);
+#endif
+}
+
+static inline uint32_t hash_map_group_match_free(const uint8_t *group)
+{
+    /* Both EMPTY and DELETED have the high bit set. */
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+#else
+    uint64_t lo, hi;
+
+    memcpy(&lo, group, sizeof(lo));
+    memcpy(&hi, group + sizeof(lo), sizeof(hi));
+    return hash_map_swar_mask(lo & 0x8080808080808080ull) |
+            (hash_map_swar_mask(hi & 0x8080808080808080ull) << 8);
+#endif
+}
+
+union hash_map_ctrl_word
+{
+    uint32_t word;
+    uint8_t bytes[4];
+};
+
+static inline uint8_t hash_map_load_ctrl_acquire(const uint8_t *ctrl, uint32_t entry_idx)
+{
+    union hash_map_ctrl_word ctrl_word;
+
+    ctrl_word.word = vkd3d_atomic_uint32_load_explicit((uint32_t *)&ctrl[entry_idx & ~3u], vkd3d_memory_order_acquire);
+    return ctrl_word.bytes[entry_idx & 3];
+}
+
+static inline void hash_map_set_ctrl(struct hash_map *hash_map, uint32_t entry_idx, uint8_t ctrl)
+{
+    uint32_t *word = (uint32_t *)&hash_map->ctrl[entry_idx & ~3u];
+    union hash_map_ctrl_word ctrl_word;
+
+    /* Control bytes are always written a word at a time, so that read-mostly
+     * readers can observe entry contents with acquire semantics. */
+    ctrl_word.word = *word;
+    ctrl_word.bytes[entry_idx & 3] = ctrl;
+
+    if (hash_map->read_mostly)
+        vkd3d_atomic_uint32_store_explicit(word, ctrl_word.word, vkd3d_memory_order_release);
+    else
+        *word = ctrl_word.word;
+}
+
+static inline uint32_t hash_map_get_growth_capacity(uint32_t entry_count)
+{
+    /* Allow a load factor of 7/8. Probing stops at the first group
+     * with an empty slot, so this is still cheap for misses. */
+    return entry_count - entry_count / 8;
+}
+
+static inline struct hash_map_table *hash_map_table_create(uint32_t entry_count, size_t entry_size)
+{
+    struct hash_map_table *table;
+    size_t size;
 
-    for (i = 0; i < old_count; i++)
+    size = align(sizeof(*table) + entry_count + entry_count * entry_size, 64);
+
+    if (!(table = vkd3d_malloc_aligned(size, 64)))
+        return NULL;
+
+    table->entry_count = entry_count;
+    memset(table + 1, HASH_MAP_CTRL_EMPTY, entry_count);
+    memset((uint8_t *)(table + 1) + entry_count, 0, entry_count * entry_size);
+    return table;
+}
+
+static inline uint8_t *hash_map_table_get_ctrl(struct hash_map_table *table)
+{
+    return (uint8_t *)(table + 1);
+}
+
+static inline void *hash_map_table_get_entries(struct hash_map_table *table)
+{
+    return hash_map_table_get_ctrl(table) + table->entry_count;
+}
+
+static inline uint32_t hash_map_find_free_idx(const uint8_t *ctrl, uint32_t entry_count, uint32_t mixed_hash)
+{
+    uint32_t group_idx, group_mask, mask;
+
+    group_idx = hash_map_hash_group(mixed_hash, entry_count);
+    group_mask = entry_count / HASH_MAP_GROUP_SIZE - 1;
+
+    while (true)
     {
-        /* Relocate existing entries one by one */
-        struct hash_map_entry *old_entry = void_ptr_offset(old_entries, i * hash_map->entry_size);
+        if ((mask = hash_map_group_match(&ctrl[group_idx * HASH_MAP_GROUP_SIZE], HASH_MAP_CTRL_EMPTY)))
+            return group_idx * HASH_MAP_GROUP_SIZE + vkd3d_bitmask_tzcnt32(mask);
 
-        if (old_entry->flags & HASH_MAP_ENTRY_OCCUPIED)
-        {
-            uint32_t entry_idx = hash_map_get_entry_idx(hash_map, old_entry->hash_value);
-            struct hash_map_entry *new_entry = hash_map_get_entry(hash_map, entry_idx);
+        group_idx = (group_idx + 1) & group_mask;
+    }
+}
+
+static inline void hash_map_retire_table(struct hash_map *hash_map, struct hash_map_table *table)
+{
+    uint32_t epoch;
 
-            while (new_entry->flags & HASH_MAP_ENTRY_OCCUPIED)
-            {
-                entry_idx = hash_map_next_entry_idx(hash_map, entry_idx);
-                new_entry = hash_map_get_entry(hash_map, entry_idx);
-            }
+    if (hash_map->read_mostly)
+    {
+        /* Readers that entered before the new table was published
+         * are counted in the slot of the current epoch. Advance the
+         * epoch so that new readers use the other slot, and wait for
+         * the old ones to leave. */
+        epoch = vkd3d_atomic_uint32_load_explicit(&hash_map->epoch, vkd3d_memory_order_relaxed);
+        vkd3d_atomic_uint32_store_explicit(&hash_map->epoch, epoch + 1, vkd3d_memory_order_seq_cst);
+
+        while (vkd3d_atomic_uint32_load_explicit(&hash_map->reader_count[epoch & 1], vkd3d_memory_order_seq_cst))
+            vkd3d_pause();
+    }
 
-            memcpy(new_entry, old_entry, hash_map->entry_size);
-        }
+    vkd3d_free_aligned(table);
+}
+
+static inline bool hash_map_rehash(struct hash_map *hash_map, uint32_t new_count)
+{
+    struct hash_map_table *old_table, *new_table;
+    uint32_t i, entry_idx, mixed_hash;
+    struct hash_map_entry *old_entry;
+    uint8_t *new_ctrl;
+    void *new_entries;
+
+    if (!(new_table = hash_map_table_create(new_count, hash_map->entry_size)))
+        return false;
+
+    new_ctrl = hash_map_table_get_ctrl(new_table);
+    new_entries = hash_map_table_get_entries(new_table);
+
+    for (i = 0; i < hash_map->entry_count; i++)
+    {
+        /* Relocate existing entries one by one. Tombstones are dropped. */
+        if (hash_map->ctrl[i] & HASH_MAP_CTRL_EMPTY)
+            continue;
+
+        old_entry = hash_map_get_entry(hash_map, i);
+        mixed_hash = hash_map_mix_hash(old_entry->hash_value);
+        entry_idx = hash_map_find_free_idx(new_ctrl, new_count, mixed_hash);
+
+        new_ctrl[entry_idx] = hash_map_hash_ctrl(mixed_hash);
+        memcpy(void_ptr_offset(new_entries, entry_idx * hash_map->entry_size), old_entry, hash_map->entry_size);
     }
 
-    vkd3d_free(old_entries);
+    old_table = hash_map->table;
+
+    hash_map->ctrl = new_ctrl;
+    hash_map->entries = new_entries;
+    hash_map->entry_count = new_count;
+    hash_map->growth_left = hash_map_get_growth_capacity(new_count) - hash_map->used_count;
+    vkd3d_atomic_ptr_store_explicit(&hash_map->table, new_table, vkd3d_memory_order_seq_cst);
+
+    if (old_table)
+        hash_map_retire_table(hash_map, old_table);
+
     return true;
 }
 
-static inline bool hash_map_should_grow_before_insert(struct hash_map *hash_map)
+static inline bool hash_map_grow(struct hash_map *hash_map)
 {
-    /* Allow a load factor of 0.7 for performance reasons */
-    return 10 * hash_map->used_count >= 7 * hash_map->entry_count;
+    uint32_t new_count = hash_map->entry_count ? hash_map->entry_count : HASH_MAP_GROUP_SIZE;
+
+    /* If most of the growth budget was eaten by tombstones,
+     * rehashing at the same size is enough to reclaim them. */
+    if (2 * (hash_map->used_count + 1) > hash_map_get_growth_capacity(new_count))
+        new_count *= 2;
+
+    return hash_map_rehash(hash_map, new_count);
 }
 
-static inline struct hash_map_entry *hash_map_find(const struct hash_map *hash_map, const void *key)
+static inline struct hash_map_entry *hash_map_find_in_table(struct hash_map_table *table,
+        pfn_hash_compare_func compare_func, size_t entry_size, const void *key,
+        uint32_t hash_value, bool read_mostly)
 {
-    uint32_t hash_value, entry_idx;
+    uint32_t mixed_hash, group_idx, group_mask, entry_idx, mask;
+    struct hash_map_entry *entry;
+    const uint8_t *ctrl;
+    void *entries;
+    uint8_t h2;
 
-    if (!hash_map->entries)
-        return NULL;
+    ctrl = hash_map_table_get_ctrl(table);
+    entries = hash_map_table_get_entries(table);
 
-    hash_value = hash_map->hash_func(key);
-    entry_idx = hash_map_get_entry_idx(hash_map, hash_value);
+    mixed_hash = hash_map_mix_hash(hash_value);
+    h2 = hash_map_hash_ctrl(mixed_hash);
+    group_idx = hash_map_hash_group(mixed_hash, table->entry_count);
+    group_mask = table->entry_count / HASH_MAP_GROUP_SIZE - 1;
 
     /* We never allow the hash table to be completely
      * populated, so this is guaranteed to return */
     while (true)
     {
-        struct hash_map_entry *entry = hash_map_get_entry(hash_map, entry_idx);
+        const uint8_t *group = &ctrl[group_idx * HASH_MAP_GROUP_SIZE];
 
-        if (!(entry->flags & HASH_MAP_ENTRY_OCCUPIED))
-            return NULL;
+        mask = hash_map_group_match(group, h2);
+
+        while (mask)
+        {
+            entry_idx = group_idx * HASH_MAP_GROUP_SIZE + vkd3d_bitmask_iter32(&mask);
 
-        if (entry->hash_value == hash_value && hash_map->compare_func(key, entry))
-            return entry;
+            /* Synchronize with the writer that published the slot. */
+            if (read_mostly && hash_map_load_ctrl_acquire(ctrl, entry_idx) != h2)
+                continue;
 
-        entry_idx = hash_map_next_entry_idx(hash_map, entry_idx);
+            entry = void_ptr_offset(entries, entry_idx * entry_size);
+
+            if (entry->hash_value == hash_value && compare_func(key, entry))
+                return entry;
+        }
+
+        if (hash_map_group_match(group, HASH_MAP_CTRL_EMPTY))
+            return NULL;
+
+        group_idx = (group_idx + 1) & group_mask;
     }
 }
 
+static inline struct hash_map_entry *hash_map_find(const struct hash_map *hash_map, const void *key)
+{
+    if (!hash_map->table)
+        return NULL;
+
+    return hash_map_find_in_table(hash_map->table, hash_map->compare_func,
+            hash_map->entry_size, key, hash_map->hash_func(key), false);
+}
+
 static inline struct hash_map_entry *hash_map_insert(struct hash_map *hash_map, const void *key, const struct hash_map_entry *entry)
 {
-    struct hash_map_entry *target = NULL;
-    uint32_t hash_value, entry_idx;
+    uint32_t hash_value, mixed_hash, group_idx, group_mask, entry_idx, mask;
+    struct hash_map_entry *target;
+    const uint8_t *group;
+    uint8_t h2;
+
+    if (!hash_map->table && !hash_map_grow(hash_map))
+        return NULL;
 
-    if (hash_map_should_grow_before_insert(hash_map))
+    hash_value = hash_map->hash_func(key);
+    mixed_hash = hash_map_mix_hash(hash_value);
+    h2 = hash_map_hash_ctrl(mixed_hash);
+    group_idx = hash_map_hash_group(mixed_hash, hash_map->entry_count);
+    group_mask = hash_map->entry_count / HASH_MAP_GROUP_SIZE - 1;
+
+    /* Look for an existing entry. New entries go into the first empty slot
+     * of the probe sequence, which is in the group where the lookup ends.
+     * Tombstones are never reused in place, since read-mostly readers may
+     * still be looking at the removed entry. */
+    while (true)
+    {
+        group = &hash_map->ctrl[group_idx * HASH_MAP_GROUP_SIZE];
+        mask = hash_map_group_match(group, h2);
+
+        while (mask)
+        {
+            entry_idx = group_idx * HASH_MAP_GROUP_SIZE + vkd3d_bitmask_iter32(&mask);
+            target = hash_map_get_entry(hash_map, entry_idx);
+
+            /* If we already have an entry in the hashmap, return the old one.
+             * Caller is responsible for cleaning up the node we attempted to add. */
+            if (target->hash_value == hash_value && hash_map->compare_func(key, target))
+                return target;
+        }
+
+        if ((mask = hash_map_group_match(group, HASH_MAP_CTRL_EMPTY)))
+            break;
+
+        group_idx = (group_idx + 1) & group_mask;
+    }
+
+    entry_idx = group_idx * HASH_MAP_GROUP_SIZE + vkd3d_bitmask_tzcnt32(mask);
+
+    if (!hash_map->growth_left)
     {
         if (!hash_map_grow(hash_map))
             return NULL;
+
+        entry_idx = hash_map_find_free_idx(hash_map->ctrl, hash_map->entry_count, mixed_hash);
     }
 
-    hash_value = hash_map->hash_func(key);
-    entry_idx = hash_map_get_entry_idx(hash_map, hash_value);
+    hash_map->growth_left -= 1;
+    hash_map->used_count += 1;
 
-    while (!target)
+    target = hash_map_get_entry(hash_map, entry_idx);
+    memcpy(target, entry, hash_map->entry_size);
+    target->flags = HASH_MAP_ENTRY_OCCUPIED;
+    target->hash_value = hash_value;
+
+    hash_map_set_ctrl(hash_map, entry_idx, h2);
+    return target;
+}
+
+static inline uint32_t hash_map_find_shift_idx(const struct hash_map *hash_map, uint32_t hole_group_idx)
+{
+    uint32_t group_idx, group_mask, home_group_idx, entry_idx, mask;
+    const struct hash_map_entry *entry;
+    const uint8_t *group;
+
+    group_mask = hash_map->entry_count / HASH_MAP_GROUP_SIZE - 1;
+    group_idx = hole_group_idx;
+
+    /* Every entry is preceded by full groups back to its home group, so only
+     * entries up to and including the next group with an empty slot can have
+     * a probe sequence that passes through the hole. Find one of them. */
+    do
     {
-        struct hash_map_entry *current = hash_map_get_entry(hash_map, entry_idx);
+        group_idx = (group_idx + 1) & group_mask;
+        group = &hash_map->ctrl[group_idx * HASH_MAP_GROUP_SIZE];
+        mask = ~hash_map_group_match_free(group) & 0xffffu;
 
-        if (!(current->flags & HASH_MAP_ENTRY_OCCUPIED) ||
-                (current->hash_value == hash_value && hash_map->compare_func(key, current)))
-            target = current;
-        else
-            entry_idx = hash_map_next_entry_idx(hash_map, entry_idx);
+        while (mask)
+        {
+            entry_idx = group_idx * HASH_MAP_GROUP_SIZE + vkd3d_bitmask_iter32(&mask);
+            entry = hash_map_get_entry(hash_map, entry_idx);
+            home_group_idx = hash_map_hash_group(hash_map_mix_hash(entry->hash_value), hash_map->entry_count);
+
+            if (((hole_group_idx - home_group_idx) & group_mask) < ((group_idx - home_group_idx) & group_mask))
+                return entry_idx;
+        }
     }
+    while (!hash_map_group_match(group, HASH_MAP_CTRL_EMPTY));
+
+    return UINT32_MAX;
+}
 
-    if (!(target->flags & HASH_MAP_ENTRY_OCCUPIED))
+static inline void hash_map_remove(struct hash_map *hash_map, struct hash_map_entry *entry)
+{
+    uint32_t entry_idx, shift_idx;
+
+    entry_idx = ((char *)entry - (char *)hash_map->entries) / hash_map->entry_size;
+    entry->flags = 0;
+    hash_map->used_count -= 1;
+
+    if (hash_map->read_mostly)
     {
-        hash_map->used_count += 1;
-        memcpy(target, entry, hash_map->entry_size);
-        target->flags = HASH_MAP_ENTRY_OCCUPIED;
-        target->hash_value = hash_value;
+        /* Readers may be probing past this slot, and would miss
+         * entries that get moved, so leave a tombstone. */
+        hash_map_set_ctrl(hash_map, entry_idx, HASH_MAP_CTRL_DELETED);
+        return;
     }
 
-    /* If target is occupied, we already have an entry in the hashmap.
-     * Return old one, caller is responsible for cleaning up the node we attempted to add. */
+    /* Lookups stop at the first group with an empty slot. As long as the
+     * group of the hole is otherwise full, move an entry whose probe
+     * sequence passes through it into the hole, which moves the hole to
+     * where that entry was. */
+    while (!hash_map_group_match(&hash_map->ctrl[entry_idx & ~(HASH_MAP_GROUP_SIZE - 1)], HASH_MAP_CTRL_EMPTY) &&
+            (shift_idx = hash_map_find_shift_idx(hash_map, entry_idx / HASH_MAP_GROUP_SIZE)) != UINT32_MAX)
+    {
+        memcpy(entry, hash_map_get_entry(hash_map, shift_idx), hash_map->entry_size);
+        hash_map_set_ctrl(hash_map, entry_idx, hash_map->ctrl[shift_idx]);
 
-    return target;
+        entry_idx = shift_idx;
+        entry = hash_map_get_entry(hash_map, entry_idx);
+        entry->flags = 0;
+    }
+
+    hash_map_set_ctrl(hash_map, entry_idx, HASH_MAP_CTRL_EMPTY);
+    hash_map->growth_left += 1;
+}
+
+/* Begins a lock-free read section on a read-mostly map. Entries returned by
+ * hash_map_find_read_mostly stay valid until the matching hash_map_read_end. */
+static inline uint32_t hash_map_read_begin(struct hash_map *hash_map)
+{
+    uint32_t epoch;
+
+    while (true)
+    {
+        epoch = vkd3d_atomic_uint32_load_explicit(&hash_map->epoch, vkd3d_memory_order_acquire);
+        vkd3d_atomic_uint32_increment(&hash_map->reader_count[epoch & 1], vkd3d_memory_order_seq_cst);
+
+        if (vkd3d_atomic_uint32_load_explicit(&hash_map->epoch, vkd3d_memory_order_seq_cst) == epoch)
+            return epoch & 1;
+
+        /* A writer retired a table in between, and may be waiting for this slot. */
+        vkd3d_atomic_uint32_decrement(&hash_map->reader_count[epoch & 1], vkd3d_memory_order_release);
+    }
+}
+
+static inline void hash_map_read_end(struct hash_map *hash_map, uint32_t read_slot)
+{
+    vkd3d_atomic_uint32_decrement(&hash_map->reader_count[read_slot], vkd3d_memory_order_release);
+}
+
+static inline struct hash_map_entry *hash_map_find_read_mostly(const struct hash_map *hash_map, const void *key)
+{
+    struct hash_map_table *table;
+
+    if (!(table = vkd3d_atomic_ptr_load_explicit((void **)&hash_map->table, vkd3d_memory_order_acquire)))
+        return NULL;
+
+    return hash_map_find_in_table(table, hash_map->compare_func,
+            hash_map->entry_size, key, hash_map->hash_func(key), true);
 }
 
 static inline void hash_map_init(struct hash_map *hash_map, pfn_hash_func hash_func, pfn_hash_compare_func compare_func, size_t entry_size)
 {
     hash_map->hash_func = hash_func;
     hash_map->compare_func = compare_func;
+    hash_map->table = NULL;
+    hash_map->ctrl = NULL;
     hash_map->entries = NULL;
     hash_map->entry_size = entry_size;
     hash_map->entry_count = 0;
     hash_map->used_count = 0;
+    hash_map->growth_left = 0;
+    hash_map->read_mostly = false;
+    hash_map->epoch = 0;
+    hash_map->reader_count[0] = 0;
+    hash_map->reader_count[1] = 0;
+}
+
+/* Writers must be serialized, and must not hold a read section themselves. */
+static inline void hash_map_init_read_mostly(struct hash_map *hash_map, pfn_hash_func hash_func, pfn_hash_compare_func compare_func, size_t entry_size)
+{
+    hash_map_init(hash_map, hash_func, compare_func, entry_size);
+    hash_map->read_mostly = true;
 }
 
+/* Must not be called while readers are active. */
 static inline void hash_map_clear(struct hash_map *hash_map)
 {
-    vkd3d_free(hash_map->entries);
+    vkd3d_free_aligned(hash_map->table);
+    hash_map->table = NULL;
+    hash_map->ctrl = NULL;
     hash_map->entries = NULL;
     hash_map->entry_count = 0;
     hash_map->used_count = 0;
+    hash_map->growth_left = 0;
 }
 
 static inline uint32_t hash_combine(uint32_t old_hash, uint32_t new_hash) {
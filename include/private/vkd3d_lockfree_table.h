@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __VKD3D_LOCKFREE_TABLE_H
+#define __VKD3D_LOCKFREE_TABLE_H
+
+#include "vkd3d_common.h"
+#include "hashmap.h"
+
+/* Insert-only open-addressing table of pointers to caller-owned entries.
+ * Readers do not take any lock. A slot only ever transitions from NULL to a
+ * fully initialized entry, which is published with release semantics. When
+ * the table needs to grow, a new table is built on the side and published
+ * atomically. Old tables may still be observed by concurrent readers, so they
+ * are retired and only freed in vkd3d_lockfree_table_cleanup. Writers must be
+ * serialized by the caller. */
+struct vkd3d_lockfree_table_slot
+{
+    void *entry;
+    uint32_t hash;
+};
+
+struct vkd3d_lockfree_table_data
+{
+    struct vkd3d_lockfree_table_data *retired;
+    uint32_t size_mask;
+    uint32_t used_count;
+    struct vkd3d_lockfree_table_slot slots[];
+};
+
+struct vkd3d_lockfree_table
+{
+    struct vkd3d_lockfree_table_data *data;
+    uint32_t initial_size;
+};
+
+typedef bool (*pfn_vkd3d_lockfree_table_compare)(const void *key, const void *entry);
+typedef void (*pfn_vkd3d_lockfree_table_destroy)(void *entry, void *userdata);
+
+/* initial_size must be a power of two. */
+void vkd3d_lockfree_table_init(struct vkd3d_lockfree_table *table, uint32_t initial_size);
+/* Calls destroy for every entry, then frees the current and all retired tables. */
+void vkd3d_lockfree_table_cleanup(struct vkd3d_lockfree_table *table,
+        pfn_vkd3d_lockfree_table_destroy destroy, void *userdata);
+/* The caller must have checked that no equal entry exists. Returns false on allocation failure. */
+bool vkd3d_lockfree_table_insert_locked(struct vkd3d_lockfree_table *table, void *entry, uint32_t hash);
+
+static inline uint32_t vkd3d_lockfree_table_slot_index(const struct vkd3d_lockfree_table_data *data, uint32_t hash)
+{
+    return hash_map_mix_hash(hash) & data->size_mask;
+}
+
+/* Safe to call concurrently with vkd3d_lockfree_table_insert_locked. */
+static inline void *vkd3d_lockfree_table_find(const struct vkd3d_lockfree_table *table,
+        const void *key, uint32_t hash, pfn_vkd3d_lockfree_table_compare compare)
+{
+    const struct vkd3d_lockfree_table_data *data;
+    void *entry;
+    uint32_t slot;
+
+    if (!(data = vkd3d_atomic_ptr_load_explicit(&table->data, vkd3d_memory_order_acquire)))
+        return NULL;
+
+    /* The table is never full, so this terminates. The hash is written
+     * before the entry is published, so it is valid once entry is seen. */
+    for (slot = vkd3d_lockfree_table_slot_index(data, hash); ; slot = (slot + 1) & data->size_mask)
+    {
+        entry = vkd3d_atomic_ptr_load_explicit(&data->slots[slot].entry, vkd3d_memory_order_acquire);
+        if (!entry)
+            return NULL;
+        if (data->slots[slot].hash == hash && compare(key, entry))
+            return entry;
+    }
+}
+
+#endif  /* __VKD3D_LOCKFREE_TABLE_H */
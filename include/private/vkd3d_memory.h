@@ -21,6 +21,8 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "vkd3d_debug.h"
@@ -75,4 +77,56 @@ static inline void vkd3d_free_aligned(void *ptr)
 #endif
 }
 
+/* Bump allocator for short-lived objects which are all freed together.
+ * Allocations are never freed individually. */
+#define VKD3D_ARENA_ALIGNMENT 16
+
+struct vkd3d_arena_block;
+
+struct vkd3d_arena
+{
+    struct vkd3d_arena_block *head;
+    size_t block_size;
+
+    /* Statistics since the last reset. */
+    size_t allocation_count;
+    size_t reserved_size;
+};
+
+void vkd3d_arena_init(struct vkd3d_arena *arena, size_t block_size);
+void *vkd3d_arena_alloc(struct vkd3d_arena *arena, size_t size);
+void vkd3d_arena_reset(struct vkd3d_arena *arena);
+void vkd3d_arena_destroy(struct vkd3d_arena *arena);
+
+/* Copies size bytes, bypassing the cache for the destination where supported.
+ * Meant for write-combined memory, which is never read back by the CPU. The caller
+ * must issue vkd3d_memcpy_non_temporal_fence() before the data is consumed elsewhere. */
+void vkd3d_memcpy_non_temporal(void *dst, const void *src, size_t size);
+void vkd3d_memcpy_non_temporal_fence(void);
+
+/* Describes a copy of slice_count slices of row_count rows between pitched
+ * surfaces. Rows are addressed linearly across slices. */
+struct vkd3d_memcpy_rows
+{
+    const uint8_t *src;
+    uint8_t *dst;
+    size_t src_row_pitch;
+    size_t src_slice_pitch;
+    size_t dst_row_pitch;
+    size_t dst_slice_pitch;
+    size_t row_size;
+    unsigned int row_count;
+    unsigned int slice_count;
+    bool non_temporal;
+};
+
+static inline unsigned int vkd3d_memcpy_rows_get_total_row_count(const struct vkd3d_memcpy_rows *copy)
+{
+    return copy->row_count * copy->slice_count;
+}
+
+/* Copies rows [first_row, first_row + row_count). Runs of rows which are tightly
+ * packed on both sides are copied with a single call. */
+void vkd3d_memcpy_rows(const struct vkd3d_memcpy_rows *copy, unsigned int first_row, unsigned int row_count);
+
 #endif  /* __VKD3D_MEMORY_H */
@@ -51,6 +51,14 @@ static inline void rw_spinlock_acquire_write(spinlock_t *spinlock)
     }
 }
 
+static inline bool rw_spinlock_try_acquire_write(spinlock_t *spinlock)
+{
+    return vkd3d_atomic_uint32_load_explicit(spinlock, vkd3d_memory_order_relaxed) == VKD3D_RW_SPINLOCK_IDLE &&
+            vkd3d_atomic_uint32_compare_exchange(spinlock,
+                    VKD3D_RW_SPINLOCK_IDLE, VKD3D_RW_SPINLOCK_WRITE,
+                    vkd3d_memory_order_acquire, vkd3d_memory_order_relaxed) == VKD3D_RW_SPINLOCK_IDLE;
+}
+
 static inline void rw_spinlock_release_write(spinlock_t *spinlock)
 {
     vkd3d_atomic_uint32_and(spinlock, ~VKD3D_RW_SPINLOCK_WRITE, vkd3d_memory_order_release);
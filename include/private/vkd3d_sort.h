@@ -0,0 +1,58 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __VKD3D_SORT_H
+#define __VKD3D_SORT_H
+
+#include "vkd3d_common.h"
+#include <stddef.h>
+
+/* Stable LSD radix sort of 64-bit keys, eight bits per pass. Values are
+ * permuted along with their keys. Byte positions that are identical for
+ * all keys are skipped, so keys packed from a few small fields are cheap.
+ * tmp_keys and tmp_values must hold count elements each. The result is
+ * always returned in keys and values. */
+void vkd3d_radix_sort_u64(uint64_t *keys, uint32_t *values,
+        uint64_t *tmp_keys, uint32_t *tmp_values, size_t count);
+
+/* Maps objects such as pointers or Vulkan handles to small ranks in order
+ * of first use, so that a few of them can be packed into a radix sort key. */
+#define VKD3D_RANK_TABLE_MAX_RANKS 1024u
+#define VKD3D_RANK_TABLE_HASH_BITS 11u
+
+struct vkd3d_rank_table
+{
+    uint64_t objects[VKD3D_RANK_TABLE_MAX_RANKS];
+    /* Rank + 1 of the object hashed to each slot, or 0 if the slot is empty. */
+    uint16_t slots[1u << VKD3D_RANK_TABLE_HASH_BITS];
+    uint32_t count;
+    uint32_t last;
+};
+
+void vkd3d_rank_table_init(struct vkd3d_rank_table *table);
+/* Returns false once more than VKD3D_RANK_TABLE_MAX_RANKS distinct objects were seen. */
+bool vkd3d_rank_table_get(struct vkd3d_rank_table *table, uint64_t object, uint32_t *rank);
+
+/* Builds a key which groups by the first rank, then by the second rank
+ * within each group, and orders by index last. */
+static inline uint64_t vkd3d_rank_sort_key(uint32_t group_rank, uint32_t subgroup_rank, uint32_t index)
+{
+    return ((uint64_t)group_rank << 48) | ((uint64_t)subgroup_rank << 32) | index;
+}
+
+#endif /* __VKD3D_SORT_H */
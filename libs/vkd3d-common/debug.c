@@ -55,6 +55,7 @@ static unsigned int vkd3d_dbg_level[VKD3D_DBG_CHANNEL_COUNT];
 static spinlock_t vkd3d_dbg_initialized;
 static pthread_once_t vkd3d_dbg_once = PTHREAD_ONCE_INIT;
 static FILE *vkd3d_log_file;
+static bool vkd3d_log_async;
 
 static void vkd3d_dbg_init_once(void)
 {
@@ -85,6 +86,8 @@ static void vkd3d_dbg_init_once(void)
         }
     }
 
+    vkd3d_log_async = !!vkd3d_env_var_as_uint("VKD3D_LOG_ASYNC", 0);
+
     vkd3d_atomic_uint32_store_explicit(&vkd3d_dbg_initialized, 1, vkd3d_memory_order_release);
 }
 
@@ -104,9 +107,311 @@ enum vkd3d_dbg_level vkd3d_dbg_get_level(enum vkd3d_dbg_channel channel)
     return vkd3d_dbg_level[channel];
 }
 
+/* With VKD3D_LOG_ASYNC=1, messages are preformatted into per-thread rings, which are only
+ * written to by the owning thread and only read by whoever holds the drain lock, normally
+ * the writer thread. A thread whose ring is full writes synchronously instead, so messages
+ * are never dropped and producers that outpace the writer are throttled to its speed. */
+#define VKD3D_DBG_RING_SIZE (64 * 1024)
+#define VKD3D_DBG_RECORD_MAX_SIZE 1024
+
+struct vkd3d_dbg_ring
+{
+    struct vkd3d_dbg_ring *next;
+    uint32_t owned;
+    uint32_t write_pos;
+    uint32_t read_pos;
+    char data[VKD3D_DBG_RING_SIZE];
+};
+
+struct vkd3d_dbg_writer
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t pending;
+    uint32_t stop;
+    /* Set while the writer thread runs and accepts messages. */
+    uint32_t active;
+    /* Set once rings may exist, never cleared. */
+    uint32_t started;
+    spinlock_t drain_lock;
+    struct vkd3d_dbg_ring *rings;
+    pthread_t thread;
+};
+
+static struct vkd3d_dbg_writer vkd3d_dbg_writer = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+static pthread_once_t vkd3d_dbg_writer_once = PTHREAD_ONCE_INIT;
+static VKD3D_THREAD_LOCAL struct vkd3d_dbg_ring *vkd3d_dbg_thread_ring;
+
+#ifdef _WIN32
+static DWORD vkd3d_dbg_ring_key = FLS_OUT_OF_INDEXES;
+#else
+static pthread_key_t vkd3d_dbg_ring_key;
+#endif
+
+static void vkd3d_dbg_ring_release(void *data)
+{
+    struct vkd3d_dbg_ring *ring = data;
+
+    /* Queued messages stay in the ring and are written out by the next drain. */
+    if (ring)
+        vkd3d_atomic_uint32_store_explicit(&ring->owned, 0, vkd3d_memory_order_release);
+}
+
+#ifdef _WIN32
+static void WINAPI vkd3d_dbg_ring_release_fls(void *data)
+{
+    vkd3d_dbg_ring_release(data);
+}
+#endif
+
+static void vkd3d_dbg_ring_read(const struct vkd3d_dbg_ring *ring, uint32_t pos, void *dst, uint32_t size)
+{
+    uint32_t offset = pos % VKD3D_DBG_RING_SIZE;
+    uint32_t first_size = min(size, VKD3D_DBG_RING_SIZE - offset);
+
+    memcpy(dst, &ring->data[offset], first_size);
+    memcpy((char *)dst + first_size, ring->data, size - first_size);
+}
+
+static void vkd3d_dbg_ring_write(struct vkd3d_dbg_ring *ring, uint32_t pos, const void *src, uint32_t size)
+{
+    uint32_t offset = pos % VKD3D_DBG_RING_SIZE;
+    uint32_t first_size = min(size, VKD3D_DBG_RING_SIZE - offset);
+
+    memcpy(&ring->data[offset], src, first_size);
+    memcpy(ring->data, (const char *)src + first_size, size - first_size);
+}
+
+static uint32_t vkd3d_dbg_record_size(uint32_t size)
+{
+    return sizeof(uint32_t) + align(size, sizeof(uint32_t));
+}
+
+static bool vkd3d_dbg_ring_push(struct vkd3d_dbg_ring *ring, const char *text, uint32_t size)
+{
+    uint32_t read_pos, write_pos, record_size;
+
+    write_pos = ring->write_pos;
+    read_pos = vkd3d_atomic_uint32_load_explicit(&ring->read_pos, vkd3d_memory_order_acquire);
+    record_size = vkd3d_dbg_record_size(size);
+
+    if (VKD3D_DBG_RING_SIZE - (write_pos - read_pos) < record_size)
+        return false;
+
+    vkd3d_dbg_ring_write(ring, write_pos, &size, sizeof(size));
+    vkd3d_dbg_ring_write(ring, write_pos + sizeof(size), text, size);
+    vkd3d_atomic_uint32_store_explicit(&ring->write_pos, write_pos + record_size, vkd3d_memory_order_release);
+    return true;
+}
+
+static void vkd3d_dbg_ring_drain(struct vkd3d_dbg_ring *ring, FILE *log_file)
+{
+    char text[VKD3D_DBG_RECORD_MAX_SIZE];
+    uint32_t read_pos, write_pos, size;
+
+    read_pos = ring->read_pos;
+    write_pos = vkd3d_atomic_uint32_load_explicit(&ring->write_pos, vkd3d_memory_order_acquire);
+
+    while (read_pos != write_pos)
+    {
+        vkd3d_dbg_ring_read(ring, read_pos, &size, sizeof(size));
+        vkd3d_dbg_ring_read(ring, read_pos + sizeof(size), text, size);
+        fwrite(text, 1, size, log_file);
+        read_pos += vkd3d_dbg_record_size(size);
+    }
+
+    vkd3d_atomic_uint32_store_explicit(&ring->read_pos, read_pos, vkd3d_memory_order_release);
+}
+
+static FILE *vkd3d_dbg_get_log_file(void)
+{
+    return vkd3d_log_file ? vkd3d_log_file : stderr;
+}
+
+/* Must be called with the drain lock held. */
+static void vkd3d_dbg_drain_rings(void)
+{
+    struct vkd3d_dbg_ring *ring;
+    FILE *log_file;
+
+    if (!vkd3d_atomic_uint32_load_explicit(&vkd3d_dbg_writer.started, vkd3d_memory_order_acquire))
+        return;
+
+    pthread_mutex_lock(&vkd3d_dbg_writer.mutex);
+    ring = vkd3d_dbg_writer.rings;
+    pthread_mutex_unlock(&vkd3d_dbg_writer.mutex);
+
+    log_file = vkd3d_dbg_get_log_file();
+
+    for (; ring; ring = ring->next)
+        vkd3d_dbg_ring_drain(ring, log_file);
+}
+
+static void *vkd3d_dbg_writer_main(void *arg)
+{
+    struct vkd3d_dbg_writer *writer = arg;
+    bool stop;
+
+    vkd3d_set_thread_name("vkd3d_log");
+
+    do
+    {
+        pthread_mutex_lock(&writer->mutex);
+        while (!vkd3d_atomic_uint32_load_explicit(&writer->pending, vkd3d_memory_order_acquire) &&
+                !vkd3d_atomic_uint32_load_explicit(&writer->stop, vkd3d_memory_order_acquire))
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+        stop = !!vkd3d_atomic_uint32_load_explicit(&writer->stop, vkd3d_memory_order_acquire);
+        pthread_mutex_unlock(&writer->mutex);
+
+        /* Messages pushed while draining set pending again. */
+        vkd3d_atomic_uint32_store_explicit(&writer->pending, 0, vkd3d_memory_order_release);
+
+        spinlock_acquire(&writer->drain_lock);
+        vkd3d_dbg_drain_rings();
+        fflush(vkd3d_dbg_get_log_file());
+        spinlock_release(&writer->drain_lock);
+    } while (!stop);
+
+    return NULL;
+}
+
+#ifdef __GNUC__
+static void vkd3d_dbg_writer_shutdown(void) __attribute__((destructor));
+#endif
+
+/* Runs when the library is unloaded or the process exits. */
+static void vkd3d_dbg_writer_shutdown(void)
+{
+    struct vkd3d_dbg_writer *writer = &vkd3d_dbg_writer;
+
+    if (!vkd3d_atomic_uint32_load_explicit(&writer->active, vkd3d_memory_order_acquire))
+        return;
+
+    /* Messages logged from now on are written synchronously. */
+    vkd3d_atomic_uint32_store_explicit(&writer->active, 0, vkd3d_memory_order_release);
+
+    pthread_mutex_lock(&writer->mutex);
+    vkd3d_atomic_uint32_store_explicit(&writer->stop, 1, vkd3d_memory_order_release);
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+
+    /* On Windows, the writer has already been terminated if the process is exiting,
+     * in which case this returns immediately. */
+    pthread_join(writer->thread, NULL);
+
+    /* The writer may have been terminated while holding the drain lock. */
+    if (spinlock_try_acquire(&writer->drain_lock))
+    {
+        vkd3d_dbg_drain_rings();
+        fflush(vkd3d_dbg_get_log_file());
+        spinlock_release(&writer->drain_lock);
+    }
+}
+
+static void vkd3d_dbg_writer_init_once(void)
+{
+    struct vkd3d_dbg_writer *writer = &vkd3d_dbg_writer;
+
+    if (!vkd3d_log_async)
+        return;
+
+#ifdef _WIN32
+    if ((vkd3d_dbg_ring_key = FlsAlloc(vkd3d_dbg_ring_release_fls)) == FLS_OUT_OF_INDEXES)
+        return;
+#else
+    if (pthread_key_create(&vkd3d_dbg_ring_key, vkd3d_dbg_ring_release))
+        return;
+#endif
+
+    if (pthread_cond_init(&writer->cond, NULL))
+        return;
+
+    if (pthread_create(&writer->thread, NULL, vkd3d_dbg_writer_main, writer))
+    {
+        pthread_cond_destroy(&writer->cond);
+        return;
+    }
+
+#ifndef __GNUC__
+    atexit(vkd3d_dbg_writer_shutdown);
+#endif
+    vkd3d_atomic_uint32_store_explicit(&writer->started, 1, vkd3d_memory_order_release);
+    vkd3d_atomic_uint32_store_explicit(&writer->active, 1, vkd3d_memory_order_release);
+}
+
+static struct vkd3d_dbg_ring *vkd3d_dbg_get_thread_ring(void)
+{
+    struct vkd3d_dbg_writer *writer = &vkd3d_dbg_writer;
+    struct vkd3d_dbg_ring *ring;
+
+    if (!vkd3d_log_async)
+        return NULL;
+
+    if ((ring = vkd3d_dbg_thread_ring))
+        return vkd3d_atomic_uint32_load_explicit(&writer->active, vkd3d_memory_order_relaxed) ? ring : NULL;
+
+    pthread_once(&vkd3d_dbg_writer_once, vkd3d_dbg_writer_init_once);
+    if (!vkd3d_atomic_uint32_load_explicit(&writer->active, vkd3d_memory_order_acquire))
+        return NULL;
+
+    pthread_mutex_lock(&writer->mutex);
+
+    /* Reuse rings of threads which have exited. */
+    for (ring = writer->rings; ring; ring = ring->next)
+    {
+        if (!vkd3d_atomic_uint32_load_explicit(&ring->owned, vkd3d_memory_order_acquire))
+            break;
+    }
+
+    /* Don't go through vkd3d_calloc(), it logs on failure. */
+    if (!ring && (ring = calloc(1, sizeof(*ring))))
+    {
+        ring->next = writer->rings;
+        writer->rings = ring;
+    }
+
+    if (ring)
+        vkd3d_atomic_uint32_store_explicit(&ring->owned, 1, vkd3d_memory_order_relaxed);
+
+    pthread_mutex_unlock(&writer->mutex);
+
+    if (!ring)
+        return NULL;
+
+#ifdef _WIN32
+    FlsSetValue(vkd3d_dbg_ring_key, ring);
+#else
+    pthread_setspecific(vkd3d_dbg_ring_key, ring);
+#endif
+
+    vkd3d_dbg_thread_ring = ring;
+    return ring;
+}
+
+static void vkd3d_dbg_writer_kick(struct vkd3d_dbg_writer *writer)
+{
+    /* Only the first message after a drain needs to wake up the writer. */
+    if (vkd3d_atomic_uint32_exchange_explicit(&writer->pending, 1, vkd3d_memory_order_acq_rel))
+        return;
+
+    pthread_mutex_lock(&writer->mutex);
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+}
+
+void vkd3d_dbg_flush(void)
+{
+    spinlock_acquire(&vkd3d_dbg_writer.drain_lock);
+    vkd3d_dbg_drain_rings();
+    fflush(vkd3d_dbg_get_log_file());
+    spinlock_release(&vkd3d_dbg_writer.drain_lock);
+}
+
 void vkd3d_dbg_printf(enum vkd3d_dbg_channel channel, enum vkd3d_dbg_level level, const char *function, const char *fmt, ...)
 {
-    static spinlock_t spin;
+    char text[VKD3D_DBG_RECORD_MAX_SIZE];
+    struct vkd3d_dbg_ring *ring;
+    int prefix_size, size;
     unsigned int tid;
     FILE *log_file;
     va_list args;
@@ -114,18 +419,41 @@ void vkd3d_dbg_printf(enum vkd3d_dbg_channel channel, enum vkd3d_dbg_level level
     if (vkd3d_dbg_get_level(channel) < level)
         return;
 
-    log_file = vkd3d_log_file ? vkd3d_log_file : stderr;
+    log_file = vkd3d_dbg_get_log_file();
     assert(level < ARRAY_SIZE(debug_level_names));
 
     tid = vkd3d_get_current_thread_id();
 
+    /* Errors are written synchronously so that they are not lost if the process goes down. */
+    if (level > VKD3D_DBG_LEVEL_ERR && (ring = vkd3d_dbg_get_thread_ring()))
+    {
+        prefix_size = snprintf(text, sizeof(text), "%04x:%s:%s: ", tid, debug_level_names[level], function);
+
+        if (prefix_size >= 0 && prefix_size < (int)sizeof(text))
+        {
+            va_start(args, fmt);
+            size = vsnprintf(text + prefix_size, sizeof(text) - prefix_size, fmt, args);
+            va_end(args);
+
+            /* Messages which don't fit in a record, or in the ring, take the synchronous path. */
+            if (size >= 0 && prefix_size + size < (int)sizeof(text) &&
+                    vkd3d_dbg_ring_push(ring, text, prefix_size + size))
+            {
+                vkd3d_dbg_writer_kick(&vkd3d_dbg_writer);
+                return;
+            }
+        }
+    }
+
     va_start(args, fmt);
-    spinlock_acquire(&spin);
+    spinlock_acquire(&vkd3d_dbg_writer.drain_lock);
+    /* Keep queued messages ordered before this one. */
+    vkd3d_dbg_drain_rings();
     fprintf(log_file, "%04x:%s:%s: ", tid, debug_level_names[level], function);
     vfprintf(log_file, fmt, args);
-    spinlock_release(&spin);
-    va_end(args);
     fflush(log_file);
+    spinlock_release(&vkd3d_dbg_writer.drain_lock);
+    va_end(args);
 }
 
 static char *get_buffer(void)
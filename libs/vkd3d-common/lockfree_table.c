@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#define VKD3D_DBG_CHANNEL VKD3D_DBG_CHANNEL_API
+
+#include "vkd3d_lockfree_table.h"
+#include "vkd3d_memory.h"
+
+static void vkd3d_lockfree_table_data_insert(struct vkd3d_lockfree_table_data *data,
+        void *entry, uint32_t hash)
+{
+    uint32_t slot;
+
+    for (slot = vkd3d_lockfree_table_slot_index(data, hash); data->slots[slot].entry;
+            slot = (slot + 1) & data->size_mask)
+        ;
+
+    data->slots[slot].hash = hash;
+    vkd3d_atomic_ptr_store_explicit(&data->slots[slot].entry, entry, vkd3d_memory_order_release);
+    data->used_count++;
+}
+
+static struct vkd3d_lockfree_table_data *vkd3d_lockfree_table_data_create(
+        const struct vkd3d_lockfree_table_data *old_data, uint32_t size)
+{
+    struct vkd3d_lockfree_table_data *data;
+    uint32_t i;
+
+    if (!(data = vkd3d_calloc(1, offsetof(struct vkd3d_lockfree_table_data, slots[size]))))
+        return NULL;
+
+    data->size_mask = size - 1;
+
+    if (old_data)
+    {
+        for (i = 0; i <= old_data->size_mask; i++)
+        {
+            if (old_data->slots[i].entry)
+                vkd3d_lockfree_table_data_insert(data, old_data->slots[i].entry, old_data->slots[i].hash);
+        }
+    }
+
+    return data;
+}
+
+void vkd3d_lockfree_table_init(struct vkd3d_lockfree_table *table, uint32_t initial_size)
+{
+    table->data = NULL;
+    table->initial_size = initial_size;
+}
+
+void vkd3d_lockfree_table_cleanup(struct vkd3d_lockfree_table *table,
+        pfn_vkd3d_lockfree_table_destroy destroy, void *userdata)
+{
+    struct vkd3d_lockfree_table_data *data, *retired;
+    uint32_t i;
+
+    if (!(data = table->data))
+        return;
+
+    /* Retired tables only hold entries that were carried over. */
+    for (i = 0; i <= data->size_mask; i++)
+    {
+        if (data->slots[i].entry)
+            destroy(data->slots[i].entry, userdata);
+    }
+
+    while (data)
+    {
+        retired = data->retired;
+        vkd3d_free(data);
+        data = retired;
+    }
+
+    table->data = NULL;
+}
+
+bool vkd3d_lockfree_table_insert_locked(struct vkd3d_lockfree_table *table, void *entry, uint32_t hash)
+{
+    struct vkd3d_lockfree_table_data *data = table->data, *new_data;
+    uint32_t size;
+
+    /* Keep the load factor at or below 0.5 so probe sequences stay short. */
+    if (!data || 2 * (data->used_count + 1) > data->size_mask + 1)
+    {
+        size = data ? 2 * (data->size_mask + 1) : table->initial_size;
+
+        if (!(new_data = vkd3d_lockfree_table_data_create(data, size)))
+            return false;
+
+        /* Readers may still be probing the old table. */
+        new_data->retired = data;
+        vkd3d_lockfree_table_data_insert(new_data, entry, hash);
+        vkd3d_atomic_ptr_store_explicit(&table->data, new_data, vkd3d_memory_order_release);
+    }
+    else
+        vkd3d_lockfree_table_data_insert(data, entry, hash);
+
+    return true;
+}
@@ -21,6 +21,15 @@
 
 #include "vkd3d_memory.h"
 
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 bool vkd3d_array_reserve(void **elements, size_t *capacity, size_t element_count, size_t element_size)
 {
     size_t new_capacity, max_capacity;
@@ -48,3 +57,222 @@ bool vkd3d_array_reserve(void **elements, size_t *capacity, size_t element_count
 
     return true;
 }
+
+struct vkd3d_arena_block
+{
+    struct vkd3d_arena_block *next;
+    size_t size;
+    size_t offset;
+    unsigned char data[];
+};
+
+void vkd3d_arena_init(struct vkd3d_arena *arena, size_t block_size)
+{
+    arena->head = NULL;
+    arena->block_size = block_size;
+    arena->allocation_count = 0;
+    arena->reserved_size = 0;
+}
+
+static void *vkd3d_arena_block_alloc(struct vkd3d_arena_block *block, size_t size)
+{
+    uintptr_t base = (uintptr_t)block->data;
+    size_t offset;
+
+    offset = align(base + block->offset, VKD3D_ARENA_ALIGNMENT) - base;
+
+    if (offset > block->size || block->size - offset < size)
+        return NULL;
+
+    block->offset = offset + size;
+    return block->data + offset;
+}
+
+void *vkd3d_arena_alloc(struct vkd3d_arena *arena, size_t size)
+{
+    struct vkd3d_arena_block *block;
+    size_t block_size;
+    void *ptr;
+
+    arena->allocation_count++;
+
+    if (arena->head && (ptr = vkd3d_arena_block_alloc(arena->head, size)))
+        return ptr;
+
+    block_size = max(arena->block_size, size + VKD3D_ARENA_ALIGNMENT);
+    if (!(block = vkd3d_malloc(offsetof(struct vkd3d_arena_block, data) + block_size)))
+        return NULL;
+
+    block->size = block_size;
+    block->offset = 0;
+    arena->reserved_size += block_size;
+
+    /* Oversized allocations get a dedicated block. Keep the current head
+     * so that its remaining space is still used for small allocations. */
+    if (arena->head && block_size > arena->block_size)
+    {
+        block->next = arena->head->next;
+        arena->head->next = block;
+    }
+    else
+    {
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    return vkd3d_arena_block_alloc(block, size);
+}
+
+void vkd3d_arena_reset(struct vkd3d_arena *arena)
+{
+    struct vkd3d_arena_block *block, *next;
+
+    if (!arena->head)
+        return;
+
+    /* Keep the most recent block around so that reusing the arena
+     * for a similar workload does not have to go through malloc again. */
+    for (block = arena->head->next; block; block = next)
+    {
+        next = block->next;
+        vkd3d_free(block);
+    }
+
+    arena->head->next = NULL;
+    arena->head->offset = 0;
+
+    arena->allocation_count = 0;
+    arena->reserved_size = arena->head->size;
+}
+
+void vkd3d_arena_destroy(struct vkd3d_arena *arena)
+{
+    struct vkd3d_arena_block *block, *next;
+
+    for (block = arena->head; block; block = next)
+    {
+        next = block->next;
+        vkd3d_free(block);
+    }
+
+    arena->head = NULL;
+    arena->allocation_count = 0;
+    arena->reserved_size = 0;
+}
+
+void vkd3d_memcpy_non_temporal(void *dst, const void *src, size_t size)
+{
+#ifdef __SSE2__
+    const uint8_t *src_bytes = src;
+    uint8_t *dst_bytes = dst;
+    size_t head_size;
+
+    /* Streaming stores require an aligned destination. */
+    head_size = min((16 - ((uintptr_t)dst_bytes & 15)) & 15, size);
+    memcpy(dst_bytes, src_bytes, head_size);
+    dst_bytes += head_size;
+    src_bytes += head_size;
+    size -= head_size;
+
+#ifdef __AVX2__
+    if (size >= 16 && ((uintptr_t)dst_bytes & 31))
+    {
+        _mm_stream_si128((__m128i *)dst_bytes, _mm_loadu_si128((const __m128i *)src_bytes));
+        dst_bytes += 16;
+        src_bytes += 16;
+        size -= 16;
+    }
+
+    while (size >= 128)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)src_bytes + 0);
+        __m256i b = _mm256_loadu_si256((const __m256i *)src_bytes + 1);
+        __m256i c = _mm256_loadu_si256((const __m256i *)src_bytes + 2);
+        __m256i d = _mm256_loadu_si256((const __m256i *)src_bytes + 3);
+        _mm256_stream_si256((__m256i *)dst_bytes + 0, a);
+        _mm256_stream_si256((__m256i *)dst_bytes + 1, b);
+        _mm256_stream_si256((__m256i *)dst_bytes + 2, c);
+        _mm256_stream_si256((__m256i *)dst_bytes + 3, d);
+        dst_bytes += 128;
+        src_bytes += 128;
+        size -= 128;
+    }
+#endif
+
+    while (size >= 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)src_bytes + 0);
+        __m128i b = _mm_loadu_si128((const __m128i *)src_bytes + 1);
+        __m128i c = _mm_loadu_si128((const __m128i *)src_bytes + 2);
+        __m128i d = _mm_loadu_si128((const __m128i *)src_bytes + 3);
+        _mm_stream_si128((__m128i *)dst_bytes + 0, a);
+        _mm_stream_si128((__m128i *)dst_bytes + 1, b);
+        _mm_stream_si128((__m128i *)dst_bytes + 2, c);
+        _mm_stream_si128((__m128i *)dst_bytes + 3, d);
+        dst_bytes += 64;
+        src_bytes += 64;
+        size -= 64;
+    }
+
+    while (size >= 16)
+    {
+        _mm_stream_si128((__m128i *)dst_bytes, _mm_loadu_si128((const __m128i *)src_bytes));
+        dst_bytes += 16;
+        src_bytes += 16;
+        size -= 16;
+    }
+
+    memcpy(dst_bytes, src_bytes, size);
+#else
+    memcpy(dst, src, size);
+#endif
+}
+
+void vkd3d_memcpy_non_temporal_fence(void)
+{
+#ifdef __SSE2__
+    _mm_sfence();
+#endif
+}
+
+void vkd3d_memcpy_rows(const struct vkd3d_memcpy_rows *copy, unsigned int first_row, unsigned int row_count)
+{
+    unsigned int slice, row, run_count, slice_run_count;
+    bool packed_rows, packed_slices;
+    const uint8_t *src;
+    size_t run_size;
+    uint8_t *dst;
+
+    packed_rows = copy->src_row_pitch == copy->row_size && copy->dst_row_pitch == copy->row_size;
+    packed_slices = packed_rows && copy->src_slice_pitch == copy->row_size * copy->row_count &&
+            copy->dst_slice_pitch == copy->row_size * copy->row_count;
+
+    while (row_count)
+    {
+        slice = first_row / copy->row_count;
+        row = first_row % copy->row_count;
+        slice_run_count = min(row_count, copy->row_count - row);
+
+        if (packed_slices)
+            run_count = row_count;
+        else if (packed_rows)
+            run_count = slice_run_count;
+        else
+            run_count = 1;
+
+        src = copy->src + slice * copy->src_slice_pitch + row * copy->src_row_pitch;
+        dst = copy->dst + slice * copy->dst_slice_pitch + row * copy->dst_row_pitch;
+        run_size = run_count * copy->row_size;
+
+        if (copy->non_temporal)
+            vkd3d_memcpy_non_temporal(dst, src, run_size);
+        else
+            memcpy(dst, src, run_size);
+
+        first_row += run_count;
+        row_count -= run_count;
+    }
+
+    if (copy->non_temporal)
+        vkd3d_memcpy_non_temporal_fence();
+}
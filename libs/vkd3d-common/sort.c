@@ -0,0 +1,147 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#define VKD3D_DBG_CHANNEL VKD3D_DBG_CHANNEL_API
+
+#include "vkd3d_sort.h"
+
+#include <string.h>
+
+#define VKD3D_RADIX_BITS 8
+#define VKD3D_RADIX_SIZE (1u << VKD3D_RADIX_BITS)
+#define VKD3D_RADIX_PASSES (64 / VKD3D_RADIX_BITS)
+
+void vkd3d_radix_sort_u64(uint64_t *keys, uint32_t *values,
+        uint64_t *tmp_keys, uint32_t *tmp_values, size_t count)
+{
+    size_t histogram[VKD3D_RADIX_PASSES][VKD3D_RADIX_SIZE];
+    unsigned int passes[VKD3D_RADIX_PASSES];
+    uint64_t *src_keys, *dst_keys, *swap_keys;
+    uint32_t *src_values, *dst_values, *swap_values;
+    unsigned int pass, pass_count, shift, digit;
+    size_t i, offset, digit_count;
+    uint64_t varying_bits;
+
+    if (count < 2)
+        return;
+
+    /* Digits which are the same for every key would not move anything.
+     * Skip them entirely, keys are typically packed from a few small fields
+     * and counting constant digits serializes on the same counters. */
+    for (i = 1, varying_bits = 0; i < count; i++)
+        varying_bits |= keys[i] ^ keys[0];
+
+    for (pass = 0, pass_count = 0; pass < VKD3D_RADIX_PASSES; pass++)
+    {
+        if ((varying_bits >> (pass * VKD3D_RADIX_BITS)) & (VKD3D_RADIX_SIZE - 1))
+            passes[pass_count++] = pass * VKD3D_RADIX_BITS;
+    }
+
+    if (!pass_count)
+        return;
+
+    /* Build the histograms for all remaining passes at once. */
+    memset(histogram, 0, pass_count * sizeof(*histogram));
+
+    for (i = 0; i < count; i++)
+    {
+        for (pass = 0; pass < pass_count; pass++)
+            histogram[pass][(keys[i] >> passes[pass]) & (VKD3D_RADIX_SIZE - 1)]++;
+    }
+
+    src_keys = keys;
+    src_values = values;
+    dst_keys = tmp_keys;
+    dst_values = tmp_values;
+
+    for (pass = 0; pass < pass_count; pass++)
+    {
+        shift = passes[pass];
+
+        for (digit = 0, offset = 0; digit < VKD3D_RADIX_SIZE; digit++)
+        {
+            digit_count = histogram[pass][digit];
+            histogram[pass][digit] = offset;
+            offset += digit_count;
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            offset = histogram[pass][(src_keys[i] >> shift) & (VKD3D_RADIX_SIZE - 1)]++;
+            dst_keys[offset] = src_keys[i];
+            dst_values[offset] = src_values[i];
+        }
+
+        swap_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = swap_keys;
+
+        swap_values = src_values;
+        src_values = dst_values;
+        dst_values = swap_values;
+    }
+
+    if (src_keys != keys)
+    {
+        memcpy(keys, src_keys, count * sizeof(*keys));
+        memcpy(values, src_values, count * sizeof(*values));
+    }
+}
+
+STATIC_ASSERT(VKD3D_RANK_TABLE_MAX_RANKS <= (1u << 16));
+STATIC_ASSERT(VKD3D_RANK_TABLE_MAX_RANKS < (1u << VKD3D_RANK_TABLE_HASH_BITS));
+
+void vkd3d_rank_table_init(struct vkd3d_rank_table *table)
+{
+    memset(table->slots, 0, sizeof(table->slots));
+    table->count = 0;
+    table->last = 0;
+}
+
+bool vkd3d_rank_table_get(struct vkd3d_rank_table *table, uint64_t object, uint32_t *rank)
+{
+    uint32_t slot, mask = ARRAY_SIZE(table->slots) - 1;
+
+    /* Objects tend to come in runs. */
+    if (table->last < table->count && table->objects[table->last] == object)
+    {
+        *rank = table->last;
+        return true;
+    }
+
+    slot = (uint32_t)((object * 0x9e3779b97f4a7c15ull) >> (64 - VKD3D_RANK_TABLE_HASH_BITS));
+
+    while (table->slots[slot])
+    {
+        if (table->objects[table->slots[slot] - 1] == object)
+        {
+            *rank = table->last = table->slots[slot] - 1;
+            return true;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    if (table->count == VKD3D_RANK_TABLE_MAX_RANKS)
+        return false;
+
+    table->objects[table->count] = object;
+    table->slots[slot] = table->count + 1;
+    *rank = table->last = table->count++;
+    return true;
+}
@@ -117,6 +117,8 @@
 
 #define VKD3D_SM4_CONDITIONAL_NZ              (0x1u << 18)
 
+#define VKD3D_SM4_ARENA_BLOCK_SIZE            (16 * 1024)
+
 enum vkd3d_sm4_opcode
 {
     VKD3D_SM4_OP_ADD                              = 0x00,
@@ -494,12 +496,6 @@ enum vkd3d_sm4_shader_data_type
     VKD3D_SM4_SHADER_DATA_MESSAGE                   = 0x4,
 };
 
-struct vkd3d_shader_src_param_entry
-{
-    struct list entry;
-    struct vkd3d_shader_src_param param;
-};
-
 struct vkd3d_sm4_data
 {
     struct vkd3d_shader_version shader_version;
@@ -509,9 +505,11 @@ struct vkd3d_sm4_data
 
     struct vkd3d_shader_src_param src_param[6];
     struct vkd3d_shader_dst_param dst_param[2];
-    struct list src_free;
-    struct list src;
     struct vkd3d_shader_immediate_constant_buffer icb;
+
+    /* Relative addressing parameters and decoded instruction operands.
+     * Everything lives until the parser is freed. */
+    struct vkd3d_arena arena;
 };
 
 struct vkd3d_sm4_opcode_info
@@ -1491,45 +1489,22 @@ void *shader_sm4_init(const DWORD *byte_code, size_t byte_code_size,
         priv->output_map[e->register_index] = e->semantic_index;
     }
 
-    list_init(&priv->src_free);
-    list_init(&priv->src);
+    vkd3d_arena_init(&priv->arena, VKD3D_SM4_ARENA_BLOCK_SIZE);
 
     return priv;
 }
 
 void shader_sm4_free(void *data)
 {
-    struct vkd3d_shader_src_param_entry *e1, *e2;
     struct vkd3d_sm4_data *priv = data;
 
-    list_move_head(&priv->src_free, &priv->src);
-    LIST_FOR_EACH_ENTRY_SAFE(e1, e2, &priv->src_free, struct vkd3d_shader_src_param_entry, entry)
-    {
-        vkd3d_free(e1);
-    }
+    vkd3d_arena_destroy(&priv->arena);
     vkd3d_free(priv);
 }
 
 static struct vkd3d_shader_src_param *get_src_param(struct vkd3d_sm4_data *priv)
 {
-    struct vkd3d_shader_src_param_entry *e;
-    struct list *elem;
-
-    if (!list_empty(&priv->src_free))
-    {
-        elem = list_head(&priv->src_free);
-        list_remove(elem);
-    }
-    else
-    {
-        if (!(e = vkd3d_malloc(sizeof(*e))))
-            return NULL;
-        elem = &e->entry;
-    }
-
-    list_add_tail(&priv->src, elem);
-    e = LIST_ENTRY(elem, struct vkd3d_shader_src_param_entry, entry);
-    return &e->param;
+    return vkd3d_arena_alloc(&priv->arena, sizeof(struct vkd3d_shader_src_param));
 }
 
 void shader_sm4_read_header(void *data, const DWORD **ptr, struct vkd3d_shader_version *shader_version)
@@ -1902,8 +1877,6 @@ void shader_sm4_read_instruction(void *data, const DWORD **ptr, struct vkd3d_sha
     const DWORD *p;
     DWORD precise;
 
-    list_move_head(&priv->src_free, &priv->src);
-
     if (*ptr >= priv->end)
     {
         WARN("End of byte-code, failed to read opcode.\n");
@@ -2009,6 +1982,81 @@ bool shader_sm4_is_end(void *data, const DWORD **ptr)
     return *ptr == priv->end;
 }
 
+static int shader_sm4_persist_instruction(struct vkd3d_sm4_data *priv,
+        struct vkd3d_shader_instruction *ins)
+{
+    struct vkd3d_shader_immediate_constant_buffer *icb;
+    struct vkd3d_shader_dst_param *dst;
+    struct vkd3d_shader_src_param *src;
+
+    /* Operands are decoded into scratch storage which is reused for every
+     * instruction, move them to the arena. Relative addressing parameters
+     * are already allocated from the arena. */
+    if (ins->dst_count)
+    {
+        if (!(dst = vkd3d_arena_alloc(&priv->arena, ins->dst_count * sizeof(*dst))))
+            return VKD3D_ERROR_OUT_OF_MEMORY;
+        memcpy(dst, ins->dst, ins->dst_count * sizeof(*dst));
+        ins->dst = dst;
+    }
+
+    if (ins->src_count)
+    {
+        if (!(src = vkd3d_arena_alloc(&priv->arena, ins->src_count * sizeof(*src))))
+            return VKD3D_ERROR_OUT_OF_MEMORY;
+        memcpy(src, ins->src, ins->src_count * sizeof(*src));
+        ins->src = src;
+    }
+
+    if (ins->handler_idx == VKD3DSIH_DCL_IMMEDIATE_CONSTANT_BUFFER)
+    {
+        if (!(icb = vkd3d_arena_alloc(&priv->arena, sizeof(*icb))))
+            return VKD3D_ERROR_OUT_OF_MEMORY;
+        icb->vec4_count = ins->declaration.icb->vec4_count;
+        memcpy(icb->data, ins->declaration.icb->data, icb->vec4_count * 4 * sizeof(*icb->data));
+        ins->declaration.icb = icb;
+    }
+
+    return VKD3D_OK;
+}
+
+int shader_sm4_read_instructions(void *data, const DWORD **ptr,
+        struct vkd3d_shader_instruction_array *instructions)
+{
+    struct vkd3d_sm4_data *priv = data;
+    struct vkd3d_shader_instruction *ins;
+    int ret;
+
+    /* Most instructions are at least 4 tokens long, avoid reallocating
+     * the array for the common case. */
+    if (!vkd3d_array_reserve((void **)&instructions->elements, &instructions->capacity,
+            instructions->count + (priv->end - *ptr) / 4, sizeof(*instructions->elements)))
+        return VKD3D_ERROR_OUT_OF_MEMORY;
+
+    while (!shader_sm4_is_end(data, ptr))
+    {
+        if (!vkd3d_array_reserve((void **)&instructions->elements, &instructions->capacity,
+                instructions->count + 1, sizeof(*instructions->elements)))
+            return VKD3D_ERROR_OUT_OF_MEMORY;
+
+        ins = &instructions->elements[instructions->count];
+        shader_sm4_read_instruction(data, ptr, ins);
+
+        if (ins->handler_idx == VKD3DSIH_INVALID)
+        {
+            WARN("Encountered unrecognized or invalid instruction.\n");
+            return VKD3D_ERROR_INVALID_ARGUMENT;
+        }
+
+        if ((ret = shader_sm4_persist_instruction(priv, ins)) < 0)
+            return ret;
+
+        instructions->count++;
+    }
+
+    return VKD3D_OK;
+}
+
 #define MAKE_TAG(ch0, ch1, ch2, ch3) \
     ((DWORD)(ch0) | ((DWORD)(ch1) << 8) | \
     ((DWORD)(ch2) << 16) | ((DWORD)(ch3) << 24 ))
@@ -20,7 +20,7 @@
 
 #include "vkd3d_shader_private.h"
 #include "vkd3d_d3d12.h"
-#include "rbtree.h"
+#include "hashmap.h"
 
 #include <stdarg.h>
 #include <stdio.h>
@@ -73,6 +73,8 @@ static enum vkd3d_shader_input_sysval_semantic vkd3d_siv_from_sysval(enum vkd3d_
 #define VKD3D_SPIRV_GENERATOR_VERSION 1
 #define VKD3D_SPIRV_GENERATOR_MAGIC ((VKD3D_SPIRV_GENERATOR_ID << 16) | VKD3D_SPIRV_GENERATOR_VERSION)
 
+#define VKD3D_DXBC_COMPILER_ARENA_BLOCK_SIZE (64 * 1024)
+
 struct vkd3d_spirv_stream
 {
     uint32_t *words;
@@ -102,13 +104,8 @@ struct vkd3d_spirv_chunk
 
 static void vkd3d_spirv_stream_clear(struct vkd3d_spirv_stream *stream)
 {
-    struct vkd3d_spirv_chunk *c1, *c2;
-
+    /* Inserted chunks are owned by the compiler arena. */
     stream->word_count = 0;
-
-    LIST_FOR_EACH_ENTRY_SAFE(c1, c2, &stream->inserted_chunks, struct vkd3d_spirv_chunk, entry)
-        vkd3d_free(c1);
-
     list_init(&stream->inserted_chunks);
 }
 
@@ -124,12 +121,12 @@ static size_t vkd3d_spirv_stream_current_location(struct vkd3d_spirv_stream *str
     return stream->word_count;
 }
 
-static void vkd3d_spirv_stream_insert(struct vkd3d_spirv_stream *stream,
+static void vkd3d_spirv_stream_insert(struct vkd3d_spirv_stream *stream, struct vkd3d_arena *arena,
         size_t location, const uint32_t *words, unsigned int word_count)
 {
     struct vkd3d_spirv_chunk *chunk, *current;
 
-    if (!(chunk = vkd3d_malloc(offsetof(struct vkd3d_spirv_chunk, words[word_count]))))
+    if (!(chunk = vkd3d_arena_alloc(arena, offsetof(struct vkd3d_spirv_chunk, words[word_count]))))
         return;
 
     chunk->location = location;
@@ -189,6 +186,8 @@ static bool vkd3d_spirv_stream_append(struct vkd3d_spirv_stream *dst_stream,
 
 struct vkd3d_spirv_builder
 {
+    struct vkd3d_arena *arena;
+
     SpvCapability *capabilities;
     size_t capabilities_size;
     size_t capability_count;
@@ -199,7 +198,7 @@ struct vkd3d_spirv_builder
 
     uint32_t current_id;
     uint32_t main_function_id;
-    struct rb_tree declarations;
+    struct hash_map declarations;
     uint32_t type_sampler_id;
     uint32_t type_bool_id;
     uint32_t type_void_id;
@@ -358,9 +357,11 @@ static uint32_t vkd3d_spirv_build_once(struct vkd3d_spirv_builder *builder,
 
 #define MAX_SPIRV_DECLARATION_PARAMETER_COUNT 7
 
+/* Declarations are stored inline in the hash map so that a lookup
+ * usually touches a single cache line. */
 struct vkd3d_spirv_declaration
 {
-    struct rb_entry entry;
+    struct hash_map_entry entry;
 
     SpvOp op;
     unsigned int parameter_count;
@@ -368,41 +369,45 @@ struct vkd3d_spirv_declaration
     uint32_t id;
 };
 
-static int vkd3d_spirv_declaration_compare(const void *key, const struct rb_entry *e)
+static uint32_t vkd3d_spirv_declaration_hash(const void *key)
+{
+    const struct vkd3d_spirv_declaration *d = key;
+    uint32_t hash;
+    unsigned int i;
+
+    hash = hash_combine(d->op, d->parameter_count);
+    for (i = 0; i < d->parameter_count; ++i)
+        hash = hash_combine(hash, d->parameters[i]);
+    return hash;
+}
+
+static bool vkd3d_spirv_declaration_compare(const void *key, const struct hash_map_entry *entry)
 {
     const struct vkd3d_spirv_declaration *a = key;
-    const struct vkd3d_spirv_declaration *b = RB_ENTRY_VALUE(e, const struct vkd3d_spirv_declaration, entry);
+    const struct vkd3d_spirv_declaration *b = (const struct vkd3d_spirv_declaration *)entry;
 
-    if (a->op != b->op)
-        return a->op - b->op;
-    if (a->parameter_count != b->parameter_count)
-        return a->parameter_count - b->parameter_count;
     assert(a->parameter_count <= ARRAY_SIZE(a->parameters));
-    return memcmp(&a->parameters, &b->parameters, a->parameter_count * sizeof(*a->parameters));
+    return a->op == b->op && a->parameter_count == b->parameter_count &&
+            !memcmp(&a->parameters, &b->parameters, a->parameter_count * sizeof(*a->parameters));
 }
 
-static void vkd3d_spirv_declaration_free(struct rb_entry *entry, void *context)
+static uint32_t vkd3d_spirv_find_declaration(struct vkd3d_spirv_builder *builder,
+        const struct vkd3d_spirv_declaration *declaration)
 {
-    struct vkd3d_spirv_declaration *d = RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry);
+    const struct vkd3d_spirv_declaration *d;
 
-    vkd3d_free(d);
+    if ((d = (const struct vkd3d_spirv_declaration *)hash_map_find(&builder->declarations, declaration)))
+        return d->id;
+    return 0;
 }
 
 static void vkd3d_spirv_insert_declaration(struct vkd3d_spirv_builder *builder,
         const struct vkd3d_spirv_declaration *declaration)
 {
-    struct vkd3d_spirv_declaration *d;
-
     assert(declaration->parameter_count <= ARRAY_SIZE(declaration->parameters));
 
-    if (!(d = vkd3d_malloc(sizeof(*d))))
-        return;
-    memcpy(d, declaration, sizeof(*d));
-    if (rb_put(&builder->declarations, d, &d->entry) == -1)
-    {
+    if (!hash_map_insert(&builder->declarations, declaration, &declaration->entry))
         ERR("Failed to insert declaration entry.\n");
-        vkd3d_free(d);
-    }
 }
 
 static uint32_t vkd3d_spirv_build_once_v(struct vkd3d_spirv_builder *builder,
@@ -411,7 +416,7 @@ static uint32_t vkd3d_spirv_build_once_v(struct vkd3d_spirv_builder *builder,
 {
     struct vkd3d_spirv_declaration declaration;
     unsigned int i, param_idx = 0;
-    struct rb_entry *entry;
+    uint32_t id;
 
     if (operand_count > ARRAY_SIZE(declaration.parameters))
     {
@@ -424,8 +429,8 @@ static uint32_t vkd3d_spirv_build_once_v(struct vkd3d_spirv_builder *builder,
         declaration.parameters[param_idx++] = operands[i];
     declaration.parameter_count = param_idx;
 
-    if ((entry = rb_get(&builder->declarations, &declaration)))
-        return RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry)->id;
+    if ((id = vkd3d_spirv_find_declaration(builder, &declaration)))
+        return id;
 
     declaration.id = build_pfn(builder, operands, operand_count);
     vkd3d_spirv_insert_declaration(builder, &declaration);
@@ -436,14 +441,14 @@ static uint32_t vkd3d_spirv_build_once1(struct vkd3d_spirv_builder *builder,
         SpvOp op, uint32_t operand0, vkd3d_spirv_build1_pfn build_pfn)
 {
     struct vkd3d_spirv_declaration declaration;
-    struct rb_entry *entry;
+    uint32_t id;
 
     declaration.op = op;
     declaration.parameter_count = 1;
     declaration.parameters[0] = operand0;
 
-    if ((entry = rb_get(&builder->declarations, &declaration)))
-        return RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry)->id;
+    if ((id = vkd3d_spirv_find_declaration(builder, &declaration)))
+        return id;
 
     declaration.id = build_pfn(builder, operand0);
     vkd3d_spirv_insert_declaration(builder, &declaration);
@@ -456,7 +461,7 @@ static uint32_t vkd3d_spirv_build_once1v(struct vkd3d_spirv_builder *builder,
 {
     struct vkd3d_spirv_declaration declaration;
     unsigned int i, param_idx = 0;
-    struct rb_entry *entry;
+    uint32_t id;
 
     if (operand_count >= ARRAY_SIZE(declaration.parameters))
     {
@@ -470,8 +475,8 @@ static uint32_t vkd3d_spirv_build_once1v(struct vkd3d_spirv_builder *builder,
         declaration.parameters[param_idx++] = operands[i];
     declaration.parameter_count = param_idx;
 
-    if ((entry = rb_get(&builder->declarations, &declaration)))
-        return RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry)->id;
+    if ((id = vkd3d_spirv_find_declaration(builder, &declaration)))
+        return id;
 
     declaration.id = build_pfn(builder, operand0, operands, operand_count);
     vkd3d_spirv_insert_declaration(builder, &declaration);
@@ -482,15 +487,15 @@ static uint32_t vkd3d_spirv_build_once2(struct vkd3d_spirv_builder *builder,
         SpvOp op, uint32_t operand0, uint32_t operand1, vkd3d_spirv_build2_pfn build_pfn)
 {
     struct vkd3d_spirv_declaration declaration;
-    struct rb_entry *entry;
+    uint32_t id;
 
     declaration.op = op;
     declaration.parameter_count = 2;
     declaration.parameters[0] = operand0;
     declaration.parameters[1] = operand1;
 
-    if ((entry = rb_get(&builder->declarations, &declaration)))
-        return RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry)->id;
+    if ((id = vkd3d_spirv_find_declaration(builder, &declaration)))
+        return id;
 
     declaration.id = build_pfn(builder, operand0, operand1);
     vkd3d_spirv_insert_declaration(builder, &declaration);
@@ -501,14 +506,14 @@ static uint32_t vkd3d_spirv_build_once7(struct vkd3d_spirv_builder *builder,
         SpvOp op, const uint32_t *operands, vkd3d_spirv_build7_pfn build_pfn)
 {
     struct vkd3d_spirv_declaration declaration;
-    struct rb_entry *entry;
+    uint32_t id;
 
     declaration.op = op;
     declaration.parameter_count = 7;
     memcpy(&declaration.parameters, operands, declaration.parameter_count * sizeof(*operands));
 
-    if ((entry = rb_get(&builder->declarations, &declaration)))
-        return RB_ENTRY_VALUE(entry, struct vkd3d_spirv_declaration, entry)->id;
+    if ((id = vkd3d_spirv_find_declaration(builder, &declaration)))
+        return id;
 
     declaration.id = build_pfn(builder, operands[0], operands[1], operands[2],
             operands[3], operands[4], operands[5], operands[6]);
@@ -709,7 +714,7 @@ static void vkd3d_spirv_end_function_stream_insertion(struct vkd3d_spirv_builder
     builder->insertion_stream = builder->function_stream;
     builder->function_stream = builder->original_function_stream;
 
-    vkd3d_spirv_stream_insert(&builder->function_stream, builder->insertion_location,
+    vkd3d_spirv_stream_insert(&builder->function_stream, builder->arena, builder->insertion_location,
             insertion_stream->words, insertion_stream->word_count);
     vkd3d_spirv_stream_clear(insertion_stream);
     builder->insertion_location = ~(size_t)0;
@@ -1731,8 +1736,10 @@ static void vkd3d_spirv_decompose_sparse_result(struct vkd3d_spirv_builder *buil
     *result_id = vkd3d_spirv_build_op_composite_extract1(builder, result_type, val_id, 1);
 }
 
-static void vkd3d_spirv_builder_init(struct vkd3d_spirv_builder *builder)
+static void vkd3d_spirv_builder_init(struct vkd3d_spirv_builder *builder, struct vkd3d_arena *arena)
 {
+    builder->arena = arena;
+
     vkd3d_spirv_stream_init(&builder->string_stream);
     vkd3d_spirv_stream_init(&builder->debug_stream);
     vkd3d_spirv_stream_init(&builder->annotation_stream);
@@ -1745,7 +1752,8 @@ static void vkd3d_spirv_builder_init(struct vkd3d_spirv_builder *builder)
 
     builder->current_id = 1;
 
-    rb_init(&builder->declarations, vkd3d_spirv_declaration_compare);
+    hash_map_init(&builder->declarations, &vkd3d_spirv_declaration_hash,
+            &vkd3d_spirv_declaration_compare, sizeof(struct vkd3d_spirv_declaration));
 
     builder->main_function_id = vkd3d_spirv_alloc_id(builder);
     vkd3d_spirv_build_op_name(builder, builder->main_function_id, "main");
@@ -1775,7 +1783,7 @@ static void vkd3d_spirv_builder_free(struct vkd3d_spirv_builder *builder)
 
     vkd3d_spirv_stream_free(&builder->insertion_stream);
 
-    rb_destroy(&builder->declarations, vkd3d_spirv_declaration_free, NULL);
+    hash_map_clear(&builder->declarations);
 
     vkd3d_free(builder->capabilities);
     vkd3d_free(builder->iface);
@@ -1999,8 +2007,6 @@ struct vkd3d_symbol_resource_data
 
 struct vkd3d_symbol
 {
-    struct rb_entry entry;
-
     enum
     {
         VKD3D_SYMBOL_REGISTER,
@@ -2029,41 +2035,50 @@ struct vkd3d_sm51_symbol_key
 
 struct vkd3d_sm51_symbol
 {
-    struct rb_entry entry;
+    struct hash_map_entry entry;
     struct vkd3d_sm51_symbol_key key;
     unsigned int register_space;
     unsigned int resource_idx;
 };
 
-static int vkd3d_symbol_compare(const void *key, const struct rb_entry *entry)
+/* Symbols are referenced by pointer and may be modified in place,
+ * so the hash map only stores a pointer to the arena allocation. */
+struct vkd3d_symbol_entry
 {
-    const struct vkd3d_symbol *a = key;
-    const struct vkd3d_symbol *b = RB_ENTRY_VALUE(entry, const struct vkd3d_symbol, entry);
+    struct hash_map_entry entry;
+    struct vkd3d_symbol *symbol;
+};
 
-    if (a->type != b->type)
-        return a->type - b->type;
-    return memcmp(&a->key, &b->key, sizeof(a->key));
+STATIC_ASSERT(sizeof(struct vkd3d_symbol_register) == sizeof(struct vkd3d_symbol_resource));
+
+static uint32_t vkd3d_symbol_hash(const void *key)
+{
+    const struct vkd3d_symbol *symbol = key;
+
+    return hash_combine(hash_combine(symbol->type, symbol->key.reg.type), symbol->key.reg.idx);
 }
 
-static int vkd3d_sm51_symbol_compare(const void *key, const struct rb_entry *entry)
+static bool vkd3d_symbol_compare(const void *key, const struct hash_map_entry *entry)
 {
-    const struct vkd3d_sm51_symbol_key *a = key;
-    const struct vkd3d_sm51_symbol *b = RB_ENTRY_VALUE(entry, const struct vkd3d_sm51_symbol, entry);
-    return memcmp(a, &b->key, sizeof(*a));
+    const struct vkd3d_symbol *a = key;
+    const struct vkd3d_symbol *b = ((const struct vkd3d_symbol_entry *)entry)->symbol;
+
+    return a->type == b->type && !memcmp(&a->key, &b->key, sizeof(a->key));
 }
 
-static void vkd3d_symbol_free(struct rb_entry *entry, void *context)
+static uint32_t vkd3d_sm51_symbol_hash(const void *key)
 {
-    struct vkd3d_symbol *s = RB_ENTRY_VALUE(entry, struct vkd3d_symbol, entry);
+    const struct vkd3d_sm51_symbol_key *k = key;
 
-    vkd3d_free(s);
+    return hash_combine(k->descriptor_type, k->idx);
 }
 
-static void vkd3d_sm51_symbol_free(struct rb_entry *entry, void *context)
+static bool vkd3d_sm51_symbol_compare(const void *key, const struct hash_map_entry *entry)
 {
-    struct vkd3d_sm51_symbol *s = RB_ENTRY_VALUE(entry, struct vkd3d_sm51_symbol, entry);
+    const struct vkd3d_sm51_symbol_key *a = key;
+    const struct vkd3d_sm51_symbol *b = (const struct vkd3d_sm51_symbol *)entry;
 
-    vkd3d_free(s);
+    return a->descriptor_type == b->key.descriptor_type && a->idx == b->key.idx;
 }
 
 static void vkd3d_symbol_make_register(struct vkd3d_symbol *symbol,
@@ -2103,11 +2118,11 @@ static void vkd3d_symbol_make_resource(struct vkd3d_symbol *symbol,
     symbol->key.resource.idx = reg->idx[0].offset;
 }
 
-static struct vkd3d_symbol *vkd3d_symbol_dup(const struct vkd3d_symbol *symbol)
+static struct vkd3d_symbol *vkd3d_symbol_dup(struct vkd3d_arena *arena, const struct vkd3d_symbol *symbol)
 {
     struct vkd3d_symbol *s;
 
-    if (!(s = vkd3d_malloc(sizeof(*s))))
+    if (!(s = vkd3d_arena_alloc(arena, sizeof(*s))))
         return NULL;
 
     return memcpy(s, symbol, sizeof(*s));
@@ -2241,16 +2256,20 @@ struct vkd3d_dxbc_compiler
     struct vkd3d_shader_version shader_version;
     struct vkd3d_spirv_builder spirv_builder;
 
+    /* Backing storage for symbols and inserted SPIR-V chunks,
+     * released in one go when the compiler is destroyed. */
+    struct vkd3d_arena arena;
+
     uint32_t options;
     uint32_t quirks;
 
-    struct rb_tree symbol_table;
+    struct hash_map symbol_table;
     uint32_t temp_id;
     unsigned int temp_count;
     struct vkd3d_hull_shader_variables hs;
     uint32_t sample_positions_id;
 
-    struct rb_tree sm51_resource_table;
+    struct hash_map sm51_resource_table;
 
     enum vkd3d_shader_type shader_type;
 
@@ -2355,6 +2374,7 @@ struct vkd3d_dxbc_compiler *vkd3d_dxbc_compiler_create(const struct vkd3d_shader
         return NULL;
 
     memset(compiler, 0, sizeof(*compiler));
+    vkd3d_arena_init(&compiler->arena, VKD3D_DXBC_COMPILER_ARENA_BLOCK_SIZE);
 
     compiler->shader_version = *shader_version;
     compiler->quirks = vkd3d_shader_compile_arguments_select_quirks(compile_args, shader_hash);
@@ -2369,11 +2389,13 @@ struct vkd3d_dxbc_compiler *vkd3d_dxbc_compiler_create(const struct vkd3d_shader
         return NULL;
     }
 
-    vkd3d_spirv_builder_init(&compiler->spirv_builder);
+    vkd3d_spirv_builder_init(&compiler->spirv_builder, &compiler->arena);
     compiler->options = compiler_options;
 
-    rb_init(&compiler->symbol_table, vkd3d_symbol_compare);
-    rb_init(&compiler->sm51_resource_table, vkd3d_sm51_symbol_compare);
+    hash_map_init(&compiler->symbol_table, &vkd3d_symbol_hash,
+            &vkd3d_symbol_compare, sizeof(struct vkd3d_symbol_entry));
+    hash_map_init(&compiler->sm51_resource_table, &vkd3d_sm51_symbol_hash,
+            &vkd3d_sm51_symbol_compare, sizeof(struct vkd3d_sm51_symbol));
 
     compiler->shader_type = shader_version->type;
 
@@ -2498,16 +2520,14 @@ static bool vkd3d_get_binding_info_for_register(
 {
     const struct vkd3d_sm51_symbol *symbol;
     struct vkd3d_sm51_symbol_key key;
-    const struct rb_entry *entry;
 
     if (shader_is_sm_5_1(compiler))
     {
         key.descriptor_type = vkd3d_shader_descriptor_type_from_register_type(reg->type);
         key.idx = reg->idx[0].offset;
-        entry = rb_get(&compiler->sm51_resource_table, &key);
-        if (entry)
+        symbol = (const struct vkd3d_sm51_symbol *)hash_map_find(&compiler->sm51_resource_table, &key);
+        if (symbol)
         {
-            symbol = RB_ENTRY_VALUE(entry, const struct vkd3d_sm51_symbol, entry);
             *reg_space = symbol->register_space;
             *reg_binding = symbol->resource_idx;
             return true;
@@ -2624,17 +2644,62 @@ static void vkd3d_dxbc_compiler_emit_descriptor_binding_for_reg(struct vkd3d_dxb
     vkd3d_dxbc_compiler_emit_descriptor_binding(compiler, variable_id, &binding);
 }
 
+static struct vkd3d_symbol *vkd3d_dxbc_compiler_find_symbol(const struct vkd3d_dxbc_compiler *compiler,
+        const struct vkd3d_symbol *key)
+{
+    const struct vkd3d_symbol_entry *e;
+
+    if ((e = (const struct vkd3d_symbol_entry *)hash_map_find(&compiler->symbol_table, key)))
+        return e->symbol;
+    return NULL;
+}
+
+static bool vkd3d_dxbc_compiler_insert_symbol(struct vkd3d_dxbc_compiler *compiler,
+        struct vkd3d_symbol *symbol)
+{
+    struct vkd3d_symbol_entry entry, *e;
+
+    entry.symbol = symbol;
+    if (!(e = (struct vkd3d_symbol_entry *)hash_map_insert(&compiler->symbol_table, symbol, &entry.entry)))
+        return false;
+    return e->symbol == symbol;
+}
+
+static struct vkd3d_symbol *vkd3d_dxbc_compiler_remove_symbol(struct vkd3d_dxbc_compiler *compiler,
+        const struct vkd3d_symbol *key)
+{
+    struct vkd3d_symbol_entry *e;
+    struct vkd3d_symbol *symbol;
+
+    if (!(e = (struct vkd3d_symbol_entry *)hash_map_find(&compiler->symbol_table, key)))
+        return NULL;
+
+    symbol = e->symbol;
+    hash_map_remove(&compiler->symbol_table, &e->entry);
+    return symbol;
+}
+
 static void vkd3d_dxbc_compiler_put_symbol(struct vkd3d_dxbc_compiler *compiler,
         const struct vkd3d_symbol *symbol)
 {
     struct vkd3d_symbol *s;
 
-    s = vkd3d_symbol_dup(symbol);
-    if (rb_put(&compiler->symbol_table, s, &s->entry) == -1)
-    {
+    if (!(s = vkd3d_symbol_dup(&compiler->arena, symbol)))
+        return;
+    if (!vkd3d_dxbc_compiler_insert_symbol(compiler, s))
         ERR("Failed to insert symbol entry (%s).\n", debug_vkd3d_symbol(symbol));
-        vkd3d_free(s);
-    }
+}
+
+static void vkd3d_dxbc_compiler_put_sm51_symbol(struct vkd3d_dxbc_compiler *compiler, unsigned int idx,
+        enum vkd3d_shader_descriptor_type descriptor_type, unsigned int register_space, unsigned int register_index)
+{
+    struct vkd3d_sm51_symbol sym;
+
+    sym.key.idx = idx;
+    sym.key.descriptor_type = descriptor_type;
+    sym.register_space = register_space;
+    sym.resource_idx = register_index;
+    hash_map_insert(&compiler->sm51_resource_table, &sym.key, &sym.entry);
 }
 
 static uint32_t vkd3d_dxbc_compiler_get_constant(struct vkd3d_dxbc_compiler *compiler,
@@ -3058,7 +3123,6 @@ static bool vkd3d_dxbc_compiler_find_register_info(const struct vkd3d_dxbc_compi
         const struct vkd3d_shader_register *reg, struct vkd3d_shader_register_info *register_info)
 {
     struct vkd3d_symbol reg_symbol, *symbol;
-    struct rb_entry *entry;
 
     assert(reg->type != VKD3DSPR_IMMCONST && reg->type != VKD3DSPR_IMMCONST64);
 
@@ -3079,13 +3143,11 @@ static bool vkd3d_dxbc_compiler_find_register_info(const struct vkd3d_dxbc_compi
     }
 
     vkd3d_symbol_make_register(&reg_symbol, reg);
-    if (!(entry = rb_get(&compiler->symbol_table, &reg_symbol)))
+    if (!(symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol)))
     {
         memset(register_info, 0, sizeof(*register_info));
         return false;
     }
-
-    symbol = RB_ENTRY_VALUE(entry, struct vkd3d_symbol, entry);
     register_info->id = symbol->id;
     register_info->storage_class = symbol->info.reg.storage_class;
     register_info->member_idx = symbol->info.reg.member_idx;
@@ -4565,7 +4627,7 @@ static uint32_t vkd3d_dxbc_compiler_emit_input(struct vkd3d_dxbc_compiler *compi
     struct vkd3d_symbol reg_symbol;
     struct vkd3d_symbol tmp_symbol;
     SpvStorageClass storage_class;
-    struct rb_entry *entry = NULL;
+    const struct vkd3d_symbol *symbol = NULL;
     bool use_private_var = false;
     unsigned int write_mask;
     unsigned int array_size;
@@ -4635,11 +4697,11 @@ static uint32_t vkd3d_dxbc_compiler_emit_input(struct vkd3d_dxbc_compiler *compi
     if (builtin)
     {
         input_id = vkd3d_dxbc_compiler_emit_builtin_variable(compiler, builtin, storage_class, array_size);
-        entry = rb_get(&compiler->symbol_table, &reg_symbol);
+        symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol);
     }
-    else if ((entry = rb_get(&compiler->symbol_table, &reg_symbol)))
+    else if ((symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol)))
     {
-        input_id = RB_ENTRY_VALUE(entry, const struct vkd3d_symbol, entry)->id;
+        input_id = symbol->id;
 
         if (use_private_var)
         {
@@ -4658,9 +4720,9 @@ static uint32_t vkd3d_dxbc_compiler_emit_input(struct vkd3d_dxbc_compiler *compi
             tmp_symbol = reg_symbol;
             tmp_symbol.key.reg.type = VKD3DSPR_INPUT;
 
-            if ((entry = rb_get(&compiler->symbol_table, &tmp_symbol)))
+            if ((symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &tmp_symbol)))
             {
-                tmp_symbol = *RB_ENTRY_VALUE(entry, const struct vkd3d_symbol, entry);
+                tmp_symbol = *symbol;
                 tmp_symbol.key.reg.type = VKD3DSPR_INCONTROLPOINT;
                 vkd3d_dxbc_compiler_put_symbol(compiler, &tmp_symbol);
 
@@ -4668,7 +4730,7 @@ static uint32_t vkd3d_dxbc_compiler_emit_input(struct vkd3d_dxbc_compiler *compi
             }
         }
 
-        if (!entry)
+        if (!symbol)
         {
             input_id = vkd3d_dxbc_compiler_get_io_variable(compiler, SpvStorageClassInput,
                     reg_idx, array_size, interpolation_mode, is_patch_constant,
@@ -4680,7 +4742,7 @@ static uint32_t vkd3d_dxbc_compiler_emit_input(struct vkd3d_dxbc_compiler *compi
     if (reg->type == VKD3DSPR_PATCHCONST && apply_patch_decoration)
         vkd3d_spirv_build_op_decorate(builder, input_id, SpvDecorationPatch, NULL, 0);
 
-    if (entry || !use_private_var)
+    if (symbol || !use_private_var)
     {
         var_id = input_id;
     }
@@ -4691,7 +4753,7 @@ static uint32_t vkd3d_dxbc_compiler_emit_input(struct vkd3d_dxbc_compiler *compi
                 storage_class, VKD3D_TYPE_FLOAT, component_count, array_size);
     }
 
-    if (!entry)
+    if (!symbol)
     {
         vkd3d_symbol_set_register_info(&reg_symbol, var_id, storage_class,
                 use_private_var ? VKD3D_TYPE_FLOAT : component_type, write_mask);
@@ -4759,7 +4821,6 @@ static void vkd3d_dxbc_compiler_emit_input_register(struct vkd3d_dxbc_compiler *
     struct vkd3d_symbol reg_symbol;
     SpvStorageClass storage_class;
     uint32_t input_id, var_id;
-    struct rb_entry *entry;
 
     assert(!reg->idx[0].rel_addr);
     assert(!reg->idx[1].rel_addr);
@@ -4776,7 +4837,7 @@ static void vkd3d_dxbc_compiler_emit_input_register(struct vkd3d_dxbc_compiler *
 
     /* vPrim may be declared in multiple hull shader phases. */
     vkd3d_symbol_make_register(&reg_symbol, reg);
-    if ((entry = rb_get(&compiler->symbol_table, &reg_symbol)))
+    if (vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol))
         return;
 
     input_id = vkd3d_dxbc_compiler_emit_builtin_variable(compiler, builtin, SpvStorageClassInput, 0);
@@ -5049,7 +5110,7 @@ static void vkd3d_dxbc_compiler_emit_output(struct vkd3d_dxbc_compiler *compiler
     bool apply_patch_decoration = true;
     struct vkd3d_symbol reg_symbol;
     SpvStorageClass storage_class;
-    struct rb_entry *entry = NULL;
+    const struct vkd3d_symbol *symbol = NULL;
     unsigned int signature_idx;
     bool use_private_variable;
     unsigned int write_mask;
@@ -5114,12 +5175,12 @@ static void vkd3d_dxbc_compiler_emit_output(struct vkd3d_dxbc_compiler *compiler
         {
             use_private_variable = true;
             write_mask = VKD3DSP_WRITEMASK_ALL;
-            entry = rb_get(&compiler->symbol_table, &reg_symbol);
+            symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol);
         }
     }
-    else if (!use_private_variable && (entry = rb_get(&compiler->symbol_table, &reg_symbol)))
+    else if (!use_private_variable && (symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol)))
     {
-        id = RB_ENTRY_VALUE(entry, const struct vkd3d_symbol, entry)->id;
+        id = symbol->id;
     }
     else
     {
@@ -5163,8 +5224,8 @@ static void vkd3d_dxbc_compiler_emit_output(struct vkd3d_dxbc_compiler *compiler
     if (use_private_variable)
         storage_class = SpvStorageClassPrivate;
 
-    if (entry || (entry = rb_get(&compiler->symbol_table, &reg_symbol)))
-        var_id = RB_ENTRY_VALUE(entry, const struct vkd3d_symbol, entry)->id;
+    if (symbol || (symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &reg_symbol)))
+        var_id = symbol->id;
     else if (!use_private_variable)
         var_id = id;
     else if (is_patch_constant)
@@ -5172,7 +5233,7 @@ static void vkd3d_dxbc_compiler_emit_output(struct vkd3d_dxbc_compiler *compiler
     else
         var_id = vkd3d_dxbc_compiler_emit_variable(compiler, &builder->global_stream,
                 storage_class, VKD3D_TYPE_FLOAT, VKD3D_VEC4_SIZE);
-    if (!entry)
+    if (!symbol)
     {
         vkd3d_symbol_set_register_info(&reg_symbol, var_id, storage_class,
                 use_private_variable ? VKD3D_TYPE_FLOAT : component_type, write_mask);
@@ -6393,14 +6454,9 @@ static void vkd3d_dxbc_compiler_emit_dcl_constant_buffer(struct vkd3d_dxbc_compi
 
     if (shader_is_sm_5_1(compiler))
     {
-        struct vkd3d_sm51_symbol *sym;
-        sym = vkd3d_calloc(1, sizeof(*sym));
-        sym->key.idx = reg->idx[0].offset;
-        sym->key.descriptor_type = VKD3D_SHADER_DESCRIPTOR_TYPE_CBV;
-        sym->register_space = instruction->declaration.cb.register_space;
-        sym->resource_idx = instruction->declaration.cb.register_index;
-        if (rb_put(&compiler->sm51_resource_table, &sym->key, &sym->entry) == -1)
-            vkd3d_free(sym);
+        vkd3d_dxbc_compiler_put_sm51_symbol(compiler, reg->idx[0].offset,
+                VKD3D_SHADER_DESCRIPTOR_TYPE_CBV,
+                instruction->declaration.cb.register_space, instruction->declaration.cb.register_index);
     }
 
     if ((push_cb = vkd3d_dxbc_compiler_find_push_constant_buffer(compiler, cb)))
@@ -6514,14 +6570,9 @@ static void vkd3d_dxbc_compiler_emit_dcl_sampler(struct vkd3d_dxbc_compiler *com
 
     if (shader_is_sm_5_1(compiler))
     {
-        struct vkd3d_sm51_symbol *sym;
-        sym = vkd3d_calloc(1, sizeof(*sym));
-        sym->key.idx = reg->idx[0].offset;
-        sym->key.descriptor_type = VKD3D_SHADER_DESCRIPTOR_TYPE_SAMPLER;
-        sym->register_space = instruction->declaration.sampler.register_space;
-        sym->resource_idx = instruction->declaration.sampler.register_index;
-        if (rb_put(&compiler->sm51_resource_table, &sym->key, &sym->entry) == -1)
-            vkd3d_free(sym);
+        vkd3d_dxbc_compiler_put_sm51_symbol(compiler, reg->idx[0].offset,
+                VKD3D_SHADER_DESCRIPTOR_TYPE_SAMPLER,
+                instruction->declaration.sampler.register_space, instruction->declaration.sampler.register_index);
     }
 
     binding = vkd3d_dxbc_compiler_get_resource_binding(compiler, reg,
@@ -6856,14 +6907,9 @@ static void vkd3d_dxbc_compiler_emit_dcl_resource(struct vkd3d_dxbc_compiler *co
 
     if (shader_is_sm_5_1(compiler))
     {
-        struct vkd3d_sm51_symbol *sym;
-        sym = vkd3d_calloc(1, sizeof(*sym));
-        sym->key.idx = semantic->reg.reg.idx[0].offset;
-        sym->key.descriptor_type = semantic->reg.reg.type == VKD3DSPR_UAV ? VKD3D_SHADER_DESCRIPTOR_TYPE_UAV : VKD3D_SHADER_DESCRIPTOR_TYPE_SRV;
-        sym->register_space = semantic->register_space;
-        sym->resource_idx = semantic->register_index;
-        if (rb_put(&compiler->sm51_resource_table, &sym->key, &sym->entry) == -1)
-            vkd3d_free(sym);
+        vkd3d_dxbc_compiler_put_sm51_symbol(compiler, semantic->reg.reg.idx[0].offset,
+                semantic->reg.reg.type == VKD3DSPR_UAV ? VKD3D_SHADER_DESCRIPTOR_TYPE_UAV : VKD3D_SHADER_DESCRIPTOR_TYPE_SRV,
+                semantic->register_space, semantic->register_index);
     }
 
     vkd3d_dxbc_compiler_emit_resource_declaration(compiler, instruction, &semantic->reg.reg,
@@ -6877,14 +6923,9 @@ static void vkd3d_dxbc_compiler_emit_dcl_resource_raw(struct vkd3d_dxbc_compiler
 
     if (shader_is_sm_5_1(compiler))
     {
-        struct vkd3d_sm51_symbol *sym;
-        sym = vkd3d_calloc(1, sizeof(*sym));
-        sym->key.idx = resource->dst.reg.idx[0].offset;
-        sym->key.descriptor_type = resource->dst.reg.type == VKD3DSPR_UAV ? VKD3D_SHADER_DESCRIPTOR_TYPE_UAV : VKD3D_SHADER_DESCRIPTOR_TYPE_SRV;
-        sym->register_space = resource->register_space;
-        sym->resource_idx = resource->register_index;
-        if (rb_put(&compiler->sm51_resource_table, &sym->key, &sym->entry) == -1)
-            vkd3d_free(sym);
+        vkd3d_dxbc_compiler_put_sm51_symbol(compiler, resource->dst.reg.idx[0].offset,
+                resource->dst.reg.type == VKD3DSPR_UAV ? VKD3D_SHADER_DESCRIPTOR_TYPE_UAV : VKD3D_SHADER_DESCRIPTOR_TYPE_SRV,
+                resource->register_space, resource->register_index);
     }
 
     vkd3d_dxbc_compiler_emit_resource_declaration(compiler, instruction, &resource->dst.reg,
@@ -6900,14 +6941,9 @@ static void vkd3d_dxbc_compiler_emit_dcl_resource_structured(struct vkd3d_dxbc_c
 
     if (shader_is_sm_5_1(compiler))
     {
-        struct vkd3d_sm51_symbol *sym;
-        sym = vkd3d_calloc(1, sizeof(*sym));
-        sym->key.idx = resource->reg.reg.idx[0].offset;
-        sym->key.descriptor_type = resource->reg.reg.type == VKD3DSPR_UAV ? VKD3D_SHADER_DESCRIPTOR_TYPE_UAV : VKD3D_SHADER_DESCRIPTOR_TYPE_SRV;
-        sym->register_space = resource->register_space;
-        sym->resource_idx = resource->register_index;
-        if (rb_put(&compiler->sm51_resource_table, &sym->key, &sym->entry) == -1)
-            vkd3d_free(sym);
+        vkd3d_dxbc_compiler_put_sm51_symbol(compiler, resource->reg.reg.idx[0].offset,
+                resource->reg.reg.type == VKD3DSPR_UAV ? VKD3D_SHADER_DESCRIPTOR_TYPE_UAV : VKD3D_SHADER_DESCRIPTOR_TYPE_SRV,
+                resource->register_space, resource->register_index);
     }
 
     vkd3d_dxbc_compiler_emit_resource_declaration(compiler, instruction, reg,
@@ -7243,7 +7279,6 @@ static void vkd3d_dxbc_compiler_leave_shader_phase(struct vkd3d_dxbc_compiler *c
     struct vkd3d_spirv_builder *builder = &compiler->spirv_builder;
     struct vkd3d_symbol reg_symbol, *symbol;
     struct vkd3d_shader_register reg;
-    struct rb_entry *entry;
     unsigned int i;
 
     vkd3d_spirv_build_op_function_end(builder);
@@ -7281,23 +7316,16 @@ static void vkd3d_dxbc_compiler_leave_shader_phase(struct vkd3d_dxbc_compiler *c
             reg.type = VKD3DSPR_OUTPUT;
             reg.idx[0].offset = e->register_index;
             vkd3d_symbol_make_register(&reg_symbol, &reg);
-            if ((entry = rb_get(&compiler->symbol_table, &reg_symbol)))
+            if ((symbol = vkd3d_dxbc_compiler_remove_symbol(compiler, &reg_symbol)))
             {
-                rb_remove(&compiler->symbol_table, entry);
-
-                symbol = RB_ENTRY_VALUE(entry, struct vkd3d_symbol, entry);
-
                 reg.type = VKD3DSPR_OUTCONTROLPOINT;
                 reg.idx[1].offset = reg.idx[0].offset;
                 reg.idx[0].offset = compiler->output_control_point_count;
                 vkd3d_symbol_make_register(symbol, &reg);
                 symbol->info.reg.is_aggregate = false;
 
-                if (rb_put(&compiler->symbol_table, symbol, entry) == -1)
-                {
+                if (!vkd3d_dxbc_compiler_insert_symbol(compiler, symbol))
                     ERR("Failed to insert vocp symbol entry (%s).\n", debug_vkd3d_symbol(symbol));
-                    vkd3d_symbol_free(entry, NULL);
-                }
             }
         }
     }
@@ -7317,11 +7345,7 @@ static void vkd3d_dxbc_compiler_leave_shader_phase(struct vkd3d_dxbc_compiler *c
             reg.idx[0].offset = e->register_index;
             vkd3d_symbol_make_register(&reg_symbol, &reg);
 
-            if ((entry = rb_get(&compiler->symbol_table, &reg_symbol)))
-            {
-                rb_remove(&compiler->symbol_table, entry);
-                vkd3d_symbol_free(entry, NULL);
-            }
+            vkd3d_dxbc_compiler_remove_symbol(compiler, &reg_symbol);
         }
     }
 
@@ -7330,11 +7354,7 @@ static void vkd3d_dxbc_compiler_leave_shader_phase(struct vkd3d_dxbc_compiler *c
         reg.type = phase->type == VKD3DSIH_HS_FORK_PHASE ? VKD3DSPR_FORKINSTID : VKD3DSPR_JOININSTID;
         reg.idx[0].offset = ~0u;
         vkd3d_symbol_make_register(&reg_symbol, &reg);
-        if ((entry = rb_get(&compiler->symbol_table, &reg_symbol)))
-        {
-            rb_remove(&compiler->symbol_table, entry);
-            vkd3d_symbol_free(entry, NULL);
-        }
+        vkd3d_dxbc_compiler_remove_symbol(compiler, &reg_symbol);
     }
 }
 
@@ -8819,13 +8839,13 @@ struct vkd3d_shader_image
 static const struct vkd3d_symbol *vkd3d_dxbc_compiler_find_resource(struct vkd3d_dxbc_compiler *compiler,
         const struct vkd3d_shader_register *resource_reg)
 {
+    const struct vkd3d_symbol *symbol;
     struct vkd3d_symbol resource_key;
-    struct rb_entry *entry;
 
     vkd3d_symbol_make_resource(&resource_key, resource_reg);
-    entry = rb_get(&compiler->symbol_table, &resource_key);
-    assert(entry);
-    return RB_ENTRY_VALUE(entry, struct vkd3d_symbol, entry);
+    symbol = vkd3d_dxbc_compiler_find_symbol(compiler, &resource_key);
+    assert(symbol);
+    return symbol;
 }
 
 static uint32_t vkd3d_dxbc_compiler_load_descriptor_table_offset(struct vkd3d_dxbc_compiler *compiler,
@@ -11159,8 +11179,8 @@ void vkd3d_dxbc_compiler_destroy(struct vkd3d_dxbc_compiler *compiler)
 
     vkd3d_spirv_builder_free(&compiler->spirv_builder);
 
-    rb_destroy(&compiler->symbol_table, vkd3d_symbol_free, NULL);
-    rb_destroy(&compiler->sm51_resource_table, vkd3d_sm51_symbol_free, NULL);
+    hash_map_clear(&compiler->symbol_table);
+    hash_map_clear(&compiler->sm51_resource_table);
 
     vkd3d_free(compiler->shader_phases);
     vkd3d_free(compiler->spec_constants);
@@ -11168,5 +11188,9 @@ void vkd3d_dxbc_compiler_destroy(struct vkd3d_dxbc_compiler *compiler)
     vkd3d_free(compiler->buffer_ref_types);
     vkd3d_free(compiler->root_descriptor_info);
 
+    TRACE("Compiler arena: %zu allocations, %zu bytes reserved.\n",
+            compiler->arena.allocation_count, compiler->arena.reserved_size);
+    vkd3d_arena_destroy(&compiler->arena);
+
     vkd3d_free(compiler);
 }
@@ -176,6 +176,9 @@ struct vkd3d_shader_parser
     struct vkd3d_shader_version shader_version;
     void *data;
     const DWORD *ptr;
+
+    /* Decoded once, shared by the scan and compile passes. */
+    struct vkd3d_shader_instruction_array instructions;
 };
 
 static int vkd3d_shader_parser_init(struct vkd3d_shader_parser *parser,
@@ -199,11 +202,23 @@ static int vkd3d_shader_parser_init(struct vkd3d_shader_parser *parser,
     }
 
     shader_sm4_read_header(parser->data, &parser->ptr, &parser->shader_version);
+
+    memset(&parser->instructions, 0, sizeof(parser->instructions));
+    if ((ret = shader_sm4_read_instructions(parser->data, &parser->ptr, &parser->instructions)) < 0)
+    {
+        WARN("Failed to decode shader, vkd3d result %d.\n", ret);
+        vkd3d_free(parser->instructions.elements);
+        shader_sm4_free(parser->data);
+        free_shader_desc(shader_desc);
+        return ret;
+    }
+
     return VKD3D_OK;
 }
 
 static void vkd3d_shader_parser_destroy(struct vkd3d_shader_parser *parser)
 {
+    vkd3d_free(parser->instructions.elements);
     shader_sm4_free(parser->data);
     free_shader_desc(&parser->shader_desc);
 }
@@ -319,16 +334,19 @@ static int vkd3d_shader_validate_shader_type(enum vkd3d_shader_type type, VkShad
     return 0;
 }
 
+static void vkd3d_shader_scan_instructions(struct vkd3d_shader_scan_info *scan_info,
+        const struct vkd3d_shader_instruction_array *instructions);
+
 int vkd3d_shader_compile_dxbc(const struct vkd3d_shader_code *dxbc,
         struct vkd3d_shader_code *spirv, unsigned int compiler_options,
         const struct vkd3d_shader_interface_info *shader_interface_info,
         const struct vkd3d_shader_compile_arguments *compile_args)
 {
-    struct vkd3d_shader_instruction instruction;
     struct vkd3d_dxbc_compiler *spirv_compiler;
     struct vkd3d_shader_scan_info scan_info;
     struct vkd3d_shader_parser parser;
     vkd3d_shader_hash_t hash;
+    size_t i;
     int ret;
 
     TRACE("dxbc {%p, %zu}, spirv %p, compiler_options %#x, shader_interface_info %p, compile_args %p.\n",
@@ -353,31 +371,23 @@ int vkd3d_shader_compile_dxbc(const struct vkd3d_shader_code *dxbc,
         return VKD3D_OK;
     }
 
-    vkd3d_shader_scan_init(&scan_info);
-
-    if ((ret = vkd3d_shader_scan_dxbc(dxbc, &scan_info)) < 0)
-    {
-        vkd3d_shader_scan_destroy(&scan_info);
-        return ret;
-    }
-
-    spirv->meta.patch_vertex_count = scan_info.patch_vertex_count;
-
     if ((ret = vkd3d_shader_parser_init(&parser, dxbc)) < 0)
-    {
-        vkd3d_shader_scan_destroy(&scan_info);
         return ret;
-    }
 
     if (shader_interface_info)
     {
         if ((ret = vkd3d_shader_validate_shader_type(parser.shader_version.type, shader_interface_info->stage)) < 0)
         {
-            vkd3d_shader_scan_destroy(&scan_info);
+            vkd3d_shader_parser_destroy(&parser);
             return ret;
         }
     }
 
+    vkd3d_shader_scan_init(&scan_info);
+    vkd3d_shader_scan_instructions(&scan_info, &parser.instructions);
+
+    spirv->meta.patch_vertex_count = scan_info.patch_vertex_count;
+
     vkd3d_shader_dump_shader(hash, dxbc, "dxbc");
 
     if (TRACE_ON())
@@ -393,20 +403,9 @@ int vkd3d_shader_compile_dxbc(const struct vkd3d_shader_code *dxbc,
         return VKD3D_ERROR;
     }
 
-    while (!shader_sm4_is_end(parser.data, &parser.ptr))
+    for (i = 0; i < parser.instructions.count; ++i)
     {
-        shader_sm4_read_instruction(parser.data, &parser.ptr, &instruction);
-
-        if (instruction.handler_idx == VKD3DSIH_INVALID)
-        {
-            WARN("Encountered unrecognized or invalid instruction.\n");
-            vkd3d_dxbc_compiler_destroy(spirv_compiler);
-            vkd3d_shader_scan_destroy(&scan_info);
-            vkd3d_shader_parser_destroy(&parser);
-            return VKD3D_ERROR_INVALID_ARGUMENT;
-        }
-
-        if ((ret = vkd3d_dxbc_compiler_handle_instruction(spirv_compiler, &instruction)) < 0)
+        if ((ret = vkd3d_dxbc_compiler_handle_instruction(spirv_compiler, &parser.instructions.elements[i])) < 0)
             break;
     }
 
@@ -565,10 +564,18 @@ static void vkd3d_shader_scan_instruction(struct vkd3d_shader_scan_info *scan_in
         vkd3d_shader_scan_record_uav_counter(scan_info, &instruction->src[0].reg);
 }
 
+static void vkd3d_shader_scan_instructions(struct vkd3d_shader_scan_info *scan_info,
+        const struct vkd3d_shader_instruction_array *instructions)
+{
+    size_t i;
+
+    for (i = 0; i < instructions->count; ++i)
+        vkd3d_shader_scan_instruction(scan_info, &instructions->elements[i]);
+}
+
 int vkd3d_shader_scan_dxbc(const struct vkd3d_shader_code *dxbc,
         struct vkd3d_shader_scan_info *scan_info)
 {
-    struct vkd3d_shader_instruction instruction;
     struct vkd3d_shader_parser parser;
     int ret;
 
@@ -584,20 +591,7 @@ int vkd3d_shader_scan_dxbc(const struct vkd3d_shader_code *dxbc,
         if ((ret = vkd3d_shader_parser_init(&parser, dxbc)) < 0)
             return ret;
 
-        while (!shader_sm4_is_end(parser.data, &parser.ptr))
-        {
-            shader_sm4_read_instruction(parser.data, &parser.ptr, &instruction);
-
-            if (instruction.handler_idx == VKD3DSIH_INVALID)
-            {
-                WARN("Encountered unrecognized or invalid instruction.\n");
-                vkd3d_shader_parser_destroy(&parser);
-                return VKD3D_ERROR_INVALID_ARGUMENT;
-            }
-
-            vkd3d_shader_scan_instruction(scan_info, &instruction);
-        }
-
+        vkd3d_shader_scan_instructions(scan_info, &parser.instructions);
         vkd3d_shader_parser_destroy(&parser);
         return VKD3D_OK;
     }
@@ -746,6 +746,13 @@ struct vkd3d_shader_instruction
     } declaration;
 };
 
+struct vkd3d_shader_instruction_array
+{
+    struct vkd3d_shader_instruction *elements;
+    size_t capacity;
+    size_t count;
+};
+
 static inline bool vkd3d_shader_instruction_has_texel_offset(const struct vkd3d_shader_instruction *ins)
 {
     return ins->texel_offset.u || ins->texel_offset.v || ins->texel_offset.w;
@@ -773,6 +780,8 @@ void shader_sm4_read_header(void *data, const DWORD **ptr,
 void shader_sm4_read_instruction(void *data, const DWORD **ptr,
         struct vkd3d_shader_instruction *ins);
 bool shader_sm4_is_end(void *data, const DWORD **ptr);
+int shader_sm4_read_instructions(void *data, const DWORD **ptr,
+        struct vkd3d_shader_instruction_array *instructions);
 
 int shader_extract_from_dxbc(const void *dxbc, size_t dxbc_length,
         struct vkd3d_shader_desc *desc);
@@ -20,40 +20,95 @@
 
 #include "vkd3d_private.h"
 
+enum d3d12_bundle_opcode
+{
+    VKD3D_BUNDLE_OP_END,
+    VKD3D_BUNDLE_OP_JUMP,
+    VKD3D_BUNDLE_OP_DRAW_INSTANCED,
+    VKD3D_BUNDLE_OP_DRAW_INDEXED_INSTANCED,
+    VKD3D_BUNDLE_OP_DISPATCH,
+    VKD3D_BUNDLE_OP_IA_SET_PRIMITIVE_TOPOLOGY,
+    VKD3D_BUNDLE_OP_OM_SET_BLEND_FACTOR,
+    VKD3D_BUNDLE_OP_OM_SET_STENCIL_REF,
+    VKD3D_BUNDLE_OP_SET_PIPELINE_STATE,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_SIGNATURE,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_SIGNATURE,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_32BIT_CONSTANT,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_32BIT_CONSTANT,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_32BIT_CONSTANTS,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_32BIT_CONSTANTS,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_CBV,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_CBV,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_SRV,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_SRV,
+    VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_UAV,
+    VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_UAV,
+    VKD3D_BUNDLE_OP_IA_SET_INDEX_BUFFER_NULL,
+    VKD3D_BUNDLE_OP_IA_SET_INDEX_BUFFER,
+    VKD3D_BUNDLE_OP_IA_SET_VERTEX_BUFFERS,
+    VKD3D_BUNDLE_OP_SET_MARKER,
+    VKD3D_BUNDLE_OP_BEGIN_EVENT,
+    VKD3D_BUNDLE_OP_END_EVENT,
+    VKD3D_BUNDLE_OP_EXECUTE_INDIRECT,
+    VKD3D_BUNDLE_OP_OM_SET_DEPTH_BOUNDS,
+    VKD3D_BUNDLE_OP_SET_SAMPLE_POSITIONS,
+    VKD3D_BUNDLE_OP_SET_VIEW_INSTANCE_MASK,
+    VKD3D_BUNDLE_OP_WRITE_BUFFER_IMMEDIATE,
+    VKD3D_BUNDLE_OP_SET_PIPELINE_STATE1,
+    VKD3D_BUNDLE_OP_DISPATCH_RAYS,
+    VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE,
+    VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE_BASE,
+    VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE_IMAGE,
+    VKD3D_BUNDLE_OP_DISPATCH_MESH,
+};
+
+static void d3d12_bundle_reset_state(struct d3d12_bundle *bundle)
+{
+    bundle->head = NULL;
+    bundle->tail = NULL;
+    memset(bundle->state, 0, sizeof(bundle->state));
+}
+
 /* ID3D12CommandAllocator */
 static inline struct d3d12_bundle_allocator *impl_from_ID3D12CommandAllocator(ID3D12CommandAllocator *iface)
 {
     return CONTAINING_RECORD(iface, struct d3d12_bundle_allocator, ID3D12CommandAllocator_iface);
 }
 
-static void *d3d12_bundle_allocator_alloc_chunk_data(struct d3d12_bundle_allocator *allocator, size_t size)
+static bool d3d12_bundle_allocator_has_chunk_space(struct d3d12_bundle_allocator *allocator, size_t size)
 {
-    size_t chunk_offset = 0;
-    void *chunk = NULL;
+    return allocator->chunks_count && allocator->chunk_offset + size <= allocator->chunk_size;
+}
 
-    size = align(size, VKD3D_BUNDLE_COMMAND_ALIGNMENT);
+static bool d3d12_bundle_allocator_add_chunk(struct d3d12_bundle_allocator *allocator, size_t min_size)
+{
+    size_t chunk_size = max(min_size, VKD3D_BUNDLE_CHUNK_SIZE);
+    void *chunk;
 
-    if (allocator->chunks_count)
-    {
-        chunk = allocator->chunks[allocator->chunks_count - 1];
-        chunk_offset = allocator->chunk_offset;
-    }
+    if (!vkd3d_array_reserve((void **)&allocator->chunks, &allocator->chunks_size,
+            allocator->chunks_count + 1, sizeof(*allocator->chunks)))
+        return false;
 
-    if (!chunk || chunk_offset + size > VKD3D_BUNDLE_CHUNK_SIZE)
-    {
-        if (!vkd3d_array_reserve((void **)&allocator->chunks, &allocator->chunks_size,
-                allocator->chunks_count + 1, sizeof(*allocator->chunks)))
-            return NULL;
+    if (!(chunk = vkd3d_malloc(chunk_size)))
+        return false;
 
-        if (!(chunk = vkd3d_malloc(VKD3D_BUNDLE_CHUNK_SIZE)))
-            return NULL;
+    allocator->chunks[allocator->chunks_count++] = chunk;
+    allocator->chunk_offset = 0;
+    allocator->chunk_size = chunk_size;
+    return true;
+}
 
-        allocator->chunks[allocator->chunks_count++] = chunk;
-        allocator->chunk_offset = chunk_offset = 0;
-    }
+static void *d3d12_bundle_allocator_alloc_chunk_data(struct d3d12_bundle_allocator *allocator, size_t size)
+{
+    void *data;
 
-    allocator->chunk_offset = chunk_offset + size;
-    return void_ptr_offset(chunk, chunk_offset);
+    assert(d3d12_bundle_allocator_has_chunk_space(allocator, size));
+
+    data = void_ptr_offset(allocator->chunks[allocator->chunks_count - 1], allocator->chunk_offset);
+    allocator->chunk_offset += size;
+    return data;
 }
 
 static void d3d12_bundle_allocator_free_chunks(struct d3d12_bundle_allocator *allocator)
@@ -68,6 +123,7 @@ static void d3d12_bundle_allocator_free_chunks(struct d3d12_bundle_allocator *al
     allocator->chunks_size = 0;
     allocator->chunks_count = 0;
     allocator->chunk_offset = 0;
+    allocator->chunk_size = 0;
 }
 
 static HRESULT STDMETHODCALLTYPE d3d12_bundle_allocator_QueryInterface(ID3D12CommandAllocator *iface,
@@ -172,8 +228,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_bundle_allocator_Reset(ID3D12CommandAlloc
             return E_FAIL;
         }
 
-        bundle->head = NULL;
-        bundle->tail = NULL;
+        d3d12_bundle_reset_state(bundle);
     }
 
     d3d12_bundle_allocator_free_chunks(allocator);
@@ -234,22 +289,105 @@ static inline struct d3d12_bundle *impl_from_ID3D12GraphicsCommandList(d3d12_com
     return CONTAINING_RECORD(iface, struct d3d12_bundle, ID3D12GraphicsCommandList_iface);
 }
 
-void *d3d12_bundle_add_command(struct d3d12_bundle *bundle, pfn_d3d12_bundle_command proc, size_t size)
+struct d3d12_bundle_jump_command
 {
-    struct d3d12_bundle_command *command = d3d12_bundle_allocator_alloc_chunk_data(bundle->allocator, size);
+    struct d3d12_bundle_command command;
+    struct d3d12_bundle_command *next;
+};
 
-    command->proc = proc;
-    command->next = NULL;
+static void d3d12_bundle_invalidate_state(struct d3d12_bundle *bundle,
+        enum d3d12_bundle_state_slot first_slot, unsigned int slot_count)
+{
+    memset(&bundle->state[first_slot], 0, sizeof(*bundle->state) * slot_count);
+}
 
-    if (bundle->tail)
-        bundle->tail->next = command;
-    else
+static void *d3d12_bundle_add_command(struct d3d12_bundle *bundle, enum d3d12_bundle_opcode opcode, size_t size)
+{
+    struct d3d12_bundle_allocator *allocator = bundle->allocator;
+    struct d3d12_bundle_jump_command *jump = NULL;
+    struct d3d12_bundle_command *command;
+
+    size = align(size, VKD3D_BUNDLE_COMMAND_ALIGNMENT);
+
+    /* Every chunk keeps enough space for a jump command at the end, so
+     * that the stream can continue in the next chunk when this one fills up. */
+    if (!d3d12_bundle_allocator_has_chunk_space(allocator, size + sizeof(*jump)))
+    {
+        if (bundle->tail)
+            jump = d3d12_bundle_allocator_alloc_chunk_data(allocator, sizeof(*jump));
+
+        if (!d3d12_bundle_allocator_add_chunk(allocator, size + sizeof(*jump)))
+        {
+            ERR("Failed to allocate bundle chunk.\n");
+            return NULL;
+        }
+    }
+
+    command = d3d12_bundle_allocator_alloc_chunk_data(allocator, size);
+    command->opcode = opcode;
+    command->size = size;
+
+    if (jump)
+    {
+        jump->command.opcode = VKD3D_BUNDLE_OP_JUMP;
+        jump->command.size = sizeof(*jump);
+        jump->next = command;
+    }
+
+    if (!bundle->head)
         bundle->head = command;
 
     bundle->tail = command;
     return command;
 }
 
+/* Records a state command of fixed size, unless it is redundant with the previous
+ * command in the same state slot. If the previous command is the last command in the
+ * stream, it is overwritten in place since nothing can observe the old state. The
+ * command header is filled in by this function, but padding within the payload must
+ * be zeroed by the caller so that commands can be compared. */
+static bool d3d12_bundle_add_state_command(struct d3d12_bundle *bundle,
+        enum d3d12_bundle_state_slot slot, enum d3d12_bundle_opcode opcode,
+        struct d3d12_bundle_command *args, size_t size)
+{
+    struct d3d12_bundle_command *command = bundle->state[slot];
+    size_t payload_size = size - sizeof(*args);
+
+    if (command && command->opcode == opcode && !memcmp(command + 1, args + 1, payload_size))
+        return false;
+
+    if (!command || command != bundle->tail || command->size != align(size, VKD3D_BUNDLE_COMMAND_ALIGNMENT))
+    {
+        if (!(command = d3d12_bundle_add_command(bundle, opcode, size)))
+            return false;
+    }
+
+    command->opcode = opcode;
+    memcpy(command + 1, args + 1, payload_size);
+
+    bundle->state[slot] = command;
+    return true;
+}
+
+static void d3d12_bundle_add_root_parameter_command(struct d3d12_bundle *bundle,
+        VkPipelineBindPoint bind_point, UINT parameter_index, enum d3d12_bundle_opcode opcode,
+        struct d3d12_bundle_command *args, size_t size)
+{
+    enum d3d12_bundle_state_slot slot = bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS
+            ? VKD3D_BUNDLE_STATE_GRAPHICS_ROOT_PARAMETERS
+            : VKD3D_BUNDLE_STATE_COMPUTE_ROOT_PARAMETERS;
+    struct d3d12_bundle_command *command;
+
+    if (parameter_index < D3D12_MAX_ROOT_COST)
+    {
+        d3d12_bundle_add_state_command(bundle, slot + parameter_index, opcode, args, size);
+    }
+    else if ((command = d3d12_bundle_add_command(bundle, opcode, size)))
+    {
+        memcpy(command + 1, args + 1, size - sizeof(*args));
+    }
+}
+
 static HRESULT STDMETHODCALLTYPE d3d12_bundle_QueryInterface(d3d12_command_list_iface *iface,
         REFIID iid, void **object)
 {
@@ -367,6 +505,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_bundle_Close(d3d12_command_list_iface *if
         return E_FAIL;
     }
 
+    /* Terminate the command stream so that replay does not need to check for the tail */
+    if (!d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_END, sizeof(struct d3d12_bundle_command)))
+        return E_OUTOFMEMORY;
+
     bundle->is_recording = false;
     return S_OK;
 }
@@ -400,8 +542,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_bundle_Reset(d3d12_command_list_iface *if
 
     bundle->is_recording = true;
     bundle->allocator = bundle_allocator;
-    bundle->head = NULL;
-    bundle->tail = NULL;
+    d3d12_bundle_reset_state(bundle);
 
     bundle_allocator->current_bundle = bundle;
 
@@ -426,14 +567,6 @@ struct d3d12_draw_instanced_command
     UINT first_instance;
 };
 
-static void d3d12_bundle_exec_draw_instanced(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_draw_instanced_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_DrawInstanced(list, args->vertex_count,
-            args->instance_count, args->first_vertex, args->first_instance);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_DrawInstanced(d3d12_command_list_iface *iface,
         UINT vertex_count_per_instance, UINT instance_count, UINT start_vertex_location,
         UINT start_instance_location)
@@ -446,7 +579,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_DrawInstanced(d3d12_command_list_ifac
             iface, vertex_count_per_instance, instance_count,
             start_vertex_location, start_instance_location);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_draw_instanced, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_DRAW_INSTANCED, sizeof(*args));
     args->vertex_count = vertex_count_per_instance;
     args->instance_count = instance_count;
     args->first_vertex = start_vertex_location;
@@ -463,15 +596,6 @@ struct d3d12_draw_indexed_instanced_command
     UINT first_instance;
 };
 
-static void d3d12_bundle_exec_draw_indexed_instanced(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_draw_indexed_instanced_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_DrawIndexedInstanced(list, args->index_count,
-            args->instance_count, args->first_index, args->vertex_offset,
-            args->first_instance);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_DrawIndexedInstanced(d3d12_command_list_iface *iface,
         UINT index_count_per_instance, UINT instance_count, UINT start_vertex_location,
         INT base_vertex_location, UINT start_instance_location)
@@ -484,7 +608,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_DrawIndexedInstanced(d3d12_command_li
             iface, index_count_per_instance, instance_count, start_vertex_location,
             base_vertex_location, start_instance_location);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_draw_indexed_instanced, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_DRAW_INDEXED_INSTANCED, sizeof(*args));
     args->index_count = index_count_per_instance;
     args->instance_count = instance_count;
     args->first_index = start_vertex_location;
@@ -498,13 +622,6 @@ struct d3d12_dispatch_command
     UINT x, y, z;
 };
 
-static void d3d12_bundle_exec_dispatch(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_dispatch_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_Dispatch(list, args->x, args->y, args->z);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_Dispatch(d3d12_command_list_iface *iface,
         UINT x, UINT y, UINT z)
 {
@@ -513,7 +630,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_Dispatch(d3d12_command_list_iface *if
 
     TRACE("iface %p, x %u, y %u, z %u.\n", iface, x, y, z);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_dispatch, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_DISPATCH, sizeof(*args));
     args->x = x;
     args->y = y;
     args->z = z;
@@ -566,23 +683,19 @@ struct d3d12_ia_set_primitive_topology_command
     D3D12_PRIMITIVE_TOPOLOGY topology;
 };
 
-static void d3d12_bundle_exec_ia_set_primitive_topology(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_ia_set_primitive_topology_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_IASetPrimitiveTopology(list, args->topology);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_IASetPrimitiveTopology(d3d12_command_list_iface *iface,
         D3D12_PRIMITIVE_TOPOLOGY topology)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_ia_set_primitive_topology_command *args;
+    struct d3d12_ia_set_primitive_topology_command args;
 
     TRACE("iface %p, topology %#x.\n", iface, topology);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_ia_set_primitive_topology, sizeof(*args));
-    args->topology = topology;
+    memset(&args, 0, sizeof(args));
+    args.topology = topology;
+
+    d3d12_bundle_add_state_command(bundle, VKD3D_BUNDLE_STATE_PRIMITIVE_TOPOLOGY,
+            VKD3D_BUNDLE_OP_IA_SET_PRIMITIVE_TOPOLOGY, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_RSSetViewports(d3d12_command_list_iface *iface,
@@ -603,26 +716,22 @@ struct d3d12_om_set_blend_factor_command
     FLOAT blend_factor[4];
 };
 
-static void d3d12_bundle_exec_om_set_blend_factor(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_om_set_blend_factor_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_OMSetBlendFactor(list, args->blend_factor);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_OMSetBlendFactor(d3d12_command_list_iface *iface,
         const FLOAT blend_factor[4])
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_om_set_blend_factor_command *args;
+    struct d3d12_om_set_blend_factor_command args;
     unsigned int i;
 
     TRACE("iface %p, blend_factor %p.\n", iface, blend_factor);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_om_set_blend_factor, sizeof(*args));
+    memset(&args, 0, sizeof(args));
 
     for (i = 0; i < 4; i++)
-        args->blend_factor[i] = blend_factor[i];
+        args.blend_factor[i] = blend_factor[i];
+
+    d3d12_bundle_add_state_command(bundle, VKD3D_BUNDLE_STATE_BLEND_FACTOR,
+            VKD3D_BUNDLE_OP_OM_SET_BLEND_FACTOR, &args.command, sizeof(args));
 }
 
 struct d3d12_om_set_stencil_ref_command
@@ -631,23 +740,19 @@ struct d3d12_om_set_stencil_ref_command
     UINT stencil_ref;
 };
 
-static void d3d12_bundle_exec_om_set_stencil_ref(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_om_set_stencil_ref_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_OMSetStencilRef(list, args->stencil_ref);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_OMSetStencilRef(d3d12_command_list_iface *iface,
         UINT stencil_ref)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_om_set_stencil_ref_command *args;
+    struct d3d12_om_set_stencil_ref_command args;
 
     TRACE("iface %p, stencil_ref %u.\n", iface, stencil_ref);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_om_set_stencil_ref, sizeof(*args));
-    args->stencil_ref = stencil_ref;
+    memset(&args, 0, sizeof(args));
+    args.stencil_ref = stencil_ref;
+
+    d3d12_bundle_add_state_command(bundle, VKD3D_BUNDLE_STATE_STENCIL_REF,
+            VKD3D_BUNDLE_OP_OM_SET_STENCIL_REF, &args.command, sizeof(args));
 }
 
 struct d3d12_set_pipeline_state_command
@@ -656,23 +761,19 @@ struct d3d12_set_pipeline_state_command
     ID3D12PipelineState *pipeline_state;
 };
 
-static void d3d12_bundle_exec_set_pipeline_state(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_pipeline_state_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetPipelineState(list, args->pipeline_state);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetPipelineState(d3d12_command_list_iface *iface,
         ID3D12PipelineState *pipeline_state)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_pipeline_state_command *args;
+    struct d3d12_set_pipeline_state_command args;
 
     TRACE("iface %p, pipeline_state %p.\n", iface, pipeline_state);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_pipeline_state, sizeof(*args));
-    args->pipeline_state = pipeline_state;
+    memset(&args, 0, sizeof(args));
+    args.pipeline_state = pipeline_state;
+
+    d3d12_bundle_add_state_command(bundle, VKD3D_BUNDLE_STATE_PIPELINE,
+            VKD3D_BUNDLE_OP_SET_PIPELINE_STATE, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_ResourceBarrier(d3d12_command_list_iface *iface,
@@ -700,42 +801,38 @@ struct d3d12_set_root_signature_command
     ID3D12RootSignature *root_signature;
 };
 
-static void d3d12_bundle_exec_set_compute_root_signature(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_signature_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetComputeRootSignature(list, args->root_signature);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootSignature(d3d12_command_list_iface *iface,
         ID3D12RootSignature *root_signature)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_signature_command *args;
+    struct d3d12_set_root_signature_command args;
 
     TRACE("iface %p, root_signature %p.\n", iface, root_signature);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_signature, sizeof(*args));
-    args->root_signature = root_signature;
-}
+    memset(&args, 0, sizeof(args));
+    args.root_signature = root_signature;
 
-static void d3d12_bundle_exec_set_graphics_root_signature(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_signature_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetGraphicsRootSignature(list, args->root_signature);
+    /* Changing the root signature invalidates all root parameters */
+    if (d3d12_bundle_add_state_command(bundle, VKD3D_BUNDLE_STATE_COMPUTE_ROOT_SIGNATURE,
+            VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_SIGNATURE, &args.command, sizeof(args)))
+        d3d12_bundle_invalidate_state(bundle, VKD3D_BUNDLE_STATE_COMPUTE_ROOT_PARAMETERS, D3D12_MAX_ROOT_COST);
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootSignature(d3d12_command_list_iface *iface,
         ID3D12RootSignature *root_signature)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_signature_command *args;
+    struct d3d12_set_root_signature_command args;
 
     TRACE("iface %p, root_signature %p.\n", iface, root_signature);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_signature, sizeof(*args));
-    args->root_signature = root_signature;
+    memset(&args, 0, sizeof(args));
+    args.root_signature = root_signature;
+
+    /* Changing the root signature invalidates all root parameters */
+    if (d3d12_bundle_add_state_command(bundle, VKD3D_BUNDLE_STATE_GRAPHICS_ROOT_SIGNATURE,
+            VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_SIGNATURE, &args.command, sizeof(args)))
+        d3d12_bundle_invalidate_state(bundle, VKD3D_BUNDLE_STATE_GRAPHICS_ROOT_PARAMETERS, D3D12_MAX_ROOT_COST);
 }
 
 struct d3d12_set_root_descriptor_table_command
@@ -745,46 +842,38 @@ struct d3d12_set_root_descriptor_table_command
     D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor;
 };
 
-static void d3d12_bundle_exec_set_compute_root_descriptor_table(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_table_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetComputeRootDescriptorTable(list, args->parameter_index, args->base_descriptor);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootDescriptorTable(d3d12_command_list_iface *iface,
         UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_table_command *args;
+    struct d3d12_set_root_descriptor_table_command args;
 
     TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
             iface, root_parameter_index, base_descriptor.ptr);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_descriptor_table, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->base_descriptor = base_descriptor;
-}
-
-static void d3d12_bundle_exec_set_graphics_root_descriptor_table(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_table_command *args = args_v;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.base_descriptor = base_descriptor;
 
-    ID3D12GraphicsCommandList6_SetGraphicsRootDescriptorTable(list, args->parameter_index, args->base_descriptor);
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_COMPUTE, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootDescriptorTable(d3d12_command_list_iface *iface,
         UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_table_command *args;
+    struct d3d12_set_root_descriptor_table_command args;
 
     TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
             iface, root_parameter_index, base_descriptor.ptr);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_descriptor_table, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->base_descriptor = base_descriptor;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.base_descriptor = base_descriptor;
+
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_GRAPHICS, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE, &args.command, sizeof(args));
 }
 
 struct d3d12_set_root_32bit_constant_command
@@ -795,13 +884,6 @@ struct d3d12_set_root_32bit_constant_command
     UINT offset;
 };
 
-static void d3d12_bundle_exec_set_compute_root_32bit_constant(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_32bit_constant_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetComputeRoot32BitConstant(list, args->parameter_index, args->data, args->offset);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstant(d3d12_command_list_iface *iface,
         UINT root_parameter_index, UINT data, UINT dst_offset)
 {
@@ -811,19 +893,12 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstant(d3d12_com
     TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
             iface, root_parameter_index, data, dst_offset);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_32bit_constant, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_32BIT_CONSTANT, sizeof(*args));
     args->parameter_index = root_parameter_index;
     args->data = data;
     args->offset = dst_offset;
 }
 
-static void d3d12_bundle_exec_set_graphics_root_32bit_constant(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_32bit_constant_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetGraphicsRoot32BitConstant(list, args->parameter_index, args->data, args->offset);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRoot32BitConstant(d3d12_command_list_iface *iface,
         UINT root_parameter_index, UINT data, UINT dst_offset)
 {
@@ -833,7 +908,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRoot32BitConstant(d3d12_co
     TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
             iface, root_parameter_index, data, dst_offset);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_32bit_constant, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_32BIT_CONSTANT, sizeof(*args));
     args->parameter_index = root_parameter_index;
     args->data = data;
     args->offset = dst_offset;
@@ -848,14 +923,6 @@ struct d3d12_set_root_32bit_constants_command
     UINT data[];
 };
 
-static void d3d12_bundle_exec_set_compute_root_32bit_constants(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_32bit_constants_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetComputeRoot32BitConstants(list, args->parameter_index,
-            args->constant_count, args->data, args->offset);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstants(d3d12_command_list_iface *iface,
         UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
 {
@@ -868,7 +935,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstants(d3d12_co
     if (!constant_count)
         return;
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_32bit_constants,
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_32BIT_CONSTANTS,
             sizeof(*args) + sizeof(UINT) * constant_count);
     args->parameter_index = root_parameter_index;
     args->constant_count = constant_count;
@@ -876,14 +943,6 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstants(d3d12_co
     memcpy(args->data, data, sizeof(UINT) * constant_count);
 }
 
-static void d3d12_bundle_exec_set_graphics_root_32bit_constants(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_32bit_constants_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetGraphicsRoot32BitConstants(list, args->parameter_index,
-            args->constant_count, args->data, args->offset);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRoot32BitConstants(d3d12_command_list_iface *iface,
         UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
 {
@@ -896,7 +955,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRoot32BitConstants(d3d12_c
     if (!constant_count)
         return;
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_32bit_constants,
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_32BIT_CONSTANTS,
             sizeof(*args) + sizeof(UINT) * constant_count);
     args->parameter_index = root_parameter_index;
     args->constant_count = constant_count;
@@ -911,130 +970,106 @@ struct d3d12_set_root_descriptor_command
     D3D12_GPU_VIRTUAL_ADDRESS address;
 };
 
-static void d3d12_bundle_exec_set_compute_root_cbv(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetComputeRootConstantBufferView(list, args->parameter_index, args->address);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootConstantBufferView(
         d3d12_command_list_iface *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_command *args;
+    struct d3d12_set_root_descriptor_command args;
 
     TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
             iface, root_parameter_index, address);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_cbv, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->address = address;
-}
-
-static void d3d12_bundle_exec_set_graphics_root_cbv(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_command *args = args_v;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.address = address;
 
-    ID3D12GraphicsCommandList6_SetGraphicsRootConstantBufferView(list, args->parameter_index, args->address);
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_COMPUTE, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_CBV, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootConstantBufferView(
         d3d12_command_list_iface *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_command *args;
+    struct d3d12_set_root_descriptor_command args;
 
     TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
             iface, root_parameter_index, address);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_cbv, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->address = address;
-}
-
-static void d3d12_bundle_exec_set_compute_root_srv(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_command *args = args_v;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.address = address;
 
-    ID3D12GraphicsCommandList6_SetComputeRootShaderResourceView(list, args->parameter_index, args->address);
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_GRAPHICS, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_CBV, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootShaderResourceView(
         d3d12_command_list_iface *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_command *args;
+    struct d3d12_set_root_descriptor_command args;
 
     TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
             iface, root_parameter_index, address);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_srv, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->address = address;
-}
-
-static void d3d12_bundle_exec_set_graphics_root_srv(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_command *args = args_v;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.address = address;
 
-    ID3D12GraphicsCommandList6_SetGraphicsRootShaderResourceView(list, args->parameter_index, args->address);
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_COMPUTE, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_SRV, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootShaderResourceView(
         d3d12_command_list_iface *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_command *args;
+    struct d3d12_set_root_descriptor_command args;
 
     TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
             iface, root_parameter_index, address);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_srv, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->address = address;
-}
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.address = address;
 
-static void d3d12_bundle_exec_set_compute_root_uav(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetComputeRootUnorderedAccessView(list, args->parameter_index, args->address);
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_GRAPHICS, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_SRV, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootUnorderedAccessView(
         d3d12_command_list_iface *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_command *args;
+    struct d3d12_set_root_descriptor_command args;
 
     TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
             iface, root_parameter_index, address);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_compute_root_uav, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->address = address;
-}
-
-static void d3d12_bundle_exec_set_graphics_root_uav(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_root_descriptor_command *args = args_v;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.address = address;
 
-    ID3D12GraphicsCommandList6_SetGraphicsRootUnorderedAccessView(list, args->parameter_index, args->address);
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_COMPUTE, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_UAV, &args.command, sizeof(args));
 }
 
 static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootUnorderedAccessView(
         d3d12_command_list_iface *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
-    struct d3d12_set_root_descriptor_command *args;
+    struct d3d12_set_root_descriptor_command args;
 
     TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
             iface, root_parameter_index, address);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_graphics_root_uav, sizeof(*args));
-    args->parameter_index = root_parameter_index;
-    args->address = address;
+    memset(&args, 0, sizeof(args));
+    args.parameter_index = root_parameter_index;
+    args.address = address;
+
+    d3d12_bundle_add_root_parameter_command(bundle, VK_PIPELINE_BIND_POINT_GRAPHICS, root_parameter_index,
+            VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_UAV, &args.command, sizeof(args));
 }
 
 struct d3d12_ia_set_index_buffer_command
@@ -1043,18 +1078,6 @@ struct d3d12_ia_set_index_buffer_command
     D3D12_INDEX_BUFFER_VIEW view;
 };
 
-static void d3d12_bundle_exec_ia_set_index_buffer_null(d3d12_command_list_iface *list, const void *args_v)
-{
-    ID3D12GraphicsCommandList6_IASetIndexBuffer(list, NULL);
-}
-
-static void d3d12_bundle_exec_ia_set_index_buffer(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_ia_set_index_buffer_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_IASetIndexBuffer(list, &args->view);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_IASetIndexBuffer(d3d12_command_list_iface *iface,
         const D3D12_INDEX_BUFFER_VIEW *view)
 {
@@ -1065,13 +1088,13 @@ static void STDMETHODCALLTYPE d3d12_bundle_IASetIndexBuffer(d3d12_command_list_i
     if (view)
     {
         struct d3d12_ia_set_index_buffer_command *args;
-        args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_ia_set_index_buffer, sizeof(*args));
+        args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_IA_SET_INDEX_BUFFER, sizeof(*args));
         args->view = *view;
     }
     else
     {
         /* Faithfully pass NULL to the command list during replay to avoid potential pitfalls */
-        d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_ia_set_index_buffer_null, sizeof(struct d3d12_bundle_command));
+        d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_IA_SET_INDEX_BUFFER_NULL, sizeof(struct d3d12_bundle_command));
     }
 }
 
@@ -1083,13 +1106,6 @@ struct d3d12_ia_set_vertex_buffers_command
     D3D12_VERTEX_BUFFER_VIEW views[];
 };
 
-static void d3d12_bundle_exec_ia_set_vertex_buffers(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_ia_set_vertex_buffers_command *args = args_v;
-
-    ID3D12GraphicsCommandList5_IASetVertexBuffers(list, args->start_slot, args->view_count, args->views);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_IASetVertexBuffers(d3d12_command_list_iface *iface,
         UINT start_slot, UINT view_count, const D3D12_VERTEX_BUFFER_VIEW *views)
 {
@@ -1101,7 +1117,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_IASetVertexBuffers(d3d12_command_list
     if (!view_count || !views)
         return;
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_ia_set_vertex_buffers,
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_IA_SET_VERTEX_BUFFERS,
             sizeof(*args) + sizeof(*views) * view_count);
     args->start_slot = start_slot;
     args->view_count = view_count;
@@ -1198,13 +1214,6 @@ struct d3d12_debug_marker_command
     char data[];
 };
 
-static void d3d12_bundle_exec_set_marker(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_debug_marker_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetMarker(list, args->metadata, args->data, args->data_size);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetMarker(d3d12_command_list_iface *iface,
         UINT metadata, const void *data, UINT size)
 {
@@ -1213,19 +1222,12 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetMarker(d3d12_command_list_iface *i
 
     TRACE("iface %p, metadata %u, data %p, size %u.\n", iface, metadata, data, size);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_marker, sizeof(*args) + size);
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_MARKER, sizeof(*args) + size);
     args->metadata = metadata;
     args->data_size = size;
     memcpy(args->data, data, size);
 }
 
-static void d3d12_bundle_exec_begin_event(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_debug_marker_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_BeginEvent(list, args->metadata, args->data, args->data_size);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_BeginEvent(d3d12_command_list_iface *iface,
         UINT metadata, const void *data, UINT size)
 {
@@ -1234,24 +1236,19 @@ static void STDMETHODCALLTYPE d3d12_bundle_BeginEvent(d3d12_command_list_iface *
 
     TRACE("iface %p, metadata %u, data %p, size %u.\n", iface, metadata, data, size);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_begin_event, sizeof(*args) + size);
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_BEGIN_EVENT, sizeof(*args) + size);
     args->metadata = metadata;
     args->data_size = size;
     memcpy(args->data, data, size);
 }
 
-static void d3d12_bundle_exec_end_event(d3d12_command_list_iface *list, const void *args_v)
-{
-    ID3D12GraphicsCommandList6_EndEvent(list);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_EndEvent(d3d12_command_list_iface *iface)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
 
     TRACE("iface %p.\n", iface);
 
-    d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_end_event, sizeof(struct d3d12_bundle_command));
+    d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_END_EVENT, sizeof(struct d3d12_bundle_command));
 }
 
 struct d3d12_execute_indirect_command
@@ -1265,14 +1262,6 @@ struct d3d12_execute_indirect_command
     UINT64 count_offset;
 };
 
-static void d3d12_bundle_exec_execute_indirect(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_execute_indirect_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_ExecuteIndirect(list, args->signature, args->max_count,
-            args->arg_buffer, args->arg_offset, args->count_buffer, args->count_offset);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_ExecuteIndirect(d3d12_command_list_iface *iface,
         ID3D12CommandSignature *command_signature, UINT max_command_count, ID3D12Resource *arg_buffer,
         UINT64 arg_buffer_offset, ID3D12Resource *count_buffer, UINT64 count_buffer_offset)
@@ -1285,7 +1274,10 @@ static void STDMETHODCALLTYPE d3d12_bundle_ExecuteIndirect(d3d12_command_list_if
             iface, command_signature, max_command_count, arg_buffer, arg_buffer_offset,
             count_buffer, count_buffer_offset);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_execute_indirect, sizeof(*args));
+    /* Indirect commands may modify vertex buffers, root arguments and other state */
+    d3d12_bundle_invalidate_state(bundle, 0, VKD3D_BUNDLE_STATE_COUNT);
+
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_EXECUTE_INDIRECT, sizeof(*args));
     args->signature = command_signature;
     args->max_count = max_command_count;
     args->arg_buffer = arg_buffer;
@@ -1327,13 +1319,6 @@ struct d3d12_om_set_depth_bounds_command
     FLOAT max;
 };
 
-static void d3d12_bundle_exec_om_set_depth_bounds(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_om_set_depth_bounds_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_OMSetDepthBounds(list, args->min, args->max);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_OMSetDepthBounds(d3d12_command_list_iface *iface,
         FLOAT min, FLOAT max)
 {
@@ -1342,7 +1327,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_OMSetDepthBounds(d3d12_command_list_i
 
     TRACE("iface %p, min %.8e, max %.8e.\n", iface, min, max);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_om_set_depth_bounds, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_OM_SET_DEPTH_BOUNDS, sizeof(*args));
     args->min = min;
     args->max = max;
 }
@@ -1355,15 +1340,6 @@ struct d3d12_set_sample_positions_command
     D3D12_SAMPLE_POSITION positions[];
 };
 
-static void d3d12_bundle_exec_set_sample_positions(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_sample_positions_command *args = args_v;
-
-    /* The sample position array is non-const but does not get written to */
-    ID3D12GraphicsCommandList6_SetSamplePositions(list, args->sample_count,
-            args->pixel_count, (D3D12_SAMPLE_POSITION*)args->positions);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetSamplePositions(d3d12_command_list_iface *iface,
         UINT sample_count, UINT pixel_count, D3D12_SAMPLE_POSITION *sample_positions)
 {
@@ -1374,7 +1350,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetSamplePositions(d3d12_command_list
     TRACE("iface %p, sample_count %u, pixel_count %u, sample_positions %p.\n",
             iface, sample_count, pixel_count, sample_positions);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_sample_positions,
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_SAMPLE_POSITIONS,
             sizeof(*args) + sizeof(*sample_positions) * array_size);
     args->sample_count = sample_count;
     args->pixel_count = pixel_count;
@@ -1399,13 +1375,6 @@ struct d3d12_set_view_instance_mask_command
     UINT mask;
 };
 
-static void d3d12_bundle_exec_set_view_instance_mask(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_view_instance_mask_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetViewInstanceMask(list, args->mask);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetViewInstanceMask(d3d12_command_list_iface *iface, UINT mask)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
@@ -1413,7 +1382,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetViewInstanceMask(d3d12_command_lis
 
     TRACE("iface %p, mask %#x.\n", iface, mask);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_view_instance_mask, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_VIEW_INSTANCE_MASK, sizeof(*args));
     args->mask = mask;
 }
 
@@ -1425,13 +1394,6 @@ struct d3d12_write_buffer_immediate_command
     D3D12_WRITEBUFFERIMMEDIATE_MODE *modes;
 };
 
-static void d3d12_bundle_exec_write_buffer_immediate(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_write_buffer_immediate_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_WriteBufferImmediate(list, args->count, args->parameters, args->modes);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_WriteBufferImmediate(d3d12_command_list_iface *iface,
         UINT count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER *parameters,
         const D3D12_WRITEBUFFERIMMEDIATE_MODE *modes)
@@ -1444,14 +1406,16 @@ static void STDMETHODCALLTYPE d3d12_bundle_WriteBufferImmediate(d3d12_command_li
     if (!count)
         return;
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_write_buffer_immediate, sizeof(*args));
+    /* Store parameters and modes inline, so that the command stream stays contiguous */
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_WRITE_BUFFER_IMMEDIATE,
+            sizeof(*args) + sizeof(*parameters) * count + (modes ? sizeof(*modes) * count : 0));
     args->count = count;
-    args->parameters = d3d12_bundle_allocator_alloc_chunk_data(bundle->allocator, sizeof(*parameters) * count);
+    args->parameters = void_ptr_offset(args, sizeof(*args));
     memcpy(args->parameters, parameters, sizeof(*parameters) * count);
 
     if (modes)
     {
-        args->modes = d3d12_bundle_allocator_alloc_chunk_data(bundle->allocator, sizeof(*modes) * count);
+        args->modes = void_ptr_offset(args->parameters, sizeof(*parameters) * count);
         memcpy(args->modes, modes, sizeof(*modes) * count);
     }
     else
@@ -1521,13 +1485,6 @@ struct d3d12_set_pipeline_state1_command
     ID3D12StateObject *state_object;
 };
 
-static void d3d12_bundle_exec_set_pipeline_state1(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_set_pipeline_state1_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_SetPipelineState1(list, args->state_object);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_SetPipelineState1(d3d12_command_list_iface *iface,
         ID3D12StateObject *state_object)
 {
@@ -1536,7 +1493,9 @@ static void STDMETHODCALLTYPE d3d12_bundle_SetPipelineState1(d3d12_command_list_
 
     TRACE("iface %p, state_object %p.\n", iface, state_object);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_set_pipeline_state1, sizeof(*args));
+    d3d12_bundle_invalidate_state(bundle, VKD3D_BUNDLE_STATE_PIPELINE, 1);
+
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_SET_PIPELINE_STATE1, sizeof(*args));
     args->state_object = state_object;
 }
 
@@ -1546,13 +1505,6 @@ struct d3d12_dispatch_rays_command
     D3D12_DISPATCH_RAYS_DESC desc;
 };
 
-static void d3d12_bundle_exec_dispatch_rays(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_dispatch_rays_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_DispatchRays(list, &args->desc);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_DispatchRays(d3d12_command_list_iface *iface,
         const D3D12_DISPATCH_RAYS_DESC *desc)
 {
@@ -1561,7 +1513,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_DispatchRays(d3d12_command_list_iface
 
     TRACE("iface %p, desc %p\n", iface, desc);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_dispatch_rays, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_DISPATCH_RAYS, sizeof(*args));
     args->desc = *desc;
 }
 
@@ -1572,20 +1524,6 @@ struct d3d12_rs_set_shading_rate_command
     D3D12_SHADING_RATE_COMBINER combiners[D3D12_RS_SET_SHADING_RATE_COMBINER_COUNT];
 };
 
-static void d3d12_bundle_exec_rs_set_shading_rate(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_rs_set_shading_rate_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_RSSetShadingRate(list, args->base, args->combiners);
-}
-
-static void d3d12_bundle_exec_rs_set_shading_rate_base(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_rs_set_shading_rate_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_RSSetShadingRate(list, args->base, NULL);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_RSSetShadingRate(d3d12_command_list_iface *iface,
         D3D12_SHADING_RATE base, const D3D12_SHADING_RATE_COMBINER *combiners)
 {
@@ -1595,8 +1533,8 @@ static void STDMETHODCALLTYPE d3d12_bundle_RSSetShadingRate(d3d12_command_list_i
     TRACE("iface %p, base %#x, combiners %p.\n", iface, base, combiners);
 
     args = d3d12_bundle_add_command(bundle, combiners
-            ? &d3d12_bundle_exec_rs_set_shading_rate
-            : &d3d12_bundle_exec_rs_set_shading_rate_base, sizeof(*args));
+            ? VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE
+            : VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE_BASE, sizeof(*args));
     args->base = base;
 
     if (combiners)
@@ -1609,13 +1547,6 @@ struct d3d12_rs_set_shading_rate_image_command
     ID3D12Resource *image;
 };
 
-static void d3d12_bundle_exec_rs_set_shading_rate_image(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_rs_set_shading_rate_image_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_RSSetShadingRateImage(list, args->image);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_RSSetShadingRateImage(d3d12_command_list_iface *iface,
         ID3D12Resource *image)
 {
@@ -1624,17 +1555,10 @@ static void STDMETHODCALLTYPE d3d12_bundle_RSSetShadingRateImage(d3d12_command_l
 
     TRACE("iface %p, image %p.\n", iface, image);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_rs_set_shading_rate_image, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE_IMAGE, sizeof(*args));
     args->image = image;
 }
 
-static void d3d12_bundle_exec_dispatch_mesh(d3d12_command_list_iface *list, const void *args_v)
-{
-    const struct d3d12_dispatch_command *args = args_v;
-
-    ID3D12GraphicsCommandList6_DispatchMesh(list, args->x, args->y, args->z);
-}
-
 static void STDMETHODCALLTYPE d3d12_bundle_DispatchMesh(d3d12_command_list_iface *iface, UINT x, UINT y, UINT z)
 {
     struct d3d12_bundle *bundle = impl_from_ID3D12GraphicsCommandList(iface);
@@ -1642,7 +1566,7 @@ static void STDMETHODCALLTYPE d3d12_bundle_DispatchMesh(d3d12_command_list_iface
 
     TRACE("iface %p, x %u, y %u, z %u.\n", iface, x, y, z);
 
-    args = d3d12_bundle_add_command(bundle, &d3d12_bundle_exec_dispatch_mesh, sizeof(*args));
+    args = d3d12_bundle_add_command(bundle, VKD3D_BUNDLE_OP_DISPATCH_MESH, sizeof(*args));
     args->x = x;
     args->y = y;
     args->z = z;
@@ -1771,10 +1695,340 @@ void d3d12_bundle_execute(struct d3d12_bundle *bundle, d3d12_command_list_iface
 {
     struct d3d12_bundle_command *command = bundle->head;
 
-    while (command)
+    if (bundle->is_recording)
+    {
+        WARN("Bundle %p is in the recording state.\n", bundle);
+        return;
+    }
+
+    if (!command)
+        return;
+
+    for (;;)
     {
-        command->proc(list, command);
-        command = command->next;
+        switch (command->opcode)
+        {
+            case VKD3D_BUNDLE_OP_END:
+                return;
+
+            case VKD3D_BUNDLE_OP_JUMP:
+                command = ((struct d3d12_bundle_jump_command *)command)->next;
+                continue;
+
+            case VKD3D_BUNDLE_OP_DRAW_INSTANCED:
+            {
+                const struct d3d12_draw_instanced_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_DrawInstanced(list, args->vertex_count,
+                        args->instance_count, args->first_vertex, args->first_instance);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_DRAW_INDEXED_INSTANCED:
+            {
+                const struct d3d12_draw_indexed_instanced_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_DrawIndexedInstanced(list, args->index_count,
+                        args->instance_count, args->first_index, args->vertex_offset,
+                        args->first_instance);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_DISPATCH:
+            {
+                const struct d3d12_dispatch_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_Dispatch(list, args->x, args->y, args->z);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_IA_SET_PRIMITIVE_TOPOLOGY:
+            {
+                const struct d3d12_ia_set_primitive_topology_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_IASetPrimitiveTopology(list, args->topology);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_OM_SET_BLEND_FACTOR:
+            {
+                const struct d3d12_om_set_blend_factor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_OMSetBlendFactor(list, args->blend_factor);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_OM_SET_STENCIL_REF:
+            {
+                const struct d3d12_om_set_stencil_ref_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_OMSetStencilRef(list, args->stencil_ref);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_PIPELINE_STATE:
+            {
+                const struct d3d12_set_pipeline_state_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetPipelineState(list, args->pipeline_state);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_SIGNATURE:
+            {
+                const struct d3d12_set_root_signature_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRootSignature(list, args->root_signature);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_SIGNATURE:
+            {
+                const struct d3d12_set_root_signature_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRootSignature(list, args->root_signature);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_DESCRIPTOR_TABLE:
+            {
+                const struct d3d12_set_root_descriptor_table_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRootDescriptorTable(list, args->parameter_index, args->base_descriptor);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE:
+            {
+                const struct d3d12_set_root_descriptor_table_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRootDescriptorTable(list, args->parameter_index, args->base_descriptor);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_32BIT_CONSTANT:
+            {
+                const struct d3d12_set_root_32bit_constant_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRoot32BitConstant(list, args->parameter_index, args->data, args->offset);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_32BIT_CONSTANT:
+            {
+                const struct d3d12_set_root_32bit_constant_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRoot32BitConstant(list, args->parameter_index, args->data, args->offset);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_32BIT_CONSTANTS:
+            {
+                const struct d3d12_set_root_32bit_constants_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRoot32BitConstants(list, args->parameter_index,
+                        args->constant_count, args->data, args->offset);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_32BIT_CONSTANTS:
+            {
+                const struct d3d12_set_root_32bit_constants_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRoot32BitConstants(list, args->parameter_index,
+                        args->constant_count, args->data, args->offset);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_CBV:
+            {
+                const struct d3d12_set_root_descriptor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRootConstantBufferView(list, args->parameter_index, args->address);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_CBV:
+            {
+                const struct d3d12_set_root_descriptor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRootConstantBufferView(list, args->parameter_index, args->address);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_SRV:
+            {
+                const struct d3d12_set_root_descriptor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRootShaderResourceView(list, args->parameter_index, args->address);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_SRV:
+            {
+                const struct d3d12_set_root_descriptor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRootShaderResourceView(list, args->parameter_index, args->address);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_COMPUTE_ROOT_UAV:
+            {
+                const struct d3d12_set_root_descriptor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetComputeRootUnorderedAccessView(list, args->parameter_index, args->address);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_GRAPHICS_ROOT_UAV:
+            {
+                const struct d3d12_set_root_descriptor_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetGraphicsRootUnorderedAccessView(list, args->parameter_index, args->address);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_IA_SET_INDEX_BUFFER_NULL:
+            {
+                ID3D12GraphicsCommandList6_IASetIndexBuffer(list, NULL);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_IA_SET_INDEX_BUFFER:
+            {
+                const struct d3d12_ia_set_index_buffer_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_IASetIndexBuffer(list, &args->view);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_IA_SET_VERTEX_BUFFERS:
+            {
+                const struct d3d12_ia_set_vertex_buffers_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList5_IASetVertexBuffers(list, args->start_slot, args->view_count, args->views);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_MARKER:
+            {
+                const struct d3d12_debug_marker_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetMarker(list, args->metadata, args->data, args->data_size);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_BEGIN_EVENT:
+            {
+                const struct d3d12_debug_marker_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_BeginEvent(list, args->metadata, args->data, args->data_size);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_END_EVENT:
+            {
+                ID3D12GraphicsCommandList6_EndEvent(list);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_EXECUTE_INDIRECT:
+            {
+                const struct d3d12_execute_indirect_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_ExecuteIndirect(list, args->signature, args->max_count,
+                        args->arg_buffer, args->arg_offset, args->count_buffer, args->count_offset);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_OM_SET_DEPTH_BOUNDS:
+            {
+                const struct d3d12_om_set_depth_bounds_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_OMSetDepthBounds(list, args->min, args->max);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_SAMPLE_POSITIONS:
+            {
+                const struct d3d12_set_sample_positions_command *args = (const void *)command;
+
+                /* The sample position array is non-const but does not get written to */
+                ID3D12GraphicsCommandList6_SetSamplePositions(list, args->sample_count,
+                        args->pixel_count, (D3D12_SAMPLE_POSITION*)args->positions);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_VIEW_INSTANCE_MASK:
+            {
+                const struct d3d12_set_view_instance_mask_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetViewInstanceMask(list, args->mask);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_WRITE_BUFFER_IMMEDIATE:
+            {
+                const struct d3d12_write_buffer_immediate_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_WriteBufferImmediate(list, args->count, args->parameters, args->modes);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_SET_PIPELINE_STATE1:
+            {
+                const struct d3d12_set_pipeline_state1_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_SetPipelineState1(list, args->state_object);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_DISPATCH_RAYS:
+            {
+                const struct d3d12_dispatch_rays_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_DispatchRays(list, &args->desc);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE:
+            {
+                const struct d3d12_rs_set_shading_rate_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_RSSetShadingRate(list, args->base, args->combiners);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE_BASE:
+            {
+                const struct d3d12_rs_set_shading_rate_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_RSSetShadingRate(list, args->base, NULL);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_RS_SET_SHADING_RATE_IMAGE:
+            {
+                const struct d3d12_rs_set_shading_rate_image_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_RSSetShadingRateImage(list, args->image);
+                break;
+            }
+
+            case VKD3D_BUNDLE_OP_DISPATCH_MESH:
+            {
+                const struct d3d12_dispatch_command *args = (const void *)command;
+
+                ID3D12GraphicsCommandList6_DispatchMesh(list, args->x, args->y, args->z);
+                break;
+            }
+
+            default:
+                ERR("Unhandled bundle opcode %u.\n", command->opcode);
+                return;
+        }
+
+        command = void_ptr_offset(command, command->size);
     }
 }
 
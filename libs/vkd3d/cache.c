@@ -742,3 +742,756 @@ HRESULT d3d12_pipeline_library_create(struct d3d12_device *device, const void *b
     *pipeline_library = object;
     return S_OK;
 }
+
+/* On-disk SPIR-V translation cache.
+ * Every entry lives in its own file named after the 64-bit cache key, so the cache
+ * is content-addressed and can be shared between processes without a central index.
+ * New entries are written to a temporary file first and then renamed into place,
+ * which is atomic, so concurrent readers either see a complete entry or nothing.
+ * The modification time of an entry is bumped on every hit, and is used as the LRU
+ * timestamp when the cache grows beyond its size limit. */
+#define VKD3D_SHADER_DISK_CACHE_MAGIC MAKE_MAGIC('V','K','S','C')
+#define VKD3D_SHADER_DISK_CACHE_VERSION 1
+#define VKD3D_SHADER_DISK_CACHE_DEFAULT_SIZE_MB 256
+
+struct vkd3d_shader_disk_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t vkd3d_build;
+    uint64_t dxbc_hash;
+    uint64_t spirv_hash;
+    uint32_t dxbc_size;
+    uint32_t spirv_size;
+    struct vkd3d_shader_meta meta;
+};
+STATIC_ASSERT(sizeof(struct vkd3d_shader_disk_cache_header) == 48 + sizeof(struct vkd3d_shader_meta));
+
+static uint64_t vkd3d_shader_disk_cache_hash_data(uint64_t h, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        h = hash_fnv1_iterate_u8(h, bytes[i]);
+    return h;
+}
+
+static uint64_t vkd3d_shader_disk_cache_hash_string(uint64_t h, const char *str)
+{
+    if (str)
+        h = vkd3d_shader_disk_cache_hash_data(h, str, strlen(str));
+    return hash_fnv1_iterate_u8(h, 0);
+}
+
+static uint64_t vkd3d_shader_disk_cache_hash_binding(uint64_t h, const struct vkd3d_shader_descriptor_binding *binding)
+{
+    if (!binding)
+        return hash_fnv1_iterate_u32(h, UINT32_MAX);
+
+    h = hash_fnv1_iterate_u32(h, binding->set);
+    h = hash_fnv1_iterate_u32(h, binding->binding);
+    return h;
+}
+
+static uint64_t vkd3d_shader_disk_cache_hash_interface(uint64_t h, const struct vkd3d_shader_interface_info *shader_interface)
+{
+    const struct vkd3d_shader_transform_feedback_info *xfb_info = shader_interface->xfb_info;
+    unsigned int i;
+
+    h = hash_fnv1_iterate_u32(h, shader_interface->flags);
+    h = hash_fnv1_iterate_u32(h, shader_interface->min_ssbo_alignment);
+    h = hash_fnv1_iterate_u32(h, shader_interface->descriptor_tables.offset);
+    h = hash_fnv1_iterate_u32(h, shader_interface->descriptor_tables.count);
+    h = hash_fnv1_iterate_u32(h, shader_interface->stage);
+
+    h = hash_fnv1_iterate_u32(h, shader_interface->binding_count);
+    for (i = 0; i < shader_interface->binding_count; i++)
+    {
+        const struct vkd3d_shader_resource_binding *binding = &shader_interface->bindings[i];
+        h = hash_fnv1_iterate_u32(h, binding->type);
+        h = hash_fnv1_iterate_u32(h, binding->register_space);
+        h = hash_fnv1_iterate_u32(h, binding->register_index);
+        h = hash_fnv1_iterate_u32(h, binding->register_count);
+        h = hash_fnv1_iterate_u32(h, binding->descriptor_table);
+        h = hash_fnv1_iterate_u32(h, binding->descriptor_offset);
+        h = hash_fnv1_iterate_u32(h, binding->shader_visibility);
+        h = hash_fnv1_iterate_u32(h, binding->flags);
+        h = vkd3d_shader_disk_cache_hash_binding(h, &binding->binding);
+    }
+
+    h = hash_fnv1_iterate_u32(h, shader_interface->push_constant_buffer_count);
+    for (i = 0; i < shader_interface->push_constant_buffer_count; i++)
+    {
+        const struct vkd3d_shader_push_constant_buffer *buffer = &shader_interface->push_constant_buffers[i];
+        h = hash_fnv1_iterate_u32(h, buffer->register_space);
+        h = hash_fnv1_iterate_u32(h, buffer->register_index);
+        h = hash_fnv1_iterate_u32(h, buffer->shader_visibility);
+        h = hash_fnv1_iterate_u32(h, buffer->offset);
+        h = hash_fnv1_iterate_u32(h, buffer->size);
+    }
+
+    h = vkd3d_shader_disk_cache_hash_binding(h, shader_interface->push_constant_ubo_binding);
+    h = vkd3d_shader_disk_cache_hash_binding(h, shader_interface->offset_buffer_binding);
+#ifdef VKD3D_ENABLE_DESCRIPTOR_QA
+    h = vkd3d_shader_disk_cache_hash_binding(h, shader_interface->descriptor_qa_global_binding);
+    h = vkd3d_shader_disk_cache_hash_binding(h, shader_interface->descriptor_qa_heap_binding);
+#endif
+
+    if (xfb_info)
+    {
+        h = hash_fnv1_iterate_u32(h, xfb_info->element_count);
+        for (i = 0; i < xfb_info->element_count; i++)
+        {
+            const struct vkd3d_shader_transform_feedback_element *e = &xfb_info->elements[i];
+            h = hash_fnv1_iterate_u32(h, e->stream_index);
+            h = vkd3d_shader_disk_cache_hash_string(h, e->semantic_name);
+            h = hash_fnv1_iterate_u32(h, e->semantic_index);
+            h = hash_fnv1_iterate_u8(h, e->component_index);
+            h = hash_fnv1_iterate_u8(h, e->component_count);
+            h = hash_fnv1_iterate_u8(h, e->output_slot);
+        }
+
+        h = hash_fnv1_iterate_u32(h, xfb_info->buffer_stride_count);
+        for (i = 0; i < xfb_info->buffer_stride_count; i++)
+            h = hash_fnv1_iterate_u32(h, xfb_info->buffer_strides[i]);
+    }
+    else
+        h = hash_fnv1_iterate_u32(h, UINT32_MAX);
+
+    return h;
+}
+
+static uint64_t vkd3d_shader_disk_cache_hash_compile_args(uint64_t h, const struct vkd3d_shader_compile_arguments *args)
+{
+    unsigned int i;
+
+    if (!args)
+        return hash_fnv1_iterate_u32(h, UINT32_MAX);
+
+    h = hash_fnv1_iterate_u32(h, args->target);
+
+    h = hash_fnv1_iterate_u32(h, args->target_extension_count);
+    for (i = 0; i < args->target_extension_count; i++)
+        h = hash_fnv1_iterate_u32(h, args->target_extensions[i]);
+
+    h = hash_fnv1_iterate_u32(h, args->parameter_count);
+    for (i = 0; i < args->parameter_count; i++)
+    {
+        h = hash_fnv1_iterate_u32(h, args->parameters[i].name);
+        h = hash_fnv1_iterate_u32(h, args->parameters[i].type);
+        h = hash_fnv1_iterate_u32(h, args->parameters[i].data_type);
+        /* Both union members are a single 32-bit word. */
+        h = hash_fnv1_iterate_u32(h, args->parameters[i].immediate_constant.u32);
+    }
+
+    h = hash_fnv1_iterate_u8(h, args->dual_source_blending);
+
+    h = hash_fnv1_iterate_u32(h, args->output_swizzle_count);
+    for (i = 0; i < args->output_swizzle_count; i++)
+        h = hash_fnv1_iterate_u32(h, args->output_swizzles[i]);
+
+    /* Quirks are resolved from the global quirk table, which is part of the shader interface key. */
+    return h;
+}
+
+uint64_t vkd3d_shader_disk_cache_compute_key(struct d3d12_device *device,
+        const struct vkd3d_shader_code *dxbc, const struct vkd3d_shader_interface_info *shader_interface,
+        const struct vkd3d_shader_compile_arguments *compile_args)
+{
+    uint64_t h = hash_fnv1_init();
+
+    h = hash_fnv1_iterate_u64(h, vkd3d_build);
+    h = hash_fnv1_iterate_u64(h, vkd3d_shader_get_revision());
+    h = hash_fnv1_iterate_u64(h, device->shader_interface_key);
+    h = hash_fnv1_iterate_u64(h, vkd3d_shader_hash(dxbc));
+    h = hash_fnv1_iterate_u64(h, dxbc->size);
+    h = vkd3d_shader_disk_cache_hash_interface(h, shader_interface);
+    h = vkd3d_shader_disk_cache_hash_compile_args(h, compile_args);
+    return h;
+}
+
+struct vkd3d_shader_disk_cache_file
+{
+    char name[32];
+    uint64_t mtime;
+    uint64_t size;
+};
+
+static bool vkd3d_shader_disk_cache_is_entry_name(const char *name)
+{
+    size_t len = strlen(name);
+    return len == 16 + 4 && !strcmp(name + 16, ".spv");
+}
+
+static void vkd3d_shader_disk_cache_get_entry_path(const struct vkd3d_shader_disk_cache *cache,
+        uint64_t key, char path[VKD3D_PATH_MAX])
+{
+    snprintf(path, VKD3D_PATH_MAX, "%s/%016"PRIx64".spv", cache->path, key);
+}
+
+/* Platform layer. Everything below the platform layer only deals with paths,
+ * mapped entries and opaque lock handles. */
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+struct vkd3d_shader_disk_cache_mapping
+{
+    const uint8_t *data;
+    size_t size;
+    int fd;
+};
+
+typedef int vkd3d_shader_disk_cache_lock_t;
+
+static bool vkd3d_shader_disk_cache_create_directory(const char *path)
+{
+    if (mkdir(path, 0755) < 0 && errno != EEXIST)
+    {
+        ERR("Failed to create shader cache directory %s, errno %d.\n", path, errno);
+        return false;
+    }
+
+    return true;
+}
+
+static bool vkd3d_shader_disk_cache_enumerate(const struct vkd3d_shader_disk_cache *cache,
+        void (*callback)(void *userdata, const char *name, uint64_t mtime, uint64_t size), void *userdata)
+{
+    char path[VKD3D_PATH_MAX];
+    struct dirent *dirent;
+    struct stat st;
+    DIR *dir;
+
+    if (!(dir = opendir(cache->path)))
+        return false;
+
+    while ((dirent = readdir(dir)))
+    {
+        if (!vkd3d_shader_disk_cache_is_entry_name(dirent->d_name))
+            continue;
+
+        snprintf(path, sizeof(path), "%s/%s", cache->path, dirent->d_name);
+        if (stat(path, &st) < 0)
+            continue;
+
+        callback(userdata, dirent->d_name, st.st_mtime, st.st_size);
+    }
+
+    closedir(dir);
+    return true;
+}
+
+static bool vkd3d_shader_disk_cache_try_lock(const struct vkd3d_shader_disk_cache *cache,
+        vkd3d_shader_disk_cache_lock_t *lock)
+{
+    char path[VKD3D_PATH_MAX];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/.lock", cache->path);
+    if ((fd = open(path, O_RDWR | O_CREAT, 0644)) < 0)
+        return false;
+
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    *lock = fd;
+    return true;
+}
+
+static void vkd3d_shader_disk_cache_unlock(vkd3d_shader_disk_cache_lock_t lock)
+{
+    flock(lock, LOCK_UN);
+    close(lock);
+}
+
+static bool vkd3d_shader_disk_cache_delete_file(const char *path)
+{
+    return !unlink(path);
+}
+
+static bool vkd3d_shader_disk_cache_map_entry(const char *path, struct vkd3d_shader_disk_cache_mapping *mapping)
+{
+    void *data;
+    struct stat st;
+
+    if ((mapping->fd = open(path, O_RDONLY)) < 0)
+        return false;
+
+    if (fstat(mapping->fd, &st) < 0 || !st.st_size)
+        goto fail;
+
+    if ((data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, mapping->fd, 0)) == MAP_FAILED)
+        goto fail;
+
+    mapping->data = data;
+    mapping->size = st.st_size;
+    return true;
+
+fail:
+    close(mapping->fd);
+    return false;
+}
+
+static void vkd3d_shader_disk_cache_touch_entry(struct vkd3d_shader_disk_cache_mapping *mapping)
+{
+    futimens(mapping->fd, NULL);
+}
+
+static void vkd3d_shader_disk_cache_unmap_entry(struct vkd3d_shader_disk_cache_mapping *mapping)
+{
+    munmap((void *)mapping->data, mapping->size);
+    close(mapping->fd);
+}
+
+static unsigned int vkd3d_shader_disk_cache_get_process_id(void)
+{
+    return getpid();
+}
+
+static bool vkd3d_shader_disk_cache_write_entry(const char *tmp_path, const char *path,
+        const struct vkd3d_shader_disk_cache_header *header, const void *code, size_t code_size)
+{
+    int fd;
+
+    if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+        WARN("Failed to create shader cache entry %s, errno %d.\n", tmp_path, errno);
+        return false;
+    }
+
+    if (write(fd, header, sizeof(*header)) != (ssize_t)sizeof(*header) ||
+            write(fd, code, code_size) != (ssize_t)code_size)
+    {
+        WARN("Failed to write shader cache entry %s, errno %d.\n", tmp_path, errno);
+        close(fd);
+        unlink(tmp_path);
+        return false;
+    }
+
+    close(fd);
+
+    /* Another process may have raced us to store the same entry,
+     * which is fine since the contents are identical. */
+    if (rename(tmp_path, path) < 0)
+    {
+        WARN("Failed to publish shader cache entry %s, errno %d.\n", path, errno);
+        unlink(tmp_path);
+        return false;
+    }
+
+    return true;
+}
+#else
+struct vkd3d_shader_disk_cache_mapping
+{
+    const uint8_t *data;
+    size_t size;
+    HANDLE file;
+    HANDLE mapping;
+};
+
+typedef HANDLE vkd3d_shader_disk_cache_lock_t;
+
+static uint64_t vkd3d_shader_disk_cache_file_time(const FILETIME *time)
+{
+    return ((uint64_t)time->dwHighDateTime << 32) | time->dwLowDateTime;
+}
+
+static bool vkd3d_shader_disk_cache_create_directory(const char *path)
+{
+    if (!CreateDirectoryA(path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        ERR("Failed to create shader cache directory %s, error %lu.\n", path, GetLastError());
+        return false;
+    }
+
+    return true;
+}
+
+static bool vkd3d_shader_disk_cache_enumerate(const struct vkd3d_shader_disk_cache *cache,
+        void (*callback)(void *userdata, const char *name, uint64_t mtime, uint64_t size), void *userdata)
+{
+    char pattern[VKD3D_PATH_MAX];
+    WIN32_FIND_DATAA data;
+    HANDLE find;
+
+    snprintf(pattern, sizeof(pattern), "%s/*.spv", cache->path);
+    if ((find = FindFirstFileA(pattern, &data)) == INVALID_HANDLE_VALUE)
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+
+    do
+    {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        if (!vkd3d_shader_disk_cache_is_entry_name(data.cFileName))
+            continue;
+
+        callback(userdata, data.cFileName, vkd3d_shader_disk_cache_file_time(&data.ftLastWriteTime),
+                ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow);
+    } while (FindNextFileA(find, &data));
+
+    FindClose(find);
+    return true;
+}
+
+static bool vkd3d_shader_disk_cache_try_lock(const struct vkd3d_shader_disk_cache *cache,
+        vkd3d_shader_disk_cache_lock_t *lock)
+{
+    char path[VKD3D_PATH_MAX];
+    HANDLE file;
+
+    /* Opening without sharing makes the handle itself the lock. */
+    snprintf(path, sizeof(path), "%s/.lock", cache->path);
+    file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    *lock = file;
+    return true;
+}
+
+static void vkd3d_shader_disk_cache_unlock(vkd3d_shader_disk_cache_lock_t lock)
+{
+    CloseHandle(lock);
+}
+
+static bool vkd3d_shader_disk_cache_delete_file(const char *path)
+{
+    return DeleteFileA(path);
+}
+
+static bool vkd3d_shader_disk_cache_map_entry(const char *path, struct vkd3d_shader_disk_cache_mapping *mapping)
+{
+    LARGE_INTEGER size;
+
+    /* Write access is only needed to refresh the LRU timestamp. Allow other processes
+     * to replace or delete the entry while it is mapped. */
+    mapping->file = CreateFileA(path, GENERIC_READ | FILE_WRITE_ATTRIBUTES,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapping->file == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (!GetFileSizeEx(mapping->file, &size) || !size.QuadPart || (uint64_t)size.QuadPart > SIZE_MAX)
+        goto fail_close;
+
+    if (!(mapping->mapping = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL)))
+        goto fail_close;
+
+    if (!(mapping->data = MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0)))
+        goto fail_close_mapping;
+
+    mapping->size = size.QuadPart;
+    return true;
+
+fail_close_mapping:
+    CloseHandle(mapping->mapping);
+fail_close:
+    CloseHandle(mapping->file);
+    return false;
+}
+
+static void vkd3d_shader_disk_cache_touch_entry(struct vkd3d_shader_disk_cache_mapping *mapping)
+{
+    FILETIME now;
+
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(mapping->file, NULL, NULL, &now);
+}
+
+static void vkd3d_shader_disk_cache_unmap_entry(struct vkd3d_shader_disk_cache_mapping *mapping)
+{
+    UnmapViewOfFile(mapping->data);
+    CloseHandle(mapping->mapping);
+    CloseHandle(mapping->file);
+}
+
+static unsigned int vkd3d_shader_disk_cache_get_process_id(void)
+{
+    return GetCurrentProcessId();
+}
+
+static bool vkd3d_shader_disk_cache_write_entry(const char *tmp_path, const char *path,
+        const struct vkd3d_shader_disk_cache_header *header, const void *code, size_t code_size)
+{
+    DWORD written;
+    HANDLE file;
+
+    file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create shader cache entry %s, error %lu.\n", tmp_path, GetLastError());
+        return false;
+    }
+
+    if (!WriteFile(file, header, sizeof(*header), &written, NULL) || written != sizeof(*header) ||
+            !WriteFile(file, code, (DWORD)code_size, &written, NULL) || written != code_size)
+    {
+        WARN("Failed to write shader cache entry %s, error %lu.\n", tmp_path, GetLastError());
+        CloseHandle(file);
+        DeleteFileA(tmp_path);
+        return false;
+    }
+
+    CloseHandle(file);
+
+    /* Another process may have raced us to store the same entry,
+     * which is fine since the contents are identical. */
+    if (!MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to publish shader cache entry %s, error %lu.\n", path, GetLastError());
+        DeleteFileA(tmp_path);
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+struct vkd3d_shader_disk_cache_scan_state
+{
+    struct vkd3d_shader_disk_cache_file *files;
+    size_t files_size;
+    size_t file_count;
+    uint64_t total_size;
+    bool collect_files;
+};
+
+static void vkd3d_shader_disk_cache_scan_file(void *userdata, const char *name, uint64_t mtime, uint64_t size)
+{
+    struct vkd3d_shader_disk_cache_scan_state *state = userdata;
+    struct vkd3d_shader_disk_cache_file *file;
+
+    state->total_size += size;
+
+    if (!state->collect_files)
+        return;
+
+    if (!vkd3d_array_reserve((void **)&state->files, &state->files_size,
+            state->file_count + 1, sizeof(*state->files)))
+        return;
+
+    file = &state->files[state->file_count++];
+    strcpy(file->name, name);
+    file->mtime = mtime;
+    file->size = size;
+}
+
+static bool vkd3d_shader_disk_cache_scan(struct vkd3d_shader_disk_cache *cache,
+        struct vkd3d_shader_disk_cache_file **files, size_t *file_count, uint64_t *total_size)
+{
+    struct vkd3d_shader_disk_cache_scan_state state;
+    bool ret;
+
+    memset(&state, 0, sizeof(state));
+    state.collect_files = !!files;
+
+    ret = vkd3d_shader_disk_cache_enumerate(cache, vkd3d_shader_disk_cache_scan_file, &state);
+
+    *total_size = state.total_size;
+    if (files)
+    {
+        *files = state.files;
+        *file_count = state.file_count;
+    }
+
+    return ret;
+}
+
+static int vkd3d_shader_disk_cache_file_compare(const void *a, const void *b)
+{
+    const struct vkd3d_shader_disk_cache_file *fa = a, *fb = b;
+    if (fa->mtime != fb->mtime)
+        return fa->mtime < fb->mtime ? -1 : 1;
+    return strcmp(fa->name, fb->name);
+}
+
+static void vkd3d_shader_disk_cache_evict(struct vkd3d_shader_disk_cache *cache)
+{
+    struct vkd3d_shader_disk_cache_file *files;
+    vkd3d_shader_disk_cache_lock_t lock;
+    char path[VKD3D_PATH_MAX];
+    uint64_t total_size;
+    size_t file_count, i;
+    uint64_t target_size;
+
+    /* Only one process needs to evict at a time. If someone else holds the lock,
+     * they will bring the cache below the limit for us. */
+    if (!vkd3d_shader_disk_cache_try_lock(cache, &lock))
+        return;
+
+    /* Rescan since other processes may have added or removed entries. */
+    if (vkd3d_shader_disk_cache_scan(cache, &files, &file_count, &total_size))
+    {
+        /* Evict down to 3/4 of the limit so we don't end up evicting on every store. */
+        target_size = cache->max_size - cache->max_size / 4;
+        qsort(files, file_count, sizeof(*files), vkd3d_shader_disk_cache_file_compare);
+
+        for (i = 0; i < file_count && total_size > target_size; i++)
+        {
+            snprintf(path, sizeof(path), "%s/%s", cache->path, files[i].name);
+            if (vkd3d_shader_disk_cache_delete_file(path))
+                total_size -= files[i].size;
+        }
+
+        TRACE("Evicted %zu shader cache entries, cache size is now %"PRIu64" bytes.\n", i, total_size);
+        cache->total_size = total_size;
+    }
+
+    vkd3d_free(files);
+    vkd3d_shader_disk_cache_unlock(lock);
+}
+
+void vkd3d_shader_disk_cache_init(struct vkd3d_shader_disk_cache *cache)
+{
+    const char *path, *size_str;
+    uint64_t size_mb;
+
+    memset(cache, 0, sizeof(*cache));
+
+    if (!(path = getenv("VKD3D_SHADER_CACHE_PATH")))
+        return;
+
+    /* Replaced or dumped shaders must go through the compiler every time. */
+    if (getenv("VKD3D_SHADER_OVERRIDE") || getenv("VKD3D_SHADER_DUMP_PATH"))
+    {
+        WARN("Shader override or dump path is set, ignoring VKD3D_SHADER_CACHE_PATH.\n");
+        return;
+    }
+
+    if (strlen(path) + 32 >= sizeof(cache->path))
+    {
+        ERR("Shader cache path %s is too long.\n", path);
+        return;
+    }
+
+    if (!vkd3d_shader_disk_cache_create_directory(path))
+        return;
+
+    strcpy(cache->path, path);
+
+    size_mb = VKD3D_SHADER_DISK_CACHE_DEFAULT_SIZE_MB;
+    if ((size_str = getenv("VKD3D_SHADER_CACHE_SIZE_MB")))
+        size_mb = strtoull(size_str, NULL, 0);
+    cache->max_size = size_mb * 1024 * 1024;
+
+    if (pthread_mutex_init(&cache->lock, NULL))
+        return;
+
+    vkd3d_shader_disk_cache_scan(cache, NULL, NULL, &cache->total_size);
+    cache->active = true;
+
+    INFO("Using shader cache in %s, %"PRIu64" MiB in use, limit %"PRIu64" MiB.\n",
+            cache->path, cache->total_size / (1024 * 1024), size_mb);
+}
+
+void vkd3d_shader_disk_cache_cleanup(struct vkd3d_shader_disk_cache *cache)
+{
+    if (!cache->active)
+        return;
+
+    pthread_mutex_destroy(&cache->lock);
+    cache->active = false;
+}
+
+bool vkd3d_shader_disk_cache_load(struct vkd3d_shader_disk_cache *cache, uint64_t key,
+        const struct vkd3d_shader_code *dxbc, struct vkd3d_shader_code *spirv)
+{
+    const struct vkd3d_shader_disk_cache_header *header;
+    struct vkd3d_shader_disk_cache_mapping mapping;
+    char path[VKD3D_PATH_MAX];
+    bool success = false;
+    void *code;
+
+    if (!cache->active)
+        return false;
+
+    vkd3d_shader_disk_cache_get_entry_path(cache, key, path);
+    if (!vkd3d_shader_disk_cache_map_entry(path, &mapping))
+        return false;
+
+    header = (const struct vkd3d_shader_disk_cache_header *)mapping.data;
+
+    /* Validate everything, the file may have been written by a different build
+     * or be the result of a hash collision. */
+    if (mapping.size < sizeof(*header) ||
+            header->magic != VKD3D_SHADER_DISK_CACHE_MAGIC ||
+            header->version != VKD3D_SHADER_DISK_CACHE_VERSION ||
+            header->key != key ||
+            header->vkd3d_build != vkd3d_build ||
+            header->dxbc_size != dxbc->size ||
+            header->dxbc_hash != vkd3d_shader_hash(dxbc) ||
+            sizeof(*header) + header->spirv_size != (uint64_t)mapping.size ||
+            header->spirv_hash != vkd3d_shader_disk_cache_hash_data(hash_fnv1_init(),
+                    mapping.data + sizeof(*header), header->spirv_size))
+    {
+        WARN("Ignoring stale or corrupt shader cache entry %s.\n", path);
+        goto out;
+    }
+
+    if (!(code = vkd3d_malloc(header->spirv_size)))
+        goto out;
+
+    memcpy(code, mapping.data + sizeof(*header), header->spirv_size);
+    spirv->code = code;
+    spirv->size = header->spirv_size;
+    spirv->meta = header->meta;
+    success = true;
+
+    /* Refresh the LRU timestamp. */
+    vkd3d_shader_disk_cache_touch_entry(&mapping);
+
+out:
+    vkd3d_shader_disk_cache_unmap_entry(&mapping);
+    return success;
+}
+
+void vkd3d_shader_disk_cache_store(struct vkd3d_shader_disk_cache *cache, uint64_t key,
+        const struct vkd3d_shader_code *dxbc, const struct vkd3d_shader_code *spirv)
+{
+    struct vkd3d_shader_disk_cache_header header;
+    char path[VKD3D_PATH_MAX];
+    char tmp_path[VKD3D_PATH_MAX];
+    uint32_t counter;
+
+    if (!cache->active || spirv->size > UINT32_MAX || dxbc->size > UINT32_MAX)
+        return;
+
+    if (spirv->meta.flags & VKD3D_SHADER_META_FLAG_REPLACED)
+        return;
+
+    header.magic = VKD3D_SHADER_DISK_CACHE_MAGIC;
+    header.version = VKD3D_SHADER_DISK_CACHE_VERSION;
+    header.key = key;
+    header.vkd3d_build = vkd3d_build;
+    header.dxbc_hash = vkd3d_shader_hash(dxbc);
+    header.dxbc_size = dxbc->size;
+    header.spirv_size = spirv->size;
+    header.spirv_hash = vkd3d_shader_disk_cache_hash_data(hash_fnv1_init(), spirv->code, spirv->size);
+    header.meta = spirv->meta;
+
+    vkd3d_shader_disk_cache_get_entry_path(cache, key, path);
+    counter = vkd3d_atomic_uint32_increment(&cache->store_counter, vkd3d_memory_order_relaxed);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp.%u.%u", cache->path,
+            vkd3d_shader_disk_cache_get_process_id(), counter);
+
+    if (!vkd3d_shader_disk_cache_write_entry(tmp_path, path, &header, spirv->code, spirv->size))
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    cache->total_size += sizeof(header) + spirv->size;
+    if (cache->max_size && cache->total_size > cache->max_size)
+        vkd3d_shader_disk_cache_evict(cache);
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -22,6 +22,8 @@
 #include "vkd3d_private.h"
 #include "vkd3d_swapchain_factory.h"
 #include "vkd3d_descriptor_debug.h"
+#include "vkd3d_rw_spinlock.h"
+#include "vkd3d_sort.h"
 #ifdef VKD3D_ENABLE_RENDERDOC
 #include "vkd3d_renderdoc.h"
 #endif
@@ -292,6 +294,21 @@ static HRESULT vkd3d_create_timeline_semaphore(struct d3d12_device *device, uint
     return hresult_from_vk_result(vr);
 }
 
+static void vkd3d_fence_worker_kick_locked(struct vkd3d_fence_worker *worker)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &worker->device->vk_procs;
+    VkSemaphoreSignalInfoKHR signal_info;
+    VkResult vr;
+
+    signal_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+    signal_info.pNext = NULL;
+    signal_info.semaphore = worker->kick_semaphore;
+    signal_info.value = ++worker->kick_value;
+
+    if ((vr = VK_CALL(vkSignalSemaphoreKHR(worker->device->vk_device, &signal_info))))
+        ERR("Failed to signal kick semaphore, vr %d.\n", vr);
+}
+
 static HRESULT vkd3d_enqueue_timeline_semaphore(struct vkd3d_fence_worker *worker,
         struct d3d12_fence *fence, uint64_t value, struct vkd3d_queue *queue)
 {
@@ -321,17 +338,33 @@ static HRESULT vkd3d_enqueue_timeline_semaphore(struct vkd3d_fence_worker *worke
     waiting_fence->value = value;
     ++worker->enqueued_fence_count;
 
-    pthread_cond_signal(&worker->cond);
+    vkd3d_fence_worker_kick_locked(worker);
     pthread_mutex_unlock(&worker->mutex);
     return S_OK;
 }
 
+static void vkd3d_fence_worker_complete_fence(struct vkd3d_fence_worker *worker, const struct vkd3d_waiting_fence *fence)
+{
+    struct d3d12_device *device = worker->device;
+    HRESULT hr;
+
+    /* This is a good time to kick the debug threads into action. */
+    if (device->debug_ring.active)
+        pthread_cond_signal(&device->debug_ring.ring_cond);
+    vkd3d_descriptor_debug_kick_qa_check(device->descriptor_qa_global_info);
+
+    TRACE("Signaling fence %p value %#"PRIx64".\n", fence->fence, fence->value);
+    if (FAILED(hr = d3d12_fence_signal(fence->fence, fence->value)))
+        ERR("Failed to signal D3D12 fence, hr %#x.\n", hr);
+
+    d3d12_fence_dec_ref(fence->fence);
+}
+
 static void vkd3d_wait_for_gpu_timeline_semaphore(struct vkd3d_fence_worker *worker, const struct vkd3d_waiting_fence *fence)
 {
     struct d3d12_device *device = worker->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     VkSemaphoreWaitInfoKHR wait_info;
-    HRESULT hr;
     int vr;
 
     wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
@@ -344,36 +377,100 @@ static void vkd3d_wait_for_gpu_timeline_semaphore(struct vkd3d_fence_worker *wor
     if ((vr = VK_CALL(vkWaitSemaphoresKHR(device->vk_device, &wait_info, ~(uint64_t)0))))
     {
         ERR("Failed to wait for Vulkan timeline semaphore, vr %d.\n", vr);
+        vkd3d_dbg_flush_on_device_lost(vr);
+        d3d12_fence_dec_ref(fence->fence);
         return;
     }
 
-    /* This is a good time to kick the debug threads into action. */
-    if (device->debug_ring.active)
-        pthread_cond_signal(&device->debug_ring.ring_cond);
-    vkd3d_descriptor_debug_kick_qa_check(device->descriptor_qa_global_info);
+    vkd3d_fence_worker_complete_fence(worker, fence);
+}
 
-    TRACE("Signaling fence %p value %#"PRIx64".\n", fence->fence, fence->value);
-    if (FAILED(hr = d3d12_fence_signal(fence->fence, fence->value)))
-        ERR("Failed to signal D3D12 fence, hr %#x.\n", hr);
+struct vkd3d_fence_worker_wait_list
+{
+    VkSemaphore *semaphores;
+    uint64_t *values;
+    size_t semaphores_size;
+    size_t values_size;
+    uint32_t count;
+};
 
-    d3d12_fence_dec_ref(fence->fence);
+static bool vkd3d_fence_worker_wait_list_add(struct vkd3d_fence_worker_wait_list *list,
+        VkSemaphore semaphore, uint64_t value)
+{
+    uint32_t i;
+
+    /* A fence with multiple pending values only needs to be waited on for the
+     * lowest one, since completions are retired in submission order. */
+    for (i = 0; i < list->count; i++)
+    {
+        if (list->semaphores[i] == semaphore)
+        {
+            list->values[i] = min(list->values[i], value);
+            return true;
+        }
+    }
+
+    if (!vkd3d_array_reserve((void **)&list->semaphores, &list->semaphores_size,
+            list->count + 1, sizeof(*list->semaphores)) ||
+            !vkd3d_array_reserve((void **)&list->values, &list->values_size,
+            list->count + 1, sizeof(*list->values)))
+        return false;
+
+    list->semaphores[list->count] = semaphore;
+    list->values[list->count] = value;
+    list->count++;
+    return true;
+}
+
+static uint32_t vkd3d_fence_worker_retire_fences(struct vkd3d_fence_worker *worker,
+        struct vkd3d_waiting_fence *fences, uint32_t fence_count)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &worker->device->vk_procs;
+    uint32_t i, pending_count = 0;
+    uint64_t completed_value;
+    VkResult vr;
+
+    /* Fences are retired in the order they were enqueued, which preserves
+     * signal ordering both per fence and per queue. */
+    for (i = 0; i < fence_count; i++)
+    {
+        if ((vr = VK_CALL(vkGetSemaphoreCounterValueKHR(worker->device->vk_device,
+                fences[i].fence->timeline_semaphore, &completed_value))))
+        {
+            ERR("Failed to query timeline semaphore value, vr %d.\n", vr);
+            d3d12_fence_dec_ref(fences[i].fence);
+            continue;
+        }
+
+        if (completed_value >= fences[i].value)
+            vkd3d_fence_worker_complete_fence(worker, &fences[i]);
+        else
+            fences[pending_count++] = fences[i];
+    }
+
+    return pending_count;
 }
 
 static void *vkd3d_fence_worker_main(void *arg)
 {
-    struct vkd3d_waiting_fence *cur_fences, *old_fences;
+    struct vkd3d_fence_worker_wait_list wait_list;
+    struct vkd3d_waiting_fence *pending_fences;
     struct vkd3d_fence_worker *worker = arg;
-    size_t cur_fences_size, old_fences_size;
-    uint32_t cur_fence_count;
-    uint32_t i;
+    const struct vkd3d_vk_device_procs *vk_procs;
+    uint32_t pending_fence_count, i;
+    VkSemaphoreWaitInfoKHR wait_info;
+    size_t pending_fences_size;
     bool do_exit;
+    VkResult vr;
     int rc;
 
     vkd3d_set_thread_name("vkd3d_fence");
 
-    cur_fence_count = 0;
-    cur_fences_size = 0;
-    cur_fences = NULL;
+    vk_procs = &worker->device->vk_procs;
+    memset(&wait_list, 0, sizeof(wait_list));
+    pending_fence_count = 0;
+    pending_fences_size = 0;
+    pending_fences = NULL;
 
     for (;;)
     {
@@ -383,44 +480,70 @@ static void *vkd3d_fence_worker_main(void *arg)
             break;
         }
 
-        if (!worker->enqueued_fence_count && !worker->should_exit)
+        if (!vkd3d_array_reserve((void **)&pending_fences, &pending_fences_size,
+                pending_fence_count + worker->enqueued_fence_count, sizeof(*pending_fences)))
         {
-            if ((rc = pthread_cond_wait(&worker->cond, &worker->mutex)))
-            {
-                ERR("Failed to wait on condition variable, error %d.\n", rc);
-                pthread_mutex_unlock(&worker->mutex);
-                break;
-            }
+            ERR("Failed to reserve pending fences.\n");
+            pthread_mutex_unlock(&worker->mutex);
+            break;
         }
 
-        old_fences_size = cur_fences_size;
-        old_fences = cur_fences;
-
-        cur_fence_count = worker->enqueued_fence_count;
-        cur_fences_size = worker->enqueued_fences_size;
-        cur_fences = worker->enqueued_fences;
+        memcpy(pending_fences + pending_fence_count, worker->enqueued_fences,
+                worker->enqueued_fence_count * sizeof(*pending_fences));
+        pending_fence_count += worker->enqueued_fence_count;
+        worker->enqueued_fence_count = 0;
         do_exit = worker->should_exit;
 
-        worker->enqueued_fence_count = 0;
-        worker->enqueued_fences_size = old_fences_size;
-        worker->enqueued_fences = old_fences;
+        /* Any enqueue after this point bumps the kick value past what we wait for. */
+        wait_list.count = 0;
+        vkd3d_fence_worker_wait_list_add(&wait_list, worker->kick_semaphore, worker->kick_value + 1);
 
         pthread_mutex_unlock(&worker->mutex);
 
-        for (i = 0; i < cur_fence_count; i++)
-            vkd3d_wait_for_gpu_timeline_semaphore(worker, &cur_fences[i]);
-
         if (do_exit)
             break;
+
+        for (i = 0; i < pending_fence_count; i++)
+        {
+            if (!vkd3d_fence_worker_wait_list_add(&wait_list,
+                    pending_fences[i].fence->timeline_semaphore, pending_fences[i].value))
+            {
+                ERR("Failed to build semaphore wait list.\n");
+                break;
+            }
+        }
+
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        wait_info.pNext = NULL;
+        wait_info.flags = VK_SEMAPHORE_WAIT_ANY_BIT_KHR;
+        wait_info.semaphoreCount = wait_list.count;
+        wait_info.pSemaphores = wait_list.semaphores;
+        wait_info.pValues = wait_list.values;
+
+        if ((vr = VK_CALL(vkWaitSemaphoresKHR(worker->device->vk_device, &wait_info, ~(uint64_t)0))))
+        {
+            ERR("Failed to wait for Vulkan timeline semaphores, vr %d.\n", vr);
+            vkd3d_dbg_flush_on_device_lost(vr);
+            break;
+        }
+
+        pending_fence_count = vkd3d_fence_worker_retire_fences(worker, pending_fences, pending_fence_count);
     }
 
-    vkd3d_free(cur_fences);
+    /* Drain everything which is still outstanding, in order. */
+    for (i = 0; i < pending_fence_count; i++)
+        vkd3d_wait_for_gpu_timeline_semaphore(worker, &pending_fences[i]);
+
+    vkd3d_free(wait_list.semaphores);
+    vkd3d_free(wait_list.values);
+    vkd3d_free(pending_fences);
     return NULL;
 }
 
 HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
         struct d3d12_device *device)
 {
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     HRESULT hr;
     int rc;
 
@@ -432,17 +555,15 @@ HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
     worker->enqueued_fence_count = 0;
     worker->enqueued_fences = NULL;
     worker->enqueued_fences_size = 0;
+    worker->kick_value = 0;
+
+    if (FAILED(hr = vkd3d_create_timeline_semaphore(device, 0, &worker->kick_semaphore)))
+        return hr;
 
     if ((rc = pthread_mutex_init(&worker->mutex, NULL)))
     {
         ERR("Failed to initialize mutex, error %d.\n", rc);
-        return hresult_from_errno(rc);
-    }
-
-    if ((rc = pthread_cond_init(&worker->cond, NULL)))
-    {
-        ERR("Failed to initialize condition variable, error %d.\n", rc);
-        pthread_mutex_destroy(&worker->mutex);
+        VK_CALL(vkDestroySemaphore(device->vk_device, worker->kick_semaphore, NULL));
         return hresult_from_errno(rc);
     }
 
@@ -450,7 +571,7 @@ HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
             vkd3d_fence_worker_main, worker, &worker->thread)))
     {
         pthread_mutex_destroy(&worker->mutex);
-        pthread_cond_destroy(&worker->cond);
+        VK_CALL(vkDestroySemaphore(device->vk_device, worker->kick_semaphore, NULL));
     }
 
     return hr;
@@ -459,6 +580,8 @@ HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
 HRESULT vkd3d_fence_worker_stop(struct vkd3d_fence_worker *worker,
         struct d3d12_device *device)
 {
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    uint32_t i;
     HRESULT hr;
     int rc;
 
@@ -471,15 +594,19 @@ HRESULT vkd3d_fence_worker_stop(struct vkd3d_fence_worker *worker,
     }
 
     worker->should_exit = true;
-    pthread_cond_signal(&worker->cond);
+    vkd3d_fence_worker_kick_locked(worker);
 
     pthread_mutex_unlock(&worker->mutex);
 
     if (FAILED(hr = vkd3d_join_thread(device->vkd3d_instance, &worker->thread)))
         return hr;
 
+    /* Anything enqueued after the worker picked up the exit request is drained here. */
+    for (i = 0; i < worker->enqueued_fence_count; i++)
+        vkd3d_wait_for_gpu_timeline_semaphore(worker, &worker->enqueued_fences[i]);
+
     pthread_mutex_destroy(&worker->mutex);
-    pthread_cond_destroy(&worker->cond);
+    VK_CALL(vkDestroySemaphore(device->vk_device, worker->kick_semaphore, NULL));
 
     vkd3d_free(worker->enqueued_fences);
     return S_OK;
@@ -1133,13 +1260,83 @@ static HRESULT d3d12_command_list_begin_command_buffer(struct d3d12_command_list
     return S_OK;
 }
 
-static HRESULT d3d12_command_allocator_allocate_command_buffer(struct d3d12_command_allocator *allocator,
-        struct d3d12_command_list *list)
+static HRESULT d3d12_command_allocator_get_vk_command_buffer(struct d3d12_command_allocator *allocator,
+        VkCommandBuffer *vk_command_buffer)
 {
     struct d3d12_device *device = allocator->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     VkCommandBufferAllocateInfo command_buffer_info;
+    size_t batch_size, total_count;
     VkResult vr;
+    VKD3D_REGION_DECL(command_buffer_allocate);
+
+    if (!allocator->free_command_buffer_count)
+    {
+        /* Grow geometrically so that allocators which record many small
+         * command lists only go through the driver a handful of times. */
+        batch_size = max(VKD3D_COMMAND_BUFFER_MIN_BATCH_SIZE,
+                min(allocator->command_buffer_total_count, VKD3D_COMMAND_BUFFER_MAX_BATCH_SIZE));
+        total_count = allocator->command_buffer_total_count + batch_size;
+
+        /* Reserve space for every command buffer in both lists up front,
+         * so that retiring and recycling them can never fail. */
+        if (!vkd3d_array_reserve((void **)&allocator->free_command_buffers, &allocator->free_command_buffers_size,
+                total_count, sizeof(*allocator->free_command_buffers)) ||
+                !vkd3d_array_reserve((void **)&allocator->command_buffers, &allocator->command_buffers_size,
+                total_count, sizeof(*allocator->command_buffers)))
+        {
+            ERR("Failed to allocate command buffer list.\n");
+            return E_OUTOFMEMORY;
+        }
+
+        command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_buffer_info.pNext = NULL;
+        command_buffer_info.commandPool = allocator->vk_command_pool;
+        command_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        command_buffer_info.commandBufferCount = batch_size;
+
+        VKD3D_REGION_BEGIN(command_buffer_allocate);
+
+        if ((vr = VK_CALL(vkAllocateCommandBuffers(device->vk_device, &command_buffer_info,
+                allocator->free_command_buffers))) < 0)
+        {
+            WARN("Failed to allocate Vulkan command buffers, vr %d.\n", vr);
+            return hresult_from_vk_result(vr);
+        }
+
+        VKD3D_REGION_END_ITERATIONS(command_buffer_allocate, batch_size);
+
+        allocator->free_command_buffer_count = batch_size;
+        allocator->command_buffer_total_count = total_count;
+    }
+
+    *vk_command_buffer = allocator->free_command_buffers[--allocator->free_command_buffer_count];
+    return S_OK;
+}
+
+static void d3d12_command_allocator_free_vk_command_buffer(struct d3d12_command_allocator *allocator,
+        VkCommandBuffer vk_command_buffer)
+{
+    struct d3d12_device *device = allocator->device;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    if (!vk_command_buffer)
+        return;
+
+    if (!vkd3d_array_reserve((void **)&allocator->command_buffers, &allocator->command_buffers_size,
+            allocator->command_buffer_count + 1, sizeof(*allocator->command_buffers)))
+    {
+        WARN("Failed to add command buffer.\n");
+        VK_CALL(vkFreeCommandBuffers(device->vk_device, allocator->vk_command_pool,
+                1, &vk_command_buffer));
+    }
+    else
+        allocator->command_buffers[allocator->command_buffer_count++] = vk_command_buffer;
+}
+
+static HRESULT d3d12_command_allocator_allocate_command_buffer(struct d3d12_command_allocator *allocator,
+        struct d3d12_command_list *list)
+{
     HRESULT hr;
 
     TRACE("allocator %p, list %p.\n", allocator, list);
@@ -1150,26 +1347,15 @@ static HRESULT d3d12_command_allocator_allocate_command_buffer(struct d3d12_comm
         return E_INVALIDARG;
     }
 
-    command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    command_buffer_info.pNext = NULL;
-    command_buffer_info.commandPool = allocator->vk_command_pool;
-    command_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    command_buffer_info.commandBufferCount = 1;
-
-    if ((vr = VK_CALL(vkAllocateCommandBuffers(device->vk_device, &command_buffer_info,
-            &list->vk_command_buffer))) < 0)
-    {
-        WARN("Failed to allocate Vulkan command buffer, vr %d.\n", vr);
-        return hresult_from_vk_result(vr);
-    }
+    if (FAILED(hr = d3d12_command_allocator_get_vk_command_buffer(allocator, &list->vk_command_buffer)))
+        return hr;
 
     list->vk_init_commands = VK_NULL_HANDLE;
     list->vk_queue_flags = allocator->vk_queue_flags;
 
     if (FAILED(hr = d3d12_command_list_begin_command_buffer(list)))
     {
-        VK_CALL(vkFreeCommandBuffers(device->vk_device, allocator->vk_command_pool,
-                1, &list->vk_command_buffer));
+        d3d12_command_allocator_free_vk_command_buffer(allocator, list->vk_command_buffer);
         return hr;
     }
 
@@ -1184,27 +1370,17 @@ static HRESULT d3d12_command_allocator_allocate_init_command_buffer(struct d3d12
 {
     struct d3d12_device *device = allocator->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    VkCommandBufferAllocateInfo command_buffer_info;
     VkCommandBufferBeginInfo begin_info;
     VkResult vr;
+    HRESULT hr;
 
     TRACE("allocator %p, list %p.\n", allocator, list);
 
     if (list->vk_init_commands)
         return S_OK;
 
-    command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    command_buffer_info.pNext = NULL;
-    command_buffer_info.commandPool = allocator->vk_command_pool;
-    command_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    command_buffer_info.commandBufferCount = 1;
-
-    if ((vr = VK_CALL(vkAllocateCommandBuffers(device->vk_device, &command_buffer_info,
-            &list->vk_init_commands))) < 0)
-    {
-        WARN("Failed to allocate Vulkan command buffer, vr %d.\n", vr);
-        return hresult_from_vk_result(vr);
-    }
+    if (FAILED(hr = d3d12_command_allocator_get_vk_command_buffer(allocator, &list->vk_init_commands)))
+        return hr;
 
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     begin_info.pNext = NULL;
@@ -1214,44 +1390,359 @@ static HRESULT d3d12_command_allocator_allocate_init_command_buffer(struct d3d12
     if ((vr = VK_CALL(vkBeginCommandBuffer(list->vk_init_commands, &begin_info))) < 0)
     {
         WARN("Failed to begin command buffer, vr %d.\n", vr);
-        VK_CALL(vkFreeCommandBuffers(device->vk_device, allocator->vk_command_pool,
-                1, &list->vk_init_commands));
+        d3d12_command_allocator_free_vk_command_buffer(allocator, list->vk_init_commands);
+        list->vk_init_commands = VK_NULL_HANDLE;
         return hresult_from_vk_result(vr);
     }
 
     return S_OK;
 }
 
-static void d3d12_command_allocator_free_vk_command_buffer(struct d3d12_command_allocator *allocator,
-        VkCommandBuffer vk_command_buffer)
+static void d3d12_command_allocator_free_command_buffer(struct d3d12_command_allocator *allocator,
+        struct d3d12_command_list *list)
+{
+    TRACE("allocator %p, list %p.\n", allocator, list);
+
+    if (allocator->current_command_list == list)
+        allocator->current_command_list = NULL;
+
+    d3d12_command_allocator_free_vk_command_buffer(allocator, list->vk_command_buffer);
+    d3d12_command_allocator_free_vk_command_buffer(allocator, list->vk_init_commands);
+}
+
+struct vkd3d_framebuffer_entry
+{
+    struct hash_map_entry entry;
+    struct vkd3d_framebuffer *framebuffer;
+};
+
+struct vkd3d_framebuffer_cookie_entry
+{
+    struct hash_map_entry entry;
+    uint64_t cookie;
+    struct vkd3d_framebuffer **framebuffers;
+    size_t framebuffers_size;
+    size_t framebuffer_count;
+};
+
+static uint32_t vkd3d_framebuffer_cookie_hash(const void *key)
+{
+    return hash_uint64(*(const uint64_t *)key);
+}
+
+static bool vkd3d_framebuffer_cookie_compare(const void *key, const struct hash_map_entry *entry)
+{
+    const struct vkd3d_framebuffer_cookie_entry *e = (const struct vkd3d_framebuffer_cookie_entry *)entry;
+    return e->cookie == *(const uint64_t *)key;
+}
+
+static uint32_t vkd3d_framebuffer_key_hash(const void *key)
+{
+    const struct vkd3d_framebuffer_key *k = key;
+    uint32_t hash, i;
+
+    hash = hash_uint64((uint64_t)k->render_pass);
+    hash = hash_combine(hash, k->view_count);
+    hash = hash_combine(hash, k->width);
+    hash = hash_combine(hash, k->height);
+    hash = hash_combine(hash, k->layers);
+
+    for (i = 0; i < k->view_count; i++)
+        hash = hash_combine(hash, hash_uint64(k->view_cookies[i]));
+
+    return hash;
+}
+
+static bool vkd3d_framebuffer_key_compare(const void *key, const struct hash_map_entry *entry)
+{
+    const struct vkd3d_framebuffer_entry *e = (const struct vkd3d_framebuffer_entry *)entry;
+    const struct vkd3d_framebuffer_key *k = key;
+    const struct vkd3d_framebuffer_key *other;
+
+    other = &e->framebuffer->key;
+
+    return k->render_pass == other->render_pass &&
+            k->view_count == other->view_count &&
+            k->width == other->width &&
+            k->height == other->height &&
+            k->layers == other->layers &&
+            !memcmp(k->view_cookies, other->view_cookies, k->view_count * sizeof(*k->view_cookies));
+}
+
+void vkd3d_framebuffer_decref(struct vkd3d_framebuffer *framebuffer, struct d3d12_device *device)
 {
-    struct d3d12_device *device = allocator->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
-    if (!vk_command_buffer)
+    if (!InterlockedDecrement(&framebuffer->refcount))
+    {
+        VK_CALL(vkDestroyFramebuffer(device->vk_device, framebuffer->vk_framebuffer, NULL));
+        vkd3d_free(framebuffer);
+    }
+}
+
+static struct vkd3d_framebuffer *vkd3d_framebuffer_create(struct d3d12_device *device,
+        const struct vkd3d_framebuffer_key *key, const VkImageView *views)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_framebuffer *framebuffer;
+    VkFramebufferCreateInfo fb_info;
+    VkResult vr;
+
+    if (!(framebuffer = vkd3d_malloc(sizeof(*framebuffer))))
+        return NULL;
+
+    fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fb_info.pNext = NULL;
+    fb_info.flags = 0;
+    fb_info.renderPass = key->render_pass;
+    fb_info.attachmentCount = key->view_count;
+    fb_info.pAttachments = views;
+    fb_info.width = key->width;
+    fb_info.height = key->height;
+    fb_info.layers = key->layers;
+
+    if ((vr = VK_CALL(vkCreateFramebuffer(device->vk_device, &fb_info, NULL, &framebuffer->vk_framebuffer))) < 0)
+    {
+        ERR("Failed to create Vulkan framebuffer, vr %d.\n", vr);
+        vkd3d_free(framebuffer);
+        return NULL;
+    }
+
+    /* One reference is owned by the cache itself. */
+    framebuffer->refcount = 1;
+    framebuffer->key = *key;
+    return framebuffer;
+}
+
+void vkd3d_framebuffer_cache_init(struct vkd3d_framebuffer_cache *cache)
+{
+    spinlock_init(&cache->spinlock);
+    hash_map_init(&cache->map, vkd3d_framebuffer_key_hash,
+            vkd3d_framebuffer_key_compare, sizeof(struct vkd3d_framebuffer_entry));
+    hash_map_init(&cache->cookie_map, vkd3d_framebuffer_cookie_hash,
+            vkd3d_framebuffer_cookie_compare, sizeof(struct vkd3d_framebuffer_cookie_entry));
+}
+
+void vkd3d_framebuffer_cache_cleanup(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device)
+{
+    uint32_t i;
+
+    for (i = 0; i < cache->map.entry_count; i++)
+    {
+        struct vkd3d_framebuffer_entry *e = (struct vkd3d_framebuffer_entry *)hash_map_get_entry(&cache->map, i);
+
+        if (e->entry.flags & HASH_MAP_ENTRY_OCCUPIED)
+            vkd3d_framebuffer_decref(e->framebuffer, device);
+    }
+
+    for (i = 0; i < cache->cookie_map.entry_count; i++)
+    {
+        struct vkd3d_framebuffer_cookie_entry *e = (struct vkd3d_framebuffer_cookie_entry *)hash_map_get_entry(&cache->cookie_map, i);
+
+        if (e->entry.flags & HASH_MAP_ENTRY_OCCUPIED)
+            vkd3d_free(e->framebuffers);
+    }
+
+    hash_map_clear(&cache->map);
+    hash_map_clear(&cache->cookie_map);
+}
+
+static bool vkd3d_framebuffer_key_is_first_cookie(const struct vkd3d_framebuffer_key *key, uint32_t index)
+{
+    uint32_t i;
+
+    /* The same view may be bound to more than one attachment */
+    for (i = 0; i < index; i++)
+    {
+        if (key->view_cookies[i] == key->view_cookies[index])
+            return false;
+    }
+
+    return true;
+}
+
+static void vkd3d_framebuffer_cache_unlink_cookie_locked(struct vkd3d_framebuffer_cache *cache,
+        uint64_t cookie, const struct vkd3d_framebuffer *framebuffer)
+{
+    struct vkd3d_framebuffer_cookie_entry *e;
+    size_t i;
+
+    if (!(e = (struct vkd3d_framebuffer_cookie_entry *)hash_map_find(&cache->cookie_map, &cookie)))
         return;
 
-    if (!vkd3d_array_reserve((void **)&allocator->command_buffers, &allocator->command_buffers_size,
-            allocator->command_buffer_count + 1, sizeof(*allocator->command_buffers)))
+    for (i = 0; i < e->framebuffer_count; i++)
     {
-        WARN("Failed to add command buffer.\n");
-        VK_CALL(vkFreeCommandBuffers(device->vk_device, allocator->vk_command_pool,
-                1, &vk_command_buffer));
+        if (e->framebuffers[i] == framebuffer)
+        {
+            e->framebuffers[i] = e->framebuffers[--e->framebuffer_count];
+            break;
+        }
+    }
+
+    if (!e->framebuffer_count)
+    {
+        vkd3d_free(e->framebuffers);
+        hash_map_remove(&cache->cookie_map, &e->entry);
+    }
+}
+
+static bool vkd3d_framebuffer_cache_link_locked(struct vkd3d_framebuffer_cache *cache,
+        struct vkd3d_framebuffer *framebuffer)
+{
+    const struct vkd3d_framebuffer_key *key = &framebuffer->key;
+    struct vkd3d_framebuffer_cookie_entry entry, *e;
+    uint32_t i;
+
+    for (i = 0; i < key->view_count; i++)
+    {
+        if (!vkd3d_framebuffer_key_is_first_cookie(key, i))
+            continue;
+
+        memset(&entry, 0, sizeof(entry));
+        entry.cookie = key->view_cookies[i];
+
+        if (!(e = (struct vkd3d_framebuffer_cookie_entry *)hash_map_insert(&cache->cookie_map,
+                &entry.cookie, &entry.entry)) ||
+                !vkd3d_array_reserve((void **)&e->framebuffers, &e->framebuffers_size,
+                        e->framebuffer_count + 1, sizeof(*e->framebuffers)))
+        {
+            if (e && !e->framebuffer_count)
+                hash_map_remove(&cache->cookie_map, &e->entry);
+
+            while (i--)
+            {
+                if (vkd3d_framebuffer_key_is_first_cookie(key, i))
+                    vkd3d_framebuffer_cache_unlink_cookie_locked(cache, key->view_cookies[i], framebuffer);
+            }
+
+            return false;
+        }
+
+        e->framebuffers[e->framebuffer_count++] = framebuffer;
+    }
+
+    return true;
+}
+
+/* Returns a framebuffer with a reference owned by the caller. */
+struct vkd3d_framebuffer *vkd3d_framebuffer_cache_get(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device, const struct vkd3d_framebuffer_key *key, const VkImageView *views)
+{
+    struct vkd3d_framebuffer *framebuffer, *redundant_framebuffer;
+    struct vkd3d_framebuffer_entry entry, *e;
+
+    VKD3D_REGION_DECL(framebuffer_cache_hit);
+    VKD3D_REGION_DECL(framebuffer_cache_create);
+
+    VKD3D_REGION_BEGIN(framebuffer_cache_hit);
+    rw_spinlock_acquire_read(&cache->spinlock);
+
+    if ((e = (struct vkd3d_framebuffer_entry *)hash_map_find(&cache->map, key)))
+    {
+        framebuffer = e->framebuffer;
+        InterlockedIncrement(&framebuffer->refcount);
+        rw_spinlock_release_read(&cache->spinlock);
+        VKD3D_REGION_END(framebuffer_cache_hit);
+        return framebuffer;
+    }
+
+    rw_spinlock_release_read(&cache->spinlock);
+
+    VKD3D_REGION_BEGIN(framebuffer_cache_create);
+
+    if (!(framebuffer = vkd3d_framebuffer_create(device, key, views)))
+        return NULL;
+
+    entry.framebuffer = framebuffer;
+
+    rw_spinlock_acquire_write(&cache->spinlock);
+
+    if (!(e = (struct vkd3d_framebuffer_entry *)hash_map_insert(&cache->map, key, &entry.entry)))
+    {
+        /* Hand out the framebuffer uncached, the caller's release destroys it. */
+        ERR("Failed to insert framebuffer into hash map.\n");
+        rw_spinlock_release_write(&cache->spinlock);
+        return framebuffer;
+    }
+
+    if (e->framebuffer == framebuffer && !vkd3d_framebuffer_cache_link_locked(cache, framebuffer))
+    {
+        /* Without a cookie link, the entry would outlive its views. */
+        ERR("Failed to link framebuffer to its view cookies.\n");
+        hash_map_remove(&cache->map, &e->entry);
+        rw_spinlock_release_write(&cache->spinlock);
+        return framebuffer;
+    }
+
+    if (e->framebuffer != framebuffer)
+    {
+        /* Another thread inserted the same framebuffer in-between releasing the reader lock
+         * and acquiring the writer lock. */
+        redundant_framebuffer = framebuffer;
+        framebuffer = e->framebuffer;
+        InterlockedIncrement(&framebuffer->refcount);
+        rw_spinlock_release_write(&cache->spinlock);
+        vkd3d_framebuffer_decref(redundant_framebuffer, device);
     }
     else
-        allocator->command_buffers[allocator->command_buffer_count++] = vk_command_buffer;
+    {
+        InterlockedIncrement(&framebuffer->refcount);
+        rw_spinlock_release_write(&cache->spinlock);
+    }
+
+    VKD3D_REGION_END(framebuffer_cache_create);
+    return framebuffer;
 }
 
-static void d3d12_command_allocator_free_command_buffer(struct d3d12_command_allocator *allocator,
-        struct d3d12_command_list *list)
+void vkd3d_framebuffer_cache_evict_cookie(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device, uint64_t cookie)
 {
-    TRACE("allocator %p, list %p.\n", allocator, list);
+    struct vkd3d_framebuffer_cookie_entry *cookie_entry;
+    struct vkd3d_framebuffer **framebuffers;
+    struct vkd3d_framebuffer_entry *e;
+    struct vkd3d_framebuffer *framebuffer;
+    size_t i, framebuffer_count;
+    uint32_t j;
 
-    if (allocator->current_command_list == list)
-        allocator->current_command_list = NULL;
+    rw_spinlock_acquire_write(&cache->spinlock);
 
-    d3d12_command_allocator_free_vk_command_buffer(allocator, list->vk_command_buffer);
-    d3d12_command_allocator_free_vk_command_buffer(allocator, list->vk_init_commands);
+    if (!(cookie_entry = (struct vkd3d_framebuffer_cookie_entry *)hash_map_find(&cache->cookie_map, &cookie)))
+    {
+        rw_spinlock_release_write(&cache->spinlock);
+        return;
+    }
+
+    framebuffers = cookie_entry->framebuffers;
+    framebuffer_count = cookie_entry->framebuffer_count;
+    hash_map_remove(&cache->cookie_map, &cookie_entry->entry);
+
+    for (i = 0; i < framebuffer_count; i++)
+    {
+        framebuffer = framebuffers[i];
+
+        if ((e = (struct vkd3d_framebuffer_entry *)hash_map_find(&cache->map, &framebuffer->key)))
+            hash_map_remove(&cache->map, &e->entry);
+
+        /* Drop the framebuffer from the lists of the other views it references */
+        for (j = 0; j < framebuffer->key.view_count; j++)
+        {
+            if (framebuffer->key.view_cookies[j] != cookie && vkd3d_framebuffer_key_is_first_cookie(&framebuffer->key, j))
+                vkd3d_framebuffer_cache_unlink_cookie_locked(cache, framebuffer->key.view_cookies[j], framebuffer);
+        }
+    }
+
+    rw_spinlock_release_write(&cache->spinlock);
+
+    /* Command allocators may still hold references to the framebuffers,
+     * in which case they are destroyed on allocator reset. Either way,
+     * vkDestroyFramebuffer never runs with the cache lock held. */
+    for (i = 0; i < framebuffer_count; i++)
+        vkd3d_framebuffer_decref(framebuffers[i], device);
+
+    vkd3d_free(framebuffers);
+
+    TRACE("Evicted %zu framebuffers referencing cookie %"PRIu64".\n", framebuffer_count, cookie);
 }
 
 static bool d3d12_command_allocator_add_render_pass(struct d3d12_command_allocator *allocator, VkRenderPass pass)
@@ -1277,6 +1768,18 @@ static bool d3d12_command_allocator_add_framebuffer(struct d3d12_command_allocat
     return true;
 }
 
+static bool d3d12_command_allocator_add_cached_framebuffer(struct d3d12_command_allocator *allocator,
+        struct vkd3d_framebuffer *framebuffer)
+{
+    if (!vkd3d_array_reserve((void **)&allocator->cached_framebuffers, &allocator->cached_framebuffers_size,
+            allocator->cached_framebuffer_count + 1, sizeof(*allocator->cached_framebuffers)))
+        return false;
+
+    allocator->cached_framebuffers[allocator->cached_framebuffer_count++] = framebuffer;
+
+    return true;
+}
+
 static bool d3d12_command_allocator_add_descriptor_pool(struct d3d12_command_allocator *allocator,
         VkDescriptorPool pool, enum vkd3d_descriptor_pool_types pool_type)
 {
@@ -1304,6 +1807,14 @@ static bool d3d12_command_allocator_add_view(struct d3d12_command_allocator *all
     return true;
 }
 
+static void d3d12_command_list_retain_view(struct d3d12_command_list *list, struct vkd3d_view *view)
+{
+    /* Cached views can only be evicted when view maps are bounded, in which
+     * case they must stay alive until the allocator is reset. */
+    if (view && list->device->view_map_limit)
+        d3d12_command_allocator_add_view(list->allocator, view);
+}
+
 static bool d3d12_command_allocator_add_buffer_view(struct d3d12_command_allocator *allocator,
         VkBufferView view)
 {
@@ -1507,6 +2018,12 @@ static void d3d12_command_allocator_free_resources(struct d3d12_command_allocato
     }
     allocator->framebuffer_count = 0;
 
+    for (i = 0; i < allocator->cached_framebuffer_count; ++i)
+    {
+        vkd3d_framebuffer_decref(allocator->cached_framebuffers[i], device);
+    }
+    allocator->cached_framebuffer_count = 0;
+
     for (i = 0; i < allocator->pass_count; ++i)
     {
         VK_CALL(vkDestroyRenderPass(device->vk_device, allocator->passes[i], NULL));
@@ -1585,10 +2102,12 @@ static ULONG STDMETHODCALLTYPE d3d12_command_allocator_Release(ID3D12CommandAllo
             vkd3d_free(allocator->descriptor_pool_caches[i].free_descriptor_pools);
         }
         vkd3d_free(allocator->framebuffers);
+        vkd3d_free(allocator->cached_framebuffers);
         vkd3d_free(allocator->passes);
 
         /* All command buffers are implicitly freed when a pool is destroyed. */
         vkd3d_free(allocator->command_buffers);
+        vkd3d_free(allocator->free_command_buffers);
         VK_CALL(vkDestroyCommandPool(device->vk_device, allocator->vk_command_pool, NULL));
 
         for (i = 0; i < allocator->scratch_buffer_count; i++)
@@ -1599,6 +2118,7 @@ static ULONG STDMETHODCALLTYPE d3d12_command_allocator_Release(ID3D12CommandAllo
 
         vkd3d_free(allocator->scratch_buffers);
         vkd3d_free(allocator->query_pools);
+        vkd3d_arena_destroy(&allocator->query_arena);
         vkd3d_free(allocator);
 
         d3d12_device_release(device);
@@ -1657,6 +2177,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_command_allocator_Reset(ID3D12CommandAllo
     LONG pending;
     VkResult vr;
     size_t i;
+    VKD3D_REGION_DECL(command_buffer_recycle);
 
     TRACE("iface %p.\n", iface);
 
@@ -1692,12 +2213,6 @@ static HRESULT STDMETHODCALLTYPE d3d12_command_allocator_Reset(ID3D12CommandAllo
     vk_procs = &device->vk_procs;
 
     d3d12_command_allocator_free_resources(allocator, true);
-    if (allocator->command_buffer_count)
-    {
-        VK_CALL(vkFreeCommandBuffers(device->vk_device, allocator->vk_command_pool,
-                allocator->command_buffer_count, allocator->command_buffers));
-        allocator->command_buffer_count = 0;
-    }
 
     /* The intent here is to recycle memory, so do not use RELEASE_RESOURCES_BIT here. */
     if ((vr = VK_CALL(vkResetCommandPool(device->vk_device, allocator->vk_command_pool, 0))))
@@ -1706,6 +2221,18 @@ static HRESULT STDMETHODCALLTYPE d3d12_command_allocator_Reset(ID3D12CommandAllo
         return hresult_from_vk_result(vr);
     }
 
+    /* Resetting the pool returns all command buffers to the initial state,
+     * so retired command buffers can be handed out again without freeing them. */
+    if (allocator->command_buffer_count)
+    {
+        VKD3D_REGION_BEGIN(command_buffer_recycle);
+        memcpy(&allocator->free_command_buffers[allocator->free_command_buffer_count], allocator->command_buffers,
+                allocator->command_buffer_count * sizeof(*allocator->command_buffers));
+        allocator->free_command_buffer_count += allocator->command_buffer_count;
+        VKD3D_REGION_END_ITERATIONS(command_buffer_recycle, allocator->command_buffer_count);
+        allocator->command_buffer_count = 0;
+    }
+
     /* Return scratch buffers to the device */
     for (i = 0; i < allocator->scratch_buffer_count; i++)
         d3d12_device_return_scratch_buffer(device, &allocator->scratch_buffers[i]);
@@ -1718,6 +2245,8 @@ static HRESULT STDMETHODCALLTYPE d3d12_command_allocator_Reset(ID3D12CommandAllo
 
     allocator->query_pool_count = 0;
     memset(&allocator->active_query_pools, 0, sizeof(allocator->active_query_pools));
+
+    vkd3d_arena_reset(&allocator->query_arena);
     return S_OK;
 }
 
@@ -1833,6 +2362,9 @@ static HRESULT d3d12_command_allocator_init(struct d3d12_command_allocator *allo
     allocator->framebuffers_size = 0;
     allocator->framebuffer_count = 0;
 
+    allocator->cached_framebuffers = NULL;
+    allocator->cached_framebuffers_size = 0;
+    allocator->cached_framebuffer_count = 0;
 
     allocator->views = NULL;
     allocator->views_size = 0;
@@ -1846,6 +2378,11 @@ static HRESULT d3d12_command_allocator_init(struct d3d12_command_allocator *allo
     allocator->command_buffers_size = 0;
     allocator->command_buffer_count = 0;
 
+    allocator->free_command_buffers = NULL;
+    allocator->free_command_buffers_size = 0;
+    allocator->free_command_buffer_count = 0;
+    allocator->command_buffer_total_count = 0;
+
     allocator->scratch_buffers = NULL;
     allocator->scratch_buffers_size = 0;
     allocator->scratch_buffer_count = 0;
@@ -1855,6 +2392,8 @@ static HRESULT d3d12_command_allocator_init(struct d3d12_command_allocator *allo
     allocator->query_pool_count = 0;
     memset(&allocator->active_query_pools, 0, sizeof(allocator->active_query_pools));
 
+    vkd3d_arena_init(&allocator->query_arena, VKD3D_QUERY_ARENA_BLOCK_SIZE);
+
     allocator->current_command_list = NULL;
 
     d3d12_device_add_ref(allocator->device = device);
@@ -3166,6 +3705,53 @@ int vkd3d_compare_pending_query(const void* query_a, const void* query_b)
     return (int)(a->vk_index - b->vk_index);
 }
 
+static struct vkd3d_active_query *d3d12_command_list_sort_pending_queries(struct d3d12_command_list *list,
+        struct vkd3d_arena *arena)
+{
+    struct vkd3d_active_query *sorted_queries;
+    struct vkd3d_rank_table *heaps, *pools;
+    uint32_t *values, heap_rank, pool_rank;
+    size_t i, count;
+    uint64_t *keys;
+
+    count = list->pending_queries_count;
+
+    if (!(keys = vkd3d_arena_alloc(arena, 2 * count * sizeof(*keys))) ||
+            !(values = vkd3d_arena_alloc(arena, 2 * count * sizeof(*values))) ||
+            !(sorted_queries = vkd3d_arena_alloc(arena, count * sizeof(*sorted_queries))) ||
+            !(heaps = vkd3d_arena_alloc(arena, sizeof(*heaps))) ||
+            !(pools = vkd3d_arena_alloc(arena, sizeof(*pools))))
+        return NULL;
+
+    vkd3d_rank_table_init(heaps);
+    vkd3d_rank_table_init(pools);
+
+    /* Queries only need to be grouped by heap and by pool within each heap,
+     * the relative order of heaps and pools does not matter. */
+    for (i = 0; i < count; i++)
+    {
+        const struct vkd3d_active_query *q = &list->pending_queries[i];
+
+        if (!vkd3d_rank_table_get(heaps, (uint64_t)(uintptr_t)q->heap, &heap_rank) ||
+                !vkd3d_rank_table_get(pools, (uint64_t)q->vk_pool, &pool_rank))
+        {
+            /* Too many distinct heaps or pools to rank cheaply. */
+            qsort(list->pending_queries, count, sizeof(*list->pending_queries), &vkd3d_compare_pending_query);
+            return list->pending_queries;
+        }
+
+        keys[i] = vkd3d_rank_sort_key(heap_rank, pool_rank, q->vk_index);
+        values[i] = i;
+    }
+
+    vkd3d_radix_sort_u64(keys, values, keys + count, values + count, count);
+
+    for (i = 0; i < count; i++)
+        sorted_queries[i] = list->pending_queries[values[i]];
+
+    return sorted_queries;
+}
+
 static size_t get_query_heap_stride(D3D12_QUERY_HEAP_TYPE heap_type)
 {
     if (heap_type == D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS)
@@ -3182,21 +3768,20 @@ static void d3d12_command_list_invalidate_root_parameters(struct d3d12_command_l
 
 static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list *list)
 {
-    /* TODO allocate arrays from command allocator in case
-     * games hit this path multiple times per frame */
     VkDeviceSize resolve_buffer_size, resolve_buffer_stride, ssbo_alignment, entry_buffer_size;
     const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
     struct vkd3d_scratch_allocation resolve_buffer, entry_buffer;
     VkDescriptorBufferInfo dst_buffer, src_buffer, map_buffer;
+    const struct vkd3d_active_query *src_queries, *prev;
     struct vkd3d_query_gather_info gather_pipeline;
-    const struct vkd3d_active_query *src_queries;
+    struct vkd3d_active_query *pending_queries;
+    struct vkd3d_arena *arena;
     unsigned int i, j, k, workgroup_count;
     uint32_t resolve_index, entry_offset;
     struct vkd3d_query_gather_args args;
     VkWriteDescriptorSet vk_writes[3];
     VkMemoryBarrier vk_barrier;
     VkDescriptorSet vk_set;
-    bool result = false;
 
     struct dispatch_entry
     {
@@ -3209,8 +3794,7 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
         VkDeviceSize resolve_buffer_size;
     };
     
-    struct dispatch_entry *dispatches = NULL;
-    size_t dispatch_size = 0;
+    struct dispatch_entry *dispatches;
     size_t dispatch_count = 0;
 
     struct resolve_entry
@@ -3222,8 +3806,7 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
         VkDeviceSize stride;
     };
     
-    struct resolve_entry *resolves = NULL;
-    size_t resolve_size = 0;
+    struct resolve_entry *resolves;
     size_t resolve_count = 0;
 
     struct query_entry
@@ -3239,17 +3822,47 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
         unsigned int dispatch_id;
     };
     
-    struct query_entry *dst_queries = NULL;
-    struct query_entry *query_list = NULL;
-    struct query_map *query_map = NULL;
+    struct query_entry *dst_queries;
+    struct query_entry *query_list;
+    struct query_map *query_map;
     size_t query_map_size = 0;
 
     if (!list->pending_queries_count)
         return true;
 
+    /* All temporary arrays live until the allocator is reset, so that
+     * gathering queries repeatedly does not go through the heap every time. */
+    arena = &list->allocator->query_arena;
+
     /* Sort pending query list so that we can batch commands */
-    qsort(list->pending_queries, list->pending_queries_count,
-            sizeof(*list->pending_queries), &vkd3d_compare_pending_query);
+    if (!(pending_queries = d3d12_command_list_sort_pending_queries(list, arena)))
+    {
+        ERR("Failed to sort pending queries.\n");
+        return false;
+    }
+
+    for (i = 0, prev = NULL; i < list->pending_queries_count; prev = &pending_queries[i++])
+    {
+        const struct vkd3d_active_query *q = &pending_queries[i];
+
+        if (!prev || prev->heap != q->heap)
+        {
+            dispatch_count++;
+            resolve_count++;
+        }
+        else if (prev->vk_pool != q->vk_pool || prev->vk_index + 1 != q->vk_index)
+            resolve_count++;
+    }
+
+    if (!(dispatches = vkd3d_arena_alloc(arena, dispatch_count * sizeof(*dispatches))) ||
+            !(resolves = vkd3d_arena_alloc(arena, resolve_count * sizeof(*resolves))))
+    {
+        ERR("Failed to allocate dispatch list.\n");
+        return false;
+    }
+
+    dispatch_count = 0;
+    resolve_count = 0;
 
     ssbo_alignment = d3d12_device_get_ssbo_alignment(list->device);
     resolve_buffer_size = 0;
@@ -3258,19 +3871,13 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
 
     for (i = 0; i < list->pending_queries_count; i++)
     {
-        struct dispatch_entry *d = dispatches ? &dispatches[dispatch_count - 1] : NULL;
-        struct resolve_entry *r = resolves ? &resolves[resolve_count - 1] : NULL;
-        struct vkd3d_active_query *q = &list->pending_queries[i];
+        struct dispatch_entry *d = dispatch_count ? &dispatches[dispatch_count - 1] : NULL;
+        struct resolve_entry *r = resolve_count ? &resolves[resolve_count - 1] : NULL;
+        struct vkd3d_active_query *q = &pending_queries[i];
 
         /* Prepare one compute dispatch per D3D12 query heap */
         if (!d || d->heap != q->heap)
         {
-            if (!vkd3d_array_reserve((void **)&dispatches, &dispatch_size, dispatch_count + 1, sizeof(*dispatches)))
-            {
-                ERR("Failed to allocate dispatch list.\n");
-                goto cleanup;
-            }
-
             /* Force new resolve entry as well so that binding the scratch buffer
              * doesn't get overly complicated when we need to deal with potential
              * SSBO alignment issues on some hardware. */
@@ -3298,12 +3905,6 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
         /* Prepare one resolve entry per Vulkan query range */
         if (!r || r->query_pool != q->vk_pool || r->first_query + r->query_count != q->vk_index)
         {
-            if (!vkd3d_array_reserve((void **)&resolves, &resolve_size, resolve_count + 1, sizeof(*resolves)))
-            {
-                ERR("Failed to allocate resolve list.\n");
-                goto cleanup;
-            }
-
             r = &resolves[resolve_count++];
             r->query_pool = q->vk_pool;
             r->first_query = q->vk_index;
@@ -3323,7 +3924,7 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
     /* Allocate scratch buffer and resolve virtual Vulkan queries into it */
     if (!d3d12_command_allocator_allocate_scratch_memory(list->allocator,
             resolve_buffer_size, max(ssbo_alignment, sizeof(uint64_t)), &resolve_buffer))
-        goto cleanup;
+        return false;
 
     for (i = 0; i < resolve_count; i++)
     {
@@ -3340,7 +3941,7 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
 
     if (!d3d12_command_allocator_allocate_scratch_memory(list->allocator,
             entry_buffer_size, ssbo_alignment, &entry_buffer))
-        goto cleanup;
+        return false;
 
     for (i = 0; i < dispatch_count; i++)
     {
@@ -3348,15 +3949,17 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
         query_map_size = max(query_map_size, d->max_index - d->min_index + 1);
     }
 
-    if (!(query_map = vkd3d_calloc(query_map_size, sizeof(*query_map))) ||
-            !(query_list = vkd3d_malloc(sizeof(*query_list) * list->pending_queries_count)))
+    if (!(query_map = vkd3d_arena_alloc(arena, sizeof(*query_map) * query_map_size)) ||
+            !(query_list = vkd3d_arena_alloc(arena, sizeof(*query_list) * list->pending_queries_count)))
     {
         ERR("Failed to allocate query map.\n");
-        goto cleanup;
+        return false;
     }
 
+    memset(query_map, 0, sizeof(*query_map) * query_map_size);
+
     /* Active list for the current dispatch */
-    src_queries = list->pending_queries;
+    src_queries = pending_queries;
     dst_queries = query_list;
 
     for (i = 0; i < dispatch_count; i++)
@@ -3449,7 +4052,7 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
 
         if (!(vkd3d_meta_get_query_gather_pipeline(&list->device->meta_ops,
                 d->heap->desc.Type, &gather_pipeline)))
-            goto cleanup;
+            return false;
 
         VK_CALL(vkCmdBindPipeline(list->vk_command_buffer,
                 VK_PIPELINE_BIND_POINT_COMPUTE, gather_pipeline.vk_pipeline));
@@ -3500,17 +4103,10 @@ static bool d3d12_command_list_gather_pending_queries(struct d3d12_command_list
             0, 1, &vk_barrier, 0, NULL, 0, NULL));
 
     list->pending_queries_count = 0;
-    result = true;
 
     d3d12_command_list_invalidate_current_pipeline(list, true);
     d3d12_command_list_invalidate_root_parameters(list, VK_PIPELINE_BIND_POINT_COMPUTE, true);
-
-cleanup:
-    vkd3d_free(resolves);
-    vkd3d_free(dispatches);
-    vkd3d_free(query_list);
-    vkd3d_free(query_map);
-    return result;
+    return true;
 }
 
 static void d3d12_command_list_end_current_render_pass(struct d3d12_command_list *list, bool suspend)
@@ -4504,14 +5100,24 @@ static bool d3d12_command_list_create_framebuffer(struct d3d12_command_list *lis
     return true;
 }
 
+static void vkd3d_framebuffer_key_add_view(struct vkd3d_framebuffer_key *key,
+        VkImageView *views, struct vkd3d_view *view)
+{
+    /* Views only take the framebuffer cache lock on destruction if they might be referenced by it. */
+    if (!(vkd3d_atomic_uint32_load_explicit(&view->flags, vkd3d_memory_order_relaxed) & VKD3D_VIEW_FRAMEBUFFER_ATTACHMENT))
+        vkd3d_atomic_uint32_or(&view->flags, VKD3D_VIEW_FRAMEBUFFER_ATTACHMENT, vkd3d_memory_order_relaxed);
+
+    key->view_cookies[key->view_count] = view->cookie;
+    views[key->view_count++] = view->vk_image_view;
+}
+
 static bool d3d12_command_list_update_current_framebuffer(struct d3d12_command_list *list)
 {
-    VkImageView views[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 2];
+    VkImageView views[VKD3D_FRAMEBUFFER_MAX_VIEWS];
     struct d3d12_graphics_pipeline_state *graphics;
-    VkFramebuffer vk_framebuffer;
-    unsigned int view_count;
+    struct vkd3d_framebuffer *framebuffer;
+    struct vkd3d_framebuffer_key key;
     uint32_t rtv_mask;
-    VkExtent3D extent;
     unsigned int i;
 
     if (list->current_framebuffer != VK_NULL_HANDLE)
@@ -4519,14 +5125,15 @@ static bool d3d12_command_list_update_current_framebuffer(struct d3d12_command_l
 
     graphics = &list->state->graphics;
     rtv_mask = graphics->rtv_active_mask & list->rtv_nonnull_mask;
-    view_count = 0;
+    key.render_pass = list->pso_render_pass;
+    key.view_count = 0;
 
     /* The pipeline has fallback render passes / PSO in case we're
      * attempting to render to unbound RTV. */
     while (rtv_mask)
     {
         i = vkd3d_bitmask_iter32(&rtv_mask);
-        views[view_count++] = list->rtvs[i].view->vk_image_view;
+        vkd3d_framebuffer_key_add_view(&key, views, list->rtvs[i].view);
     }
 
     if (d3d12_command_list_has_depth_stencil_view(list))
@@ -4537,21 +5144,34 @@ static bool d3d12_command_list_update_current_framebuffer(struct d3d12_command_l
             return false;
         }
 
-        views[view_count++] = list->dsv.view->vk_image_view;
+        vkd3d_framebuffer_key_add_view(&key, views, list->dsv.view);
     }
 
     if (list->vrs_image)
-        views[view_count++] = list->vrs_image->vrs_view;
+    {
+        key.view_cookies[key.view_count] = list->vrs_image->res.cookie;
+        views[key.view_count++] = list->vrs_image->vrs_view;
+    }
 
-    d3d12_command_list_get_fb_extent(list, &extent.width, &extent.height, &extent.depth);
+    d3d12_command_list_get_fb_extent(list, &key.width, &key.height, &key.layers);
 
-    if (!d3d12_command_list_create_framebuffer(list, list->pso_render_pass, view_count, views, extent, &vk_framebuffer))
+    if (!(framebuffer = vkd3d_framebuffer_cache_get(&list->device->framebuffer_cache,
+            list->device, &key, views)))
     {
         ERR("Failed to create framebuffer.\n");
         return false;
     }
 
-    list->current_framebuffer = vk_framebuffer;
+    /* The allocator keeps the framebuffer alive until reset, even if it is evicted
+     * from the cache in the meantime. */
+    if (!d3d12_command_allocator_add_cached_framebuffer(list->allocator, framebuffer))
+    {
+        WARN("Failed to add framebuffer.\n");
+        vkd3d_framebuffer_decref(framebuffer, list->device);
+        return false;
+    }
+
+    list->current_framebuffer = framebuffer->vk_framebuffer;
 
     return true;
 }
@@ -7978,6 +8598,8 @@ static void STDMETHODCALLTYPE d3d12_command_list_OMSetRenderTargets(d3d12_comman
 
         d3d12_command_list_track_resource_usage(list, rtv_desc->resource, true);
 
+        d3d12_command_list_retain_view(list, rtv_desc->view);
+
         list->rtvs[i] = *rtv_desc;
         list->rtv_nonnull_mask |= 1u << i;
         list->fb_width = min(list->fb_width, rtv_desc->width);
@@ -7991,6 +8613,7 @@ static void STDMETHODCALLTYPE d3d12_command_list_OMSetRenderTargets(d3d12_comman
                 && rtv_desc->resource)
         {
             d3d12_command_list_track_resource_usage(list, rtv_desc->resource, true);
+            d3d12_command_list_retain_view(list, rtv_desc->view);
 
             list->dsv = *rtv_desc;
             list->fb_width = min(list->fb_width, rtv_desc->width);
@@ -8071,6 +8694,7 @@ static void STDMETHODCALLTYPE d3d12_command_list_ClearDepthStencilView(d3d12_com
             iface, dsv.ptr, flags, depth, stencil, rect_count, rects);
 
     d3d12_command_list_track_resource_usage(list, dsv_desc->resource, true);
+    d3d12_command_list_retain_view(list, dsv_desc->view);
 
     if (flags & D3D12_CLEAR_FLAG_DEPTH)
         clear_aspects |= VK_IMAGE_ASPECT_DEPTH_BIT;
@@ -8101,6 +8725,7 @@ static void STDMETHODCALLTYPE d3d12_command_list_ClearRenderTargetView(d3d12_com
             iface, rtv.ptr, color, rect_count, rects);
 
     d3d12_command_list_track_resource_usage(list, rtv_desc->resource, true);
+    d3d12_command_list_retain_view(list, rtv_desc->view);
 
     if (rtv_desc->format->type == VKD3D_FORMAT_TYPE_UINT)
     {
@@ -8433,7 +9058,10 @@ static void STDMETHODCALLTYPE d3d12_command_list_ClearUnorderedAccessViewUint(d3
         return;
 
     if (args.has_view)
+    {
+        d3d12_command_list_retain_view(list, desc->info.view);
         color = vkd3d_fixup_clear_uav_swizzle(list->device, desc->info.view->format->dxgi_format, color);
+    }
 
     if (args.has_view && desc->info.view->format->type != VKD3D_FORMAT_TYPE_UINT)
     {
@@ -8523,7 +9151,10 @@ static void STDMETHODCALLTYPE d3d12_command_list_ClearUnorderedAccessViewFloat(d
         return;
 
     if (args.has_view)
+    {
+        d3d12_command_list_retain_view(list, desc->info.view);
         color = vkd3d_fixup_clear_uav_swizzle(list->device, desc->info.view->format->dxgi_format, color);
+    }
 
     d3d12_command_list_clear_uav(list, desc, resource_impl, &args, &color, rect_count, rects);
 }
@@ -9156,6 +9787,79 @@ STATIC_ASSERT(sizeof(VkDispatchIndirectCommand) == sizeof(D3D12_DISPATCH_ARGUMEN
 STATIC_ASSERT(sizeof(VkDrawIndexedIndirectCommand) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
 STATIC_ASSERT(sizeof(VkDrawIndirectCommand) == sizeof(D3D12_DRAW_ARGUMENTS));
 
+static bool d3d12_command_list_emit_execute_indirect_expansion(struct d3d12_command_list *list,
+        enum vkd3d_execute_indirect_type type, VkDeviceAddress arg_va, uint32_t arg_stride,
+        VkDeviceAddress count_va, uint32_t max_command_count, struct vkd3d_scratch_allocation *scratch)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_execute_indirect_info pipeline_info;
+    struct vkd3d_execute_indirect_args args;
+    VkExtent3D workgroup_size;
+    VkMemoryBarrier vk_barrier;
+
+    vkd3d_meta_get_execute_indirect_pipeline(&list->device->meta_ops, type, &pipeline_info);
+    workgroup_size = vkd3d_meta_get_execute_indirect_workgroup_size();
+
+    if (!d3d12_command_allocator_allocate_scratch_memory(list->allocator,
+            (VkDeviceSize)max_command_count * pipeline_info.command_size, sizeof(uint32_t), scratch))
+        return false;
+
+    d3d12_command_list_end_current_render_pass(list, true);
+
+    d3d12_command_list_invalidate_current_pipeline(list, true);
+    d3d12_command_list_invalidate_root_parameters(list, VK_PIPELINE_BIND_POINT_COMPUTE, true);
+
+    args.src_arg_va = arg_va;
+    args.dst_arg_va = scratch->va;
+    args.count_va = count_va;
+    args.predicate_va = list->predicate_va;
+    args.src_arg_stride = arg_stride / sizeof(uint32_t);
+    args.max_command_count = max_command_count;
+    args.has_count = !!count_va;
+    args.has_predicate = !!list->predicate_va;
+
+    VK_CALL(vkCmdBindPipeline(list->vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipeline_info.vk_pipeline));
+    VK_CALL(vkCmdPushConstants(list->vk_command_buffer,
+            pipeline_info.vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+            0, sizeof(args), &args));
+    VK_CALL(vkCmdDispatch(list->vk_command_buffer,
+            vkd3d_compute_workgroup_count(max_command_count, workgroup_size.width), 1, 1));
+
+    vk_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    vk_barrier.pNext = NULL;
+    vk_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    vk_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            0, 1, &vk_barrier, 0, NULL, 0, NULL));
+    return true;
+}
+
+/* Vulkan has no count buffer variant of vkCmdDispatchIndirect, so every command
+ * a multi-dispatch might execute is recorded as its own dispatch. */
+#define VKD3D_EXECUTE_INDIRECT_MAX_DISPATCH_COUNT 64
+
+static UINT d3d12_command_signature_clamp_command_count(const struct d3d12_command_signature *signature,
+        const struct d3d12_resource *arg_buffer, UINT64 arg_buffer_offset, UINT max_command_count)
+{
+    UINT64 command_count;
+
+    /* Applications tend to pass a generous upper bound along with a count buffer,
+     * but no more commands than fit into the argument buffer can ever execute. */
+    if (arg_buffer_offset + signature->command_size > arg_buffer->desc.Width)
+        return 0;
+
+    if (!signature->desc.ByteStride)
+        return max_command_count;
+
+    command_count = (arg_buffer->desc.Width - arg_buffer_offset - signature->command_size) /
+            signature->desc.ByteStride + 1;
+    return min(max_command_count, command_count);
+}
+
 static void STDMETHODCALLTYPE d3d12_command_list_ExecuteIndirect(d3d12_command_list_iface *iface,
         ID3D12CommandSignature *command_signature, UINT max_command_count, ID3D12Resource *arg_buffer,
         UINT64 arg_buffer_offset, ID3D12Resource *count_buffer, UINT64 count_buffer_offset)
@@ -9166,69 +9870,144 @@ static void STDMETHODCALLTYPE d3d12_command_list_ExecuteIndirect(d3d12_command_l
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList(iface);
     const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
     const D3D12_COMMAND_SIGNATURE_DESC *signature_desc = &sig_impl->desc;
+    enum vkd3d_execute_indirect_type expand_type;
     struct vkd3d_scratch_allocation scratch;
-    unsigned int i;
+    VkDeviceSize arg_offset, arg_stride;
+    bool has_draw_count, use_expansion;
+    VkBuffer arg_vk_buffer;
+    unsigned int i, j;
+
+    TRACE("iface %p, command_signature %p, max_command_count %u, arg_buffer %p, "
+            "arg_buffer_offset %#"PRIx64", count_buffer %p, count_buffer_offset %#"PRIx64".\n",
+            iface, command_signature, max_command_count, arg_buffer, arg_buffer_offset,
+            count_buffer, count_buffer_offset);
+
+    if (!(max_command_count = d3d12_command_signature_clamp_command_count(sig_impl,
+            arg_impl, arg_buffer_offset, max_command_count)))
+        return;
+
+    /* Applying root constants, root descriptors or vertex/index buffer views per command
+     * requires device-generated commands, which are not supported. Such signatures run
+     * their draws, or a single dispatch, with the state set before ExecuteIndirect. */
+    if (sig_impl->has_state_arguments)
+        FIXME_ONCE("Ignoring state-changing arguments of command signature %p.\n", sig_impl);
+
+    /* The draw or dispatch is always the last argument, and state-changing arguments
+     * can only precede it. Locate it within each command record. */
+    arg_buffer_offset += sig_impl->argument_offset;
+
+    for (i = 0; i < signature_desc->NumArgumentDescs; ++i)
+    {
+        const D3D12_INDIRECT_ARGUMENT_DESC *arg_desc = &signature_desc->pArgumentDescs[i];
+
+        switch (arg_desc->Type)
+        {
+            case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
+                expand_type = VKD3D_EXECUTE_INDIRECT_DRAW;
+                break;
+
+            case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
+                expand_type = VKD3D_EXECUTE_INDIRECT_DRAW_INDEXED;
+                break;
+
+            case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
+                expand_type = VKD3D_EXECUTE_INDIRECT_DISPATCH;
+                break;
 
-    TRACE("iface %p, command_signature %p, max_command_count %u, arg_buffer %p, "
-            "arg_buffer_offset %#"PRIx64", count_buffer %p, count_buffer_offset %#"PRIx64".\n",
-            iface, command_signature, max_command_count, arg_buffer, arg_buffer_offset,
-            count_buffer, count_buffer_offset);
+            default:
+                continue;
+        }
 
-    if ((count_buffer || list->predicate_va) && !list->device->vk_info.KHR_draw_indirect_count)
-    {
-        FIXME("Count buffers not supported by Vulkan implementation.\n");
-        return;
-    }
+        arg_vk_buffer = arg_impl->res.vk_buffer;
+        arg_offset = arg_impl->mem.offset + arg_buffer_offset;
+        arg_stride = signature_desc->ByteStride;
+        has_draw_count = false;
 
-    for (i = 0; i < signature_desc->NumArgumentDescs; ++i)
-    {
-        const D3D12_INDIRECT_ARGUMENT_DESC *arg_desc = &signature_desc->pArgumentDescs[i];
+        /* Applications commonly pass a large upper bound along with a count buffer.
+         * Don't record thousands of dispatches which do nothing. */
+        if (expand_type == VKD3D_EXECUTE_INDIRECT_DISPATCH &&
+                max_command_count > VKD3D_EXECUTE_INDIRECT_MAX_DISPATCH_COUNT)
+        {
+            FIXME_ONCE("Limiting indirect dispatch command count %u to %u.\n",
+                    max_command_count, VKD3D_EXECUTE_INDIRECT_MAX_DISPATCH_COUNT);
+            max_command_count = VKD3D_EXECUTE_INDIRECT_MAX_DISPATCH_COUNT;
+        }
 
-        if (list->predicate_va)
+        /* Multi-dispatch and count buffers have no direct Vulkan equivalent for
+         * dispatches, and count buffers or predication on draws need draw_indirect_count.
+         * Otherwise, expand the stream on the GPU into a fixed-count stream where
+         * commands which must not run are no-ops. */
+        use_expansion = expand_type == VKD3D_EXECUTE_INDIRECT_DISPATCH ? (max_command_count > 1 || count_buffer) :
+                ((count_buffer || list->predicate_va) && !list->device->vk_info.KHR_draw_indirect_count);
+
+        /* Every command of an expanded stream would run with the same stale state,
+         * so keep such signatures on the direct path. */
+        if (use_expansion && sig_impl->has_state_arguments)
+        {
+            if (expand_type != VKD3D_EXECUTE_INDIRECT_DISPATCH)
+            {
+                FIXME("Count buffers not supported by Vulkan implementation.\n");
+                return;
+            }
+
+            FIXME("Ignoring command count %u and count buffer %p for signature with state-changing arguments.\n",
+                    max_command_count, count_buffer);
+            use_expansion = false;
+            max_command_count = 1;
+            count_buffer = NULL;
+        }
+
+        if (use_expansion)
+        {
+            if (!d3d12_command_list_emit_execute_indirect_expansion(list, expand_type,
+                    d3d12_resource_get_va(arg_impl, arg_buffer_offset), signature_desc->ByteStride,
+                    count_buffer ? d3d12_resource_get_va(count_impl, count_buffer_offset) : 0,
+                    max_command_count, &scratch))
+                return;
+
+            arg_vk_buffer = scratch.buffer;
+            arg_offset = scratch.offset;
+            arg_stride = list->device->meta_ops.execute_indirect.command_sizes[expand_type];
+        }
+        else if (list->predicate_va)
         {
             union vkd3d_predicate_command_direct_args args;
             enum vkd3d_predicate_command_type type;
             VkDeviceSize indirect_va;
 
-            switch (arg_desc->Type)
+            if (expand_type == VKD3D_EXECUTE_INDIRECT_DISPATCH)
             {
-                case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
-                case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
-                    if (count_buffer)
-                    {
-                        type = VKD3D_PREDICATE_COMMAND_DRAW_INDIRECT_COUNT;
-                        indirect_va = d3d12_resource_get_va(count_impl, count_buffer_offset);
-                    }
-                    else
-                    {
-                        args.draw_count = max_command_count;
-                        type = VKD3D_PREDICATE_COMMAND_DRAW_INDIRECT;
-                        indirect_va = 0;
-                    }
-                    break;
-
-                case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
-                    type = VKD3D_PREDICATE_COMMAND_DISPATCH_INDIRECT;
-                    indirect_va = d3d12_resource_get_va(arg_impl, arg_buffer_offset);
-                    break;
-
-                default:
-                    FIXME("Ignoring unhandled argument type %#x.\n", arg_desc->Type);
-                    continue;
+                type = VKD3D_PREDICATE_COMMAND_DISPATCH_INDIRECT;
+                indirect_va = d3d12_resource_get_va(arg_impl, arg_buffer_offset);
+            }
+            else if (count_buffer)
+            {
+                type = VKD3D_PREDICATE_COMMAND_DRAW_INDIRECT_COUNT;
+                indirect_va = d3d12_resource_get_va(count_impl, count_buffer_offset);
+            }
+            else
+            {
+                args.draw_count = max_command_count;
+                type = VKD3D_PREDICATE_COMMAND_DRAW_INDIRECT;
+                indirect_va = 0;
             }
 
             if (!d3d12_command_list_emit_predicated_command(list, type, indirect_va, &args, &scratch))
                 return;
+
+            if (expand_type == VKD3D_EXECUTE_INDIRECT_DISPATCH)
+            {
+                arg_vk_buffer = scratch.buffer;
+                arg_offset = scratch.offset;
+            }
+            else
+                has_draw_count = true;
         }
         else if (count_buffer)
         {
             scratch.buffer = count_impl->res.vk_buffer;
             scratch.offset = count_impl->mem.offset + count_buffer_offset;
-        }
-        else
-        {
-            scratch.buffer = arg_impl->res.vk_buffer;
-            scratch.offset = arg_impl->mem.offset + arg_buffer_offset;
+            has_draw_count = true;
         }
 
         switch (arg_desc->Type)
@@ -9240,16 +10019,16 @@ static void STDMETHODCALLTYPE d3d12_command_list_ExecuteIndirect(d3d12_command_l
                     break;
                 }
 
-                if (count_buffer || list->predicate_va)
+                if (has_draw_count)
                 {
-                    VK_CALL(vkCmdDrawIndirectCountKHR(list->vk_command_buffer, arg_impl->res.vk_buffer,
-                            arg_buffer_offset + arg_impl->mem.offset, scratch.buffer, scratch.offset,
-                            max_command_count, signature_desc->ByteStride));
+                    VK_CALL(vkCmdDrawIndirectCountKHR(list->vk_command_buffer, arg_vk_buffer,
+                            arg_offset, scratch.buffer, scratch.offset,
+                            max_command_count, arg_stride));
                 }
                 else
                 {
-                    VK_CALL(vkCmdDrawIndirect(list->vk_command_buffer, arg_impl->res.vk_buffer,
-                            arg_buffer_offset + arg_impl->mem.offset, max_command_count, signature_desc->ByteStride));
+                    VK_CALL(vkCmdDrawIndirect(list->vk_command_buffer, arg_vk_buffer,
+                            arg_offset, max_command_count, arg_stride));
                 }
                 break;
 
@@ -9268,37 +10047,35 @@ static void STDMETHODCALLTYPE d3d12_command_list_ExecuteIndirect(d3d12_command_l
 
                 d3d12_command_list_check_index_buffer_strip_cut_value(list);
 
-                if (count_buffer || list->predicate_va)
+                if (has_draw_count)
                 {
-                    VK_CALL(vkCmdDrawIndexedIndirectCountKHR(list->vk_command_buffer, arg_impl->res.vk_buffer,
-                            arg_buffer_offset + arg_impl->mem.offset, scratch.buffer, scratch.offset,
-                            max_command_count, signature_desc->ByteStride));
+                    VK_CALL(vkCmdDrawIndexedIndirectCountKHR(list->vk_command_buffer, arg_vk_buffer,
+                            arg_offset, scratch.buffer, scratch.offset,
+                            max_command_count, arg_stride));
                 }
                 else
                 {
-                    VK_CALL(vkCmdDrawIndexedIndirect(list->vk_command_buffer, arg_impl->res.vk_buffer,
-                            arg_buffer_offset + arg_impl->mem.offset, max_command_count, signature_desc->ByteStride));
+                    VK_CALL(vkCmdDrawIndexedIndirect(list->vk_command_buffer, arg_vk_buffer,
+                            arg_offset, max_command_count, arg_stride));
                 }
                 break;
 
             case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
-                if (max_command_count != 1)
-                    FIXME("Ignoring command count %u.\n", max_command_count);
-
-                if (count_buffer)
-                    FIXME_ONCE("Count buffers not supported for indirect dispatch.\n");
-
                 if (!d3d12_command_list_update_compute_state(list))
                 {
                     WARN("Failed to update compute state, ignoring dispatch.\n");
                     return;
                 }
 
-                VK_CALL(vkCmdDispatchIndirect(list->vk_command_buffer, scratch.buffer, scratch.offset));
+                /* Commands beyond the count buffer value dispatch no workgroups. */
+                for (j = 0; j < max_command_count; j++)
+                {
+                    VK_CALL(vkCmdDispatchIndirect(list->vk_command_buffer, arg_vk_buffer,
+                            arg_offset + j * arg_stride));
+                }
                 break;
 
             default:
-                FIXME("Ignoring unhandled argument type %#x.\n", arg_desc->Type);
                 break;
         }
     }
@@ -10085,7 +10862,6 @@ static ULONG STDMETHODCALLTYPE d3d12_command_queue_Release(ID3D12CommandQueue *i
         vkd3d_private_store_destroy(&command_queue->private_store);
 
         d3d12_command_queue_submit_stop(command_queue);
-        vkd3d_fence_worker_stop(&command_queue->fence_worker, device);
         d3d12_device_unmap_vkd3d_queue(device, command_queue->vkd3d_queue);
         pthread_join(command_queue->submission_thread, NULL);
         pthread_mutex_destroy(&command_queue->queue_lock);
@@ -10311,6 +11087,8 @@ static void STDMETHODCALLTYPE d3d12_command_queue_UpdateTileMappings(ID3D12Comma
     }
 
     vkd3d_free(bound_tiles);
+    /* Released by the submission worker once the binds are flushed. */
+    vkd3d_resource_incref(resource);
     d3d12_command_queue_add_submission(command_queue, &sub);
     return;
 
@@ -10358,6 +11136,8 @@ static void STDMETHODCALLTYPE d3d12_command_queue_CopyTileMappings(ID3D12Command
         bind->vk_offset = 0;
     }
 
+    vkd3d_resource_incref(dst_resource);
+    vkd3d_resource_incref(src_resource);
     d3d12_command_queue_add_submission(command_queue, &sub);
 }
 
@@ -10744,6 +11524,7 @@ static void d3d12_command_queue_wait(struct d3d12_command_queue *command_queue,
     if (vr < 0)
     {
         ERR("Failed to submit wait operation, vr %d.\n", vr);
+        vkd3d_dbg_flush_on_device_lost(vr);
     }
 
     /* We should probably trigger DEVICE_REMOVED if we hit any errors in the submission thread. */
@@ -10812,10 +11593,11 @@ static void d3d12_command_queue_signal(struct d3d12_command_queue *command_queue
     if (vr < 0)
     {
         ERR("Failed to submit signal operation, vr %d.\n", vr);
+        vkd3d_dbg_flush_on_device_lost(vr);
         return;
     }
 
-    if (FAILED(hr = vkd3d_enqueue_timeline_semaphore(&command_queue->fence_worker, fence, physical_value, vkd3d_queue)))
+    if (FAILED(hr = vkd3d_enqueue_timeline_semaphore(&command_queue->device->fence_worker, fence, physical_value, vkd3d_queue)))
     {
         /* In case of an unexpected failure, try to safely destroy Vulkan objects. */
         vkd3d_queue_wait_idle(vkd3d_queue, vk_procs);
@@ -11152,7 +11934,10 @@ static void d3d12_command_queue_execute(struct d3d12_command_queue *command_queu
 #endif
 
     if ((vr = VK_CALL(vkQueueSubmit(vk_queue, num_submits, submit_desc, VK_NULL_HANDLE))) < 0)
+    {
         ERR("Failed to submit queue(s), vr %d.\n", vr);
+        vkd3d_dbg_flush_on_device_lost(vr);
+    }
 
 #ifdef VKD3D_ENABLE_RENDERDOC
     if (debug_capture)
@@ -11163,33 +11948,19 @@ static void d3d12_command_queue_execute(struct d3d12_command_queue *command_queu
     vkd3d_queue_release(vkd3d_queue);
 }
 
-static unsigned int vkd3d_compact_sparse_bind_ranges(const struct d3d12_resource *src_resource,
-        struct vkd3d_sparse_memory_bind_range *bind_ranges, struct vkd3d_sparse_memory_bind *bind_infos,
-        unsigned int count, enum vkd3d_sparse_memory_bind_mode mode, bool can_compact)
+static unsigned int vkd3d_compact_sparse_bind_ranges(struct vkd3d_sparse_memory_bind_range *bind_ranges,
+        const struct vkd3d_sparse_memory_bind *bind_infos, unsigned int count, bool can_compact)
 {
     struct vkd3d_sparse_memory_bind_range *range = NULL;
-    VkDeviceMemory vk_memory;
-    VkDeviceSize vk_offset;
     unsigned int i, j;
 
     for (i = 0, j = 0; i < count; i++)
     {
-        struct vkd3d_sparse_memory_bind *bind = &bind_infos[i];
+        const struct vkd3d_sparse_memory_bind *bind = &bind_infos[i];
 
-        if (mode == VKD3D_SPARSE_MEMORY_BIND_MODE_UPDATE)
-        {
-            vk_memory = bind->vk_memory;
-            vk_offset = bind->vk_offset;
-        }
-        else /* if (mode == VKD3D_SPARSE_MEMORY_BIND_MODE_COPY) */
-        {
-            struct d3d12_sparse_tile *src_tile = &src_resource->sparse.tiles[bind->src_tile];
-            vk_memory = src_tile->vk_memory;
-            vk_offset = src_tile->vk_offset;
-        }
-
-        if (can_compact && range && bind->dst_tile == range->tile_index + range->tile_count && vk_memory == range->vk_memory &&
-                (vk_offset == range->vk_offset + range->tile_count * VKD3D_TILE_SIZE || !vk_memory))
+        if (can_compact && range && bind->dst_tile == range->tile_index + range->tile_count &&
+                bind->vk_memory == range->vk_memory &&
+                (bind->vk_offset == range->vk_offset + range->tile_count * VKD3D_TILE_SIZE || !bind->vk_memory))
         {
             range->tile_count++;
         }
@@ -11198,135 +11969,166 @@ static unsigned int vkd3d_compact_sparse_bind_ranges(const struct d3d12_resource
             range = &bind_ranges[j++];
             range->tile_index = bind->dst_tile;
             range->tile_count = 1;
-            range->vk_memory = vk_memory;
-            range->vk_offset = vk_offset;
+            range->vk_memory = bind->vk_memory;
+            range->vk_offset = bind->vk_offset;
         }
     }
 
     return j;
 }
 
-static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_queue,
-        enum vkd3d_sparse_memory_bind_mode mode, struct d3d12_resource *dst_resource,
-        struct d3d12_resource *src_resource, unsigned int count,
-        struct vkd3d_sparse_memory_bind *bind_infos)
+/* Tile mapping updates are accumulated until the next non-sparse submission and then
+ * flushed with a single vkQueueBindSparse. The CPU-side tile table is updated as binds
+ * are added, so that tile mapping copies observe preceding updates in the same batch,
+ * and only the final mapping of each tile is sent to Vulkan. */
+struct d3d12_command_queue_sparse_batch_entry
 {
-    const VkPipelineStageFlags wait_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    struct vkd3d_sparse_memory_bind_range *bind_ranges = NULL;
-    unsigned int first_packed_tile, processed_tiles;
-    VkSparseImageOpaqueMemoryBindInfo opaque_info;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    VkSparseImageMemoryBind *image_binds = NULL;
-    VkSparseBufferMemoryBindInfo buffer_info;
-    VkSparseMemoryBind *memory_binds = NULL;
-    VkSparseImageMemoryBindInfo image_info;
-    VkBindSparseInfo bind_sparse_info;
-    struct vkd3d_queue *queue_sparse;
-    struct vkd3d_queue *queue;
-    VkSubmitInfo submit_info;
-    VkQueue vk_queue_sparse;
-    unsigned int i, j, k;
-    VkQueue vk_queue;
-    bool can_compact;
-    VkResult vr;
+    struct d3d12_resource *resource;
+    uint32_t tile_index;
+};
 
-    TRACE("queue %p, dst_resource %p, src_resource %p, count %u, bind_infos %p.\n",
-          command_queue, dst_resource, src_resource, count, bind_infos);
+struct d3d12_command_queue_sparse_batch
+{
+    struct d3d12_command_queue_sparse_batch_entry *entries;
+    size_t entries_size;
+    size_t entry_count;
+
+    /* Resources referenced by the batched submissions, released after the flush. */
+    struct d3d12_resource **resources;
+    size_t resources_size;
+    size_t resource_count;
+
+    struct vkd3d_sparse_memory_bind *binds;
+    size_t binds_size;
+    struct vkd3d_sparse_memory_bind_range *ranges;
+    size_t ranges_size;
+
+    VkSparseMemoryBind *memory_binds;
+    size_t memory_binds_size;
+    size_t memory_bind_count;
+    VkSparseImageMemoryBind *image_binds;
+    size_t image_binds_size;
+    size_t image_bind_count;
+
+    VkSparseBufferMemoryBindInfo *buffer_infos;
+    size_t buffer_infos_size;
+    size_t buffer_info_count;
+    VkSparseImageOpaqueMemoryBindInfo *opaque_infos;
+    size_t opaque_infos_size;
+    size_t opaque_info_count;
+    VkSparseImageMemoryBindInfo *image_infos;
+    size_t image_infos_size;
+    size_t image_info_count;
+};
 
-    vk_procs = &command_queue->device->vk_procs;
+static void d3d12_command_queue_sparse_batch_cleanup(struct d3d12_command_queue_sparse_batch *batch)
+{
+    vkd3d_free(batch->entries);
+    vkd3d_free(batch->resources);
+    vkd3d_free(batch->binds);
+    vkd3d_free(batch->ranges);
+    vkd3d_free(batch->memory_binds);
+    vkd3d_free(batch->image_binds);
+    vkd3d_free(batch->buffer_infos);
+    vkd3d_free(batch->opaque_infos);
+    vkd3d_free(batch->image_infos);
+}
 
-    bind_sparse_info.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
-    bind_sparse_info.pNext = NULL;
-    bind_sparse_info.bufferBindCount = 0;
-    bind_sparse_info.pBufferBinds = NULL;
-    bind_sparse_info.imageOpaqueBindCount = 0;
-    bind_sparse_info.pImageOpaqueBinds = NULL;
-    bind_sparse_info.imageBindCount = 0;
-    bind_sparse_info.pImageBinds = NULL;
+static void d3d12_command_queue_sparse_batch_add(struct d3d12_command_queue_sparse_batch *batch,
+        const struct d3d12_command_queue_submission_bind_sparse *bind_sparse)
+{
+    struct d3d12_resource *dst_resource = bind_sparse->dst_resource;
+    struct d3d12_command_queue_sparse_batch_entry *entry;
+    struct vkd3d_sparse_memory_bind *bind;
+    struct d3d12_sparse_tile *tile;
+    unsigned int i;
+
+    TRACE("dst_resource %p, src_resource %p, count %u, bind_infos %p.\n",
+            dst_resource, bind_sparse->src_resource, bind_sparse->bind_count, bind_sparse->bind_infos);
 
-    if (!(bind_ranges = vkd3d_malloc(count * sizeof(*bind_ranges))))
+    if (!vkd3d_array_reserve((void **)&batch->resources, &batch->resources_size,
+            batch->resource_count + 2, sizeof(*batch->resources)))
     {
-        ERR("Failed to allocate bind range info.\n");
-        goto cleanup;
+        ERR("Failed to allocate sparse bind batch.\n");
+        vkd3d_resource_decref((ID3D12Resource *)&dst_resource->ID3D12Resource_iface);
+        if (bind_sparse->src_resource)
+            vkd3d_resource_decref((ID3D12Resource *)&bind_sparse->src_resource->ID3D12Resource_iface);
+        return;
     }
 
-    /* NV driver is buggy and test_update_tile_mappings fails (bug 3274618). */
-    can_compact = command_queue->device->device_info.properties2.properties.vendorID != VKD3D_VENDOR_ID_NVIDIA;
-    count = vkd3d_compact_sparse_bind_ranges(src_resource, bind_ranges, bind_infos, count, mode, can_compact);
+    batch->resources[batch->resource_count++] = dst_resource;
+    if (bind_sparse->src_resource)
+        batch->resources[batch->resource_count++] = bind_sparse->src_resource;
 
-    first_packed_tile = dst_resource->sparse.tile_count;
+    if (!vkd3d_array_reserve((void **)&batch->entries, &batch->entries_size,
+            batch->entry_count + bind_sparse->bind_count, sizeof(*batch->entries)))
+    {
+        ERR("Failed to allocate sparse bind batch.\n");
+        return;
+    }
 
-    if (d3d12_resource_is_buffer(dst_resource))
+    /* Resolve all source tiles before updating any destination tile,
+     * since source and destination may overlap. */
+    if (bind_sparse->mode == VKD3D_SPARSE_MEMORY_BIND_MODE_COPY)
     {
-        if (!(memory_binds = vkd3d_malloc(count * sizeof(*memory_binds))))
+        for (i = 0; i < bind_sparse->bind_count; i++)
         {
-            ERR("Failed to allocate sparse memory bind info.\n");
-            goto cleanup;
+            bind = &bind_sparse->bind_infos[i];
+            tile = &bind_sparse->src_resource->sparse.tiles[bind->src_tile];
+            bind->vk_memory = tile->vk_memory;
+            bind->vk_offset = tile->vk_offset;
         }
-
-        buffer_info.buffer = dst_resource->res.vk_buffer;
-        buffer_info.bindCount = count;
-        buffer_info.pBinds = memory_binds;
-
-        bind_sparse_info.bufferBindCount = 1;
-        bind_sparse_info.pBufferBinds = &buffer_info;
     }
-    else
-    {
-        unsigned int opaque_bind_count = 0;
-        unsigned int image_bind_count = 0;
-
-        if (dst_resource->sparse.packed_mips.NumPackedMips)
-            first_packed_tile = dst_resource->sparse.packed_mips.StartTileIndexInOverallResource;
 
-        for (i = 0; i < count; i++)
-        {
-            const struct vkd3d_sparse_memory_bind_range *bind = &bind_ranges[i];
+    for (i = 0; i < bind_sparse->bind_count; i++)
+    {
+        bind = &bind_sparse->bind_infos[i];
+        tile = &dst_resource->sparse.tiles[bind->dst_tile];
+        tile->vk_memory = bind->vk_memory;
+        tile->vk_offset = bind->vk_offset;
 
-            if (bind->tile_index < first_packed_tile)
-                image_bind_count += bind->tile_count;
-            if (bind->tile_index + bind->tile_count > first_packed_tile)
-                opaque_bind_count++;
-        }
+        entry = &batch->entries[batch->entry_count++];
+        entry->resource = dst_resource;
+        entry->tile_index = bind->dst_tile;
+    }
+}
 
-        if (opaque_bind_count)
-        {
-            if (!(memory_binds = vkd3d_malloc(opaque_bind_count * sizeof(*memory_binds))))
-            {
-                ERR("Failed to allocate sparse memory bind info.\n");
-                goto cleanup;
-            }
+static int d3d12_command_queue_sparse_batch_entry_compare(const void *a, const void *b)
+{
+    const struct d3d12_command_queue_sparse_batch_entry *entry_a = a;
+    const struct d3d12_command_queue_sparse_batch_entry *entry_b = b;
 
-            opaque_info.image = dst_resource->res.vk_image;
-            opaque_info.bindCount = opaque_bind_count;
-            opaque_info.pBinds = memory_binds;
+    if (entry_a->resource != entry_b->resource)
+        return (uintptr_t)entry_a->resource < (uintptr_t)entry_b->resource ? -1 : 1;
+    if (entry_a->tile_index != entry_b->tile_index)
+        return entry_a->tile_index < entry_b->tile_index ? -1 : 1;
+    return 0;
+}
 
-            bind_sparse_info.imageOpaqueBindCount = 1;
-            bind_sparse_info.pImageOpaqueBinds = &opaque_info;
-        }
+static bool d3d12_command_queue_sparse_batch_add_resource(struct d3d12_command_queue_sparse_batch *batch,
+        struct d3d12_resource *dst_resource, unsigned int count, bool can_compact)
+{
+    size_t first_memory_bind, first_image_bind;
+    VkSparseImageOpaqueMemoryBindInfo *opaque_info;
+    unsigned int first_packed_tile, processed_tiles;
+    VkSparseBufferMemoryBindInfo *buffer_info;
+    VkSparseImageMemoryBindInfo *image_info;
+    unsigned int i;
 
-        if (image_bind_count)
-        {
-            if (!(image_binds = vkd3d_malloc(image_bind_count * sizeof(*image_binds))))
-            {
-                ERR("Failed to allocate sparse memory bind info.\n");
-                goto cleanup;
-            }
+    count = vkd3d_compact_sparse_bind_ranges(batch->ranges, batch->binds, count, can_compact);
 
-            /* The image bind count is not exact but only an upper limit,
-             * so do the actual counting while filling in bind infos */
-            image_info.image = dst_resource->res.vk_image;
-            image_info.bindCount = 0;
-            image_info.pBinds = image_binds;
+    first_memory_bind = batch->memory_bind_count;
+    first_image_bind = batch->image_bind_count;
+    first_packed_tile = dst_resource->sparse.tile_count;
 
-            bind_sparse_info.imageBindCount = 1;
-            bind_sparse_info.pImageBinds = &image_info;
-        }
-    }
+    if (d3d12_resource_is_texture(dst_resource) && dst_resource->sparse.packed_mips.NumPackedMips)
+        first_packed_tile = dst_resource->sparse.packed_mips.StartTileIndexInOverallResource;
 
-    for (i = 0, k = 0; i < count; i++)
+    /* Memory and image bind arrays are reserved for the whole batch up front,
+     * since bind infos point into them. */
+    for (i = 0; i < count; i++)
     {
-        struct vkd3d_sparse_memory_bind_range *bind = &bind_ranges[i];
+        struct vkd3d_sparse_memory_bind_range *bind = &batch->ranges[i];
 
         while (bind->tile_count)
         {
@@ -11336,13 +12138,13 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
             {
                 const D3D12_SUBRESOURCE_TILING *tiling = &dst_resource->sparse.tilings[tile->image.subresource_index];
                 const uint32_t tile_count = tiling->WidthInTiles * tiling->HeightInTiles * tiling->DepthInTiles;
+                VkSparseImageMemoryBind *vk_bind = &batch->image_binds[batch->image_bind_count++];
 
                 if (bind->tile_index == tiling->StartTileIndexInOverallResource && bind->tile_count >= tile_count)
                 {
                     /* Bind entire subresource at once to reduce overhead */
                     const struct d3d12_sparse_tile *last_tile = &tile[tile_count - 1];
 
-                    VkSparseImageMemoryBind *vk_bind = &image_binds[image_info.bindCount++];
                     vk_bind->subresource = tile->image.subresource;
                     vk_bind->offset = tile->image.offset;
                     vk_bind->extent.width = last_tile->image.offset.x + last_tile->image.extent.width;
@@ -11356,7 +12158,6 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
                 }
                 else
                 {
-                    VkSparseImageMemoryBind *vk_bind = &image_binds[image_info.bindCount++];
                     vk_bind->subresource = tile->image.subresource;
                     vk_bind->offset = tile->image.offset;
                     vk_bind->extent = tile->image.extent;
@@ -11370,8 +12171,8 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
             else
             {
                 const struct d3d12_sparse_tile *last_tile = &tile[bind->tile_count - 1];
+                VkSparseMemoryBind *vk_bind = &batch->memory_binds[batch->memory_bind_count++];
 
-                VkSparseMemoryBind *vk_bind = &memory_binds[k++];
                 vk_bind->resourceOffset = tile->buffer.offset;
                 vk_bind->size = last_tile->buffer.offset
                               + last_tile->buffer.length
@@ -11383,18 +12184,68 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
                 processed_tiles = bind->tile_count;
             }
 
-            for (j = 0; j < processed_tiles; j++)
-            {
-                tile[j].vk_memory = bind->vk_memory;
-                tile[j].vk_offset = bind->vk_offset + j * VKD3D_TILE_SIZE;
-            }
-
             bind->tile_index += processed_tiles;
             bind->tile_count -= processed_tiles;
             bind->vk_offset += processed_tiles * VKD3D_TILE_SIZE;
         }
     }
 
+    if (batch->memory_bind_count > first_memory_bind)
+    {
+        if (d3d12_resource_is_buffer(dst_resource))
+        {
+            if (!vkd3d_array_reserve((void **)&batch->buffer_infos, &batch->buffer_infos_size,
+                    batch->buffer_info_count + 1, sizeof(*batch->buffer_infos)))
+                return false;
+
+            buffer_info = &batch->buffer_infos[batch->buffer_info_count++];
+            buffer_info->buffer = dst_resource->res.vk_buffer;
+            buffer_info->bindCount = batch->memory_bind_count - first_memory_bind;
+            buffer_info->pBinds = &batch->memory_binds[first_memory_bind];
+        }
+        else
+        {
+            if (!vkd3d_array_reserve((void **)&batch->opaque_infos, &batch->opaque_infos_size,
+                    batch->opaque_info_count + 1, sizeof(*batch->opaque_infos)))
+                return false;
+
+            opaque_info = &batch->opaque_infos[batch->opaque_info_count++];
+            opaque_info->image = dst_resource->res.vk_image;
+            opaque_info->bindCount = batch->memory_bind_count - first_memory_bind;
+            opaque_info->pBinds = &batch->memory_binds[first_memory_bind];
+        }
+    }
+
+    if (batch->image_bind_count > first_image_bind)
+    {
+        if (!vkd3d_array_reserve((void **)&batch->image_infos, &batch->image_infos_size,
+                batch->image_info_count + 1, sizeof(*batch->image_infos)))
+            return false;
+
+        image_info = &batch->image_infos[batch->image_info_count++];
+        image_info->image = dst_resource->res.vk_image;
+        image_info->bindCount = batch->image_bind_count - first_image_bind;
+        image_info->pBinds = &batch->image_binds[first_image_bind];
+    }
+
+    return true;
+}
+
+static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_queue,
+        const VkBindSparseInfo *bind_sparse_info)
+{
+    const VkPipelineStageFlags wait_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    const struct vkd3d_vk_device_procs *vk_procs;
+    VkBindSparseInfo serialized_bind_info;
+    struct vkd3d_queue *queue_sparse;
+    struct vkd3d_queue *queue;
+    VkSubmitInfo submit_info;
+    VkQueue vk_queue_sparse;
+    VkQueue vk_queue;
+    VkResult vr;
+
+    vk_procs = &command_queue->device->vk_procs;
+
     /* Ensure that we use a queue that supports sparse binding */
     queue = command_queue->vkd3d_queue;
 
@@ -11406,7 +12257,7 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
     if (!(vk_queue = vkd3d_queue_acquire(queue)))
     {
         ERR("Failed to acquire queue %p.\n", queue);
-        goto cleanup;
+        return;
     }
 
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -11422,7 +12273,10 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
     /* We need to serialize sparse bind operations.
      * Create a roundtrip with binary semaphores. */
     if ((vr = VK_CALL(vkQueueSubmit(vk_queue, 1, &submit_info, VK_NULL_HANDLE))) < 0)
+    {
         ERR("Failed to submit signal, vr %d.\n", vr);
+        vkd3d_dbg_flush_on_device_lost(vr);
+    }
 
     if (queue != queue_sparse)
     {
@@ -11430,18 +12284,19 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
         {
             ERR("Failed to acquire queue %p.\n", queue_sparse);
             vkd3d_queue_release(queue);
-            goto cleanup;
+            return;
         }
     }
     else
         vk_queue_sparse = vk_queue;
 
-    bind_sparse_info.pWaitSemaphores = &queue->serializing_binary_semaphore;
-    bind_sparse_info.pSignalSemaphores = &queue->serializing_binary_semaphore;
-    bind_sparse_info.waitSemaphoreCount = 1;
-    bind_sparse_info.signalSemaphoreCount = 1;
+    serialized_bind_info = *bind_sparse_info;
+    serialized_bind_info.pWaitSemaphores = &queue->serializing_binary_semaphore;
+    serialized_bind_info.pSignalSemaphores = &queue->serializing_binary_semaphore;
+    serialized_bind_info.waitSemaphoreCount = 1;
+    serialized_bind_info.signalSemaphoreCount = 1;
 
-    if ((vr = VK_CALL(vkQueueBindSparse(vk_queue_sparse, 1, &bind_sparse_info, VK_NULL_HANDLE))) < 0)
+    if ((vr = VK_CALL(vkQueueBindSparse(vk_queue_sparse, 1, &serialized_bind_info, VK_NULL_HANDLE))) < 0)
         ERR("Failed to perform sparse binding, vr %d.\n", vr);
 
     if (queue != queue_sparse)
@@ -11454,14 +12309,105 @@ static void d3d12_command_queue_bind_sparse(struct d3d12_command_queue *command_
     submit_info.signalSemaphoreCount = 0;
 
     if ((vr = VK_CALL(vkQueueSubmit(vk_queue, 1, &submit_info, VK_NULL_HANDLE))) < 0)
+    {
         ERR("Failed to submit signal, vr %d.\n", vr);
+        vkd3d_dbg_flush_on_device_lost(vr);
+    }
 
     vkd3d_queue_release(queue);
+}
 
-cleanup:
-    vkd3d_free(memory_binds);
-    vkd3d_free(image_binds);
-    vkd3d_free(bind_ranges);
+static void d3d12_command_queue_sparse_batch_flush(struct d3d12_command_queue_sparse_batch *batch,
+        struct d3d12_command_queue *command_queue)
+{
+    struct d3d12_command_queue_sparse_batch_entry *entry;
+    VkBindSparseInfo bind_sparse_info;
+    size_t i, j, count, group_start;
+    struct d3d12_resource *resource;
+    bool can_compact;
+
+    if (!batch->entry_count)
+        goto done;
+
+    /* Sort by resource and tile, and only keep one entry per tile. The tile table
+     * already holds the final mapping of every tile touched in this batch. */
+    qsort(batch->entries, batch->entry_count, sizeof(*batch->entries),
+            d3d12_command_queue_sparse_batch_entry_compare);
+
+    for (i = 1, count = 1; i < batch->entry_count; i++)
+    {
+        if (d3d12_command_queue_sparse_batch_entry_compare(&batch->entries[i], &batch->entries[count - 1]))
+            batch->entries[count++] = batch->entries[i];
+    }
+
+    TRACE("Flushing %zu sparse binds, %zu unique tiles.\n", batch->entry_count, count);
+
+    batch->memory_bind_count = 0;
+    batch->image_bind_count = 0;
+    batch->buffer_info_count = 0;
+    batch->opaque_info_count = 0;
+    batch->image_info_count = 0;
+
+    if (!vkd3d_array_reserve((void **)&batch->binds, &batch->binds_size, count, sizeof(*batch->binds)) ||
+            !vkd3d_array_reserve((void **)&batch->ranges, &batch->ranges_size, count, sizeof(*batch->ranges)) ||
+            !vkd3d_array_reserve((void **)&batch->memory_binds, &batch->memory_binds_size,
+                    count, sizeof(*batch->memory_binds)) ||
+            !vkd3d_array_reserve((void **)&batch->image_binds, &batch->image_binds_size,
+                    count, sizeof(*batch->image_binds)))
+    {
+        ERR("Failed to allocate sparse bind info.\n");
+        goto done;
+    }
+
+    /* NV driver is buggy and test_update_tile_mappings fails (bug 3274618). */
+    can_compact = command_queue->device->device_info.properties2.properties.vendorID != VKD3D_VENDOR_ID_NVIDIA;
+
+    for (i = 0, group_start = 0; i <= count; i++)
+    {
+        if (i < count && batch->entries[i].resource == batch->entries[group_start].resource)
+            continue;
+
+        resource = batch->entries[group_start].resource;
+
+        for (j = group_start; j < i; j++)
+        {
+            entry = &batch->entries[j];
+            batch->binds[j - group_start].dst_tile = entry->tile_index;
+            batch->binds[j - group_start].src_tile = 0;
+            batch->binds[j - group_start].vk_memory = resource->sparse.tiles[entry->tile_index].vk_memory;
+            batch->binds[j - group_start].vk_offset = resource->sparse.tiles[entry->tile_index].vk_offset;
+        }
+
+        if (!d3d12_command_queue_sparse_batch_add_resource(batch, resource, i - group_start, can_compact))
+        {
+            ERR("Failed to allocate sparse bind info.\n");
+            goto done;
+        }
+
+        group_start = i;
+    }
+
+    bind_sparse_info.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+    bind_sparse_info.pNext = NULL;
+    bind_sparse_info.waitSemaphoreCount = 0;
+    bind_sparse_info.pWaitSemaphores = NULL;
+    bind_sparse_info.bufferBindCount = batch->buffer_info_count;
+    bind_sparse_info.pBufferBinds = batch->buffer_infos;
+    bind_sparse_info.imageOpaqueBindCount = batch->opaque_info_count;
+    bind_sparse_info.pImageOpaqueBinds = batch->opaque_infos;
+    bind_sparse_info.imageBindCount = batch->image_info_count;
+    bind_sparse_info.pImageBinds = batch->image_infos;
+    bind_sparse_info.signalSemaphoreCount = 0;
+    bind_sparse_info.pSignalSemaphores = NULL;
+
+    d3d12_command_queue_bind_sparse(command_queue, &bind_sparse_info);
+
+done:
+    for (i = 0; i < batch->resource_count; i++)
+        vkd3d_resource_decref((ID3D12Resource *)&batch->resources[i]->ID3D12Resource_iface);
+
+    batch->resource_count = 0;
+    batch->entry_count = 0;
 }
 
 void d3d12_command_queue_submit_stop(struct d3d12_command_queue *queue)
@@ -11511,14 +12457,39 @@ static void d3d12_command_queue_release_serialized(struct d3d12_command_queue *q
     pthread_mutex_unlock(&queue->queue_lock);
 }
 
+static bool d3d12_command_queue_submission_can_merge_execute(const struct d3d12_command_queue_submission *submission)
+{
+    /* Initial transitions and debug captures are tied to the vkQueueSubmit of a particular
+     * ExecuteCommandLists call, so only plain submissions can be folded into a previous one. */
+    return submission->type == VKD3D_SUBMISSION_EXECUTE &&
+            !submission->execute.transition_count &&
+            !submission->execute.debug_capture;
+}
+
+static void d3d12_command_queue_submission_execute_cleanup(struct d3d12_command_queue_submission_execute *execute)
+{
+    unsigned int i;
+
+    vkd3d_free(execute->cmd);
+    vkd3d_free(execute->transitions);
+    /* TODO: The correct place to do this would be in a fence handler, but this is good enough for now. */
+    for (i = 0; i < execute->outstanding_submissions_counter_count; i++)
+        InterlockedDecrement(execute->outstanding_submissions_counters[i]);
+    vkd3d_free(execute->outstanding_submissions_counters);
+}
+
 static void *d3d12_command_queue_submission_worker_main(void *userdata)
 {
-    struct d3d12_command_queue_submission submission;
+    struct d3d12_command_queue_submission *submissions = NULL, *submission;
+    size_t submissions_count = 0, submissions_size = 0, swap_size;
+    struct d3d12_command_queue_sparse_batch sparse_batch;
     struct d3d12_command_queue_transition_pool pool;
+    size_t merged_cmd_count, merged_cmd_size = 0;
     struct d3d12_command_queue *queue = userdata;
     uint64_t transition_timeline_value = 0;
+    VkCommandBuffer *merged_cmd = NULL;
     VkCommandBuffer transition_cmd;
-    unsigned int i;
+    size_t i, j, merge_count;
     HRESULT hr;
 
     VKD3D_REGION_DECL(queue_wait);
@@ -11527,81 +12498,134 @@ static void *d3d12_command_queue_submission_worker_main(void *userdata)
 
     vkd3d_set_thread_name("vkd3d_queue");
 
+    memset(&sparse_batch, 0, sizeof(sparse_batch));
+
     if (FAILED(hr = d3d12_command_queue_transition_pool_init(&pool, queue)))
         ERR("Failed to initialize transition pool.\n");
 
     for (;;)
     {
+        /* Grab every pending submission at once by swapping arrays with the producers.
+         * This keeps the critical section O(1) regardless of how deep the backlog is. */
         pthread_mutex_lock(&queue->queue_lock);
         while (queue->submissions_count == 0)
             pthread_cond_wait(&queue->queue_cond, &queue->queue_lock);
 
-        queue->submissions_count--;
-        submission = queue->submissions[0];
-        memmove(queue->submissions, queue->submissions + 1, queue->submissions_count * sizeof(submission));
+        submission = queue->submissions;
+        queue->submissions = submissions;
+        submissions = submission;
+
+        submissions_count = queue->submissions_count;
+        queue->submissions_count = 0;
+
+        swap_size = queue->submissions_size;
+        queue->submissions_size = submissions_size;
+        submissions_size = swap_size;
         pthread_mutex_unlock(&queue->queue_lock);
 
-        switch (submission.type)
+        for (i = 0; i < submissions_count; i++)
         {
-        case VKD3D_SUBMISSION_STOP:
-            goto cleanup;
+            submission = &submissions[i];
 
-        case VKD3D_SUBMISSION_WAIT:
-            VKD3D_REGION_BEGIN(queue_wait);
-            d3d12_command_queue_wait(queue, submission.wait.fence, submission.wait.value);
-            d3d12_fence_dec_ref(submission.wait.fence);
-            VKD3D_REGION_END(queue_wait);
-            break;
+            switch (submission->type)
+            {
+            case VKD3D_SUBMISSION_STOP:
+                goto cleanup;
 
-        case VKD3D_SUBMISSION_SIGNAL:
-            VKD3D_REGION_BEGIN(queue_signal);
-            d3d12_command_queue_signal(queue, submission.signal.fence, submission.signal.value);
-            d3d12_fence_dec_ref(submission.signal.fence);
-            VKD3D_REGION_END(queue_signal);
-            break;
+            case VKD3D_SUBMISSION_WAIT:
+                VKD3D_REGION_BEGIN(queue_wait);
+                d3d12_command_queue_wait(queue, submission->wait.fence, submission->wait.value);
+                d3d12_fence_dec_ref(submission->wait.fence);
+                VKD3D_REGION_END(queue_wait);
+                break;
 
-        case VKD3D_SUBMISSION_EXECUTE:
-            VKD3D_REGION_BEGIN(queue_execute);
-            d3d12_command_queue_transition_pool_build(&pool, queue->device,
-                    submission.execute.transitions,
-                    submission.execute.transition_count,
-                    &transition_cmd, &transition_timeline_value);
-            d3d12_command_queue_execute(queue, submission.execute.cmd,
-                    submission.execute.cmd_count,
-                    transition_cmd, pool.timeline, transition_timeline_value,
-                    submission.execute.debug_capture);
-            vkd3d_free(submission.execute.cmd);
-            vkd3d_free(submission.execute.transitions);
-            /* TODO: The correct place to do this would be in a fence handler, but this is good enough for now. */
-            for (i = 0; i < submission.execute.outstanding_submissions_counter_count; i++)
-                InterlockedDecrement(submission.execute.outstanding_submissions_counters[i]);
-            vkd3d_free(submission.execute.outstanding_submissions_counters);
-            VKD3D_REGION_END(queue_execute);
-            break;
+            case VKD3D_SUBMISSION_SIGNAL:
+                VKD3D_REGION_BEGIN(queue_signal);
+                d3d12_command_queue_signal(queue, submission->signal.fence, submission->signal.value);
+                d3d12_fence_dec_ref(submission->signal.fence);
+                VKD3D_REGION_END(queue_signal);
+                break;
 
-        case VKD3D_SUBMISSION_BIND_SPARSE:
-            d3d12_command_queue_bind_sparse(queue, submission.bind_sparse.mode,
-                    submission.bind_sparse.dst_resource, submission.bind_sparse.src_resource,
-                    submission.bind_sparse.bind_count, submission.bind_sparse.bind_infos);
-            vkd3d_free(submission.bind_sparse.bind_infos);
-            break;
+            case VKD3D_SUBMISSION_EXECUTE:
+                VKD3D_REGION_BEGIN(queue_execute);
+                d3d12_command_queue_transition_pool_build(&pool, queue->device,
+                        submission->execute.transitions,
+                        submission->execute.transition_count,
+                        &transition_cmd, &transition_timeline_value);
+
+                /* Fold back-to-back ExecuteCommandLists calls into a single vkQueueSubmit.
+                 * Every submission already ends with a full barrier, so this is transparent. */
+                merge_count = 1;
+                merged_cmd_count = submission->execute.cmd_count;
+                if (!submission->execute.debug_capture)
+                {
+                    while (i + merge_count < submissions_count &&
+                            d3d12_command_queue_submission_can_merge_execute(&submissions[i + merge_count]))
+                        merged_cmd_count += submissions[i + merge_count++].execute.cmd_count;
+                }
 
-        case VKD3D_SUBMISSION_DRAIN:
-        {
-            pthread_mutex_lock(&queue->queue_lock);
-            queue->queue_drain_count++;
-            pthread_cond_signal(&queue->queue_cond);
-            pthread_mutex_unlock(&queue->queue_lock);
-            break;
-        }
+                if (merge_count > 1 && vkd3d_array_reserve((void **)&merged_cmd, &merged_cmd_size,
+                        merged_cmd_count, sizeof(*merged_cmd)))
+                {
+                    for (j = 0, merged_cmd_count = 0; j < merge_count; j++)
+                    {
+                        memcpy(merged_cmd + merged_cmd_count, submissions[i + j].execute.cmd,
+                                submissions[i + j].execute.cmd_count * sizeof(*merged_cmd));
+                        merged_cmd_count += submissions[i + j].execute.cmd_count;
+                    }
 
-        default:
-            ERR("Unrecognized submission type %u.\n", submission.type);
-            break;
+                    TRACE("Merging %zu submissions.\n", merge_count);
+                    d3d12_command_queue_execute(queue, merged_cmd, merged_cmd_count,
+                            transition_cmd, pool.timeline, transition_timeline_value, false);
+                }
+                else
+                {
+                    merge_count = 1;
+                    d3d12_command_queue_execute(queue, submission->execute.cmd,
+                            submission->execute.cmd_count,
+                            transition_cmd, pool.timeline, transition_timeline_value,
+                            submission->execute.debug_capture);
+                }
+
+                for (j = 0; j < merge_count; j++)
+                    d3d12_command_queue_submission_execute_cleanup(&submissions[i + j].execute);
+                i += merge_count - 1;
+                VKD3D_REGION_END_ITERATIONS(queue_execute, merge_count);
+                break;
+
+            case VKD3D_SUBMISSION_BIND_SPARSE:
+                /* Coalesce back-to-back tile mapping updates into one bind operation. Updates
+                 * pile up while the worker is busy, and it dequeues all of them at once. */
+                for (j = i; j < submissions_count && submissions[j].type == VKD3D_SUBMISSION_BIND_SPARSE; j++)
+                {
+                    d3d12_command_queue_sparse_batch_add(&sparse_batch, &submissions[j].bind_sparse);
+                    vkd3d_free(submissions[j].bind_sparse.bind_infos);
+                }
+
+                d3d12_command_queue_sparse_batch_flush(&sparse_batch, queue);
+                i = j - 1;
+                break;
+
+            case VKD3D_SUBMISSION_DRAIN:
+            {
+                pthread_mutex_lock(&queue->queue_lock);
+                queue->queue_drain_count++;
+                pthread_cond_signal(&queue->queue_cond);
+                pthread_mutex_unlock(&queue->queue_lock);
+                break;
+            }
+
+            default:
+                ERR("Unrecognized submission type %u.\n", submission->type);
+                break;
+            }
         }
     }
 
 cleanup:
+    d3d12_command_queue_sparse_batch_cleanup(&sparse_batch);
+    vkd3d_free(merged_cmd);
+    vkd3d_free(submissions);
     d3d12_command_queue_transition_pool_deinit(&pool, queue->device);
     return NULL;
 }
@@ -11656,9 +12680,6 @@ static HRESULT d3d12_command_queue_init(struct d3d12_command_queue *queue,
 
     d3d12_device_add_ref(queue->device = device);
 
-    if (FAILED(hr = vkd3d_fence_worker_start(&queue->fence_worker, device)))
-        goto fail_fence_worker_start;
-
     if ((rc = pthread_create(&queue->submission_thread, NULL, d3d12_command_queue_submission_worker_main, queue)) < 0)
     {
         d3d12_device_release(queue->device);
@@ -11668,9 +12689,7 @@ static HRESULT d3d12_command_queue_init(struct d3d12_command_queue *queue,
 
     return S_OK;
 
-fail_pthread_create:
-    vkd3d_fence_worker_stop(&queue->fence_worker, device);
-fail_fence_worker_start:;
+fail_pthread_create:;
 #ifdef VKD3D_BUILD_STANDALONE_D3D12
 fail_swapchain_factory:
     vkd3d_private_store_destroy(&queue->private_store);
@@ -11864,9 +12883,36 @@ CONST_VTBL struct ID3D12CommandSignatureVtbl d3d12_command_signature_vtbl =
     d3d12_command_signature_GetDevice,
 };
 
+static uint32_t d3d12_command_signature_get_argument_size(const D3D12_INDIRECT_ARGUMENT_DESC *argument_desc)
+{
+    switch (argument_desc->Type)
+    {
+        case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
+            return sizeof(D3D12_DRAW_ARGUMENTS);
+        case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
+            return sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+        case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
+            return sizeof(D3D12_DISPATCH_ARGUMENTS);
+        case D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW:
+            return sizeof(D3D12_VERTEX_BUFFER_VIEW);
+        case D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW:
+            return sizeof(D3D12_INDEX_BUFFER_VIEW);
+        case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
+            return argument_desc->Constant.Num32BitValuesToSet * sizeof(uint32_t);
+        case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
+        case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW:
+        case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW:
+            return sizeof(D3D12_GPU_VIRTUAL_ADDRESS);
+        default:
+            FIXME("Unhandled argument type %#x.\n", argument_desc->Type);
+            return 0;
+    }
+}
+
 HRESULT d3d12_command_signature_create(struct d3d12_device *device, const D3D12_COMMAND_SIGNATURE_DESC *desc,
         struct d3d12_command_signature **signature)
 {
+    uint32_t argument_offset = 0, command_size = 0;
     struct d3d12_command_signature *object;
     unsigned int i;
     HRESULT hr;
@@ -11884,8 +12930,10 @@ HRESULT d3d12_command_signature_create(struct d3d12_device *device, const D3D12_
                     WARN("Draw/dispatch must be the last element of a command signature.\n");
                     return E_INVALIDARG;
                 }
+                command_size = argument_offset + d3d12_command_signature_get_argument_size(argument_desc);
                 break;
             default:
+                argument_offset += d3d12_command_signature_get_argument_size(argument_desc);
                 break;
         }
     }
@@ -11895,6 +12943,9 @@ HRESULT d3d12_command_signature_create(struct d3d12_device *device, const D3D12_
 
     object->ID3D12CommandSignature_iface.lpVtbl = &d3d12_command_signature_vtbl;
     object->refcount = 1;
+    object->argument_offset = argument_offset;
+    object->command_size = command_size;
+    object->has_state_arguments = argument_offset != 0;
 
     object->desc = *desc;
     if (!(object->desc.pArgumentDescs = vkd3d_calloc(desc->NumArgumentDescs, sizeof(*desc->pArgumentDescs))))
@@ -2684,6 +2684,11 @@ static void d3d12_device_destroy(struct d3d12_device *device)
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     size_t i;
 
+    vkd3d_pipeline_variant_worker_stop(&device->pipeline_variant_worker, device);
+    vkd3d_copy_workers_stop(&device->copy_workers, device);
+    /* Drains outstanding fence signals, which may release the last fence references. */
+    vkd3d_fence_worker_stop(&device->fence_worker, device);
+
     for (i = 0; i < device->scratch_buffer_count; i++)
         d3d12_device_destroy_scratch_buffer(device, &device->scratch_buffers[i]);
 
@@ -2698,10 +2703,13 @@ static void d3d12_device_destroy(struct d3d12_device *device)
     vkd3d_memory_info_cleanup(&device->memory_info, device);
     vkd3d_shader_debug_ring_cleanup(&device->debug_ring, device);
     d3d12_device_global_pipeline_cache_cleanup(device);
+    vkd3d_shader_disk_cache_cleanup(&device->disk_shader_cache);
     vkd3d_sampler_state_cleanup(&device->sampler_state, device);
     vkd3d_view_map_destroy(&device->sampler_map, device);
     vkd3d_meta_ops_cleanup(&device->meta_ops, device);
     vkd3d_bindless_state_cleanup(&device->bindless_state, device);
+    vkd3d_framebuffer_cache_cleanup(&device->framebuffer_cache, device);
+    vkd3d_root_signature_cache_cleanup(&device->root_signature_cache);
     vkd3d_render_pass_cache_cleanup(&device->render_pass_cache, device);
     d3d12_device_destroy_vkd3d_queues(device);
     vkd3d_memory_allocator_cleanup(&device->memory_allocator, device);
@@ -2757,6 +2765,8 @@ static ULONG STDMETHODCALLTYPE d3d12_device_Release(d3d12_device_iface *iface)
         d3d12_remove_device_singleton(device->adapter_luid);
         d3d12_device_destroy(device);
         vkd3d_free(device);
+        /* Applications may unload us right after releasing the device. */
+        vkd3d_dbg_flush();
     }
 
     if (is_locked)
@@ -3823,23 +3833,31 @@ static void STDMETHODCALLTYPE d3d12_device_CreateConstantBufferView(d3d12_device
         const D3D12_CONSTANT_BUFFER_VIEW_DESC *desc, D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
     struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_desc *d3d12_desc = d3d12_desc_from_cpu_handle(descriptor);
+    struct vkd3d_view *old_view;
 
     TRACE("iface %p, desc %p, descriptor %#lx.\n", iface, desc, descriptor.ptr);
 
-    d3d12_desc_create_cbv(d3d12_desc_from_cpu_handle(descriptor), device, desc);
+    old_view = d3d12_desc_begin_update(d3d12_desc, NULL, device);
+    d3d12_desc_create_cbv(d3d12_desc, device, desc);
+    d3d12_desc_end_update(d3d12_desc, old_view, NULL, device);
 }
 
 static void STDMETHODCALLTYPE d3d12_device_CreateShaderResourceView(d3d12_device_iface *iface,
         ID3D12Resource *resource, const D3D12_SHADER_RESOURCE_VIEW_DESC *desc,
         D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
+    struct d3d12_desc *d3d12_desc = d3d12_desc_from_cpu_handle(descriptor);
+    struct d3d12_resource *d3d12_resource = impl_from_ID3D12Resource(resource);
     struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct vkd3d_view *old_view;
 
     TRACE("iface %p, resource %p, desc %p, descriptor %#lx.\n",
             iface, resource, desc, descriptor.ptr);
 
-    d3d12_desc_create_srv(d3d12_desc_from_cpu_handle(descriptor),
-            device, impl_from_ID3D12Resource(resource), desc);
+    old_view = d3d12_desc_begin_update(d3d12_desc, d3d12_resource, device);
+    d3d12_desc_create_srv(d3d12_desc, device, d3d12_resource, desc);
+    d3d12_desc_end_update(d3d12_desc, old_view, d3d12_resource, device);
 }
 
 VKD3D_THREAD_LOCAL struct D3D12_UAV_INFO *d3d12_uav_info = NULL;
@@ -3855,12 +3873,15 @@ static void STDMETHODCALLTYPE d3d12_device_CreateUnorderedAccessView(d3d12_devic
     struct d3d12_resource *d3d12_resource_ = impl_from_ID3D12Resource(resource);
     struct d3d12_device *device = impl_from_ID3D12Device(iface);
     struct d3d12_desc *d3d12_desc_cpu = d3d12_desc_from_cpu_handle(descriptor);
+    struct vkd3d_view *old_view;
     TRACE("iface %p, resource %p, counter_resource %p, desc %p, descriptor %#lx.\n",
             iface, resource, counter_resource, desc, descriptor.ptr);
 
+    old_view = d3d12_desc_begin_update(d3d12_desc_cpu, d3d12_resource_, device);
     d3d12_desc_create_uav(d3d12_desc_cpu,
             device, d3d12_resource_,
             impl_from_ID3D12Resource(counter_resource), desc);
+    d3d12_desc_end_update(d3d12_desc_cpu, old_view, d3d12_resource_, device);
     
     /* d3d12_uav_info stores the pointer to data from previous call to d3d12_device_vkd3d_ext_CaptureUAVInfo(). Below code will update the data. */
     if (d3d12_uav_info)
@@ -3888,32 +3909,48 @@ static void STDMETHODCALLTYPE d3d12_device_CreateRenderTargetView(d3d12_device_i
         ID3D12Resource *resource, const D3D12_RENDER_TARGET_VIEW_DESC *desc,
         D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
+    struct d3d12_rtv_desc *rtv_desc = d3d12_rtv_desc_from_cpu_handle(descriptor);
+    struct d3d12_resource *d3d12_resource = impl_from_ID3D12Resource(resource);
+    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct vkd3d_view *old_view;
+
     TRACE("iface %p, resource %p, desc %p, descriptor %#lx.\n",
             iface, resource, desc, descriptor.ptr);
 
-    d3d12_rtv_desc_create_rtv(d3d12_rtv_desc_from_cpu_handle(descriptor),
-            impl_from_ID3D12Device(iface), impl_from_ID3D12Resource(resource), desc);
+    old_view = d3d12_rtv_desc_begin_update(rtv_desc, d3d12_resource, device);
+    d3d12_rtv_desc_create_rtv(rtv_desc, device, d3d12_resource, desc);
+    d3d12_rtv_desc_end_update(rtv_desc, old_view, d3d12_resource, device);
 }
 
 static void STDMETHODCALLTYPE d3d12_device_CreateDepthStencilView(d3d12_device_iface *iface,
         ID3D12Resource *resource, const D3D12_DEPTH_STENCIL_VIEW_DESC *desc,
         D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
+    struct d3d12_rtv_desc *rtv_desc = d3d12_rtv_desc_from_cpu_handle(descriptor);
+    struct d3d12_resource *d3d12_resource = impl_from_ID3D12Resource(resource);
+    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct vkd3d_view *old_view;
+
     TRACE("iface %p, resource %p, desc %p, descriptor %#lx.\n",
             iface, resource, desc, descriptor.ptr);
 
-    d3d12_rtv_desc_create_dsv(d3d12_rtv_desc_from_cpu_handle(descriptor),
-            impl_from_ID3D12Device(iface), impl_from_ID3D12Resource(resource), desc);
+    old_view = d3d12_rtv_desc_begin_update(rtv_desc, d3d12_resource, device);
+    d3d12_rtv_desc_create_dsv(rtv_desc, device, d3d12_resource, desc);
+    d3d12_rtv_desc_end_update(rtv_desc, old_view, d3d12_resource, device);
 }
 
 static void STDMETHODCALLTYPE d3d12_device_CreateSampler(d3d12_device_iface *iface,
         const D3D12_SAMPLER_DESC *desc, D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
     struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_desc *d3d12_desc = d3d12_desc_from_cpu_handle(descriptor);
+    struct vkd3d_view *old_view;
 
     TRACE("iface %p, desc %p, descriptor %#lx.\n", iface, desc, descriptor.ptr);
 
-    d3d12_desc_create_sampler(d3d12_desc_from_cpu_handle(descriptor), device, desc);
+    old_view = d3d12_desc_begin_update(d3d12_desc, NULL, device);
+    d3d12_desc_create_sampler(d3d12_desc, device, desc);
+    d3d12_desc_end_update(d3d12_desc, old_view, NULL, device);
 }
 
 static inline D3D12_CPU_DESCRIPTOR_HANDLE d3d12_advance_cpu_descriptor_handle(D3D12_CPU_DESCRIPTOR_HANDLE handle,
@@ -3933,8 +3970,10 @@ static inline void d3d12_device_copy_descriptors(struct d3d12_device *device,
     unsigned int dst_range_idx, dst_idx, src_range_idx, src_idx;
     D3D12_CPU_DESCRIPTOR_HANDLE dst, src, dst_start, src_start;
     unsigned int dst_range_size, src_range_size, copy_count;
+    struct vkd3d_descriptor_copy_batch batch;
     unsigned int increment;
 
+    batch.copy_count = 0;
     increment = d3d12_device_get_descriptor_handle_increment_size(device, descriptor_heap_type);
 
     dst_range_idx = dst_idx = 0;
@@ -3958,12 +3997,12 @@ static inline void d3d12_device_copy_descriptors(struct d3d12_device *device,
             case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV:
                 d3d12_desc_copy(d3d12_desc_from_cpu_handle(dst),
                         d3d12_desc_from_cpu_handle(src), copy_count,
-                        descriptor_heap_type, device);
+                        descriptor_heap_type, &batch, device);
                 break;
             case D3D12_DESCRIPTOR_HEAP_TYPE_RTV:
             case D3D12_DESCRIPTOR_HEAP_TYPE_DSV:
                 d3d12_rtv_desc_copy(d3d12_rtv_desc_from_cpu_handle(dst),
-                        d3d12_rtv_desc_from_cpu_handle(src), copy_count);
+                        d3d12_rtv_desc_from_cpu_handle(src), copy_count, device);
                 break;
             default:
                 ERR("Unhandled descriptor heap type %u.\n", descriptor_heap_type);
@@ -3984,6 +4023,8 @@ static inline void d3d12_device_copy_descriptors(struct d3d12_device *device,
             src_idx = 0;
         }
     }
+
+    vkd3d_descriptor_copy_batch_flush(&batch, device);
 }
 
 static void STDMETHODCALLTYPE d3d12_device_CopyDescriptors(d3d12_device_iface *iface,
@@ -5905,6 +5946,19 @@ static bool d3d12_device_supports_feature_level(struct d3d12_device *device, D3D
 
 extern CONST_VTBL struct ID3D12DeviceExtVtbl d3d12_device_vkd3d_ext_vtbl;
 
+static void d3d12_device_init_view_map_limit(struct d3d12_device *device)
+{
+    const char *limit_str;
+
+    device->view_map_limit = 0;
+
+    if ((limit_str = getenv("VKD3D_VIEW_MAP_LIMIT")))
+    {
+        device->view_map_limit = strtoul(limit_str, NULL, 0);
+        INFO("Limiting cached views to %u per resource.\n", device->view_map_limit);
+    }
+}
+
 static HRESULT d3d12_device_init(struct d3d12_device *device,
         struct vkd3d_instance *instance, const struct vkd3d_device_create_info *create_info)
 {
@@ -5932,6 +5986,8 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
 
     device->vk_device = VK_NULL_HANDLE;
 
+    d3d12_device_init_view_map_limit(device);
+
     if ((rc = pthread_mutex_init(&device->mutex, NULL)))
     {
         ERR("Failed to initialize mutex, error %d.\n", rc);
@@ -5981,7 +6037,14 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
             goto out_cleanup_global_pipeline_cache;
     }
 
+    if (FAILED(hr = vkd3d_fence_worker_start(&device->fence_worker, device)))
+        goto out_cleanup_descriptor_qa_global_info;
+
     vkd3d_render_pass_cache_init(&device->render_pass_cache);
+    vkd3d_framebuffer_cache_init(&device->framebuffer_cache);
+    vkd3d_root_signature_cache_init(&device->root_signature_cache);
+    vkd3d_pipeline_variant_worker_start(&device->pipeline_variant_worker, device);
+    vkd3d_copy_workers_start(&device->copy_workers, device);
 
     if ((device->parent = create_info->parent))
         IUnknown_AddRef(device->parent);
@@ -5990,6 +6053,7 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
 
     vkd3d_init_shader_extensions(device);
     vkd3d_compute_shader_interface_key(device);
+    vkd3d_shader_disk_cache_init(&device->disk_shader_cache);
 
 #ifdef VKD3D_ENABLE_RENDERDOC
     if (vkd3d_renderdoc_active() && vkd3d_renderdoc_global_capture_enabled())
@@ -5998,6 +6062,8 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
 
     return S_OK;
 
+out_cleanup_descriptor_qa_global_info:
+    vkd3d_descriptor_debug_free_global_info(device->descriptor_qa_global_info, device);
 out_cleanup_global_pipeline_cache:
     d3d12_device_global_pipeline_cache_cleanup(device);
 out_cleanup_debug_ring:
@@ -6089,6 +6155,8 @@ HRESULT d3d12_device_create(struct vkd3d_instance *instance,
     {
         vkd3d_free(object);
         pthread_mutex_unlock(&d3d12_device_map_mutex);
+        /* Most applications give up when device creation fails. */
+        vkd3d_dbg_flush();
         return hr;
     }
 
@@ -6098,6 +6166,7 @@ HRESULT d3d12_device_create(struct vkd3d_instance *instance,
         d3d12_device_destroy(object);
         vkd3d_free(object);
         pthread_mutex_unlock(&d3d12_device_map_mutex);
+        vkd3d_dbg_flush();
         return E_INVALIDARG;
     }
 
@@ -6123,6 +6192,7 @@ void d3d12_device_mark_as_removed(struct d3d12_device *device, HRESULT reason,
     va_end(args);
 
     device->removed_reason = reason;
+    vkd3d_dbg_flush();
 }
 
 HRESULT vkd3d_create_thread(struct vkd3d_instance *instance,
@@ -617,183 +617,303 @@ static HRESULT vkd3d_memory_allocation_init(struct vkd3d_memory_allocation *allo
     return S_OK;
 }
 
-static void vkd3d_memory_chunk_insert_range(struct vkd3d_memory_chunk *chunk,
-        size_t index, VkDeviceSize offset, VkDeviceSize length)
+static void vkd3d_memory_chunk_mapping(VkDeviceSize size, uint32_t *fl, uint32_t *sl)
 {
-    if (!vkd3d_array_reserve((void**)&chunk->free_ranges, &chunk->free_ranges_size,
-            chunk->free_ranges_count + 1, sizeof(*chunk->free_ranges)))
+    unsigned int log2_size;
+
+    if (size < (1u << VKD3D_MEMORY_TLSF_FL_SHIFT))
     {
-        ERR("Failed to insert free range.\n");
-        return;
+        *fl = 0;
+        *sl = (uint32_t)size >> VKD3D_MEMORY_TLSF_GRANULARITY_BITS;
+    }
+    else
+    {
+        log2_size = vkd3d_log2i((uint32_t)size);
+        *fl = log2_size - VKD3D_MEMORY_TLSF_FL_SHIFT + 1;
+        *sl = ((uint32_t)size >> (log2_size - VKD3D_MEMORY_TLSF_SL_BITS)) & (VKD3D_MEMORY_TLSF_SL_COUNT - 1);
     }
-
-    memmove(&chunk->free_ranges[index + 1], &chunk->free_ranges[index],
-            sizeof(*chunk->free_ranges) * (chunk->free_ranges_count - index));
-
-    chunk->free_ranges[index].offset = offset;
-    chunk->free_ranges[index].length = length;
-    chunk->free_ranges_count++;
 }
 
-static void vkd3d_memory_chunk_remove_range(struct vkd3d_memory_chunk *chunk, size_t index)
+static uint32_t vkd3d_memory_chunk_alloc_block(struct vkd3d_memory_chunk *chunk)
 {
-    chunk->free_ranges_count--;
+    uint32_t index;
+
+    /* Capacity is reserved up front by the caller, so this cannot fail */
+    if ((index = chunk->block_pool) != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        chunk->block_pool = chunk->blocks[index].next_free;
+    else
+        index = chunk->blocks_count++;
 
-    memmove(&chunk->free_ranges[index], &chunk->free_ranges[index + 1],
-            sizeof(*chunk->free_ranges) * (chunk->free_ranges_count - index));
+    return index;
 }
 
-static HRESULT vkd3d_memory_chunk_allocate_range(struct vkd3d_memory_chunk *chunk, const VkMemoryRequirements *memory_requirements,
-        struct vkd3d_memory_allocation *allocation)
+static void vkd3d_memory_chunk_release_block(struct vkd3d_memory_chunk *chunk, uint32_t index)
 {
-    struct vkd3d_memory_free_range *pick_range;
-    VkDeviceSize l_length, r_length;
-    size_t i, pick_index;
+    chunk->blocks[index].next_free = chunk->block_pool;
+    chunk->block_pool = index;
+}
 
-    if (!chunk->free_ranges_count)
-        return E_OUTOFMEMORY;
+static bool vkd3d_memory_chunk_reserve_blocks(struct vkd3d_memory_chunk *chunk, size_t count)
+{
+    uint32_t index;
 
-    pick_index = chunk->free_ranges_count;
-    pick_range = NULL;
+    /* Pool entries can be reused without growing the array */
+    for (index = chunk->block_pool; count && index != VKD3D_MEMORY_TLSF_BLOCK_NONE; count--)
+        index = chunk->blocks[index].next_free;
 
-    for (i = 0; i < chunk->free_ranges_count; i++)
-    {
-        struct vkd3d_memory_free_range *range = &chunk->free_ranges[i];
+    return vkd3d_array_reserve((void**)&chunk->blocks, &chunk->blocks_size,
+            chunk->blocks_count + count, sizeof(*chunk->blocks));
+}
 
-        if (range->offset + range->length < align(range->offset, memory_requirements->alignment) + memory_requirements->size)
-            continue;
+static void vkd3d_memory_chunk_insert_free_block(struct vkd3d_memory_chunk *chunk, uint32_t index)
+{
+    struct vkd3d_memory_chunk_block *block = &chunk->blocks[index];
+    uint32_t fl, sl, head;
 
-        /* Exact fit leaving no gaps */
-        if (range->length == memory_requirements->size)
-        {
-            pick_index = i;
-            pick_range = range;
-            break;
-        }
+    vkd3d_memory_chunk_mapping(block->size, &fl, &sl);
+    head = chunk->free_lists[fl][sl];
 
-        /* Alignment is almost always going to be 64 KiB, so
-         * don't worry too much about misalignment gaps here */
-        if (!pick_range || range->length > pick_range->length)
-        {
-            pick_index = i;
-            pick_range = range;
-        }
-    }
+    block->is_free = true;
+    block->prev_free = VKD3D_MEMORY_TLSF_BLOCK_NONE;
+    block->next_free = head;
 
-    if (!pick_range)
-        return E_OUTOFMEMORY;
+    if (head != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        chunk->blocks[head].prev_free = index;
 
-    /* Adjust offsets and addresses of the base allocation */
-    vkd3d_memory_allocation_slice(allocation, &chunk->allocation,
-            align(pick_range->offset, memory_requirements->alignment),
-            memory_requirements->size);
-    allocation->chunk = chunk;
+    chunk->free_lists[fl][sl] = index;
+    chunk->fl_bitmap |= 1u << fl;
+    chunk->sl_bitmap[fl] |= 1u << sl;
+    chunk->free_block_count++;
+}
 
-    /* Remove allocated range from the free list */
-    l_length = allocation->offset - pick_range->offset;
-    r_length = pick_range->offset + pick_range->length
-            - allocation->offset - allocation->resource.size;
+static void vkd3d_memory_chunk_remove_free_block(struct vkd3d_memory_chunk *chunk, uint32_t index)
+{
+    struct vkd3d_memory_chunk_block *block = &chunk->blocks[index];
+    uint32_t fl, sl;
 
-    if (l_length)
-    {
-        pick_range->length = l_length;
+    vkd3d_memory_chunk_mapping(block->size, &fl, &sl);
 
-        if (r_length)
-        {
-            vkd3d_memory_chunk_insert_range(chunk, pick_index + 1,
-                allocation->offset + allocation->resource.size, r_length);
-        }
-    }
-    else if (r_length)
-    {
-        pick_range->offset = allocation->offset + allocation->resource.size;
-        pick_range->length = r_length;
-    }
+    if (block->prev_free != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        chunk->blocks[block->prev_free].next_free = block->next_free;
     else
+        chunk->free_lists[fl][sl] = block->next_free;
+
+    if (block->next_free != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        chunk->blocks[block->next_free].prev_free = block->prev_free;
+
+    if (chunk->free_lists[fl][sl] == VKD3D_MEMORY_TLSF_BLOCK_NONE)
     {
-        vkd3d_memory_chunk_remove_range(chunk, pick_index);
+        chunk->sl_bitmap[fl] &= ~(1u << sl);
+
+        if (!chunk->sl_bitmap[fl])
+            chunk->fl_bitmap &= ~(1u << fl);
     }
 
-    return S_OK;
+    block->is_free = false;
+    chunk->free_block_count--;
 }
 
-static size_t vkd3d_memory_chunk_find_range(struct vkd3d_memory_chunk *chunk, VkDeviceSize offset)
+static uint32_t vkd3d_memory_chunk_find_free_block(struct vkd3d_memory_chunk *chunk, VkDeviceSize size)
 {
-    struct vkd3d_memory_free_range *range;
-    size_t index, hi, lo;
+    uint32_t fl, sl, sl_mask, fl_mask;
+
+    /* Round up to the next size class so that any block in
+     * the selected free list is large enough to hold size. */
+    if (size >= (1u << VKD3D_MEMORY_TLSF_FL_SHIFT))
+        size += (1u << (vkd3d_log2i((uint32_t)size) - VKD3D_MEMORY_TLSF_SL_BITS)) - 1;
 
-    lo = 0;
-    hi = chunk->free_ranges_count;
+    vkd3d_memory_chunk_mapping(size, &fl, &sl);
 
-    while (lo < hi)
+    if (fl >= VKD3D_MEMORY_TLSF_FL_COUNT)
+        return VKD3D_MEMORY_TLSF_BLOCK_NONE;
+
+    if (!(sl_mask = chunk->sl_bitmap[fl] & (~0u << sl)))
     {
-        index = lo + (hi - lo) / 2;
-        range = &chunk->free_ranges[index];
+        if (!(fl_mask = chunk->fl_bitmap & (~0u << (fl + 1))))
+            return VKD3D_MEMORY_TLSF_BLOCK_NONE;
 
-        if (range->offset > offset)
-            hi = index;
-        else
-            lo = index + 1;
+        fl = vkd3d_bitmask_tzcnt32(fl_mask);
+        sl_mask = chunk->sl_bitmap[fl];
     }
 
-    return lo;
+    sl = vkd3d_bitmask_tzcnt32(sl_mask);
+    return chunk->free_lists[fl][sl];
 }
 
-static void vkd3d_memory_chunk_free_range(struct vkd3d_memory_chunk *chunk, const struct vkd3d_memory_allocation *allocation)
+static void vkd3d_memory_chunk_split_block(struct vkd3d_memory_chunk *chunk, uint32_t index, VkDeviceSize size)
 {
-    struct vkd3d_memory_free_range *range;
-    bool adjacent_l, adjacent_r;
-    size_t index;
+    struct vkd3d_memory_chunk_block *block, *split;
+    uint32_t split_index;
+
+    split_index = vkd3d_memory_chunk_alloc_block(chunk);
+    block = &chunk->blocks[index];
+    split = &chunk->blocks[split_index];
 
-    index = vkd3d_memory_chunk_find_range(chunk, allocation->offset);
+    split->offset = block->offset + size;
+    split->size = block->size - size;
+    split->prev_phys = index;
+    split->next_phys = block->next_phys;
+    split->is_free = false;
 
-    adjacent_l = false;
-    adjacent_r = false;
+    if (block->next_phys != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        chunk->blocks[block->next_phys].prev_phys = split_index;
 
-    if (index > 0)
+    block->next_phys = split_index;
+    block->size = size;
+}
+
+static HRESULT vkd3d_memory_chunk_allocate_range(struct vkd3d_memory_chunk *chunk, const VkMemoryRequirements *memory_requirements,
+        struct vkd3d_memory_allocation *allocation)
+{
+    VkDeviceSize size, alignment, aligned_offset;
+    struct vkd3d_memory_chunk_block *block;
+    uint32_t index;
+
+    if (!chunk->fl_bitmap)
+        return E_OUTOFMEMORY;
+
+    alignment = max(memory_requirements->alignment, VKD3D_MEMORY_TLSF_GRANULARITY);
+    size = align(memory_requirements->size, VKD3D_MEMORY_TLSF_GRANULARITY);
+
+    /* Splitting can require up to two additional block structs */
+    if (!vkd3d_memory_chunk_reserve_blocks(chunk, 2))
     {
-        range = &chunk->free_ranges[index - 1];
-        adjacent_l = range->offset + range->length == allocation->offset;
+        ERR("Failed to reserve chunk blocks.\n");
+        return E_OUTOFMEMORY;
     }
 
-    if (index < chunk->free_ranges_count)
+    /* Alignment is almost always going to be 64 KiB and most blocks
+     * are going to be aligned already, so try a good fit first and
+     * only pad the search size if the candidate block is misaligned. */
+    index = vkd3d_memory_chunk_find_free_block(chunk, size);
+
+    if (index != VKD3D_MEMORY_TLSF_BLOCK_NONE)
     {
-        range = &chunk->free_ranges[index];
-        adjacent_r = range->offset == allocation->offset + allocation->resource.size;
+        block = &chunk->blocks[index];
+
+        if (align(block->offset, alignment) + size > block->offset + block->size)
+            index = VKD3D_MEMORY_TLSF_BLOCK_NONE;
     }
 
-    if (adjacent_l)
+    if (index == VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        index = vkd3d_memory_chunk_find_free_block(chunk, size + alignment - VKD3D_MEMORY_TLSF_GRANULARITY);
+
+    if (index == VKD3D_MEMORY_TLSF_BLOCK_NONE)
+        return E_OUTOFMEMORY;
+
+    vkd3d_memory_chunk_remove_free_block(chunk, index);
+    block = &chunk->blocks[index];
+    aligned_offset = align(block->offset, alignment);
+
+    /* Return the misalignment gap and any unused tail to the free lists. Neither
+     * needs to be merged with its neighbours since free blocks never touch. */
+    if (aligned_offset != block->offset)
     {
-        range = &chunk->free_ranges[index - 1];
-        range->length += allocation->resource.size;
+        vkd3d_memory_chunk_split_block(chunk, index, aligned_offset - block->offset);
+        vkd3d_memory_chunk_insert_free_block(chunk, index);
+        index = chunk->blocks[index].next_phys;
+        block = &chunk->blocks[index];
+    }
 
-        if (adjacent_r)
-        {
-            range->length += chunk->free_ranges[index].length;
-            vkd3d_memory_chunk_remove_range(chunk, index);
-        }
+    if (block->size > size)
+    {
+        vkd3d_memory_chunk_split_block(chunk, index, size);
+        vkd3d_memory_chunk_insert_free_block(chunk, chunk->blocks[index].next_phys);
+        block = &chunk->blocks[index];
     }
-    else if (adjacent_r)
+
+    chunk->used_size += block->size;
+    vkd3d_atomic_uint32_increment(&chunk->used_block_count, vkd3d_memory_order_relaxed);
+
+    /* Adjust offsets and addresses of the base allocation */
+    vkd3d_memory_allocation_slice(allocation, &chunk->allocation,
+            block->offset, memory_requirements->size);
+    allocation->chunk = chunk;
+    allocation->chunk_block = index;
+    return S_OK;
+}
+
+static void vkd3d_memory_chunk_free_block(struct vkd3d_memory_chunk *chunk, uint32_t index)
+{
+    struct vkd3d_memory_chunk_block *block, *neighbour;
+    uint32_t neighbour_index;
+
+    block = &chunk->blocks[index];
+    chunk->used_size -= block->size;
+    vkd3d_atomic_uint32_decrement(&chunk->used_block_count, vkd3d_memory_order_relaxed);
+
+    /* Merge with the next block if it is free */
+    if ((neighbour_index = block->next_phys) != VKD3D_MEMORY_TLSF_BLOCK_NONE &&
+            chunk->blocks[neighbour_index].is_free)
     {
-        range = &chunk->free_ranges[index];
-        range->offset = allocation->offset;
-        range->length += allocation->resource.size;
+        neighbour = &chunk->blocks[neighbour_index];
+        vkd3d_memory_chunk_remove_free_block(chunk, neighbour_index);
+
+        block->size += neighbour->size;
+        block->next_phys = neighbour->next_phys;
+
+        if (neighbour->next_phys != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+            chunk->blocks[neighbour->next_phys].prev_phys = index;
+
+        vkd3d_memory_chunk_release_block(chunk, neighbour_index);
     }
-    else
+
+    /* Merge into the previous block if it is free */
+    if ((neighbour_index = block->prev_phys) != VKD3D_MEMORY_TLSF_BLOCK_NONE &&
+            chunk->blocks[neighbour_index].is_free)
     {
-        vkd3d_memory_chunk_insert_range(chunk, index,
-                allocation->offset, allocation->resource.size);
+        neighbour = &chunk->blocks[neighbour_index];
+        vkd3d_memory_chunk_remove_free_block(chunk, neighbour_index);
+
+        neighbour->size += block->size;
+        neighbour->next_phys = block->next_phys;
+
+        if (block->next_phys != VKD3D_MEMORY_TLSF_BLOCK_NONE)
+            chunk->blocks[block->next_phys].prev_phys = neighbour_index;
+
+        vkd3d_memory_chunk_release_block(chunk, index);
+        index = neighbour_index;
     }
+
+    vkd3d_memory_chunk_insert_free_block(chunk, index);
 }
 
 static bool vkd3d_memory_chunk_is_free(struct vkd3d_memory_chunk *chunk)
 {
-    return chunk->free_ranges_count == 1 && chunk->free_ranges[0].length == chunk->allocation.resource.size;
+    return !chunk->used_size;
+}
+
+static bool vkd3d_memory_chunk_is_magazine_only(struct vkd3d_memory_chunk *chunk)
+{
+    uint32_t magazine_block_count;
+
+    magazine_block_count = vkd3d_atomic_uint32_load_explicit(&chunk->magazine_block_count, vkd3d_memory_order_relaxed);
+    return magazine_block_count && magazine_block_count ==
+            vkd3d_atomic_uint32_load_explicit(&chunk->used_block_count, vkd3d_memory_order_relaxed);
+}
+
+static VkDeviceSize vkd3d_memory_chunk_get_largest_free_block(struct vkd3d_memory_chunk *chunk)
+{
+    VkDeviceSize largest = 0;
+    uint32_t fl, sl, index;
+
+    if (!chunk->fl_bitmap)
+        return 0;
+
+    /* Blocks within the highest non-empty size class are not sorted */
+    fl = vkd3d_log2i(chunk->fl_bitmap);
+    sl = vkd3d_log2i(chunk->sl_bitmap[fl]);
+
+    for (index = chunk->free_lists[fl][sl]; index != VKD3D_MEMORY_TLSF_BLOCK_NONE; index = chunk->blocks[index].next_free)
+        largest = max(largest, chunk->blocks[index].size);
+
+    return largest;
 }
 
 static HRESULT vkd3d_memory_chunk_create(struct d3d12_device *device, struct vkd3d_memory_allocator *allocator,
         const struct vkd3d_allocate_memory_info *info, struct vkd3d_memory_chunk **chunk)
 {
+    struct vkd3d_memory_chunk_block *block;
     struct vkd3d_memory_chunk *object;
     HRESULT hr;
 
@@ -803,14 +923,28 @@ static HRESULT vkd3d_memory_chunk_create(struct d3d12_device *device, struct vkd
         return E_OUTOFMEMORY;
 
     memset(object, 0, sizeof(*object));
+    memset(object->free_lists, 0xff, sizeof(object->free_lists));
+    object->block_pool = VKD3D_MEMORY_TLSF_BLOCK_NONE;
+
+    if (!vkd3d_memory_chunk_reserve_blocks(object, 1))
+    {
+        vkd3d_free(object);
+        return E_OUTOFMEMORY;
+    }
 
     if (FAILED(hr = vkd3d_memory_allocation_init(&object->allocation, device, allocator, info)))
     {
+        vkd3d_free(object->blocks);
         vkd3d_free(object);
         return hr;
     }
 
-    vkd3d_memory_chunk_insert_range(object, 0, 0, object->allocation.resource.size);
+    block = &object->blocks[vkd3d_memory_chunk_alloc_block(object)];
+    block->offset = 0;
+    block->size = object->allocation.resource.size;
+    block->prev_phys = VKD3D_MEMORY_TLSF_BLOCK_NONE;
+    block->next_phys = VKD3D_MEMORY_TLSF_BLOCK_NONE;
+    vkd3d_memory_chunk_insert_free_block(object, 0);
     *chunk = object;
 
     TRACE("Created chunk %p (allocation %p).\n", object, &object->allocation);
@@ -825,19 +959,61 @@ static void vkd3d_memory_chunk_destroy(struct vkd3d_memory_chunk *chunk, struct
         vkd3d_memory_allocator_wait_allocation(allocator, device, &chunk->allocation);
 
     vkd3d_memory_allocation_free(&chunk->allocation, device, allocator);
-    vkd3d_free(chunk->free_ranges);
+    vkd3d_free(chunk->blocks);
     vkd3d_free(chunk);
 }
 
+static struct vkd3d_memory_chunk_bucket *vkd3d_memory_allocator_find_bucket(struct vkd3d_memory_allocator *allocator,
+        D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags, uint32_t vk_memory_type)
+{
+    struct vkd3d_memory_chunk_bucket *bucket;
+    size_t i;
+
+    for (i = 0; i < allocator->buckets_count; i++)
+    {
+        bucket = allocator->buckets[i];
+
+        if (bucket->heap_type == heap_type && bucket->heap_flags == heap_flags &&
+                bucket->vk_memory_type == vk_memory_type)
+            return bucket;
+    }
+
+    return NULL;
+}
+
+static struct vkd3d_memory_chunk_bucket *vkd3d_memory_allocator_get_bucket(struct vkd3d_memory_allocator *allocator,
+        D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags, uint32_t vk_memory_type)
+{
+    struct vkd3d_memory_chunk_bucket *bucket;
+
+    if ((bucket = vkd3d_memory_allocator_find_bucket(allocator, heap_type, heap_flags, vk_memory_type)))
+        return bucket;
+
+    if (!vkd3d_array_reserve((void**)&allocator->buckets, &allocator->buckets_size,
+            allocator->buckets_count + 1, sizeof(*allocator->buckets)))
+        return NULL;
+
+    if (!(bucket = vkd3d_calloc(1, sizeof(*bucket))))
+        return NULL;
+
+    bucket->heap_type = heap_type;
+    bucket->heap_flags = heap_flags;
+    bucket->vk_memory_type = vk_memory_type;
+
+    allocator->buckets[allocator->buckets_count++] = bucket;
+    return bucket;
+}
+
 static void vkd3d_memory_allocator_remove_chunk(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device, struct vkd3d_memory_chunk *chunk)
 {
+    struct vkd3d_memory_chunk_bucket *bucket = chunk->bucket;
     size_t i;
 
-    for (i = 0; i < allocator->chunks_count; i++)
+    for (i = 0; i < bucket->chunks_count; i++)
     {
-        if (allocator->chunks[i] == chunk)
+        if (bucket->chunks[i] == chunk)
         {
-            allocator->chunks[i] = allocator->chunks[--allocator->chunks_count];
+            bucket->chunks[i] = bucket->chunks[--bucket->chunks_count];
             break;
         }
     }
@@ -845,6 +1021,41 @@ static void vkd3d_memory_allocator_remove_chunk(struct vkd3d_memory_allocator *a
     vkd3d_memory_chunk_destroy(chunk, device, allocator);
 }
 
+static void vkd3d_memory_allocator_get_stats_locked(struct vkd3d_memory_allocator *allocator,
+        struct vkd3d_memory_allocator_stats *stats)
+{
+    struct vkd3d_memory_chunk_bucket *bucket;
+    struct vkd3d_memory_chunk *chunk;
+    size_t i, j;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (i = 0; i < allocator->buckets_count; i++)
+    {
+        bucket = allocator->buckets[i];
+
+        for (j = 0; j < bucket->chunks_count; j++)
+        {
+            chunk = bucket->chunks[j];
+
+            stats->chunk_count++;
+            stats->free_block_count += chunk->free_block_count;
+            stats->chunk_size += chunk->allocation.resource.size;
+            stats->used_size += chunk->used_size;
+            stats->largest_free_block = max(stats->largest_free_block,
+                    vkd3d_memory_chunk_get_largest_free_block(chunk));
+        }
+    }
+}
+
+void vkd3d_memory_allocator_get_stats(struct vkd3d_memory_allocator *allocator,
+        struct vkd3d_memory_allocator_stats *stats)
+{
+    pthread_mutex_lock(&allocator->mutex);
+    vkd3d_memory_allocator_get_stats_locked(allocator, stats);
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
 static void vkd3d_memory_allocator_cleanup_clear_queue(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device)
 {
     struct vkd3d_memory_clear_queue *clear_queue = &allocator->clear_queue;
@@ -930,6 +1141,7 @@ fail:
 
 HRESULT vkd3d_memory_allocator_init(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device)
 {
+    unsigned int i;
     HRESULT hr;
     int rc;
 
@@ -938,6 +1150,9 @@ HRESULT vkd3d_memory_allocator_init(struct vkd3d_memory_allocator *allocator, st
     if ((rc = pthread_mutex_init(&allocator->mutex, NULL)))
         return hresult_from_errno(rc);
 
+    for (i = 0; i < ARRAY_SIZE(allocator->magazine_shards); i++)
+        spinlock_init(&allocator->magazine_shards[i].lock);
+
     if (FAILED(hr = vkd3d_memory_allocator_init_clear_queue(allocator, device)))
     {
         pthread_mutex_destroy(&allocator->mutex);
@@ -953,12 +1168,21 @@ HRESULT vkd3d_memory_allocator_init(struct vkd3d_memory_allocator *allocator, st
 
 void vkd3d_memory_allocator_cleanup(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device)
 {
-    size_t i;
+    struct vkd3d_memory_chunk_bucket *bucket;
+    size_t i, j;
 
-    for (i = 0; i < allocator->chunks_count; i++)
-        vkd3d_memory_chunk_destroy(allocator->chunks[i], device, allocator);
+    for (i = 0; i < allocator->buckets_count; i++)
+    {
+        bucket = allocator->buckets[i];
+
+        for (j = 0; j < bucket->chunks_count; j++)
+            vkd3d_memory_chunk_destroy(bucket->chunks[j], device, allocator);
+
+        vkd3d_free(bucket->chunks);
+        vkd3d_free(bucket);
+    }
 
-    vkd3d_free(allocator->chunks);
+    vkd3d_free(allocator->buckets);
     vkd3d_va_map_cleanup(&allocator->va_map);
     vkd3d_memory_allocator_cleanup_clear_queue(allocator, device);
     pthread_mutex_destroy(&allocator->mutex);
@@ -1236,11 +1460,20 @@ static void vkd3d_memory_allocator_wait_allocation(struct vkd3d_memory_allocator
     vkd3d_memory_allocator_wait_clear_semaphore(allocator, device, wait_value, UINT64_MAX);
 }
 
+static D3D12_HEAP_FLAGS vkd3d_memory_chunk_get_heap_flags(D3D12_HEAP_FLAGS heap_flags)
+{
+    /* Match flags since otherwise the backing buffer
+     * may not support our required usage flags */
+    return heap_flags & ~(D3D12_HEAP_FLAG_CREATE_NOT_ZEROED | D3D12_HEAP_FLAG_CREATE_NOT_RESIDENT);
+}
+
 static HRESULT vkd3d_memory_allocator_try_add_chunk(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags, uint32_t type_mask,
         VkMemoryPropertyFlags optional_properties, struct vkd3d_memory_chunk **chunk)
 {
+    struct vkd3d_memory_allocator_stats stats;
     struct vkd3d_allocate_memory_info alloc_info;
+    struct vkd3d_memory_chunk_bucket *bucket;
     struct vkd3d_memory_chunk *object;
     HRESULT hr;
 
@@ -1256,17 +1489,31 @@ static HRESULT vkd3d_memory_allocator_try_add_chunk(struct vkd3d_memory_allocato
     if (!(heap_flags & D3D12_HEAP_FLAG_DENY_BUFFERS))
         alloc_info.flags |= VKD3D_ALLOCATION_FLAG_GLOBAL_BUFFER;
 
-    if (!vkd3d_array_reserve((void**)&allocator->chunks, &allocator->chunks_size,
-            allocator->chunks_count + 1, sizeof(*allocator->chunks)))
+    if (FAILED(hr = vkd3d_memory_chunk_create(device, allocator, &alloc_info, &object)))
+        return hr;
+
+    /* The memory type is only known once the chunk is allocated */
+    if (!(bucket = vkd3d_memory_allocator_get_bucket(allocator, object->allocation.heap_type,
+            object->allocation.heap_flags, object->allocation.device_allocation.vk_memory_type)) ||
+            !vkd3d_array_reserve((void**)&bucket->chunks, &bucket->chunks_size,
+                    bucket->chunks_count + 1, sizeof(*bucket->chunks)))
     {
         ERR("Failed to allocate space for new chunk.\n");
+        vkd3d_memory_chunk_destroy(object, device, allocator);
         return E_OUTOFMEMORY;
     }
 
-    if (FAILED(hr = vkd3d_memory_chunk_create(device, allocator, &alloc_info, &object)))
-        return hr;
+    object->bucket = bucket;
+    bucket->chunks[bucket->chunks_count++] = *chunk = object;
+
+    if (TRACE_ON())
+    {
+        vkd3d_memory_allocator_get_stats_locked(allocator, &stats);
+        TRACE("Added chunk %p, %u chunks, %"PRIu64" / %"PRIu64" bytes used, %u free blocks, largest free block %"PRIu64" bytes.\n",
+                object, stats.chunk_count, stats.used_size, stats.chunk_size,
+                stats.free_block_count, stats.largest_free_block);
+    }
 
-    allocator->chunks[allocator->chunks_count++] = *chunk = object;
     return S_OK;
 }
 
@@ -1276,72 +1523,512 @@ static HRESULT vkd3d_memory_allocator_try_suballocate_memory(struct vkd3d_memory
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
         struct vkd3d_memory_allocation *allocation)
 {
-    const D3D12_HEAP_FLAGS heap_flag_mask = ~(D3D12_HEAP_FLAG_CREATE_NOT_ZEROED | D3D12_HEAP_FLAG_CREATE_NOT_RESIDENT);
+    struct vkd3d_memory_chunk_bucket *bucket;
     struct vkd3d_memory_chunk *chunk;
+    uint32_t memory_types;
     HRESULT hr;
     size_t i;
 
     type_mask &= device->memory_info.global_mask;
     type_mask &= memory_requirements->memoryTypeBits;
+    memory_types = type_mask;
 
-    for (i = 0; i < allocator->chunks_count; i++)
+    while (memory_types)
     {
-        chunk = allocator->chunks[i];
-
-        /* Match flags since otherwise the backing buffer
-         * may not support our required usage flags */
-        if (chunk->allocation.heap_type != heap_properties->Type ||
-                chunk->allocation.heap_flags != (heap_flags & heap_flag_mask))
+        if (!(bucket = vkd3d_memory_allocator_find_bucket(allocator, heap_properties->Type,
+                vkd3d_memory_chunk_get_heap_flags(heap_flags), vkd3d_bitmask_iter32(&memory_types))))
             continue;
 
-        /* Filter out unsupported memory types */
-        if (!(type_mask & (1u << chunk->allocation.device_allocation.vk_memory_type)))
-            continue;
+        for (i = 0; i < bucket->chunks_count; i++)
+        {
+            chunk = bucket->chunks[i];
 
-        if (SUCCEEDED(hr = vkd3d_memory_chunk_allocate_range(chunk, memory_requirements, allocation)))
-            return hr;
+            if (SUCCEEDED(hr = vkd3d_memory_chunk_allocate_range(chunk, memory_requirements, allocation)))
+                return hr;
+        }
     }
 
     /* Try allocating a new chunk on one of the supported memory type
      * before the caller falls back to potentially slower memory */
     if (FAILED(hr = vkd3d_memory_allocator_try_add_chunk(allocator, device, heap_properties,
-            heap_flags & heap_flag_mask, type_mask, optional_properties, &chunk)))
+            vkd3d_memory_chunk_get_heap_flags(heap_flags), type_mask, optional_properties, &chunk)))
         return hr;
 
     return vkd3d_memory_chunk_allocate_range(chunk, memory_requirements, allocation);
 }
 
+static void vkd3d_memory_allocator_lock(struct vkd3d_memory_allocator *allocator)
+{
+    VKD3D_REGION_DECL(memory_allocator_lock);
+
+    /* Time spent here is the cost of contention on the shared chunk lists */
+    VKD3D_REGION_BEGIN(memory_allocator_lock);
+    pthread_mutex_lock(&allocator->mutex);
+    VKD3D_REGION_END(memory_allocator_lock);
+}
+
+static void vkd3d_memory_allocator_unlock(struct vkd3d_memory_allocator *allocator)
+{
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+static uint32_t vkd3d_memory_magazine_thread_counter;
+static VKD3D_THREAD_LOCAL uint32_t vkd3d_memory_magazine_thread_index;
+
+static struct vkd3d_memory_magazine_shard *vkd3d_memory_allocator_get_magazine_shard(
+        struct vkd3d_memory_allocator *allocator)
+{
+    /* Assign shards round-robin on first use so that threads spread out evenly */
+    if (!vkd3d_memory_magazine_thread_index)
+    {
+        vkd3d_memory_magazine_thread_index = vkd3d_atomic_uint32_increment(
+                &vkd3d_memory_magazine_thread_counter, vkd3d_memory_order_relaxed);
+    }
+
+    return &allocator->magazine_shards[vkd3d_memory_magazine_thread_index % VKD3D_MEMORY_MAGAZINE_SHARD_COUNT];
+}
+
+static bool vkd3d_memory_magazine_get_class(VkDeviceSize size, VkDeviceSize alignment, uint32_t *class_index)
+{
+    if (!size || size > VKD3D_MEMORY_MAGAZINE_CLASS_SIZE * VKD3D_MEMORY_MAGAZINE_CLASS_COUNT ||
+            alignment > VKD3D_MEMORY_MAGAZINE_CLASS_SIZE)
+        return false;
+
+    *class_index = align(size, VKD3D_MEMORY_MAGAZINE_CLASS_SIZE) / VKD3D_MEMORY_MAGAZINE_CLASS_SIZE - 1;
+    return true;
+}
+
+static struct vkd3d_memory_magazine *vkd3d_memory_magazine_shard_get_magazine(struct vkd3d_memory_magazine_shard *shard,
+        D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags, bool create)
+{
+    struct vkd3d_memory_magazine *magazine;
+    uint32_t i;
+
+    for (i = 0; i < shard->magazine_count; i++)
+    {
+        magazine = &shard->magazines[i];
+
+        if (magazine->heap_type == heap_type && magazine->heap_flags == heap_flags)
+            return magazine;
+    }
+
+    if (!create || shard->magazine_count == VKD3D_MEMORY_MAGAZINE_KEY_COUNT)
+        return NULL;
+
+    magazine = &shard->magazines[shard->magazine_count++];
+    magazine->heap_type = heap_type;
+    magazine->heap_flags = heap_flags;
+    return magazine;
+}
+
+static void vkd3d_memory_magazine_entry_init(struct vkd3d_memory_magazine_entry *entry,
+        const struct vkd3d_memory_allocation *allocation)
+{
+    entry->chunk = allocation->chunk;
+    entry->chunk_block = allocation->chunk_block;
+    entry->offset = allocation->offset - allocation->chunk->allocation.offset;
+}
+
+static void vkd3d_memory_magazine_entry_get_allocation(const struct vkd3d_memory_magazine_entry *entry,
+        VkDeviceSize size, struct vkd3d_memory_allocation *allocation)
+{
+    /* The chunk's base allocation is immutable while any of its ranges are in use */
+    vkd3d_memory_allocation_slice(allocation, &entry->chunk->allocation, entry->offset, size);
+    allocation->chunk = entry->chunk;
+    allocation->chunk_block = entry->chunk_block;
+    allocation->flags |= VKD3D_ALLOCATION_FLAG_MAGAZINE;
+}
+
+static uint32_t vkd3d_memory_magazine_get_class_size(uint32_t class_index)
+{
+    return (class_index + 1) * VKD3D_MEMORY_MAGAZINE_CLASS_SIZE;
+}
+
+static bool vkd3d_memory_allocator_park_magazine_entry(struct vkd3d_memory_allocator *allocator,
+        const struct vkd3d_memory_magazine_entry *entry, uint32_t class_index)
+{
+    uint32_t class_size = vkd3d_memory_magazine_get_class_size(class_index);
+
+    if (vkd3d_atomic_uint32_add(&allocator->magazine_cached_size, class_size,
+            vkd3d_memory_order_relaxed) > VKD3D_MEMORY_MAGAZINE_MAX_CACHED_SIZE)
+    {
+        vkd3d_atomic_uint32_sub(&allocator->magazine_cached_size, class_size, vkd3d_memory_order_relaxed);
+        return false;
+    }
+
+    vkd3d_atomic_uint32_increment(&entry->chunk->magazine_block_count, vkd3d_memory_order_relaxed);
+    return true;
+}
+
+static void vkd3d_memory_allocator_unpark_magazine_entries(struct vkd3d_memory_allocator *allocator,
+        const struct vkd3d_memory_magazine_entry *entries, uint32_t count, uint32_t class_index)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+        vkd3d_atomic_uint32_decrement(&entries[i].chunk->magazine_block_count, vkd3d_memory_order_relaxed);
+
+    if (count)
+    {
+        vkd3d_atomic_uint32_sub(&allocator->magazine_cached_size,
+                count * vkd3d_memory_magazine_get_class_size(class_index), vkd3d_memory_order_relaxed);
+    }
+}
+
+static void vkd3d_memory_allocator_reclaim_chunk_locked(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, struct vkd3d_memory_chunk *chunk)
+{
+    struct vkd3d_memory_magazine_entry *entries;
+    struct vkd3d_memory_magazine_shard *shard;
+    struct vkd3d_memory_magazine *magazine;
+    uint32_t i, j, k, l, *count;
+
+    /* Every range the chunk still has handed out is parked in a magazine,
+     * pull them all out so that the chunk can be returned to the system. */
+    for (i = 0; i < VKD3D_MEMORY_MAGAZINE_SHARD_COUNT; i++)
+    {
+        shard = &allocator->magazine_shards[i];
+        spinlock_acquire(&shard->lock);
+
+        for (j = 0; j < shard->magazine_count; j++)
+        {
+            magazine = &shard->magazines[j];
+
+            for (k = 0; k < VKD3D_MEMORY_MAGAZINE_CLASS_COUNT; k++)
+            {
+                entries = magazine->entries[k];
+                count = &magazine->entry_count[k];
+
+                for (l = 0; l < *count; )
+                {
+                    if (entries[l].chunk != chunk)
+                    {
+                        l++;
+                        continue;
+                    }
+
+                    vkd3d_memory_allocator_unpark_magazine_entries(allocator, &entries[l], 1, k);
+                    vkd3d_memory_chunk_free_block(chunk, entries[l].chunk_block);
+                    memmove(&entries[l], &entries[l + 1], (--(*count) - l) * sizeof(*entries));
+                }
+            }
+        }
+
+        spinlock_release(&shard->lock);
+    }
+
+    if (vkd3d_memory_chunk_is_free(chunk))
+        vkd3d_memory_allocator_remove_chunk(allocator, device, chunk);
+}
+
+static void vkd3d_memory_allocator_free_chunk_block_locked(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, struct vkd3d_memory_chunk *chunk, uint32_t chunk_block)
+{
+    vkd3d_memory_chunk_free_block(chunk, chunk_block);
+
+    /* Must not be called with a shard lock held since reclaiming takes all of them */
+    if (vkd3d_memory_chunk_is_free(chunk))
+        vkd3d_memory_allocator_remove_chunk(allocator, device, chunk);
+    else if (vkd3d_memory_chunk_is_magazine_only(chunk))
+        vkd3d_memory_allocator_reclaim_chunk_locked(allocator, device, chunk);
+}
+
+static void vkd3d_memory_allocator_free_magazine_entries_locked(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, const struct vkd3d_memory_magazine_entry *entries, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+        vkd3d_memory_allocator_free_chunk_block_locked(allocator, device, entries[i].chunk, entries[i].chunk_block);
+}
+
+static bool vkd3d_memory_allocator_drain_magazines_locked(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, bool idle_only)
+{
+    struct vkd3d_memory_magazine_entry entries[VKD3D_MEMORY_MAGAZINE_KEY_COUNT *
+            VKD3D_MEMORY_MAGAZINE_CLASS_COUNT * VKD3D_MEMORY_MAGAZINE_ENTRY_COUNT];
+    struct vkd3d_memory_magazine_shard *shard;
+    struct vkd3d_memory_magazine *magazine;
+    uint32_t i, j, k, count, epoch;
+    bool drained = false;
+
+    epoch = vkd3d_atomic_uint32_load_explicit(&allocator->magazine_epoch, vkd3d_memory_order_relaxed);
+
+    /* Lock order is allocator mutex, then shard lock. Ranges are only freed after
+     * the shard lock is released since freeing them may need to reclaim a chunk. */
+    for (i = 0; i < VKD3D_MEMORY_MAGAZINE_SHARD_COUNT; i++)
+    {
+        shard = &allocator->magazine_shards[i];
+        spinlock_acquire(&shard->lock);
+
+        for (j = 0, count = 0; j < shard->magazine_count; j++)
+        {
+            magazine = &shard->magazines[j];
+
+            if (idle_only && epoch - magazine->last_use_epoch < VKD3D_MEMORY_MAGAZINE_IDLE_EPOCHS)
+                continue;
+
+            for (k = 0; k < VKD3D_MEMORY_MAGAZINE_CLASS_COUNT; k++)
+            {
+                vkd3d_memory_allocator_unpark_magazine_entries(allocator,
+                        magazine->entries[k], magazine->entry_count[k], k);
+                memcpy(&entries[count], magazine->entries[k], magazine->entry_count[k] * sizeof(*entries));
+                count += magazine->entry_count[k];
+                magazine->entry_count[k] = 0;
+            }
+        }
+
+        spinlock_release(&shard->lock);
+
+        vkd3d_memory_allocator_free_magazine_entries_locked(allocator, device, entries, count);
+        drained = drained || count;
+    }
+
+    return drained;
+}
+
+static void vkd3d_memory_allocator_advance_epoch_locked(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device)
+{
+    uint32_t epoch;
+
+    /* Piggyback on slow paths rather than running a timer, magazines which
+     * keep seeing use never get here and need no trimming to begin with. */
+    epoch = vkd3d_atomic_uint32_increment(&allocator->magazine_epoch, vkd3d_memory_order_relaxed);
+
+    if (epoch - allocator->magazine_trim_epoch >= VKD3D_MEMORY_MAGAZINE_TRIM_INTERVAL)
+    {
+        allocator->magazine_trim_epoch = epoch;
+        vkd3d_memory_allocator_drain_magazines_locked(allocator, device, true);
+    }
+}
+
+static void vkd3d_memory_allocator_free_magazine_entries(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, const struct vkd3d_memory_magazine_entry *entries, uint32_t count)
+{
+    vkd3d_memory_allocator_lock(allocator);
+    vkd3d_memory_allocator_free_magazine_entries_locked(allocator, device, entries, count);
+    vkd3d_memory_allocator_advance_epoch_locked(allocator, device);
+    vkd3d_memory_allocator_unlock(allocator);
+}
+
+static bool vkd3d_memory_allocator_pop_magazine(struct vkd3d_memory_allocator *allocator,
+        const struct vkd3d_allocate_memory_info *info, uint32_t class_index, uint32_t type_mask,
+        struct vkd3d_memory_allocation *allocation)
+{
+    struct vkd3d_memory_magazine_shard *shard;
+    struct vkd3d_memory_magazine_entry entry;
+    struct vkd3d_memory_magazine *magazine;
+    bool found = false;
+    uint32_t i, *count;
+
+    shard = vkd3d_memory_allocator_get_magazine_shard(allocator);
+    spinlock_acquire(&shard->lock);
+
+    if ((magazine = vkd3d_memory_magazine_shard_get_magazine(shard, info->heap_properties.Type,
+            vkd3d_memory_chunk_get_heap_flags(info->heap_flags), false)))
+    {
+        count = &magazine->entry_count[class_index];
+
+        for (i = *count; i && !found; i--)
+        {
+            entry = magazine->entries[class_index][i - 1];
+
+            if ((found = !!(type_mask & (1u << entry.chunk->allocation.device_allocation.vk_memory_type))))
+                magazine->entries[class_index][i - 1] = magazine->entries[class_index][--(*count)];
+        }
+
+        if (found)
+        {
+            vkd3d_memory_allocator_unpark_magazine_entries(allocator, &entry, 1, class_index);
+            magazine->last_use_epoch = vkd3d_atomic_uint32_load_explicit(&allocator->magazine_epoch,
+                    vkd3d_memory_order_relaxed);
+        }
+    }
+
+    spinlock_release(&shard->lock);
+
+    if (found)
+        vkd3d_memory_magazine_entry_get_allocation(&entry, info->memory_requirements.size, allocation);
+
+    return found;
+}
+
+static void vkd3d_memory_allocator_push_magazine_entries(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags,
+        uint32_t class_index, const struct vkd3d_memory_magazine_entry *entries, uint32_t count)
+{
+    struct vkd3d_memory_magazine_entry drain_entries[VKD3D_MEMORY_MAGAZINE_ENTRY_COUNT + VKD3D_MEMORY_MAGAZINE_BATCH_SIZE];
+    struct vkd3d_memory_magazine_shard *shard;
+    struct vkd3d_memory_magazine *magazine;
+    uint32_t drain_count = 0, i, *entry_count;
+
+    shard = vkd3d_memory_allocator_get_magazine_shard(allocator);
+    spinlock_acquire(&shard->lock);
+
+    if ((magazine = vkd3d_memory_magazine_shard_get_magazine(shard, heap_type, heap_flags, true)))
+    {
+        entry_count = &magazine->entry_count[class_index];
+        magazine->last_use_epoch = vkd3d_atomic_uint32_load_explicit(&allocator->magazine_epoch,
+                vkd3d_memory_order_relaxed);
+
+        for (i = 0; i < count; i++)
+        {
+            /* Return a batch of the least recently used ranges to the
+             * shared chunks rather than a single range at a time. */
+            if (*entry_count == VKD3D_MEMORY_MAGAZINE_ENTRY_COUNT)
+            {
+                vkd3d_memory_allocator_unpark_magazine_entries(allocator, magazine->entries[class_index],
+                        VKD3D_MEMORY_MAGAZINE_BATCH_SIZE, class_index);
+                memcpy(&drain_entries[drain_count], magazine->entries[class_index],
+                        VKD3D_MEMORY_MAGAZINE_BATCH_SIZE * sizeof(*drain_entries));
+                memmove(magazine->entries[class_index], &magazine->entries[class_index][VKD3D_MEMORY_MAGAZINE_BATCH_SIZE],
+                        (*entry_count - VKD3D_MEMORY_MAGAZINE_BATCH_SIZE) * sizeof(*drain_entries));
+                drain_count += VKD3D_MEMORY_MAGAZINE_BATCH_SIZE;
+                *entry_count -= VKD3D_MEMORY_MAGAZINE_BATCH_SIZE;
+            }
+
+            /* Ranges beyond the allocator-wide budget go straight back to their chunk */
+            if (vkd3d_memory_allocator_park_magazine_entry(allocator, &entries[i], class_index))
+                magazine->entries[class_index][(*entry_count)++] = entries[i];
+            else
+                drain_entries[drain_count++] = entries[i];
+        }
+    }
+    else
+    {
+        memcpy(drain_entries, entries, count * sizeof(*drain_entries));
+        drain_count = count;
+    }
+
+    spinlock_release(&shard->lock);
+
+    if (drain_count)
+        vkd3d_memory_allocator_free_magazine_entries(allocator, device, drain_entries, drain_count);
+}
+
+static HRESULT vkd3d_memory_allocator_refill_magazine(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, const struct vkd3d_allocate_memory_info *info,
+        uint32_t class_index, uint32_t type_mask, struct vkd3d_memory_allocation *allocation)
+{
+    struct vkd3d_memory_magazine_entry entries[VKD3D_MEMORY_MAGAZINE_BATCH_SIZE + 1];
+    uint32_t count, batch_size, cached_size;
+    VkMemoryRequirements class_requirements;
+    struct vkd3d_memory_allocation range;
+    VKD3D_REGION_DECL(memory_magazine_refill);
+
+    class_requirements.size = vkd3d_memory_magazine_get_class_size(class_index);
+    class_requirements.alignment = VKD3D_MEMORY_MAGAZINE_CLASS_SIZE;
+    class_requirements.memoryTypeBits = type_mask;
+
+    /* Don't carve ranges which would immediately be rejected by the magazine */
+    cached_size = vkd3d_atomic_uint32_load_explicit(&allocator->magazine_cached_size, vkd3d_memory_order_relaxed);
+    batch_size = cached_size < VKD3D_MEMORY_MAGAZINE_MAX_CACHED_SIZE
+            ? (VKD3D_MEMORY_MAGAZINE_MAX_CACHED_SIZE - cached_size) / class_requirements.size : 0;
+    batch_size = min(batch_size, VKD3D_MEMORY_MAGAZINE_BATCH_SIZE);
+
+    VKD3D_REGION_BEGIN(memory_magazine_refill);
+    vkd3d_memory_allocator_lock(allocator);
+    vkd3d_memory_allocator_advance_epoch_locked(allocator, device);
+
+    /* Carve one range for the caller plus a batch for subsequent allocations */
+    for (count = 0; count < batch_size + 1; count++)
+    {
+        if (FAILED(vkd3d_memory_allocator_try_suballocate_memory(allocator, device,
+                &class_requirements, type_mask, 0, &info->heap_properties, info->heap_flags, &range)))
+            break;
+
+        vkd3d_memory_magazine_entry_init(&entries[count], &range);
+    }
+
+    vkd3d_memory_allocator_unlock(allocator);
+
+    if (!count)
+        return E_OUTOFMEMORY;
+
+    vkd3d_memory_magazine_entry_get_allocation(&entries[0], info->memory_requirements.size, allocation);
+
+    if (count > 1)
+    {
+        vkd3d_memory_allocator_push_magazine_entries(allocator, device, info->heap_properties.Type,
+                vkd3d_memory_chunk_get_heap_flags(info->heap_flags), class_index, &entries[1], count - 1);
+    }
+
+    VKD3D_REGION_END_ITERATIONS(memory_magazine_refill, count);
+    return S_OK;
+}
+
 void vkd3d_free_memory(struct d3d12_device *device, struct vkd3d_memory_allocator *allocator,
         const struct vkd3d_memory_allocation *allocation)
 {
+    struct vkd3d_memory_magazine_entry entry;
+    struct vkd3d_memory_chunk *chunk;
+    uint32_t class_index;
+
     if (allocation->device_allocation.vk_memory == VK_NULL_HANDLE)
         return;
 
     if (allocation->clear_semaphore_value)
         vkd3d_memory_allocator_wait_allocation(allocator, device, allocation);
 
-    if (allocation->chunk)
+    if ((chunk = allocation->chunk))
     {
-        pthread_mutex_lock(&allocator->mutex);
-        vkd3d_memory_chunk_free_range(allocation->chunk, allocation);
+        /* If this is the last range of the chunk that is not parked in a magazine,
+         * parking it as well would keep an otherwise empty chunk alive. Free it
+         * through the shared path instead, which reclaims the parked ranges. */
+        if ((allocation->flags & VKD3D_ALLOCATION_FLAG_MAGAZINE) &&
+                vkd3d_memory_magazine_get_class(allocation->resource.size, 0, &class_index) &&
+                vkd3d_atomic_uint32_load_explicit(&chunk->used_block_count, vkd3d_memory_order_relaxed) !=
+                vkd3d_atomic_uint32_load_explicit(&chunk->magazine_block_count, vkd3d_memory_order_relaxed) + 1)
+        {
+            vkd3d_memory_magazine_entry_init(&entry, allocation);
+            vkd3d_memory_allocator_push_magazine_entries(allocator, device, allocation->heap_type,
+                    allocation->heap_flags, class_index, &entry, 1);
+            return;
+        }
 
-        if (vkd3d_memory_chunk_is_free(allocation->chunk))
-            vkd3d_memory_allocator_remove_chunk(allocator, device, allocation->chunk);
-        pthread_mutex_unlock(&allocator->mutex);
+        vkd3d_memory_allocator_lock(allocator);
+        vkd3d_memory_allocator_free_chunk_block_locked(allocator, device, chunk, allocation->chunk_block);
+        vkd3d_memory_allocator_advance_epoch_locked(allocator, device);
+        vkd3d_memory_allocator_unlock(allocator);
     }
     else
         vkd3d_memory_allocation_free(allocation, device, allocator);
 }
 
+static HRESULT vkd3d_memory_allocator_suballocate_locked(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, const struct vkd3d_allocate_memory_info *info,
+        uint32_t required_mask, uint32_t optional_mask, VkMemoryPropertyFlags optional_flags,
+        struct vkd3d_memory_allocation *allocation)
+{
+    VkMemoryRequirements memory_requirements = info->memory_requirements;
+    HRESULT hr;
+
+    hr = vkd3d_memory_allocator_try_suballocate_memory(allocator, device,
+            &memory_requirements, optional_mask, 0, &info->heap_properties,
+            info->heap_flags, allocation);
+
+    if (FAILED(hr) && (required_mask & ~optional_mask))
+    {
+        hr = vkd3d_memory_allocator_try_suballocate_memory(allocator, device,
+                &memory_requirements, required_mask & ~optional_mask,
+                optional_flags,
+                &info->heap_properties, info->heap_flags, allocation);
+    }
+
+    return hr;
+}
+
 static HRESULT vkd3d_suballocate_memory(struct d3d12_device *device, struct vkd3d_memory_allocator *allocator,
         const struct vkd3d_allocate_memory_info *info, struct vkd3d_memory_allocation *allocation)
 {
     const VkMemoryPropertyFlags optional_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    VkMemoryRequirements memory_requirements = info->memory_requirements;
-    uint32_t required_mask, optional_mask;
+    uint32_t required_mask, optional_mask, magazine_mask, class_index;
     VkMemoryPropertyFlags type_flags;
     HRESULT hr;
-    
+    VKD3D_REGION_DECL(memory_magazine_hit);
+    VKD3D_REGION_DECL(suballocate_memory);
+
     if (FAILED(hr = vkd3d_select_memory_flags(device, &info->heap_properties, &type_flags)))
         return hr;
 
@@ -1349,21 +2036,44 @@ static HRESULT vkd3d_suballocate_memory(struct d3d12_device *device, struct vkd3
     required_mask = vkd3d_find_memory_types_with_flags(device, type_flags & ~optional_flags);
     optional_mask = vkd3d_find_memory_types_with_flags(device, type_flags);
 
-    pthread_mutex_lock(&allocator->mutex);
+    /* Magazines only hold ranges of the preferred memory types, anything
+     * that needs to fall back goes through the shared chunks directly. */
+    if (vkd3d_memory_magazine_get_class(info->memory_requirements.size,
+            info->memory_requirements.alignment, &class_index))
+    {
+        magazine_mask = optional_mask & info->memory_requirements.memoryTypeBits & device->memory_info.global_mask;
 
-    hr = vkd3d_memory_allocator_try_suballocate_memory(allocator, device,
-            &memory_requirements, optional_mask, 0, &info->heap_properties,
-            info->heap_flags, allocation);
+        if (magazine_mask)
+        {
+            VKD3D_REGION_BEGIN(memory_magazine_hit);
+            if (vkd3d_memory_allocator_pop_magazine(allocator, info, class_index, magazine_mask, allocation))
+            {
+                VKD3D_REGION_END(memory_magazine_hit);
+                return S_OK;
+            }
 
-    if (FAILED(hr) && (required_mask & ~optional_mask))
+            if (SUCCEEDED(hr = vkd3d_memory_allocator_refill_magazine(allocator, device,
+                    info, class_index, magazine_mask, allocation)))
+                return hr;
+        }
+    }
+
+    VKD3D_REGION_BEGIN(suballocate_memory);
+    vkd3d_memory_allocator_lock(allocator);
+    vkd3d_memory_allocator_advance_epoch_locked(allocator, device);
+
+    hr = vkd3d_memory_allocator_suballocate_locked(allocator, device, info,
+            required_mask, optional_mask, optional_flags, allocation);
+
+    /* Ranges cached in magazines may keep otherwise free chunks alive */
+    if (FAILED(hr) && vkd3d_memory_allocator_drain_magazines_locked(allocator, device, false))
     {
-        hr = vkd3d_memory_allocator_try_suballocate_memory(allocator, device,
-                &memory_requirements, required_mask & ~optional_mask,
-                optional_flags,
-                &info->heap_properties, info->heap_flags, allocation);
+        hr = vkd3d_memory_allocator_suballocate_locked(allocator, device, info,
+                required_mask, optional_mask, optional_flags, allocation);
     }
 
-    pthread_mutex_unlock(&allocator->mutex);
+    vkd3d_memory_allocator_unlock(allocator);
+    VKD3D_REGION_END(suballocate_memory);
     return hr;
 }
 
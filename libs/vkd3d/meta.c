@@ -1323,6 +1323,79 @@ void vkd3d_meta_get_predicate_pipeline(struct vkd3d_meta_ops *meta_ops,
     info->data_size = predicate_ops->data_sizes[command_type];
 }
 
+HRESULT vkd3d_execute_indirect_ops_init(struct vkd3d_execute_indirect_ops *meta_indirect_ops,
+        struct d3d12_device *device)
+{
+    VkPushConstantRange push_constant_range;
+    VkSpecializationInfo spec_info;
+    VkResult vr;
+    size_t i;
+
+    static const uint32_t arg_counts[] =
+    {
+        4, /* VKD3D_EXECUTE_INDIRECT_DRAW */
+        5, /* VKD3D_EXECUTE_INDIRECT_DRAW_INDEXED */
+        3, /* VKD3D_EXECUTE_INDIRECT_DISPATCH */
+    };
+
+    static const VkSpecializationMapEntry spec_map = { 0, 0, sizeof(uint32_t) };
+
+    STATIC_ASSERT(ARRAY_SIZE(arg_counts) == VKD3D_EXECUTE_INDIRECT_COUNT);
+
+    memset(meta_indirect_ops, 0, sizeof(*meta_indirect_ops));
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(struct vkd3d_execute_indirect_args);
+
+    if ((vr = vkd3d_meta_create_pipeline_layout(device, 0, NULL, 1,
+            &push_constant_range, &meta_indirect_ops->vk_pipeline_layout)) < 0)
+        return hresult_from_vk_result(vr);
+
+    spec_info.mapEntryCount = 1;
+    spec_info.pMapEntries = &spec_map;
+    spec_info.dataSize = sizeof(uint32_t);
+
+    for (i = 0; i < ARRAY_SIZE(arg_counts); i++)
+    {
+        spec_info.pData = &arg_counts[i];
+
+        if ((vr = vkd3d_meta_create_compute_pipeline(device, sizeof(cs_execute_indirect_expand),
+                cs_execute_indirect_expand, meta_indirect_ops->vk_pipeline_layout, &spec_info,
+                &meta_indirect_ops->vk_pipelines[i])) < 0)
+            goto fail;
+
+        meta_indirect_ops->command_sizes[i] = arg_counts[i] * sizeof(uint32_t);
+    }
+
+    return S_OK;
+
+fail:
+    vkd3d_execute_indirect_ops_cleanup(meta_indirect_ops, device);
+    return hresult_from_vk_result(vr);
+}
+
+void vkd3d_execute_indirect_ops_cleanup(struct vkd3d_execute_indirect_ops *meta_indirect_ops,
+        struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    size_t i;
+
+    for (i = 0; i < VKD3D_EXECUTE_INDIRECT_COUNT; i++)
+        VK_CALL(vkDestroyPipeline(device->vk_device, meta_indirect_ops->vk_pipelines[i], NULL));
+
+    VK_CALL(vkDestroyPipelineLayout(device->vk_device, meta_indirect_ops->vk_pipeline_layout, NULL));
+}
+
+void vkd3d_meta_get_execute_indirect_pipeline(struct vkd3d_meta_ops *meta_ops,
+        enum vkd3d_execute_indirect_type type, struct vkd3d_execute_indirect_info *info)
+{
+    const struct vkd3d_execute_indirect_ops *indirect_ops = &meta_ops->execute_indirect;
+
+    info->vk_pipeline_layout = indirect_ops->vk_pipeline_layout;
+    info->vk_pipeline = indirect_ops->vk_pipelines[type];
+    info->command_size = indirect_ops->command_sizes[type];
+}
+
 HRESULT vkd3d_meta_ops_init(struct vkd3d_meta_ops *meta_ops, struct d3d12_device *device)
 {
     HRESULT hr;
@@ -1348,8 +1421,13 @@ HRESULT vkd3d_meta_ops_init(struct vkd3d_meta_ops *meta_ops, struct d3d12_device
     if (FAILED(hr = vkd3d_predicate_ops_init(&meta_ops->predicate, device)))
         goto fail_predicate_ops;
 
+    if (FAILED(hr = vkd3d_execute_indirect_ops_init(&meta_ops->execute_indirect, device)))
+        goto fail_execute_indirect_ops;
+
     return S_OK;
 
+fail_execute_indirect_ops:
+    vkd3d_predicate_ops_cleanup(&meta_ops->predicate, device);
 fail_predicate_ops:
     vkd3d_query_ops_cleanup(&meta_ops->query, device);
 fail_query_ops:
@@ -1366,6 +1444,7 @@ fail_common:
 
 HRESULT vkd3d_meta_ops_cleanup(struct vkd3d_meta_ops *meta_ops, struct d3d12_device *device)
 {
+    vkd3d_execute_indirect_ops_cleanup(&meta_ops->execute_indirect, device);
     vkd3d_predicate_ops_cleanup(&meta_ops->predicate, device);
     vkd3d_query_ops_cleanup(&meta_ops->query, device);
     vkd3d_swapchain_ops_cleanup(&meta_ops->swapchain, device);
@@ -116,6 +116,7 @@ static void d3d12_state_object_cleanup(struct d3d12_state_object *object)
         vkd3d_free(object->exports[i].plain_export);
     }
     vkd3d_free(object->exports);
+    hash_map_clear(&object->export_map);
     vkd3d_free(object->entry_points);
 
     for (i = 0; i < object->collections_count; i++)
@@ -206,11 +207,83 @@ static bool vkd3d_export_equal(LPCWSTR export, const struct vkd3d_shader_library
             vkd3d_export_strequal(export, entry->plain_entry_point);
 }
 
+struct d3d12_state_object_export_key
+{
+    const WCHAR *name;
+    size_t length;
+};
+
+struct d3d12_state_object_export_entry
+{
+    struct hash_map_entry entry;
+    const WCHAR *name;
+    size_t length;
+    uint32_t index;
+};
+
+static uint32_t d3d12_state_object_export_hash(const void *key)
+{
+    const struct d3d12_state_object_export_key *k = key;
+    uint64_t hash = hash_fnv1_init();
+    size_t i;
+
+    for (i = 0; i < k->length; i++)
+        hash = hash_fnv1_iterate_u32(hash, k->name[i]);
+
+    return hash_uint64(hash);
+}
+
+static bool d3d12_state_object_export_compare(const void *key, const struct hash_map_entry *entry)
+{
+    const struct d3d12_state_object_export_entry *e = (const struct d3d12_state_object_export_entry *)entry;
+    const struct d3d12_state_object_export_key *k = key;
+
+    return k->length == e->length && !memcmp(k->name, e->name, k->length * sizeof(*k->name));
+}
+
+static bool d3d12_state_object_add_export_name(struct d3d12_state_object *object,
+        const WCHAR *name, uint32_t index)
+{
+    struct d3d12_state_object_export_entry entry;
+    struct d3d12_state_object_export_key key;
+
+    if (!name)
+        return true;
+
+    key.name = name;
+    key.length = vkd3d_wcslen(name);
+
+    /* If names alias, the first export wins, same as a linear search would. */
+    entry.name = key.name;
+    entry.length = key.length;
+    entry.index = index;
+    return !!hash_map_insert(&object->export_map, &key, &entry.entry);
+}
+
+static HRESULT d3d12_state_object_init_export_map(struct d3d12_state_object *object)
+{
+    size_t i;
+
+    hash_map_init(&object->export_map, d3d12_state_object_export_hash,
+            d3d12_state_object_export_compare, sizeof(struct d3d12_state_object_export_entry));
+
+    for (i = 0; i < object->exports_count; i++)
+    {
+        if (!d3d12_state_object_add_export_name(object, object->exports[i].mangled_export, i) ||
+                !d3d12_state_object_add_export_name(object, object->exports[i].plain_export, i))
+            return E_OUTOFMEMORY;
+    }
+
+    return S_OK;
+}
+
 static uint32_t d3d12_state_object_get_export_index(struct d3d12_state_object *object,
         const WCHAR *export_name, const WCHAR **out_subtype)
 {
+    const struct d3d12_state_object_export_entry *entry;
+    struct d3d12_state_object_export_key key;
     const WCHAR *subtype = NULL;
-    size_t i, n;
+    size_t n;
 
     /* Need to check for hitgroup::{closesthit,anyhit,intersection}. */
     n = 0;
@@ -220,14 +293,13 @@ static uint32_t d3d12_state_object_get_export_index(struct d3d12_state_object *o
     if (export_name[n] == ':')
         subtype = export_name + n;
 
-    for (i = 0; i < object->exports_count; i++)
+    key.name = export_name;
+    key.length = n;
+
+    if ((entry = (const struct d3d12_state_object_export_entry *)hash_map_find(&object->export_map, &key)))
     {
-        if (vkd3d_export_strequal_substr(export_name, n, object->exports[i].mangled_export) ||
-                vkd3d_export_strequal_substr(export_name, n, object->exports[i].plain_export))
-        {
-            *out_subtype = subtype;
-            return i;
-        }
+        *out_subtype = subtype;
+        return entry->index;
     }
 
     return UINT32_MAX;
@@ -951,6 +1023,99 @@ static void d3d12_state_object_append_local_static_samplers(
     *out_vk_bindings_count = vk_bindings_count;
 }
 
+/* Upper bound of threads used to translate the exports of a single state object. */
+#define VKD3D_STATE_OBJECT_COMPILE_THREAD_COUNT 8
+
+struct d3d12_state_object_export_compile
+{
+    const struct vkd3d_shader_library_entry_point *entry;
+    uint32_t stage_index;
+    struct vkd3d_shader_code dxil;
+    /* Snapshots of the interface as it was when the entry point was visited,
+     * since flags are promoted while iterating over entry points. */
+    struct vkd3d_shader_interface_info shader_interface_info;
+    struct vkd3d_shader_interface_local_info shader_interface_local_info;
+    struct vkd3d_shader_resource_binding *local_bindings;
+    struct vkd3d_shader_code spirv;
+    int ret;
+};
+
+struct d3d12_state_object_compile_context
+{
+    struct d3d12_state_object_export_compile *exports;
+    size_t exports_count;
+    const struct vkd3d_shader_compile_arguments *compile_args;
+    LONG next_export;
+};
+
+static void d3d12_state_object_compile_exports_work(struct d3d12_state_object_compile_context *context)
+{
+    struct d3d12_state_object_export_compile *export;
+    size_t index;
+
+    while ((index = (size_t)(InterlockedIncrement(&context->next_export) - 1)) < context->exports_count)
+    {
+        export = &context->exports[index];
+        export->ret = vkd3d_shader_compile_dxil_export(&export->dxil, export->entry->real_entry_point,
+                &export->spirv, &export->shader_interface_info, &export->shader_interface_local_info,
+                context->compile_args);
+    }
+}
+
+static void *d3d12_state_object_compile_exports_main(void *userdata)
+{
+    vkd3d_set_thread_name("vkd3d_rt_compile");
+    d3d12_state_object_compile_exports_work(userdata);
+    return NULL;
+}
+
+static void d3d12_state_object_compile_exports(struct d3d12_state_object *object,
+        struct d3d12_state_object_compile_context *context)
+{
+    union vkd3d_thread_handle threads[VKD3D_STATE_OBJECT_COMPILE_THREAD_COUNT - 1];
+    unsigned int thread_count, i;
+
+    context->next_export = 0;
+    if (context->exports_count <= 1)
+    {
+        d3d12_state_object_compile_exports_work(context);
+        return;
+    }
+
+    thread_count = min(context->exports_count - 1, ARRAY_SIZE(threads));
+
+    /* The calling thread picks up whatever the helper threads do not get to,
+     * so failing to create threads only serializes compilation. */
+    for (i = 0; i < thread_count; i++)
+    {
+        if (FAILED(vkd3d_create_thread(object->device->vkd3d_instance,
+                d3d12_state_object_compile_exports_main, context, &threads[i])))
+        {
+            WARN("Failed to create compile thread.\n");
+            break;
+        }
+    }
+    thread_count = i;
+
+    d3d12_state_object_compile_exports_work(context);
+
+    for (i = 0; i < thread_count; i++)
+        vkd3d_join_thread(object->device->vkd3d_instance, &threads[i]);
+}
+
+static void d3d12_state_object_compile_context_cleanup(struct d3d12_state_object_compile_context *context)
+{
+    size_t i;
+
+    for (i = 0; i < context->exports_count; i++)
+    {
+        vkd3d_free(context->exports[i].local_bindings);
+        vkd3d_shader_free_shader_code(&context->exports[i].spirv);
+    }
+
+    vkd3d_free(context->exports);
+}
+
 static HRESULT d3d12_state_object_compile_pipeline(struct d3d12_state_object *object,
         struct d3d12_state_object_pipeline_data *data)
 {
@@ -961,6 +1126,8 @@ static HRESULT d3d12_state_object_compile_pipeline(struct d3d12_state_object *ob
     struct vkd3d_shader_interface_info shader_interface_info;
     VkRayTracingPipelineCreateInfoKHR pipeline_create_info;
     struct vkd3d_shader_resource_binding *local_bindings;
+    struct d3d12_state_object_compile_context compile_context;
+    struct d3d12_state_object_export_compile *export_compile;
     struct vkd3d_shader_compile_arguments compile_args;
     struct d3d12_state_object_collection *collection;
     VkPipelineDynamicStateCreateInfo dynamic_state;
@@ -975,8 +1142,6 @@ static HRESULT d3d12_state_object_compile_pipeline(struct d3d12_state_object *ob
     VkPipelineShaderStageCreateInfo *stage;
     uint32_t pgroup_offset, pstage_offset;
     unsigned int num_groups_to_export;
-    struct vkd3d_shader_code spirv;
-    struct vkd3d_shader_code dxil;
     size_t i, j;
     VkResult vr;
     HRESULT hr;
@@ -1023,6 +1188,15 @@ static HRESULT d3d12_state_object_compile_pipeline(struct d3d12_state_object *ob
     local_static_sampler_bindings_size = 0;
     object->local_static_sampler.set_index = global_signature ? global_signature->num_set_layouts : 0;
 
+    memset(&compile_context, 0, sizeof(compile_context));
+    compile_context.compile_args = &compile_args;
+
+    if (data->entry_points_count &&
+            !(compile_context.exports = vkd3d_calloc(data->entry_points_count, sizeof(*compile_context.exports))))
+        return E_OUTOFMEMORY;
+
+    /* Gather everything which depends on the order of entry points first,
+     * translate the exports in parallel, then create shader modules in export order. */
     for (i = 0; i < data->entry_points_count; i++)
     {
         entry = &data->entry_points[i];
@@ -1108,41 +1282,59 @@ static HRESULT d3d12_state_object_compile_pipeline(struct d3d12_state_object *ob
         stage->pName = "main";
         stage->pSpecializationInfo = NULL;
 
-        memset(&dxil, 0, sizeof(dxil));
-        memset(&spirv, 0, sizeof(spirv));
+        export_compile = &compile_context.exports[compile_context.exports_count++];
+        export_compile->entry = entry;
+        export_compile->stage_index = data->stages_count;
+        export_compile->local_bindings = local_bindings;
+        export_compile->shader_interface_info = shader_interface_info;
+        export_compile->shader_interface_local_info = shader_interface_local_info;
 
         /* TODO: If we're exporting multiple entry points from one DXIL library,
          * we can amortize the parsing cost. */
-        dxil.code = data->dxil_libraries[entry->identifier]->DXILLibrary.pShaderBytecode;
-        dxil.size = data->dxil_libraries[entry->identifier]->DXILLibrary.BytecodeLength;
+        export_compile->dxil.code = data->dxil_libraries[entry->identifier]->DXILLibrary.pShaderBytecode;
+        export_compile->dxil.size = data->dxil_libraries[entry->identifier]->DXILLibrary.BytecodeLength;
+
+        data->stages_count++;
+    }
+
+    d3d12_state_object_compile_exports(object, &compile_context);
+
+    for (i = 0; i < compile_context.exports_count; i++)
+    {
+        export_compile = &compile_context.exports[i];
+        stage = &data->stages[export_compile->stage_index];
 
-        if (vkd3d_shader_compile_dxil_export(&dxil, entry->real_entry_point, &spirv,
-                &shader_interface_info, &shader_interface_local_info, &compile_args) != VKD3D_OK)
+        if (export_compile->ret != VKD3D_OK)
         {
-            ERR("Failed to convert DXIL export: %s\n", entry->real_entry_point);
-            vkd3d_free(local_bindings);
+            ERR("Failed to convert DXIL export: %s\n", export_compile->entry->real_entry_point);
+            d3d12_state_object_compile_context_cleanup(&compile_context);
             return E_OUTOFMEMORY;
         }
 
-        vkd3d_free(local_bindings);
-        if (!d3d12_device_validate_shader_meta(object->device, &spirv.meta))
+        if (!d3d12_device_validate_shader_meta(object->device, &export_compile->spirv.meta))
+        {
+            d3d12_state_object_compile_context_cleanup(&compile_context);
             return E_INVALIDARG;
+        }
 
-        stage->module = create_shader_module(object->device, spirv.code, spirv.size);
+        stage->module = create_shader_module(object->device,
+                export_compile->spirv.code, export_compile->spirv.size);
 
-        if ((spirv.meta.flags & VKD3D_SHADER_META_FLAG_USES_SUBGROUP_SIZE) &&
+        if ((export_compile->spirv.meta.flags & VKD3D_SHADER_META_FLAG_USES_SUBGROUP_SIZE) &&
                 object->device->device_info.subgroup_size_control_features.subgroupSizeControl)
         {
             stage->flags |= VK_PIPELINE_SHADER_STAGE_CREATE_ALLOW_VARYING_SUBGROUP_SIZE_BIT_EXT;
         }
 
-        vkd3d_shader_free_shader_code(&spirv);
         if (!stage->module)
+        {
+            d3d12_state_object_compile_context_cleanup(&compile_context);
             return E_OUTOFMEMORY;
-
-        data->stages_count++;
+        }
     }
 
+    d3d12_state_object_compile_context_cleanup(&compile_context);
+
     for (i = 0; i < data->hit_groups_count; i++)
     {
         hit_group = data->hit_groups[i];
@@ -1386,6 +1578,9 @@ static HRESULT d3d12_state_object_compile_pipeline(struct d3d12_state_object *ob
     data->exports_size = 0;
     data->exports_count = 0;
 
+    if (FAILED(hr = d3d12_state_object_init_export_map(object)))
+        return hr;
+
     /* Spec says we need to hold a reference to the collection object, but it doesn't show up in API,
      * so we must assume private reference. */
     if (data->collections_count)
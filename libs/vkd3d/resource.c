@@ -21,6 +21,10 @@
 
 #include <float.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "vkd3d_private.h"
 #include "vkd3d_rw_spinlock.h"
 #include "vkd3d_descriptor_debug.h"
@@ -770,8 +774,13 @@ struct vkd3d_view_entry
     struct hash_map_entry entry;
     struct vkd3d_view_key key;
     struct vkd3d_view *view;
+    uint32_t referenced;
 };
 
+/* Upper bound of views released by a single eviction pass,
+ * so that the map lock is not held for too long. */
+#define VKD3D_VIEW_MAP_EVICT_BATCH_SIZE 64
+
 static bool d3d12_sampler_needs_border_color(D3D12_TEXTURE_ADDRESS_MODE u,
         D3D12_TEXTURE_ADDRESS_MODE v, D3D12_TEXTURE_ADDRESS_MODE w);
 
@@ -891,12 +900,13 @@ static bool vkd3d_view_entry_compare(const void *key, const struct hash_map_entr
 HRESULT vkd3d_view_map_init(struct vkd3d_view_map *view_map)
 {
     view_map->spinlock = 0;
-    hash_map_init(&view_map->map, &vkd3d_view_entry_hash, &vkd3d_view_entry_compare, sizeof(struct vkd3d_view_entry));
+    hash_map_init_read_mostly(&view_map->map, &vkd3d_view_entry_hash, &vkd3d_view_entry_compare, sizeof(struct vkd3d_view_entry));
+    view_map->evict_lock = 0;
+    view_map->max_entries = 0;
+    view_map->clock_hand = 0;
     return S_OK;
 }
 
-static void vkd3d_view_destroy(struct vkd3d_view *view, struct d3d12_device *device);
-
 void vkd3d_view_map_destroy(struct vkd3d_view_map *view_map, struct d3d12_device *device)
 {
     uint32_t i;
@@ -905,13 +915,69 @@ void vkd3d_view_map_destroy(struct vkd3d_view_map *view_map, struct d3d12_device
     {
         struct vkd3d_view_entry *e = (struct vkd3d_view_entry *)hash_map_get_entry(&view_map->map, i);
 
+        /* Descriptors or command allocators may still hold references
+         * if the device tracks descriptor views. */
         if (e->entry.flags & HASH_MAP_ENTRY_OCCUPIED)
-            vkd3d_view_destroy(e->view, device);
+            vkd3d_view_decref(e->view, device);
     }
 
     hash_map_clear(&view_map->map);
 }
 
+static void vkd3d_view_map_evict(struct vkd3d_view_map *view_map, struct d3d12_device *device)
+{
+    struct vkd3d_view *evicted_views[VKD3D_VIEW_MAP_EVICT_BATCH_SIZE];
+    uint32_t target_count, evict_count, step_count, i;
+    struct vkd3d_view_entry *e;
+
+    if (vkd3d_atomic_uint32_load_explicit(&view_map->map.used_count, vkd3d_memory_order_relaxed) <= view_map->max_entries)
+        return;
+
+    /* Eviction is opportunistic. If descriptor updates are in flight, the next update retries. */
+    if (!rw_spinlock_try_acquire_write(&view_map->evict_lock))
+        return;
+
+    rw_spinlock_acquire_write(&view_map->spinlock);
+
+    /* Evict down to 3/4 of the limit so that we do not run a pass on every new view. */
+    target_count = view_map->max_entries - view_map->max_entries / 4;
+    step_count = 2 * view_map->map.entry_count;
+    evict_count = 0;
+
+    /* CLOCK replacement. Lookups mark entries as referenced, and the hand clears the mark
+     * on its first pass. Views referenced by anyone but the map itself are never evicted. */
+    while (view_map->map.used_count > target_count && evict_count < ARRAY_SIZE(evicted_views) && step_count--)
+    {
+        i = view_map->clock_hand;
+        e = (struct vkd3d_view_entry *)hash_map_get_entry(&view_map->map, i);
+
+        if (e->entry.flags & HASH_MAP_ENTRY_OCCUPIED)
+        {
+            if (e->referenced)
+            {
+                e->referenced = 0;
+            }
+            else if (!(vkd3d_atomic_uint32_load_explicit(&e->view->flags, vkd3d_memory_order_relaxed) & VKD3D_VIEW_NO_EVICT) &&
+                    vkd3d_atomic_uint32_load_explicit((uint32_t *)&e->view->refcount, vkd3d_memory_order_acquire) == 1)
+            {
+                evicted_views[evict_count++] = e->view;
+                hash_map_remove(&view_map->map, &e->entry);
+            }
+        }
+
+        view_map->clock_hand = hash_map_next_entry_idx(&view_map->map, i);
+    }
+
+    TRACE("Evicted %u views from view map %p, %u views remaining.\n",
+            evict_count, view_map, view_map->map.used_count);
+
+    rw_spinlock_release_write(&view_map->spinlock);
+    rw_spinlock_release_write(&view_map->evict_lock);
+
+    for (i = 0; i < evict_count; i++)
+        vkd3d_view_decref(evicted_views[i], device);
+}
+
 static struct vkd3d_view *vkd3d_view_create(enum vkd3d_view_type type);
 
 static HRESULT d3d12_create_sampler(struct d3d12_device *device,
@@ -923,20 +989,24 @@ struct vkd3d_view *vkd3d_view_map_create_view(struct vkd3d_view_map *view_map,
     struct vkd3d_view_entry entry, *e;
     struct vkd3d_view *redundant_view;
     struct vkd3d_view *view;
+    uint32_t read_slot;
     bool success;
 
     /* In the steady state, we will be reading existing entries from a view map.
-     * Prefer read-write spinlocks here to reduce contention as much as possible. */
-    rw_spinlock_acquire_read(&view_map->spinlock);
+     * The map is read-mostly, so lookups do not take the lock at all and only
+     * writers serialize on the spinlock. */
+    read_slot = hash_map_read_begin(&view_map->map);
 
-    if ((e = (struct vkd3d_view_entry *)hash_map_find(&view_map->map, key)))
+    if ((e = (struct vkd3d_view_entry *)hash_map_find_read_mostly(&view_map->map, key)))
     {
         view = e->view;
-        rw_spinlock_release_read(&view_map->spinlock);
+        if (view_map->max_entries && !vkd3d_atomic_uint32_load_explicit(&e->referenced, vkd3d_memory_order_relaxed))
+            vkd3d_atomic_uint32_store_explicit(&e->referenced, 1, vkd3d_memory_order_relaxed);
+        hash_map_read_end(&view_map->map, read_slot);
         return view;
     }
 
-    rw_spinlock_release_read(&view_map->spinlock);
+    hash_map_read_end(&view_map->map, read_slot);
 
     switch (key->view_type)
     {
@@ -971,6 +1041,7 @@ struct vkd3d_view *vkd3d_view_map_create_view(struct vkd3d_view_map *view_map,
 
     entry.key = *key;
     entry.view = view;
+    entry.referenced = 1;
 
     rw_spinlock_acquire_write(&view_map->spinlock);
 
@@ -1679,6 +1750,162 @@ static D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE d3d12_resource_GetGPUVirtualA
     return resource->res.va;
 }
 
+/* Copies below this size are not worth waking up the workers for. */
+#define VKD3D_COPY_WORKER_THRESHOLD (4u << 20)
+#define VKD3D_COPY_WORKER_CHUNK_SIZE (1u << 20)
+
+static bool vkd3d_copy_workers_copy_chunk_locked(struct vkd3d_copy_workers *workers)
+{
+    const struct vkd3d_memcpy_rows *copy = workers->copy;
+    unsigned int first_row, row_count, chunk;
+
+    if (!copy || workers->next_chunk >= workers->chunk_count)
+        return false;
+
+    chunk = workers->next_chunk++;
+    first_row = chunk * workers->chunk_row_count;
+    row_count = min(workers->chunk_row_count, vkd3d_memcpy_rows_get_total_row_count(copy) - first_row);
+
+    pthread_mutex_unlock(&workers->mutex);
+    vkd3d_memcpy_rows(copy, first_row, row_count);
+    pthread_mutex_lock(&workers->mutex);
+
+    if (!--workers->pending_chunk_count)
+        pthread_cond_broadcast(&workers->done_cond);
+    return true;
+}
+
+static void *vkd3d_copy_worker_main(void *arg)
+{
+    struct vkd3d_copy_workers *workers = arg;
+    int rc;
+
+    vkd3d_set_thread_name("vkd3d_copy");
+
+    if ((rc = pthread_mutex_lock(&workers->mutex)))
+    {
+        ERR("Failed to lock mutex, error %d.\n", rc);
+        return NULL;
+    }
+
+    while (!workers->should_exit)
+    {
+        if (vkd3d_copy_workers_copy_chunk_locked(workers))
+            continue;
+
+        if ((rc = pthread_cond_wait(&workers->cond, &workers->mutex)))
+        {
+            ERR("Failed to wait on condition variable, error %d.\n", rc);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&workers->mutex);
+    return NULL;
+}
+
+void vkd3d_copy_workers_start(struct vkd3d_copy_workers *workers, struct d3d12_device *device)
+{
+    uint32_t i;
+    int rc;
+
+    memset(workers, 0, sizeof(*workers));
+
+    if ((rc = pthread_mutex_init(&workers->mutex, NULL)))
+    {
+        ERR("Failed to initialize mutex, error %d.\n", rc);
+        return;
+    }
+
+    if ((rc = pthread_cond_init(&workers->cond, NULL)))
+    {
+        ERR("Failed to initialize condition variable, error %d.\n", rc);
+        pthread_mutex_destroy(&workers->mutex);
+        return;
+    }
+
+    if ((rc = pthread_cond_init(&workers->done_cond, NULL)))
+    {
+        ERR("Failed to initialize condition variable, error %d.\n", rc);
+        pthread_cond_destroy(&workers->cond);
+        pthread_mutex_destroy(&workers->mutex);
+        return;
+    }
+
+    workers->device = device;
+
+    /* Without worker threads, all copies run on the calling thread. */
+    for (i = 0; i < ARRAY_SIZE(workers->threads); i++)
+    {
+        if (FAILED(vkd3d_create_thread(device->vkd3d_instance,
+                vkd3d_copy_worker_main, workers, &workers->threads[i])))
+        {
+            ERR("Failed to create copy worker thread.\n");
+            break;
+        }
+
+        workers->thread_count++;
+    }
+}
+
+void vkd3d_copy_workers_stop(struct vkd3d_copy_workers *workers, struct d3d12_device *device)
+{
+    uint32_t i;
+
+    if (!workers->device)
+        return;
+
+    pthread_mutex_lock(&workers->mutex);
+    workers->should_exit = true;
+    pthread_cond_broadcast(&workers->cond);
+    pthread_mutex_unlock(&workers->mutex);
+
+    for (i = 0; i < workers->thread_count; i++)
+        vkd3d_join_thread(device->vkd3d_instance, &workers->threads[i]);
+
+    pthread_cond_destroy(&workers->done_cond);
+    pthread_cond_destroy(&workers->cond);
+    pthread_mutex_destroy(&workers->mutex);
+}
+
+void vkd3d_copy_workers_copy(struct vkd3d_copy_workers *workers, const struct vkd3d_memcpy_rows *copy)
+{
+    unsigned int total_row_count = vkd3d_memcpy_rows_get_total_row_count(copy);
+
+    if (!workers->thread_count || !copy->row_size ||
+            (uint64_t)total_row_count * copy->row_size < VKD3D_COPY_WORKER_THRESHOLD)
+    {
+        vkd3d_memcpy_rows(copy, 0, total_row_count);
+        return;
+    }
+
+    pthread_mutex_lock(&workers->mutex);
+
+    if (workers->copy)
+    {
+        /* Another thread owns the workers, don't serialize behind it. */
+        pthread_mutex_unlock(&workers->mutex);
+        vkd3d_memcpy_rows(copy, 0, total_row_count);
+        return;
+    }
+
+    workers->copy = copy;
+    workers->chunk_row_count = max(1u, VKD3D_COPY_WORKER_CHUNK_SIZE / copy->row_size);
+    workers->chunk_count = (total_row_count + workers->chunk_row_count - 1) / workers->chunk_row_count;
+    workers->next_chunk = 0;
+    workers->pending_chunk_count = workers->chunk_count;
+    pthread_cond_broadcast(&workers->cond);
+
+    while (vkd3d_copy_workers_copy_chunk_locked(workers))
+        ;
+
+    while (workers->pending_chunk_count)
+        pthread_cond_wait(&workers->done_cond, &workers->mutex);
+
+    workers->copy = NULL;
+    pthread_mutex_unlock(&workers->mutex);
+}
+
 static HRESULT STDMETHODCALLTYPE d3d12_resource_WriteToSubresource(d3d12_resource_iface *iface,
         UINT dst_sub_resource, const D3D12_BOX *dst_box, const void *src_data,
         UINT src_row_pitch, UINT src_slice_pitch)
@@ -1686,6 +1913,8 @@ static HRESULT STDMETHODCALLTYPE d3d12_resource_WriteToSubresource(d3d12_resourc
     struct d3d12_resource *resource = impl_from_ID3D12Resource2(iface);
     const struct vkd3d_vk_device_procs *vk_procs;
     VkImageSubresource vk_sub_resource;
+    struct vkd3d_memcpy_rows copy;
+    VkMemoryPropertyFlags memory_flags;
     VkSubresourceLayout vk_layout;
     struct d3d12_device *device;
     uint8_t *dst_data;
@@ -1751,10 +1980,16 @@ static HRESULT STDMETHODCALLTYPE d3d12_resource_WriteToSubresource(d3d12_resourc
     dst_data += vk_layout.offset + vkd3d_format_get_data_offset(resource->format, vk_layout.rowPitch,
             vk_layout.depthPitch, dst_box->left, dst_box->top, dst_box->front);
 
-    vkd3d_format_copy_data(resource->format, src_data, src_row_pitch, src_slice_pitch,
+    vkd3d_format_init_copy_rows(resource->format, &copy, src_data, src_row_pitch, src_slice_pitch,
             dst_data, vk_layout.rowPitch, vk_layout.depthPitch, dst_box->right - dst_box->left,
             dst_box->bottom - dst_box->top, dst_box->back - dst_box->front);
 
+    /* Uncached memory is write-combined, so bypass the cache rather than polluting it. */
+    memory_flags = device->memory_properties.memoryTypes[resource->mem.device_allocation.vk_memory_type].propertyFlags;
+    copy.non_temporal = !(memory_flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+    vkd3d_copy_workers_copy(&device->copy_workers, &copy);
+
     return S_OK;
 }
 
@@ -1765,6 +2000,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_resource_ReadFromSubresource(d3d12_resour
     struct d3d12_resource *resource = impl_from_ID3D12Resource2(iface);
     const struct vkd3d_vk_device_procs *vk_procs;
     VkImageSubresource vk_sub_resource;
+    struct vkd3d_memcpy_rows copy;
     VkSubresourceLayout vk_layout;
     struct d3d12_device *device;
     uint8_t *src_data;
@@ -1830,9 +2066,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_resource_ReadFromSubresource(d3d12_resour
     src_data += vk_layout.offset + vkd3d_format_get_data_offset(resource->format, vk_layout.rowPitch,
             vk_layout.depthPitch, src_box->left, src_box->top, src_box->front);
 
-    vkd3d_format_copy_data(resource->format, src_data, vk_layout.rowPitch, vk_layout.depthPitch,
+    vkd3d_format_init_copy_rows(resource->format, &copy, src_data, vk_layout.rowPitch, vk_layout.depthPitch,
             dst_data, dst_row_pitch, dst_slice_pitch, src_box->right - src_box->left,
             src_box->bottom - src_box->top, src_box->back - src_box->front);
+    vkd3d_copy_workers_copy(&device->copy_workers, &copy);
 
     return S_OK;
 }
@@ -2535,7 +2772,11 @@ static void d3d12_resource_destroy(struct d3d12_resource *resource, struct d3d12
         vkd3d_free_memory(device, &device->memory_allocator, &resource->mem);
 
     if (resource->vrs_view)
+    {
+        /* VRS attachments are keyed on the resource cookie in the framebuffer cache. */
+        vkd3d_framebuffer_cache_evict_cookie(&device->framebuffer_cache, device, resource->res.cookie);
         VK_CALL(vkDestroyImageView(device->vk_device, resource->vrs_view, NULL));
+    }
 
     vkd3d_private_store_destroy(&resource->private_store);
     d3d12_device_release(resource->device);
@@ -2594,6 +2835,7 @@ static HRESULT d3d12_resource_create(struct d3d12_device *device, uint32_t flags
         vkd3d_free(object);
         return hr;
     }
+    object->view_map.max_entries = device->view_map_limit;
 
     if (FAILED(hr = vkd3d_private_store_init(&object->private_store)))
     {
@@ -2958,6 +3200,7 @@ VKD3D_EXPORT HRESULT vkd3d_create_image_resource(ID3D12Device *device,
         vkd3d_free(object);
         return hr;
     }
+    object->view_map.max_entries = d3d12_device->view_map_limit;
 
     if (FAILED(hr = vkd3d_private_store_init(&object->private_store)))
     {
@@ -2995,6 +3238,7 @@ static struct vkd3d_view *vkd3d_view_create(enum vkd3d_view_type type)
     {
         view->refcount = 1;
         view->type = type;
+        view->flags = 0;
         view->cookie = vkd3d_allocate_cookie();
     }
     return view;
@@ -3013,6 +3257,9 @@ static void vkd3d_view_destroy(struct vkd3d_view *view, struct d3d12_device *dev
 
     vkd3d_descriptor_debug_unregister_cookie(device->descriptor_qa_global_info, view->cookie);
 
+    if (view->flags & VKD3D_VIEW_FRAMEBUFFER_ATTACHMENT)
+        vkd3d_framebuffer_cache_evict_cookie(&device->framebuffer_cache, device, view->cookie);
+
     switch (view->type)
     {
         case VKD3D_VIEW_TYPE_BUFFER:
@@ -3040,137 +3287,313 @@ void vkd3d_view_decref(struct vkd3d_view *view, struct d3d12_device *device)
         vkd3d_view_destroy(view, device);
 }
 
-static void d3d12_desc_copy_single(struct d3d12_desc *dst, struct d3d12_desc *src,
-        struct d3d12_device *device)
+static struct vkd3d_view *d3d12_desc_get_view(const struct d3d12_desc *descriptor)
+{
+    return (descriptor->metadata.flags & VKD3D_DESCRIPTOR_FLAG_VIEW) ? descriptor->info.view : NULL;
+}
+
+static void d3d12_device_begin_view_update(struct d3d12_device *device, struct d3d12_resource *resource)
+{
+    if (resource && resource->view_map.max_entries)
+        rw_spinlock_acquire_read(&resource->view_map.evict_lock);
+}
+
+static void d3d12_device_end_view_update(struct d3d12_device *device, struct d3d12_resource *resource,
+        struct vkd3d_view *new_view, struct vkd3d_view *old_view)
+{
+    /* Take the new reference before anything can evict the view. */
+    if (new_view)
+        vkd3d_view_incref(new_view);
+
+    if (resource && resource->view_map.max_entries)
+    {
+        rw_spinlock_release_read(&resource->view_map.evict_lock);
+        vkd3d_view_map_evict(&resource->view_map, device);
+    }
+
+    if (old_view)
+        vkd3d_view_decref(old_view, device);
+}
+
+struct vkd3d_view *d3d12_desc_begin_update(struct d3d12_desc *descriptor,
+        struct d3d12_resource *resource, struct d3d12_device *device)
+{
+    if (!device->view_map_limit)
+        return NULL;
+
+    d3d12_device_begin_view_update(device, resource);
+    return d3d12_desc_get_view(descriptor);
+}
+
+void d3d12_desc_end_update(struct d3d12_desc *descriptor, struct vkd3d_view *old_view,
+        struct d3d12_resource *resource, struct d3d12_device *device)
+{
+    if (device->view_map_limit)
+        d3d12_device_end_view_update(device, resource, d3d12_desc_get_view(descriptor), old_view);
+}
+
+struct vkd3d_view *d3d12_rtv_desc_begin_update(struct d3d12_rtv_desc *rtv_desc,
+        struct d3d12_resource *resource, struct d3d12_device *device)
+{
+    if (!device->view_map_limit)
+        return NULL;
+
+    d3d12_device_begin_view_update(device, resource);
+    return rtv_desc->view;
+}
+
+void d3d12_rtv_desc_end_update(struct d3d12_rtv_desc *rtv_desc, struct vkd3d_view *old_view,
+        struct d3d12_resource *resource, struct d3d12_device *device)
+{
+    if (device->view_map_limit)
+        d3d12_device_end_view_update(device, resource, rtv_desc->view, old_view);
+}
+
+static void d3d12_desc_copy_view_references(struct d3d12_desc *dst, const struct d3d12_desc *src,
+        unsigned int count, struct d3d12_device *device)
+{
+    struct vkd3d_view *view;
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((view = d3d12_desc_get_view(&src[i])))
+            vkd3d_view_incref(view);
+        if ((view = d3d12_desc_get_view(&dst[i])))
+            vkd3d_view_decref(view, device);
+    }
+}
+
+static bool d3d12_desc_needs_update(const struct d3d12_desc *dst, const struct d3d12_desc *src)
+{
+    /* Only update the descriptor if something has changed */
+    if (src->metadata.cookie != dst->metadata.cookie)
+        return true;
+
+    /* We don't have a cookie for the UAV counter, so just force update if we have that.
+     * If flags differ, we also need to update. E.g. happens if UAV counter flag is turned off.
+     * We have no cookie for the UAV counter itself.
+     * Lastly, if we have plain VkBuffers, offset/range might differ. */
+    if ((src->metadata.flags & VKD3D_DESCRIPTOR_FLAG_RAW_VA_AUX_BUFFER) != 0 ||
+            (src->metadata.flags != dst->metadata.flags))
+        return true;
+
+    if (src->metadata.flags & VKD3D_DESCRIPTOR_FLAG_OFFSET_RANGE)
+    {
+        return dst->info.buffer.offset != src->info.buffer.offset ||
+                dst->info.buffer.range != src->info.buffer.range;
+    }
+
+    return false;
+}
+
+static unsigned int d3d12_desc_count_unchanged(const struct d3d12_desc *dst, const struct d3d12_desc *src,
+        unsigned int count)
+{
+    const uint32_t deep_compare_flags = VKD3D_DESCRIPTOR_FLAG_RAW_VA_AUX_BUFFER |
+            VKD3D_DESCRIPTOR_FLAG_OFFSET_RANGE | VKD3D_DESCRIPTOR_FLAG_BUFFER_OFFSET;
+    unsigned int i;
+
+    /* Skip over descriptors that are trivially identical, i.e. where cookie, set mask
+     * and flags all match and there is no side data that has to be compared or copied.
+     * Anything else is left to the slower path. */
+    for (i = 0; i < count; i++)
+    {
+#ifdef __SSE2__
+        __m128i src_header = _mm_load_si128((const __m128i *)&src[i].metadata);
+        __m128i dst_header = _mm_load_si128((const __m128i *)&dst[i].metadata);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(src_header, dst_header)) != 0xffff)
+            break;
+#else
+        if (src[i].metadata.cookie != dst[i].metadata.cookie ||
+                src[i].metadata.set_info_mask != dst[i].metadata.set_info_mask ||
+                src[i].metadata.flags != dst[i].metadata.flags)
+            break;
+#endif
+
+        if (src[i].metadata.flags & deep_compare_flags)
+            break;
+    }
+
+    return i;
+}
+
+void vkd3d_descriptor_copy_batch_flush(struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device)
 {
-    VkCopyDescriptorSet vk_copies[VKD3D_MAX_BINDLESS_DESCRIPTOR_SETS];
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    struct vkd3d_descriptor_data metadata = src->metadata;
+
+    if (batch->copy_count)
+    {
+        VK_CALL(vkUpdateDescriptorSets(device->vk_device, 0, NULL, batch->copy_count, batch->copies));
+        batch->copy_count = 0;
+    }
+}
+
+static void vkd3d_descriptor_copy_batch_add(struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device,
+        const struct d3d12_desc *dst, const struct d3d12_desc *src,
+        struct vkd3d_descriptor_binding binding, unsigned int count)
+{
+    VkDescriptorSet src_set = src->heap->vk_descriptor_sets[binding.set];
+    VkDescriptorSet dst_set = dst->heap->vk_descriptor_sets[binding.set];
+    VkCopyDescriptorSet *vk_copy;
+    uint32_t i;
+
+    /* Look for a recent copy that this one extends. Copies are applied in order, so
+     * stop at any copy in between that might touch the same descriptors. */
+    for (i = batch->copy_count; i && batch->copy_count - i < VKD3D_DESCRIPTOR_COPY_BATCH_LOOKBACK; i--)
+    {
+        vk_copy = &batch->copies[i - 1];
+
+        if (vk_copy->srcSet == src_set && vk_copy->dstSet == dst_set &&
+                vk_copy->srcBinding == binding.binding && vk_copy->dstBinding == binding.binding)
+        {
+            /* Within one set, a chain such as [0] -> [1] followed by [1] -> [2] must not become
+             * [0, 2) -> [1, 3), since a single copy must not read descriptors it writes. */
+            if (vk_copy->srcArrayElement + vk_copy->descriptorCount == src->heap_offset &&
+                    vk_copy->dstArrayElement + vk_copy->descriptorCount == dst->heap_offset &&
+                    (src_set != dst_set ||
+                    vk_copy->srcArrayElement >= dst->heap_offset + count ||
+                    vk_copy->dstArrayElement >= src->heap_offset + count))
+            {
+                vk_copy->descriptorCount += count;
+                return;
+            }
+
+            break;
+        }
+
+        if (vk_copy->dstSet == src_set || vk_copy->srcSet == dst_set)
+            break;
+
+        /* Merging past an earlier write to the same descriptors would reorder the writes */
+        if (vk_copy->dstSet == dst_set && vk_copy->dstBinding == binding.binding &&
+                vk_copy->dstArrayElement < dst->heap_offset + count &&
+                vk_copy->dstArrayElement + vk_copy->descriptorCount > dst->heap_offset)
+            break;
+    }
+
+    if (batch->copy_count == ARRAY_SIZE(batch->copies))
+        vkd3d_descriptor_copy_batch_flush(batch, device);
+
+    vk_copy = &batch->copies[batch->copy_count++];
+    vk_copy->sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    vk_copy->pNext = NULL;
+    vk_copy->srcSet = src_set;
+    vk_copy->srcBinding = binding.binding;
+    vk_copy->srcArrayElement = src->heap_offset;
+    vk_copy->dstSet = dst_set;
+    vk_copy->dstBinding = binding.binding;
+    vk_copy->dstArrayElement = dst->heap_offset;
+    vk_copy->descriptorCount = count;
+}
+
+static void d3d12_desc_copy_run(struct d3d12_desc *dst, struct d3d12_desc *src,
+        unsigned int count, struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device)
+{
+    const struct vkd3d_descriptor_data *metadata = &src->metadata;
     struct vkd3d_descriptor_binding binding;
     uint32_t set_mask, set_info_index;
-    const VkDescriptorSet *src_sets;
-    const VkDescriptorSet *dst_sets;
-    VkCopyDescriptorSet *vk_copy;
-    uint32_t copy_count = 0;
-    bool needs_update;
+    unsigned int i;
 
-    /* Only update the descriptor if something has changed */
-    if (!(needs_update = (metadata.cookie != dst->metadata.cookie)))
-    {
-        /* We don't have a cookie for the UAV counter, so just force update if we have that.
-         * If flags differ, we also need to update. E.g. happens if UAV counter flag is turned off.
-         * We have no cookie for the UAV counter itself.
-         * Lastly, if we have plain VkBuffers, offset/range might differ. */
-        if ((metadata.flags & VKD3D_DESCRIPTOR_FLAG_RAW_VA_AUX_BUFFER) != 0 ||
-            (metadata.flags != dst->metadata.flags))
+    /* All descriptors in a run share set mask and flags, and live
+     * in consecutive slots of their heaps, so a single copy per
+     * descriptor set is enough to update the entire run. */
+    set_mask = metadata->set_info_mask;
+
+    for (i = 0; i < count; i++)
+        memcpy(&dst[i], &src[i], D3D12_DESC_PAYLOAD_SIZE);
+
+    while (set_mask)
+    {
+        set_info_index = vkd3d_bitmask_iter32(&set_mask);
+        binding = vkd3d_bindless_state_binding_from_info_index(&device->bindless_state, set_info_index);
+        vkd3d_descriptor_copy_batch_add(batch, device, dst, src, binding, count);
+    }
+
+    if (metadata->flags & VKD3D_DESCRIPTOR_FLAG_RAW_VA_AUX_BUFFER)
+    {
+        if (dst->heap->raw_va_aux_buffer.host_ptr)
         {
-            needs_update = true;
+            const VkDeviceAddress *src_vas = src->heap->raw_va_aux_buffer.host_ptr;
+            VkDeviceAddress *dst_vas = dst->heap->raw_va_aux_buffer.host_ptr;
+            memcpy(dst_vas + dst->heap_offset, src_vas + src->heap_offset, sizeof(*dst_vas) * count);
         }
-        else if (metadata.flags & VKD3D_DESCRIPTOR_FLAG_OFFSET_RANGE)
+        else
         {
-            needs_update =
-                    dst->info.buffer.offset != src->info.buffer.offset ||
-                    dst->info.buffer.range != src->info.buffer.range;
+            binding = vkd3d_bindless_state_find_set(
+                    &device->bindless_state, VKD3D_BINDLESS_SET_UAV | VKD3D_BINDLESS_SET_AUX_BUFFER);
+            vkd3d_descriptor_copy_batch_add(batch, device, dst, src, binding, count);
         }
     }
+}
+
+static void d3d12_desc_copy_buffer_ranges(struct d3d12_desc *dst, struct d3d12_desc *src, unsigned int count)
+{
+    const struct vkd3d_bound_buffer_range *src_buffer_ranges = src->heap->buffer_ranges.host_ptr;
+    struct vkd3d_bound_buffer_range *dst_buffer_ranges = dst->heap->buffer_ranges.host_ptr;
+    memcpy(dst_buffer_ranges + dst->heap_offset, src_buffer_ranges + src->heap_offset,
+            sizeof(*dst_buffer_ranges) * count);
+}
+
+static void d3d12_desc_copy_separate(struct d3d12_desc *dst, struct d3d12_desc *src,
+        unsigned int count, struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device)
+{
+    unsigned int i, run_count;
 
-    if (needs_update)
+    i = 0;
+
+    while (i < count)
     {
-        src_sets = src->heap->vk_descriptor_sets;
-        dst_sets = dst->heap->vk_descriptor_sets;
-        dst->metadata = metadata;
-        dst->info = src->info;
-        set_mask = metadata.set_info_mask;
+        if ((i += d3d12_desc_count_unchanged(dst + i, src + i, count - i)) >= count)
+            break;
 
-        while (set_mask)
+        if (!d3d12_desc_needs_update(&dst[i], &src[i]))
         {
-            set_info_index = vkd3d_bitmask_iter32(&set_mask);
-            binding = vkd3d_bindless_state_binding_from_info_index(&device->bindless_state, set_info_index);
-
-            vk_copy = &vk_copies[copy_count++];
-            vk_copy->sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
-            vk_copy->pNext = NULL;
-            vk_copy->srcSet = src_sets[binding.set];
-            vk_copy->srcBinding = binding.binding;
-            vk_copy->srcArrayElement = src->heap_offset;
-            vk_copy->dstSet = dst_sets[binding.set];
-            vk_copy->dstBinding = binding.binding;
-            vk_copy->dstArrayElement = dst->heap_offset;
-            vk_copy->descriptorCount = 1;
+            if (src[i].metadata.flags & VKD3D_DESCRIPTOR_FLAG_BUFFER_OFFSET)
+                d3d12_desc_copy_buffer_ranges(dst + i, src + i, 1);
+            i++;
+            continue;
         }
 
-        if (metadata.flags & VKD3D_DESCRIPTOR_FLAG_RAW_VA_AUX_BUFFER)
+        /* Gather a run of changed descriptors of the same kind */
+        for (run_count = 1; i + run_count < count; run_count++)
         {
-            if (dst->heap->raw_va_aux_buffer.host_ptr)
-            {
-                const VkDeviceAddress *src_vas = src->heap->raw_va_aux_buffer.host_ptr;
-                VkDeviceAddress *dst_vas = dst->heap->raw_va_aux_buffer.host_ptr;
-                dst_vas[dst->heap_offset] = src_vas[src->heap_offset];
-            }
-            else
-            {
-                binding = vkd3d_bindless_state_find_set(
-                        &device->bindless_state, VKD3D_BINDLESS_SET_UAV | VKD3D_BINDLESS_SET_AUX_BUFFER);
-
-                vk_copy = &vk_copies[copy_count++];
-                vk_copy->sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
-                vk_copy->pNext = NULL;
-                vk_copy->srcSet = src->heap->vk_descriptor_sets[binding.set];
-                vk_copy->srcBinding = binding.binding;
-                vk_copy->srcArrayElement = src->heap_offset;
-                vk_copy->dstSet = dst->heap->vk_descriptor_sets[binding.set];
-                vk_copy->dstBinding = binding.binding;
-                vk_copy->dstArrayElement = dst->heap_offset;
-                vk_copy->descriptorCount = 1;
-            }
+            if (src[i + run_count].metadata.set_info_mask != src[i].metadata.set_info_mask ||
+                    src[i + run_count].metadata.flags != src[i].metadata.flags ||
+                    !d3d12_desc_needs_update(&dst[i + run_count], &src[i + run_count]))
+                break;
         }
 
-        if (copy_count)
-            VK_CALL(vkUpdateDescriptorSets(device->vk_device, 0, NULL, copy_count, vk_copies));
-    }
+        d3d12_desc_copy_run(dst + i, src + i, run_count, batch, device);
 
-    if (metadata.flags & VKD3D_DESCRIPTOR_FLAG_BUFFER_OFFSET)
-    {
-        const struct vkd3d_bound_buffer_range *src_buffer_ranges = src->heap->buffer_ranges.host_ptr;
-        struct vkd3d_bound_buffer_range *dst_buffer_ranges = dst->heap->buffer_ranges.host_ptr;
-        dst_buffer_ranges[dst->heap_offset] = src_buffer_ranges[src->heap_offset];
+        if (src[i].metadata.flags & VKD3D_DESCRIPTOR_FLAG_BUFFER_OFFSET)
+            d3d12_desc_copy_buffer_ranges(dst + i, src + i, run_count);
+
+        i += run_count;
     }
 }
 
-void d3d12_desc_copy_range(struct d3d12_desc *dst, struct d3d12_desc *src,
-        unsigned int count, D3D12_DESCRIPTOR_HEAP_TYPE heap_type, struct d3d12_device *device)
+static void d3d12_desc_copy_range(struct d3d12_desc *dst, struct d3d12_desc *src,
+        unsigned int count, D3D12_DESCRIPTOR_HEAP_TYPE heap_type,
+        struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device)
 {
-    VkCopyDescriptorSet vk_copies[VKD3D_MAX_BINDLESS_DESCRIPTOR_SETS];
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     struct vkd3d_descriptor_binding binding;
-    VkCopyDescriptorSet *vk_copy;
     uint32_t set_info_mask = 0;
-    uint32_t copy_count = 0;
     uint32_t set_info_index;
     unsigned int i;
 
     for (i = 0; i < count; i++)
     {
         set_info_mask |= src[i].metadata.set_info_mask;
-        dst[i].metadata = src[i].metadata;
-        dst[i].info = src[i].info;
+        memcpy(&dst[i], &src[i], D3D12_DESC_PAYLOAD_SIZE);
     }
 
     while (set_info_mask)
     {
         set_info_index = vkd3d_bitmask_iter32(&set_info_mask);
         binding = vkd3d_bindless_state_binding_from_info_index(&device->bindless_state, set_info_index);
-
-        vk_copy = &vk_copies[copy_count++];
-        vk_copy->sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
-        vk_copy->pNext = NULL;
-        vk_copy->srcSet = src->heap->vk_descriptor_sets[binding.set];
-        vk_copy->srcBinding = binding.binding;
-        vk_copy->srcArrayElement = src->heap_offset;
-        vk_copy->dstSet = dst->heap->vk_descriptor_sets[binding.set];
-        vk_copy->dstBinding = binding.binding;
-        vk_copy->dstArrayElement = dst->heap_offset;
-        vk_copy->descriptorCount = count;
+        vkd3d_descriptor_copy_batch_add(batch, device, dst, src, binding, count);
     }
 
     if (heap_type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
@@ -3184,17 +3607,7 @@ void d3d12_desc_copy_range(struct d3d12_desc *dst, struct d3d12_desc *src,
         else
         {
             binding = vkd3d_bindless_state_find_set(&device->bindless_state, VKD3D_BINDLESS_SET_UAV | VKD3D_BINDLESS_SET_AUX_BUFFER);
-
-            vk_copy = &vk_copies[copy_count++];
-            vk_copy->sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
-            vk_copy->pNext = NULL;
-            vk_copy->srcSet = src->heap->vk_descriptor_sets[binding.set];
-            vk_copy->srcBinding = binding.binding;
-            vk_copy->srcArrayElement = src->heap_offset;
-            vk_copy->dstSet = dst->heap->vk_descriptor_sets[binding.set];
-            vk_copy->dstBinding = binding.binding;
-            vk_copy->dstArrayElement = dst->heap_offset;
-            vk_copy->descriptorCount = count;
+            vkd3d_descriptor_copy_batch_add(batch, device, dst, src, binding, count);
         }
 
         if (device->bindless_state.flags & (VKD3D_TYPED_OFFSET_BUFFER | VKD3D_SSBO_OFFSET_BUFFER))
@@ -3204,17 +3617,14 @@ void d3d12_desc_copy_range(struct d3d12_desc *dst, struct d3d12_desc *src,
             memcpy(dst_ranges + dst->heap_offset, src_ranges + src->heap_offset, sizeof(*dst_ranges) * count);
         }
     }
-
-    if (copy_count)
-        VK_CALL(vkUpdateDescriptorSets(device->vk_device, 0, NULL, copy_count, vk_copies));
 }
 
-void d3d12_desc_copy(struct d3d12_desc *dst, struct d3d12_desc *src,
-        unsigned int count, D3D12_DESCRIPTOR_HEAP_TYPE heap_type, struct d3d12_device *device)
+void d3d12_desc_copy(struct d3d12_desc *dst, struct d3d12_desc *src, unsigned int count,
+        D3D12_DESCRIPTOR_HEAP_TYPE heap_type, struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device)
 {
+#ifdef VKD3D_ENABLE_DESCRIPTOR_QA
     unsigned int i;
 
-#ifdef VKD3D_ENABLE_DESCRIPTOR_QA
     for (i = 0; i < count; i++)
     {
         vkd3d_descriptor_debug_copy_descriptor(
@@ -3224,13 +3634,13 @@ void d3d12_desc_copy(struct d3d12_desc *dst, struct d3d12_desc *src,
     }
 #endif
 
+    if (device->view_map_limit)
+        d3d12_desc_copy_view_references(dst, src, count, device);
+
     if (device->bindless_state.flags & VKD3D_BINDLESS_MUTABLE_TYPE)
-        d3d12_desc_copy_range(dst, src, count, heap_type, device);
+        d3d12_desc_copy_range(dst, src, count, heap_type, batch, device);
     else
-    {
-        for (i = 0; i < count; i++)
-            d3d12_desc_copy_single(dst + i, src + i, device);
-    }
+        d3d12_desc_copy_separate(dst, src, count, batch, device);
 }
 
 bool vkd3d_create_raw_r32ui_vk_buffer_view(struct d3d12_device *device,
@@ -4387,10 +4797,23 @@ static void vkd3d_create_buffer_uav(struct d3d12_desc *descriptor, struct d3d12_
         }
         else
         {
+            bool bounded = !!counter_resource->view_map.max_entries;
             struct vkd3d_view *view;
+            bool ret;
+
+            /* The counter view is not referenced by the descriptor, pin it instead. */
+            if (bounded)
+                rw_spinlock_acquire_read(&counter_resource->view_map.evict_lock);
 
-            if (!vkd3d_create_buffer_view_for_resource(device, counter_resource, DXGI_FORMAT_R32_UINT,
-                    desc->Buffer.CounterOffsetInBytes / sizeof(uint32_t), 1, 0, 0, &view))
+            ret = vkd3d_create_buffer_view_for_resource(device, counter_resource, DXGI_FORMAT_R32_UINT,
+                    desc->Buffer.CounterOffsetInBytes / sizeof(uint32_t), 1, 0, 0, &view);
+
+            if (ret && bounded)
+                vkd3d_atomic_uint32_or(&view->flags, VKD3D_VIEW_NO_EVICT, vkd3d_memory_order_relaxed);
+            if (bounded)
+                rw_spinlock_release_read(&counter_resource->view_map.evict_lock);
+
+            if (!ret)
                 return;
 
             uav_counter_view = view->vk_buffer_view;
@@ -4833,8 +5256,22 @@ void d3d12_desc_create_sampler(struct d3d12_desc *sampler,
 }
 
 /* RTVs */
-void d3d12_rtv_desc_copy(struct d3d12_rtv_desc *dst, struct d3d12_rtv_desc *src, unsigned int count)
+void d3d12_rtv_desc_copy(struct d3d12_rtv_desc *dst, struct d3d12_rtv_desc *src, unsigned int count,
+        struct d3d12_device *device)
 {
+    unsigned int i;
+
+    if (device->view_map_limit)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (src[i].view)
+                vkd3d_view_incref(src[i].view);
+            if (dst[i].view)
+                vkd3d_view_decref(dst[i].view, device);
+        }
+    }
+
     memcpy(dst, src, sizeof(*dst) * count);
 }
 
@@ -5059,6 +5496,43 @@ static ULONG STDMETHODCALLTYPE d3d12_descriptor_heap_AddRef(ID3D12DescriptorHeap
     return refcount;
 }
 
+static void d3d12_descriptor_heap_release_views(struct d3d12_descriptor_heap *heap)
+{
+    struct d3d12_rtv_desc *rtv_desc;
+    struct d3d12_device *device;
+    struct vkd3d_view *view;
+    struct d3d12_desc *desc;
+    unsigned int i;
+
+    device = heap->device;
+
+    switch (heap->desc.Type)
+    {
+        case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV:
+        case D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER:
+            desc = (struct d3d12_desc *)heap->descriptors;
+            for (i = 0; i < heap->desc.NumDescriptors; i++)
+            {
+                if ((view = d3d12_desc_get_view(&desc[i])))
+                    vkd3d_view_decref(view, device);
+            }
+            break;
+
+        case D3D12_DESCRIPTOR_HEAP_TYPE_RTV:
+        case D3D12_DESCRIPTOR_HEAP_TYPE_DSV:
+            rtv_desc = (struct d3d12_rtv_desc *)heap->descriptors;
+            for (i = 0; i < heap->desc.NumDescriptors; i++)
+            {
+                if (rtv_desc[i].view)
+                    vkd3d_view_decref(rtv_desc[i].view, device);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
 static ULONG STDMETHODCALLTYPE d3d12_descriptor_heap_Release(ID3D12DescriptorHeap *iface)
 {
     struct d3d12_descriptor_heap *heap = impl_from_ID3D12DescriptorHeap(iface);
@@ -5070,6 +5544,8 @@ static ULONG STDMETHODCALLTYPE d3d12_descriptor_heap_Release(ID3D12DescriptorHea
     {
         struct d3d12_device *device = heap->device;
 
+        if (device->view_map_limit)
+            d3d12_descriptor_heap_release_views(heap);
         d3d12_descriptor_heap_cleanup(heap);
         vkd3d_private_store_destroy(&heap->private_store);
         vkd3d_free_aligned(heap);
@@ -75,16 +75,47 @@ static void d3d12_root_signature_cleanup(struct d3d12_root_signature *root_signa
     vkd3d_free(root_signature->root_constants);
     vkd3d_free(root_signature->static_samplers);
     vkd3d_free(root_signature->static_samplers_desc);
+    vkd3d_free(root_signature->bytecode);
 }
 
+static void vkd3d_root_signature_cache_remove(struct vkd3d_root_signature_cache *cache,
+        struct d3d12_root_signature *root_signature);
+
 static ULONG STDMETHODCALLTYPE d3d12_root_signature_Release(ID3D12RootSignature *iface)
 {
     struct d3d12_root_signature *root_signature = impl_from_ID3D12RootSignature(iface);
-    ULONG refcount = InterlockedDecrement(&root_signature->refcount);
+    struct vkd3d_root_signature_cache *cache = &root_signature->device->root_signature_cache;
+    uint32_t cur_refcount, cas_refcount;
+    bool is_locked = false;
 
-    TRACE("%p decreasing refcount to %u.\n", root_signature, refcount);
+    cur_refcount = 0;
+    cas_refcount = vkd3d_atomic_uint32_load_explicit((uint32_t *)&root_signature->refcount, vkd3d_memory_order_relaxed);
 
-    if (!refcount)
+    /* Lookups in the root signature cache must not resurrect a dying object,
+     * so lock the cache before decrementing the ref count to zero. */
+    while (cas_refcount != cur_refcount)
+    {
+        cur_refcount = cas_refcount;
+
+        if (cur_refcount == 1 && !is_locked && root_signature->bytecode)
+        {
+            rw_spinlock_acquire_write(&cache->spinlock);
+            is_locked = true;
+        }
+
+        cas_refcount = vkd3d_atomic_uint32_compare_exchange((uint32_t *)&root_signature->refcount, cur_refcount,
+                cur_refcount - 1, vkd3d_memory_order_acq_rel, vkd3d_memory_order_relaxed);
+    }
+
+    if (cur_refcount == 1 && is_locked)
+        vkd3d_root_signature_cache_remove(cache, root_signature);
+
+    if (is_locked)
+        rw_spinlock_release_write(&cache->spinlock);
+
+    TRACE("%p decreasing refcount to %u.\n", root_signature, cur_refcount - 1);
+
+    if (cur_refcount == 1)
     {
         struct d3d12_device *device = root_signature->device;
         vkd3d_private_store_destroy(&root_signature->private_store);
@@ -93,7 +124,7 @@ static ULONG STDMETHODCALLTYPE d3d12_root_signature_Release(ID3D12RootSignature
         d3d12_device_release(device);
     }
 
-    return refcount;
+    return cur_refcount - 1;
 }
 
 static HRESULT STDMETHODCALLTYPE d3d12_root_signature_GetPrivateData(ID3D12RootSignature *iface,
@@ -1446,6 +1477,116 @@ fail:
     return hr;
 }
 
+struct vkd3d_root_signature_cache_key
+{
+    uint64_t bytecode_hash;
+    const void *bytecode;
+    size_t bytecode_length;
+};
+
+struct vkd3d_root_signature_cache_entry
+{
+    struct hash_map_entry entry;
+    struct d3d12_root_signature *root_signature;
+};
+
+static uint32_t vkd3d_root_signature_cache_hash(const void *key)
+{
+    const struct vkd3d_root_signature_cache_key *k = key;
+
+    return hash_uint64(k->bytecode_hash);
+}
+
+static bool vkd3d_root_signature_cache_compare(const void *key, const struct hash_map_entry *entry)
+{
+    const struct vkd3d_root_signature_cache_entry *e = (const struct vkd3d_root_signature_cache_entry *)entry;
+    const struct vkd3d_root_signature_cache_key *k = key;
+
+    return k->bytecode_hash == e->root_signature->bytecode_hash &&
+            k->bytecode_length == e->root_signature->bytecode_length &&
+            !memcmp(k->bytecode, e->root_signature->bytecode, k->bytecode_length);
+}
+
+void vkd3d_root_signature_cache_init(struct vkd3d_root_signature_cache *cache)
+{
+    spinlock_init(&cache->spinlock);
+    hash_map_init(&cache->map, vkd3d_root_signature_cache_hash,
+            vkd3d_root_signature_cache_compare, sizeof(struct vkd3d_root_signature_cache_entry));
+}
+
+void vkd3d_root_signature_cache_cleanup(struct vkd3d_root_signature_cache *cache)
+{
+    /* Every root signature holds a device reference, so the cache is empty by now. */
+    if (cache->map.used_count)
+        ERR("Leaking %u root signatures.\n", cache->map.used_count);
+
+    hash_map_clear(&cache->map);
+}
+
+static struct d3d12_root_signature *vkd3d_root_signature_cache_lookup(struct vkd3d_root_signature_cache *cache,
+        const struct vkd3d_root_signature_cache_key *key)
+{
+    const struct vkd3d_root_signature_cache_entry *e;
+    struct d3d12_root_signature *root_signature;
+
+    rw_spinlock_acquire_read(&cache->spinlock);
+
+    /* Root signatures only drop their last reference with the cache locked for writing,
+     * so anything we find here is alive. */
+    if ((e = (const struct vkd3d_root_signature_cache_entry *)hash_map_find(&cache->map, key)))
+    {
+        root_signature = e->root_signature;
+        d3d12_root_signature_AddRef(&root_signature->ID3D12RootSignature_iface);
+    }
+    else
+        root_signature = NULL;
+
+    rw_spinlock_release_read(&cache->spinlock);
+    return root_signature;
+}
+
+static struct d3d12_root_signature *vkd3d_root_signature_cache_insert(struct vkd3d_root_signature_cache *cache,
+        const struct vkd3d_root_signature_cache_key *key, struct d3d12_root_signature *root_signature)
+{
+    struct vkd3d_root_signature_cache_entry entry, *e;
+    struct d3d12_root_signature *existing;
+
+    entry.root_signature = root_signature;
+
+    rw_spinlock_acquire_write(&cache->spinlock);
+
+    if (!(e = (struct vkd3d_root_signature_cache_entry *)hash_map_insert(&cache->map, key, &entry.entry)))
+    {
+        /* Not fatal, the root signature just cannot be shared. */
+        ERR("Failed to insert root signature into cache.\n");
+        existing = root_signature;
+    }
+    else if ((existing = e->root_signature) != root_signature)
+    {
+        /* Another thread created the same root signature in the meantime. */
+        d3d12_root_signature_AddRef(&existing->ID3D12RootSignature_iface);
+    }
+
+    rw_spinlock_release_write(&cache->spinlock);
+    return existing;
+}
+
+static void vkd3d_root_signature_cache_remove(struct vkd3d_root_signature_cache *cache,
+        struct d3d12_root_signature *root_signature)
+{
+    struct vkd3d_root_signature_cache_key key;
+    struct vkd3d_root_signature_cache_entry *e;
+
+    key.bytecode_hash = root_signature->bytecode_hash;
+    key.bytecode = root_signature->bytecode;
+    key.bytecode_length = root_signature->bytecode_length;
+
+    /* Redundant objects that lost the insert race are not in the map. */
+    if ((e = (struct vkd3d_root_signature_cache_entry *)hash_map_find(&cache->map, &key)) &&
+            e->root_signature == root_signature)
+        hash_map_remove(&cache->map, &e->entry);
+}
+
 HRESULT d3d12_root_signature_create(struct d3d12_device *device,
         const void *bytecode, size_t bytecode_length, struct d3d12_root_signature **root_signature)
 {
@@ -1455,9 +1596,31 @@ HRESULT d3d12_root_signature_create(struct d3d12_device *device,
         D3D12_VERSIONED_ROOT_SIGNATURE_DESC d3d12;
         struct vkd3d_versioned_root_signature_desc vkd3d;
     } root_signature_desc;
-    struct d3d12_root_signature *object;
+    struct vkd3d_root_signature_cache_key key;
+    struct d3d12_root_signature *object, *existing;
     HRESULT hr;
     int ret;
+    VKD3D_REGION_DECL(root_signature_cache_hit);
+    VKD3D_REGION_DECL(root_signature_create);
+
+    VKD3D_REGION_BEGIN(root_signature_cache_hit);
+
+    /* Applications tend to create the same root signature over and over again,
+     * e.g. once per pipeline. Hand out the existing object instead of parsing
+     * the blob and creating new Vulkan layouts every time. */
+    key.bytecode_hash = vkd3d_shader_hash(&dxbc);
+    key.bytecode = bytecode;
+    key.bytecode_length = bytecode_length;
+
+    if ((object = vkd3d_root_signature_cache_lookup(&device->root_signature_cache, &key)))
+    {
+        TRACE("Reusing root signature %p.\n", object);
+        *root_signature = object;
+        VKD3D_REGION_END(root_signature_cache_hit);
+        return S_OK;
+    }
+
+    VKD3D_REGION_BEGIN(root_signature_create);
 
     if ((ret = vkd3d_parse_root_signature_v_1_1(&dxbc, &root_signature_desc.vkd3d)) < 0)
     {
@@ -1481,8 +1644,23 @@ HRESULT d3d12_root_signature_create(struct d3d12_device *device,
 
     TRACE("Created root signature %p.\n", object);
 
+    /* If we fail to keep a copy of the blob, the root signature is simply not shared. */
+    if ((object->bytecode = vkd3d_malloc(bytecode_length)))
+    {
+        memcpy(object->bytecode, bytecode, bytecode_length);
+        object->bytecode_hash = key.bytecode_hash;
+        object->bytecode_length = bytecode_length;
+
+        if ((existing = vkd3d_root_signature_cache_insert(&device->root_signature_cache, &key, object)) != object)
+        {
+            d3d12_root_signature_Release(&object->ID3D12RootSignature_iface);
+            object = existing;
+        }
+    }
+
     *root_signature = object;
 
+    VKD3D_REGION_END(root_signature_create);
     return S_OK;
 }
 
@@ -1517,6 +1695,39 @@ struct vkd3d_render_pass_entry
 /* Ensure that key is packed, and can be memcmp'd. */
 STATIC_ASSERT(sizeof(struct vkd3d_render_pass_key) == 52);
 
+#define VKD3D_RENDER_PASS_TABLE_INITIAL_SIZE 64u
+
+static uint32_t vkd3d_render_pass_key_hash(const struct vkd3d_render_pass_key *key)
+{
+    uint64_t hash = hash_fnv1_init();
+    unsigned int i;
+
+    hash = hash_fnv1_iterate_u32(hash, key->attachment_count);
+    hash = hash_fnv1_iterate_u32(hash, key->rtv_active_mask);
+    hash = hash_fnv1_iterate_u32(hash, key->flags);
+    hash = hash_fnv1_iterate_u32(hash, key->sample_count);
+    for (i = 0; i < ARRAY_SIZE(key->vk_formats); i++)
+        hash = hash_fnv1_iterate_u32(hash, key->vk_formats[i]);
+
+    return hash_uint64(hash);
+}
+
+static bool vkd3d_render_pass_entry_compare(const void *key, const void *entry)
+{
+    const struct vkd3d_render_pass_entry *render_pass = entry;
+    return !memcmp(&render_pass->key, key, sizeof(render_pass->key));
+}
+
+static void vkd3d_render_pass_entry_destroy(void *entry, void *userdata)
+{
+    struct vkd3d_render_pass_entry *render_pass = entry;
+    struct d3d12_device *device = userdata;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    VK_CALL(vkDestroyRenderPass(device->vk_device, render_pass->vk_render_pass, NULL));
+    vkd3d_free(render_pass);
+}
+
 static VkImageLayout vkd3d_render_pass_get_depth_stencil_layout(const struct vkd3d_render_pass_key *key)
 {
     if (!(key->flags & VKD3D_RENDER_PASS_KEY_DEPTH_STENCIL_ENABLE))
@@ -1533,7 +1744,8 @@ static VkImageLayout vkd3d_render_pass_get_depth_stencil_layout(const struct vkd
 }
 
 static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pass_cache *cache,
-        struct d3d12_device *device, const struct vkd3d_render_pass_key *key, VkRenderPass *vk_render_pass)
+        struct d3d12_device *device, const struct vkd3d_render_pass_key *key, uint32_t key_hash,
+        VkRenderPass *vk_render_pass)
 {
     VkAttachmentReference2KHR attachment_references[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 2];
     VkAttachmentDescription2KHR attachments[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 2];
@@ -1549,15 +1761,12 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
     unsigned int rt_count;
     VkResult vr;
 
-    if (!vkd3d_array_reserve((void **)&cache->render_passes, &cache->render_passes_size,
-            cache->render_pass_count + 1, sizeof(*cache->render_passes)))
+    if (!(entry = vkd3d_malloc(sizeof(*entry))))
     {
         *vk_render_pass = VK_NULL_HANDLE;
         return E_OUTOFMEMORY;
     }
 
-    entry = &cache->render_passes[cache->render_pass_count];
-
     entry->key = *key;
 
     have_depth_stencil = !!(key->flags & VKD3D_RENDER_PASS_KEY_DEPTH_STENCIL_ENABLE);
@@ -1723,88 +1932,69 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
     pass_info.correlatedViewMaskCount = 0;
     pass_info.pCorrelatedViewMasks = NULL;
 
-    if ((vr = VK_CALL(vkCreateRenderPass2KHR(device->vk_device, &pass_info, NULL, vk_render_pass))) >= 0)
+    if ((vr = VK_CALL(vkCreateRenderPass2KHR(device->vk_device, &pass_info, NULL, vk_render_pass))) < 0)
     {
-        entry->vk_render_pass = *vk_render_pass;
-        ++cache->render_pass_count;
+        WARN("Failed to create Vulkan render pass, vr %d.\n", vr);
+        vkd3d_free(entry);
+        *vk_render_pass = VK_NULL_HANDLE;
+        return hresult_from_vk_result(vr);
     }
-    else
+
+    entry->vk_render_pass = *vk_render_pass;
+
+    if (!vkd3d_lockfree_table_insert_locked(&cache->table, entry, key_hash))
     {
-        WARN("Failed to create Vulkan render pass, vr %d.\n", vr);
+        VK_CALL(vkDestroyRenderPass(device->vk_device, *vk_render_pass, NULL));
+        vkd3d_free(entry);
         *vk_render_pass = VK_NULL_HANDLE;
+        return E_OUTOFMEMORY;
     }
 
-    return hresult_from_vk_result(vr);
+    return S_OK;
 }
 
 HRESULT vkd3d_render_pass_cache_find(struct vkd3d_render_pass_cache *cache,
         struct d3d12_device *device, const struct vkd3d_render_pass_key *key, VkRenderPass *vk_render_pass)
 {
-    size_t searched_count;
-    bool found = false;
-    HRESULT hr = S_OK;
-    size_t i;
+    struct vkd3d_render_pass_entry *entry;
+    uint32_t key_hash;
+    HRESULT hr;
 
-    rw_spinlock_acquire_read(&cache->lock);
-    for (i = 0; i < cache->render_pass_count; ++i)
-    {
-        struct vkd3d_render_pass_entry *current = &cache->render_passes[i];
+    key_hash = vkd3d_render_pass_key_hash(key);
 
-        if (!memcmp(&current->key, key, sizeof(*key)))
-        {
-            *vk_render_pass = current->vk_render_pass;
-            found = true;
-            break;
-        }
+    if ((entry = vkd3d_lockfree_table_find(&cache->table, key, key_hash, vkd3d_render_pass_entry_compare)))
+    {
+        *vk_render_pass = entry->vk_render_pass;
+        return S_OK;
     }
-    searched_count = cache->render_pass_count;
-    rw_spinlock_release_read(&cache->lock);
 
-    if (!found)
-    {
-        rw_spinlock_acquire_write(&cache->lock);
-        /* If another thread came in and wrote the render pass we want in between the read unlock and write lock,
-         * find it now. */
-        for (i = searched_count; i < cache->render_pass_count; ++i)
-        {
-            struct vkd3d_render_pass_entry *current = &cache->render_passes[i];
+    /* Only writers serialize against each other. */
+    spinlock_acquire(&cache->lock);
 
-            if (!memcmp(&current->key, key, sizeof(*key)))
-            {
-                *vk_render_pass = current->vk_render_pass;
-                rw_spinlock_release_write(&cache->lock);
-                return S_OK;
-            }
-        }
-        hr = vkd3d_render_pass_cache_create_pass_locked(cache, device, key, vk_render_pass);
-        rw_spinlock_release_write(&cache->lock);
+    /* If another thread came in and wrote the render pass we want in between the lookup and the lock,
+     * find it now. */
+    if ((entry = vkd3d_lockfree_table_find(&cache->table, key, key_hash, vkd3d_render_pass_entry_compare)))
+    {
+        *vk_render_pass = entry->vk_render_pass;
+        hr = S_OK;
     }
+    else
+        hr = vkd3d_render_pass_cache_create_pass_locked(cache, device, key, key_hash, vk_render_pass);
 
+    spinlock_release(&cache->lock);
     return hr;
 }
 
 void vkd3d_render_pass_cache_init(struct vkd3d_render_pass_cache *cache)
 {
-    cache->render_passes = NULL;
-    cache->render_pass_count = 0;
-    cache->render_passes_size = 0;
-    cache->lock = 0;
+    vkd3d_lockfree_table_init(&cache->table, VKD3D_RENDER_PASS_TABLE_INITIAL_SIZE);
+    spinlock_init(&cache->lock);
 }
 
 void vkd3d_render_pass_cache_cleanup(struct vkd3d_render_pass_cache *cache,
         struct d3d12_device *device)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    unsigned int i;
-
-    for (i = 0; i < cache->render_pass_count; ++i)
-    {
-        struct vkd3d_render_pass_entry *current = &cache->render_passes[i];
-        VK_CALL(vkDestroyRenderPass(device->vk_device, current->vk_render_pass, NULL));
-    }
-
-    vkd3d_free(cache->render_passes);
-    cache->render_passes = NULL;
+    vkd3d_lockfree_table_cleanup(&cache->table, vkd3d_render_pass_entry_destroy, device);
 }
 
 static void d3d12_promote_depth_stencil_desc(D3D12_DEPTH_STENCIL_DESC1 *out, const D3D12_DEPTH_STENCIL_DESC *in)
@@ -2004,15 +2194,391 @@ HRESULT vkd3d_pipeline_state_desc_from_d3d12_stream_desc(struct d3d12_pipeline_s
 #undef VKD3D_HANDLE_SUBOBJECT
 #undef VKD3D_HANDLE_SUBOBJECT_EXPLICIT
 
+enum vkd3d_compiled_pipeline_status
+{
+    VKD3D_COMPILED_PIPELINE_PENDING = 0,
+    VKD3D_COMPILED_PIPELINE_READY,
+    VKD3D_COMPILED_PIPELINE_FAILED,
+};
+
+/* Entries are published as pending and filled in by the pipeline variant worker.
+ * vk_pipeline, render_pass_compat and dynamic_state_flags may only be read
+ * once status has been observed to be ready. */
 struct vkd3d_compiled_pipeline
 {
-    struct list entry;
     struct vkd3d_pipeline_key key;
+    uint32_t status; /* vkd3d_compiled_pipeline_status */
+    bool speculative;
+    uint32_t used;
     VkPipeline vk_pipeline;
     struct vkd3d_render_pass_compatibility render_pass_compat;
     uint32_t dynamic_state_flags;
 };
 
+#define VKD3D_COMPILED_PIPELINE_TABLE_INITIAL_SIZE 16u
+
+/* Lets the hash read whole words, a variable-size memcpy does not get inlined. */
+STATIC_ASSERT(!(sizeof(struct vkd3d_pipeline_key) % sizeof(uint32_t)));
+
+static uint32_t vkd3d_pipeline_key_hash(const struct vkd3d_pipeline_key *key)
+{
+    /* Keys are always zero-initialized, so padding is well-defined. */
+    const uint8_t *data = (const uint8_t *)key;
+    uint32_t hash = 0, word;
+    size_t i;
+
+    for (i = 0; i < sizeof(*key); i += sizeof(word))
+    {
+        memcpy(&word, data + i, sizeof(word));
+        hash = hash_combine(hash, word);
+    }
+
+    return hash;
+}
+
+static bool vkd3d_compiled_pipeline_compare(const void *key, const void *entry)
+{
+    const struct vkd3d_compiled_pipeline *compiled_pipeline = entry;
+    return !memcmp(&compiled_pipeline->key, key, sizeof(compiled_pipeline->key));
+}
+
+static void vkd3d_compiled_pipeline_destroy(void *entry, void *userdata)
+{
+    struct vkd3d_compiled_pipeline *compiled_pipeline = entry;
+    struct d3d12_device *device = userdata;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    VK_CALL(vkDestroyPipeline(device->vk_device, compiled_pipeline->vk_pipeline, NULL));
+    vkd3d_free(compiled_pipeline);
+}
+
+static void d3d12_pipeline_state_compile_variant(struct d3d12_pipeline_state *state,
+        struct vkd3d_compiled_pipeline *pipeline, const struct vkd3d_format *dsv_format)
+{
+    VkPipeline vk_pipeline;
+    VKD3D_REGION_DECL(pipeline_variant_compile);
+
+    VKD3D_REGION_BEGIN(pipeline_variant_compile);
+
+    vk_pipeline = d3d12_pipeline_state_create_pipeline_variant(state,
+            &pipeline->key, dsv_format, VK_NULL_HANDLE, &pipeline->render_pass_compat,
+            &pipeline->dynamic_state_flags, pipeline->key.variant_flags);
+
+    if (!vk_pipeline)
+        ERR("Failed to create pipeline variant for %p.\n", state);
+
+    pipeline->vk_pipeline = vk_pipeline;
+    vkd3d_atomic_uint32_store_explicit(&pipeline->status,
+            vk_pipeline ? VKD3D_COMPILED_PIPELINE_READY : VKD3D_COMPILED_PIPELINE_FAILED,
+            vkd3d_memory_order_release);
+
+    VKD3D_REGION_END(pipeline_variant_compile);
+}
+
+static bool vkd3d_pipeline_variant_job_queue_push(struct vkd3d_pipeline_variant_job_queue *queue,
+        const struct vkd3d_pipeline_variant_job *job)
+{
+    /* Reclaim consumed slots before growing the array. */
+    if (queue->head && queue->count == queue->jobs_size)
+    {
+        memmove(queue->jobs, &queue->jobs[queue->head], (queue->count - queue->head) * sizeof(*queue->jobs));
+        queue->count -= queue->head;
+        queue->head = 0;
+    }
+
+    if (!vkd3d_array_reserve((void **)&queue->jobs, &queue->jobs_size,
+            queue->count + 1, sizeof(*queue->jobs)))
+        return false;
+
+    queue->jobs[queue->count++] = *job;
+    return true;
+}
+
+static bool vkd3d_pipeline_variant_job_queue_pop(struct vkd3d_pipeline_variant_job_queue *queue,
+        struct vkd3d_pipeline_variant_job *job)
+{
+    if (queue->head == queue->count)
+        return false;
+
+    *job = queue->jobs[queue->head++];
+
+    if (queue->head == queue->count)
+        queue->head = queue->count = 0;
+    return true;
+}
+
+static bool vkd3d_pipeline_variant_job_queue_remove(struct vkd3d_pipeline_variant_job_queue *queue,
+        const struct vkd3d_compiled_pipeline *pipeline, struct vkd3d_pipeline_variant_job *job)
+{
+    size_t i;
+
+    for (i = queue->head; i < queue->count; i++)
+    {
+        if (queue->jobs[i].pipeline == pipeline)
+        {
+            *job = queue->jobs[i];
+            memmove(&queue->jobs[i], &queue->jobs[i + 1], (queue->count - i - 1) * sizeof(*queue->jobs));
+            queue->count--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint32_t vkd3d_pipeline_variant_job_queue_cancel(struct vkd3d_pipeline_variant_job_queue *queue,
+        const struct d3d12_pipeline_state *state)
+{
+    uint32_t cancel_count = 0;
+    size_t i, j;
+
+    for (i = queue->head, j = queue->head; i < queue->count; i++)
+    {
+        if (queue->jobs[i].state == state)
+            cancel_count++;
+        else
+            queue->jobs[j++] = queue->jobs[i];
+    }
+
+    queue->count = j;
+    return cancel_count;
+}
+
+static void *vkd3d_pipeline_variant_worker_main(void *arg)
+{
+    struct vkd3d_pipeline_variant_worker *worker = arg;
+    struct vkd3d_pipeline_variant_job job;
+    bool has_job;
+    int rc;
+
+    vkd3d_set_thread_name("vkd3d_pipeline");
+
+    for (;;)
+    {
+        if ((rc = pthread_mutex_lock(&worker->mutex)))
+        {
+            ERR("Failed to lock mutex, error %d.\n", rc);
+            break;
+        }
+
+        for (;;)
+        {
+            if ((has_job = vkd3d_pipeline_variant_job_queue_pop(&worker->urgent_jobs, &job) ||
+                    vkd3d_pipeline_variant_job_queue_pop(&worker->speculative_jobs, &job)))
+                break;
+
+            if (worker->should_exit)
+                break;
+
+            if ((rc = pthread_cond_wait(&worker->cond, &worker->mutex)))
+            {
+                ERR("Failed to wait on condition variable, error %d.\n", rc);
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(&worker->mutex);
+
+        if (!has_job)
+            break;
+
+        d3d12_pipeline_state_compile_variant(job.state, job.pipeline, job.dsv_format);
+
+        pthread_mutex_lock(&worker->mutex);
+        job.state->graphics.pending_variant_count--;
+        pthread_cond_broadcast(&worker->done_cond);
+        pthread_mutex_unlock(&worker->mutex);
+    }
+
+    return NULL;
+}
+
+void vkd3d_pipeline_variant_worker_start(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_device *device)
+{
+    uint32_t i;
+    int rc;
+
+    memset(worker, 0, sizeof(*worker));
+
+    if ((rc = pthread_mutex_init(&worker->mutex, NULL)))
+    {
+        ERR("Failed to initialize mutex, error %d.\n", rc);
+        return;
+    }
+
+    if ((rc = pthread_cond_init(&worker->cond, NULL)))
+    {
+        ERR("Failed to initialize condition variable, error %d.\n", rc);
+        pthread_mutex_destroy(&worker->mutex);
+        return;
+    }
+
+    if ((rc = pthread_cond_init(&worker->done_cond, NULL)))
+    {
+        ERR("Failed to initialize condition variable, error %d.\n", rc);
+        pthread_cond_destroy(&worker->cond);
+        pthread_mutex_destroy(&worker->mutex);
+        return;
+    }
+
+    worker->device = device;
+
+    /* Without worker threads, pipeline variants are compiled on the recording thread. */
+    for (i = 0; i < ARRAY_SIZE(worker->threads); i++)
+    {
+        if (FAILED(vkd3d_create_thread(device->vkd3d_instance,
+                vkd3d_pipeline_variant_worker_main, worker, &worker->threads[i])))
+        {
+            ERR("Failed to create pipeline variant worker thread.\n");
+            break;
+        }
+
+        worker->thread_count++;
+    }
+}
+
+void vkd3d_pipeline_variant_worker_stop(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_device *device)
+{
+    uint32_t i;
+
+    if (!worker->device)
+        return;
+
+    pthread_mutex_lock(&worker->mutex);
+    worker->should_exit = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+
+    for (i = 0; i < worker->thread_count; i++)
+        vkd3d_join_thread(device->vkd3d_instance, &worker->threads[i]);
+
+    pthread_cond_destroy(&worker->done_cond);
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->mutex);
+
+    vkd3d_free(worker->urgent_jobs.jobs);
+    vkd3d_free(worker->speculative_jobs.jobs);
+}
+
+static bool vkd3d_pipeline_variant_worker_enqueue(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_pipeline_state *state, struct vkd3d_compiled_pipeline *pipeline,
+        const struct vkd3d_format *dsv_format, bool speculative)
+{
+    struct vkd3d_pipeline_variant_job_queue *queue;
+    struct vkd3d_pipeline_variant_job job;
+#ifdef VKD3D_ENABLE_PROFILING
+    size_t queue_depth;
+#endif
+    bool ret;
+    VKD3D_REGION_DECL(pipeline_variant_queue_depth);
+
+    if (!worker->thread_count)
+        return false;
+
+    job.state = state;
+    job.pipeline = pipeline;
+    job.dsv_format = dsv_format;
+
+    queue = speculative ? &worker->speculative_jobs : &worker->urgent_jobs;
+
+    VKD3D_REGION_BEGIN(pipeline_variant_queue_depth);
+
+    pthread_mutex_lock(&worker->mutex);
+    if ((ret = vkd3d_pipeline_variant_job_queue_push(queue, &job)))
+    {
+        state->graphics.pending_variant_count++;
+        pthread_cond_signal(&worker->cond);
+    }
+#ifdef VKD3D_ENABLE_PROFILING
+    queue_depth = (worker->urgent_jobs.count - worker->urgent_jobs.head) +
+            (worker->speculative_jobs.count - worker->speculative_jobs.head);
+#endif
+    pthread_mutex_unlock(&worker->mutex);
+
+    /* Iterations accumulate the queue depth observed by each enqueue. */
+    VKD3D_REGION_END_ITERATIONS(pipeline_variant_queue_depth, queue_depth);
+
+    return ret;
+}
+
+static void vkd3d_pipeline_variant_worker_compile(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_pipeline_state *state, struct vkd3d_compiled_pipeline *pipeline,
+        const struct vkd3d_format *dsv_format)
+{
+    d3d12_pipeline_state_compile_variant(state, pipeline, dsv_format);
+
+    /* Other recording threads may be waiting for the same variant. */
+    if (worker->device)
+    {
+        pthread_mutex_lock(&worker->mutex);
+        pthread_cond_broadcast(&worker->done_cond);
+        pthread_mutex_unlock(&worker->mutex);
+    }
+}
+
+static void vkd3d_pipeline_variant_worker_wait(struct vkd3d_pipeline_variant_worker *worker,
+        struct vkd3d_compiled_pipeline *pipeline)
+{
+    struct vkd3d_pipeline_variant_job job;
+    VKD3D_REGION_DECL(pipeline_variant_wait);
+
+    if (vkd3d_atomic_uint32_load_explicit(&pipeline->status, vkd3d_memory_order_acquire) != VKD3D_COMPILED_PIPELINE_PENDING)
+        return;
+
+    VKD3D_REGION_BEGIN(pipeline_variant_wait);
+
+    if (!worker->device)
+    {
+        while (vkd3d_atomic_uint32_load_explicit(&pipeline->status, vkd3d_memory_order_acquire) == VKD3D_COMPILED_PIPELINE_PENDING)
+            vkd3d_pause();
+
+        VKD3D_REGION_END(pipeline_variant_wait);
+        return;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+
+    /* Do not wait behind speculative work if the variant is needed right now. */
+    if (vkd3d_pipeline_variant_job_queue_remove(&worker->speculative_jobs, pipeline, &job) &&
+            !vkd3d_pipeline_variant_job_queue_push(&worker->urgent_jobs, &job))
+    {
+        pthread_mutex_unlock(&worker->mutex);
+        d3d12_pipeline_state_compile_variant(job.state, job.pipeline, job.dsv_format);
+        pthread_mutex_lock(&worker->mutex);
+        job.state->graphics.pending_variant_count--;
+        pthread_cond_broadcast(&worker->done_cond);
+    }
+
+    while (vkd3d_atomic_uint32_load_explicit(&pipeline->status, vkd3d_memory_order_acquire) == VKD3D_COMPILED_PIPELINE_PENDING)
+        pthread_cond_wait(&worker->done_cond, &worker->mutex);
+
+    pthread_mutex_unlock(&worker->mutex);
+
+    VKD3D_REGION_END(pipeline_variant_wait);
+}
+
+static void vkd3d_pipeline_variant_worker_cancel(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_pipeline_state *state)
+{
+    struct d3d12_graphics_pipeline_state *graphics = &state->graphics;
+
+    if (!worker->thread_count)
+        return;
+
+    pthread_mutex_lock(&worker->mutex);
+
+    graphics->pending_variant_count -= vkd3d_pipeline_variant_job_queue_cancel(&worker->urgent_jobs, state);
+    graphics->pending_variant_count -= vkd3d_pipeline_variant_job_queue_cancel(&worker->speculative_jobs, state);
+
+    /* Variants which are already being compiled still reference the PSO. */
+    while (graphics->pending_variant_count)
+        pthread_cond_wait(&worker->done_cond, &worker->mutex);
+
+    pthread_mutex_unlock(&worker->mutex);
+}
+
 /* ID3D12PipelineState */
 static HRESULT STDMETHODCALLTYPE d3d12_pipeline_state_QueryInterface(ID3D12PipelineState *iface,
         REFIID riid, void **object)
@@ -2051,7 +2617,6 @@ static void d3d12_pipeline_state_destroy_graphics(struct d3d12_pipeline_state *s
 {
     struct d3d12_graphics_pipeline_state *graphics = &state->graphics;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    struct vkd3d_compiled_pipeline *current, *e;
     unsigned int i;
 
     for (i = 0; i < graphics->stage_count; ++i)
@@ -2059,11 +2624,7 @@ static void d3d12_pipeline_state_destroy_graphics(struct d3d12_pipeline_state *s
         VK_CALL(vkDestroyShaderModule(device->vk_device, graphics->stages[i].module, NULL));
     }
 
-    LIST_FOR_EACH_ENTRY_SAFE(current, e, &graphics->compiled_fallback_pipelines, struct vkd3d_compiled_pipeline, entry)
-    {
-        VK_CALL(vkDestroyPipeline(device->vk_device, current->vk_pipeline, NULL));
-        vkd3d_free(current);
-    }
+    vkd3d_lockfree_table_cleanup(&graphics->compiled_fallback_pipelines, vkd3d_compiled_pipeline_destroy, device);
 
     for (i = 0; i < VKD3D_GRAPHICS_PIPELINE_STATIC_VARIANT_COUNT; i++)
         VK_CALL(vkDestroyPipeline(device->vk_device, graphics->pipeline[i], NULL));
@@ -2093,7 +2654,10 @@ static ULONG STDMETHODCALLTYPE d3d12_pipeline_state_Release(ID3D12PipelineState
         vkd3d_private_store_destroy(&state->private_store);
 
         if (d3d12_pipeline_state_is_graphics(state))
+        {
+            vkd3d_pipeline_variant_worker_cancel(&device->pipeline_variant_worker, state);
             d3d12_pipeline_state_destroy_graphics(state, device);
+        }
         else if (d3d12_pipeline_state_is_compute(state))
             VK_CALL(vkDestroyPipeline(device->vk_device, state->compute.vk_pipeline, NULL));
 
@@ -2215,8 +2779,11 @@ static HRESULT create_shader_stage(struct d3d12_device *device,
     VkShaderModuleCreateInfo shader_desc;
     struct vkd3d_shader_code spirv = {0};
     char hash_str[16 + 1];
+    uint64_t cache_key = 0;
     VkResult vr;
     int ret;
+    VKD3D_REGION_DECL(shader_cache_hit);
+    VKD3D_REGION_DECL(shader_cache_miss);
 
     stage_desc->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stage_desc->pNext = NULL;
@@ -2229,13 +2796,36 @@ static HRESULT create_shader_stage(struct d3d12_device *device,
     shader_desc.pNext = NULL;
     shader_desc.flags = 0;
 
-    TRACE("Calling vkd3d_shader_compile_dxbc.\n");
-    if ((ret = vkd3d_shader_compile_dxbc(&dxbc, &spirv, 0, shader_interface, compile_args)) < 0)
+    if (device->disk_shader_cache.active)
     {
-        WARN("Failed to compile shader, vkd3d result %d.\n", ret);
-        return hresult_from_vkd3d_result(ret);
+        cache_key = vkd3d_shader_disk_cache_compute_key(device, &dxbc, shader_interface, compile_args);
+
+        /* Both regions only time the lookup itself, so that hits and misses are comparable. */
+        VKD3D_REGION_BEGIN(shader_cache_hit);
+        VKD3D_REGION_BEGIN(shader_cache_miss);
+        if (vkd3d_shader_disk_cache_load(&device->disk_shader_cache, cache_key, &dxbc, &spirv))
+        {
+            VKD3D_REGION_END(shader_cache_hit);
+            TRACE("Found shader %016"PRIx64" in disk cache.\n", spirv.meta.hash);
+        }
+        else
+            VKD3D_REGION_END(shader_cache_miss);
+    }
+
+    if (!spirv.code)
+    {
+        TRACE("Calling vkd3d_shader_compile_dxbc.\n");
+        if ((ret = vkd3d_shader_compile_dxbc(&dxbc, &spirv, 0, shader_interface, compile_args)) < 0)
+        {
+            WARN("Failed to compile shader, vkd3d result %d.\n", ret);
+            return hresult_from_vkd3d_result(ret);
+        }
+        TRACE("Called vkd3d_shader_compile_dxbc.\n");
+
+        if (device->disk_shader_cache.active)
+            vkd3d_shader_disk_cache_store(&device->disk_shader_cache, cache_key, &dxbc, &spirv);
     }
-    TRACE("Called vkd3d_shader_compile_dxbc.\n");
+
     shader_desc.codeSize = spirv.size;
     shader_desc.pCode = spirv.code;
     *meta = spirv.meta;
@@ -3740,7 +4330,7 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
         }
     }
 
-    list_init(&graphics->compiled_fallback_pipelines);
+    vkd3d_lockfree_table_init(&graphics->compiled_fallback_pipelines, VKD3D_COMPILED_PIPELINE_TABLE_INITIAL_SIZE);
 
     if (FAILED(hr = vkd3d_private_store_init(&state->private_store)))
         goto fail;
@@ -3790,6 +4380,8 @@ static HRESULT d3d12_pipeline_create_private_root_signature(struct d3d12_device
             bytecode->pShaderBytecode, bytecode->BytecodeLength, &IID_ID3D12RootSignature, (void**)root_signature);
 }
 
+static void d3d12_pipeline_state_queue_speculative_variants(struct d3d12_pipeline_state *state);
+
 HRESULT d3d12_pipeline_state_create(struct d3d12_device *device, VkPipelineBindPoint bind_point,
         const struct d3d12_pipeline_state_desc *desc, struct d3d12_pipeline_state **state)
 {
@@ -3838,6 +4430,9 @@ HRESULT d3d12_pipeline_state_create(struct d3d12_device *device, VkPipelineBindP
         return hr;
     }
 
+    if (bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
+        d3d12_pipeline_state_queue_speculative_variants(object);
+
     TRACE("Created pipeline state %p.\n", object);
 
     *state = object;
@@ -3940,67 +4535,53 @@ enum VkPrimitiveTopology vk_topology_from_d3d12_topology(D3D12_PRIMITIVE_TOPOLOG
     }
 }
 
-static VkPipeline d3d12_pipeline_state_find_compiled_pipeline(struct d3d12_pipeline_state *state,
-        const struct vkd3d_pipeline_key *key,
-        const struct vkd3d_render_pass_compatibility **render_pass_compat,
-        uint32_t *dynamic_state_flags)
+static struct vkd3d_compiled_pipeline *d3d12_pipeline_state_find_compiled_pipeline(
+        struct d3d12_pipeline_state *state, const struct vkd3d_pipeline_key *key)
 {
-    const struct d3d12_graphics_pipeline_state *graphics = &state->graphics;
-    VkPipeline vk_pipeline = VK_NULL_HANDLE;
-    struct vkd3d_compiled_pipeline *current;
-
-    *render_pass_compat = NULL;
-
-    rw_spinlock_acquire_read(&state->lock);
-    LIST_FOR_EACH_ENTRY(current, &graphics->compiled_fallback_pipelines, struct vkd3d_compiled_pipeline, entry)
-    {
-        if (!memcmp(&current->key, key, sizeof(*key)))
-        {
-            vk_pipeline = current->vk_pipeline;
-            *render_pass_compat = &current->render_pass_compat;
-            *dynamic_state_flags = current->dynamic_state_flags;
-            break;
-        }
-    }
-    rw_spinlock_release_read(&state->lock);
-
-    return vk_pipeline;
+    return vkd3d_lockfree_table_find(&state->graphics.compiled_fallback_pipelines,
+            key, vkd3d_pipeline_key_hash(key), vkd3d_compiled_pipeline_compare);
 }
 
-static bool d3d12_pipeline_state_put_pipeline_to_cache(struct d3d12_pipeline_state *state,
-        const struct vkd3d_pipeline_key *key, VkPipeline vk_pipeline,
-        const struct vkd3d_render_pass_compatibility *render_pass_compat,
-        const struct vkd3d_render_pass_compatibility **out_render_pass_compat,
-        uint32_t dynamic_state_flags)
+/* Returns the existing entry if another thread added the same variant first. */
+static struct vkd3d_compiled_pipeline *d3d12_pipeline_state_add_compiled_pipeline(struct d3d12_pipeline_state *state,
+        const struct vkd3d_pipeline_key *key, bool speculative, bool *created)
 {
     struct d3d12_graphics_pipeline_state *graphics = &state->graphics;
-    struct vkd3d_compiled_pipeline *compiled_pipeline, *current;
+    struct vkd3d_compiled_pipeline *compiled_pipeline;
+    struct vkd3d_compiled_pipeline *existing;
+    uint32_t key_hash;
 
-    if (!(compiled_pipeline = vkd3d_malloc(sizeof(*compiled_pipeline))))
-        return false;
+    *created = false;
+
+    if (!(compiled_pipeline = vkd3d_calloc(1, sizeof(*compiled_pipeline))))
+        return NULL;
 
     compiled_pipeline->key = *key;
-    compiled_pipeline->vk_pipeline = vk_pipeline;
-    compiled_pipeline->render_pass_compat = *render_pass_compat;
-    compiled_pipeline->dynamic_state_flags = dynamic_state_flags;
-    *out_render_pass_compat = &compiled_pipeline->render_pass_compat;
+    compiled_pipeline->status = VKD3D_COMPILED_PIPELINE_PENDING;
+    compiled_pipeline->speculative = speculative;
+    key_hash = vkd3d_pipeline_key_hash(key);
 
+    /* Only writers serialize against each other. */
     rw_spinlock_acquire_write(&state->lock);
 
-    LIST_FOR_EACH_ENTRY(current, &graphics->compiled_fallback_pipelines, struct vkd3d_compiled_pipeline, entry)
+    if ((existing = vkd3d_lockfree_table_find(&graphics->compiled_fallback_pipelines,
+            key, key_hash, vkd3d_compiled_pipeline_compare)))
     {
-        if (!memcmp(&current->key, key, sizeof(*key)))
-        {
-            vkd3d_free(compiled_pipeline);
-            compiled_pipeline = NULL;
-            break;
-        }
+        rw_spinlock_release_write(&state->lock);
+        vkd3d_free(compiled_pipeline);
+        return existing;
     }
 
-    if (compiled_pipeline)
-        list_add_tail(&graphics->compiled_fallback_pipelines, &compiled_pipeline->entry);
+    if (!vkd3d_lockfree_table_insert_locked(&graphics->compiled_fallback_pipelines, compiled_pipeline, key_hash))
+    {
+        rw_spinlock_release_write(&state->lock);
+        vkd3d_free(compiled_pipeline);
+        return NULL;
+    }
 
     rw_spinlock_release_write(&state->lock);
+
+    *created = true;
     return compiled_pipeline;
 }
 
@@ -4243,15 +4824,16 @@ VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_sta
         const struct vkd3d_render_pass_compatibility **render_pass_compat,
         uint32_t *dynamic_state_flags, uint32_t variant_flags)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &state->device->vk_procs;
     struct d3d12_graphics_pipeline_state *graphics = &state->graphics;
-    struct vkd3d_render_pass_compatibility new_render_pass_compat;
+    struct vkd3d_compiled_pipeline *pipeline;
     struct d3d12_device *device = state->device;
     struct vkd3d_pipeline_key pipeline_key;
     uint32_t stride, stride_align_mask;
     bool extended_dynamic_state;
-    VkPipeline vk_pipeline;
     unsigned int i;
+    bool created;
+    VKD3D_REGION_DECL(pipeline_variant_speculative_miss);
+    VKD3D_REGION_DECL(pipeline_variant_speculative_hit);
 
     assert(d3d12_pipeline_state_is_graphics(state));
 
@@ -4296,37 +4878,125 @@ VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_sta
     pipeline_key.rtv_active_mask = state->graphics.rtv_active_mask & rtv_nonnull_mask;
     pipeline_key.variant_flags = variant_flags;
 
-    if ((vk_pipeline = d3d12_pipeline_state_find_compiled_pipeline(state, &pipeline_key, render_pass_compat,
-            dynamic_state_flags)))
+    if (!(pipeline = d3d12_pipeline_state_find_compiled_pipeline(state, &pipeline_key)))
     {
-        return vk_pipeline;
-    }
+        if (extended_dynamic_state)
+            FIXME("Extended dynamic state is supported, but compiling a fallback pipeline late!\n");
 
-    if (extended_dynamic_state)
-        FIXME("Extended dynamic state is supported, but compiling a fallback pipeline late!\n");
+        if (!(pipeline = d3d12_pipeline_state_add_compiled_pipeline(state, &pipeline_key, false, &created)))
+        {
+            ERR("Failed to allocate pipeline variant.\n");
+            return VK_NULL_HANDLE;
+        }
 
-    vk_pipeline = d3d12_pipeline_state_create_pipeline_variant(state,
-            &pipeline_key, dsv_format, VK_NULL_HANDLE, &new_render_pass_compat, dynamic_state_flags,
-            variant_flags);
+        if (created)
+        {
+            VKD3D_REGION_BEGIN(pipeline_variant_speculative_miss);
+            if (!vkd3d_pipeline_variant_worker_enqueue(&device->pipeline_variant_worker,
+                    state, pipeline, dsv_format, false))
+                vkd3d_pipeline_variant_worker_compile(&device->pipeline_variant_worker, state, pipeline, dsv_format);
+            VKD3D_REGION_END(pipeline_variant_speculative_miss);
+        }
+    }
 
-    if (!vk_pipeline)
+    /* Never compile on the recording thread if a worker already owns the variant. */
+    vkd3d_pipeline_variant_worker_wait(&device->pipeline_variant_worker, pipeline);
+
+    if (vkd3d_atomic_uint32_load_explicit(&pipeline->status, vkd3d_memory_order_acquire) != VKD3D_COMPILED_PIPELINE_READY)
     {
         ERR("Failed to create pipeline.\n");
         return VK_NULL_HANDLE;
     }
 
-    if (d3d12_pipeline_state_put_pipeline_to_cache(state, &pipeline_key, vk_pipeline, &new_render_pass_compat,
-            render_pass_compat, *dynamic_state_flags))
+    if (pipeline->speculative && !vkd3d_atomic_uint32_load_explicit(&pipeline->used, vkd3d_memory_order_relaxed))
     {
-        return vk_pipeline;
+        VKD3D_REGION_BEGIN(pipeline_variant_speculative_hit);
+        vkd3d_atomic_uint32_store_explicit(&pipeline->used, 1, vkd3d_memory_order_relaxed);
+        VKD3D_REGION_END(pipeline_variant_speculative_hit);
     }
 
-    /* Other thread compiled the pipeline before us. */
-    VK_CALL(vkDestroyPipeline(device->vk_device, vk_pipeline, NULL));
-    vk_pipeline = d3d12_pipeline_state_find_compiled_pipeline(state, &pipeline_key, render_pass_compat, dynamic_state_flags);
-    if (!vk_pipeline)
-        ERR("Could not get the pipeline compiled by other thread from the cache.\n");
-    return vk_pipeline;
+    *render_pass_compat = &pipeline->render_pass_compat;
+    *dynamic_state_flags = pipeline->dynamic_state_flags;
+    return pipeline->vk_pipeline;
+}
+
+static void d3d12_pipeline_state_queue_speculative_variants(struct d3d12_pipeline_state *state)
+{
+    struct d3d12_graphics_pipeline_state *graphics = &state->graphics;
+    D3D12_PRIMITIVE_TOPOLOGY topologies[2];
+    struct vkd3d_compiled_pipeline *pipeline;
+    struct d3d12_device *device = state->device;
+    struct vkd3d_pipeline_key pipeline_key;
+    unsigned int topology_count, i;
+    uint32_t binding;
+    bool created;
+
+    /* With extended dynamic state, the static pipeline already covers the common case,
+     * and the remaining fallbacks depend on state we cannot predict here. */
+    if (!device->pipeline_variant_worker.thread_count ||
+            device->device_info.extended_dynamic_state_features.extendedDynamicState)
+        return;
+
+    topology_count = 0;
+
+    switch (graphics->primitive_topology_type)
+    {
+        case D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT:
+            topologies[topology_count++] = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+            break;
+
+        case D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE:
+            topologies[topology_count++] = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+            topologies[topology_count++] = D3D_PRIMITIVE_TOPOLOGY_LINESTRIP;
+            break;
+
+        case D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE:
+            topologies[topology_count++] = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+            topologies[topology_count++] = D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+            break;
+
+        case D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH:
+            if (graphics->patch_vertex_count)
+            {
+                topologies[topology_count++] = D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST +
+                        graphics->patch_vertex_count - 1;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    /* Must match the key built in d3d12_pipeline_state_get_or_create_pipeline(),
+     * assuming a single viewport, tightly packed vertex buffers and all render targets bound. */
+    memset(&pipeline_key, 0, sizeof(pipeline_key));
+    pipeline_key.viewport_count = 1;
+
+    for (i = 0; i < graphics->attribute_binding_count; ++i)
+    {
+        binding = graphics->attribute_bindings[i].binding;
+        pipeline_key.strides[i] = graphics->minimum_vertex_buffer_dynamic_stride[binding] &
+                ~graphics->vertex_buffer_stride_align_mask[binding];
+    }
+
+    pipeline_key.dsv_format = graphics->dsv_format ? graphics->dsv_format->vk_format : VK_FORMAT_UNDEFINED;
+    pipeline_key.rtv_active_mask = graphics->rtv_active_mask;
+    pipeline_key.variant_flags = 0;
+
+    for (i = 0; i < topology_count; i++)
+    {
+        pipeline_key.topology = topologies[i];
+
+        if (!(pipeline = d3d12_pipeline_state_add_compiled_pipeline(state, &pipeline_key, true, &created)) || !created)
+            continue;
+
+        if (!vkd3d_pipeline_variant_worker_enqueue(&device->pipeline_variant_worker,
+                state, pipeline, graphics->dsv_format, true))
+        {
+            /* The entry is already visible, so it has to be completed. */
+            vkd3d_pipeline_variant_worker_compile(&device->pipeline_variant_worker, state, pipeline, graphics->dsv_format);
+        }
+    }
 }
 
 static uint32_t d3d12_max_descriptor_count_from_heap_type(D3D12_DESCRIPTOR_HEAP_TYPE heap_type)
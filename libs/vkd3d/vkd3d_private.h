@@ -26,6 +26,7 @@
 #include "vkd3d_memory.h"
 #include "vkd3d_utf8.h"
 #include "hashmap.h"
+#include "vkd3d_lockfree_table.h"
 #include "list.h"
 #include "rbtree.h"
 
@@ -97,6 +98,14 @@ struct vkd3d_vk_device_procs
 
 HRESULT hresult_from_errno(int rc);
 HRESULT hresult_from_vk_result(VkResult vr);
+
+/* Processes rarely survive a lost device for long, so make sure
+ * queued log messages leading up to it reach the log file. */
+static inline void vkd3d_dbg_flush_on_device_lost(VkResult vr)
+{
+    if (vr == VK_ERROR_DEVICE_LOST)
+        vkd3d_dbg_flush();
+}
 HRESULT hresult_from_vkd3d_result(int vkd3d_result);
 
 struct vkd3d_vulkan_info
@@ -217,13 +226,18 @@ struct vkd3d_waiting_fence
     uint64_t value;
 };
 
+/* A single worker per device services completions for every queue. It blocks in a
+ * wait-any on all outstanding timeline semaphores, plus a host-signalled kick
+ * semaphore which is bumped whenever new work is enqueued or the worker should exit. */
 struct vkd3d_fence_worker
 {
     union vkd3d_thread_handle thread;
     pthread_mutex_t mutex;
-    pthread_cond_t cond;
     bool should_exit;
 
+    VkSemaphore kick_semaphore;
+    uint64_t kick_value;
+
     uint32_t enqueued_fence_count;
     struct vkd3d_waiting_fence *enqueued_fences;
     size_t enqueued_fences_size;
@@ -342,13 +356,10 @@ struct vkd3d_render_pass_key
     VkFormat vk_formats[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
 };
 
-struct vkd3d_render_pass_entry;
-
 struct vkd3d_render_pass_cache
 {
-    struct vkd3d_render_pass_entry *render_passes;
-    size_t render_pass_count;
-    size_t render_passes_size;
+    /* Lock-free for readers, lock only serializes insertions. */
+    struct vkd3d_lockfree_table table;
     spinlock_t lock;
 };
 
@@ -359,6 +370,47 @@ HRESULT vkd3d_render_pass_cache_find(struct vkd3d_render_pass_cache *cache,
         VkRenderPass *vk_render_pass);
 void vkd3d_render_pass_cache_init(struct vkd3d_render_pass_cache *cache);
 
+#define VKD3D_FRAMEBUFFER_MAX_VIEWS (D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 2)
+
+/* Attachments are identified by view cookies (or the resource cookie for
+ * VRS attachments), which are never reused, so a key can never alias a
+ * framebuffer created for views which have since been destroyed. */
+struct vkd3d_framebuffer_key
+{
+    VkRenderPass render_pass;
+    uint64_t view_cookies[VKD3D_FRAMEBUFFER_MAX_VIEWS];
+    uint32_t view_count;
+    uint32_t width;
+    uint32_t height;
+    uint32_t layers;
+};
+
+struct vkd3d_framebuffer
+{
+    LONG refcount;
+    VkFramebuffer vk_framebuffer;
+    struct vkd3d_framebuffer_key key;
+};
+
+void vkd3d_framebuffer_decref(struct vkd3d_framebuffer *framebuffer, struct d3d12_device *device);
+
+struct vkd3d_framebuffer_cache
+{
+    spinlock_t spinlock;
+    struct hash_map map;
+    /* Maps view cookies to the cached framebuffers referencing them,
+     * so that destroying a view only touches its own framebuffers. */
+    struct hash_map cookie_map;
+};
+
+void vkd3d_framebuffer_cache_cleanup(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device);
+void vkd3d_framebuffer_cache_evict_cookie(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device, uint64_t cookie);
+struct vkd3d_framebuffer *vkd3d_framebuffer_cache_get(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device, const struct vkd3d_framebuffer_key *key, const VkImageView *views);
+void vkd3d_framebuffer_cache_init(struct vkd3d_framebuffer_cache *cache);
+
 struct vkd3d_private_store
 {
     pthread_mutex_t mutex;
@@ -611,9 +663,11 @@ enum vkd3d_allocation_flag
     VKD3D_ALLOCATION_FLAG_ALLOW_WRITE_WATCH = (1u << 3),
     VKD3D_ALLOCATION_FLAG_NO_FALLBACK       = (1u << 4),
     VKD3D_ALLOCATION_FLAG_DEDICATED         = (1u << 5),
+    VKD3D_ALLOCATION_FLAG_MAGAZINE          = (1u << 6),
 };
 
-#define VKD3D_MEMORY_CHUNK_SIZE (VKD3D_VA_BLOCK_SIZE * 16)
+#define VKD3D_MEMORY_CHUNK_SIZE_BITS (VKD3D_VA_BLOCK_SIZE_BITS + 4)
+#define VKD3D_MEMORY_CHUNK_SIZE (1ull << VKD3D_MEMORY_CHUNK_SIZE_BITS)
 
 struct vkd3d_memory_chunk;
 
@@ -682,6 +736,7 @@ struct vkd3d_memory_allocation
     uint64_t clear_semaphore_value;
 
     struct vkd3d_memory_chunk *chunk;
+    uint32_t chunk_block;
 };
 
 static inline void vkd3d_memory_allocation_slice(struct vkd3d_memory_allocation *dst,
@@ -696,18 +751,121 @@ static inline void vkd3d_memory_allocation_slice(struct vkd3d_memory_allocation
         dst->cpu_address = void_ptr_offset(dst->cpu_address, offset);
 }
 
-struct vkd3d_memory_free_range
+/* Chunks are managed with a two-level segregated fit allocator (TLSF).
+ * Free blocks are binned by size into a first level of power-of-two classes,
+ * each subdivided linearly into VKD3D_MEMORY_TLSF_SL_COUNT second-level classes,
+ * so that both allocation and free are O(1) bitmap lookups. */
+#define VKD3D_MEMORY_TLSF_GRANULARITY_BITS (8u)
+#define VKD3D_MEMORY_TLSF_GRANULARITY (1u << VKD3D_MEMORY_TLSF_GRANULARITY_BITS)
+#define VKD3D_MEMORY_TLSF_SL_BITS (4u)
+#define VKD3D_MEMORY_TLSF_SL_COUNT (1u << VKD3D_MEMORY_TLSF_SL_BITS)
+#define VKD3D_MEMORY_TLSF_FL_SHIFT (VKD3D_MEMORY_TLSF_SL_BITS + VKD3D_MEMORY_TLSF_GRANULARITY_BITS)
+#define VKD3D_MEMORY_TLSF_FL_COUNT (VKD3D_MEMORY_CHUNK_SIZE_BITS - VKD3D_MEMORY_TLSF_FL_SHIFT + 2)
+#define VKD3D_MEMORY_TLSF_BLOCK_NONE (~0u)
+
+struct vkd3d_memory_chunk_block
 {
     VkDeviceSize offset;
-    VkDeviceSize length;
+    VkDeviceSize size;
+    /* Neighbours in address order */
+    uint32_t prev_phys;
+    uint32_t next_phys;
+    /* Links in the free list of the block's size class. For
+     * unused block structs, next_free links the block pool. */
+    uint32_t prev_free;
+    uint32_t next_free;
+    bool is_free;
 };
 
+struct vkd3d_memory_chunk_bucket;
+
 struct vkd3d_memory_chunk
 {
     struct vkd3d_memory_allocation allocation;
-    struct vkd3d_memory_free_range *free_ranges;
-    size_t free_ranges_size;
-    size_t free_ranges_count;
+    struct vkd3d_memory_chunk_bucket *bucket;
+
+    struct vkd3d_memory_chunk_block *blocks;
+    size_t blocks_size;
+    size_t blocks_count;
+    uint32_t block_pool;
+
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[VKD3D_MEMORY_TLSF_FL_COUNT];
+    uint32_t free_lists[VKD3D_MEMORY_TLSF_FL_COUNT][VKD3D_MEMORY_TLSF_SL_COUNT];
+
+    VkDeviceSize used_size;
+    uint32_t free_block_count;
+
+    /* Blocks handed out by the chunk and how many of those are currently
+     * parked in magazines. Once they match, nothing but magazines keeps the
+     * chunk alive. The former is only modified under the allocator mutex,
+     * the latter under the lock of the shard that holds the range. */
+    uint32_t used_block_count;
+    uint32_t magazine_block_count;
+};
+
+/* Chunks can only service allocations with matching heap properties
+ * and memory type, so keep them grouped to skip incompatible chunks. */
+struct vkd3d_memory_chunk_bucket
+{
+    D3D12_HEAP_TYPE heap_type;
+    D3D12_HEAP_FLAGS heap_flags;
+    uint32_t vk_memory_type;
+
+    struct vkd3d_memory_chunk **chunks;
+    size_t chunks_size;
+    size_t chunks_count;
+};
+
+/* Small suballocations are served from per-thread magazines of pre-carved
+ * ranges so that the allocator mutex is only taken to refill or drain them.
+ * Threads are mapped to shards, each magazine holds ranges of one size class
+ * for a given heap type and set of heap flags. */
+#define VKD3D_MEMORY_MAGAZINE_SHARD_COUNT (8u)
+#define VKD3D_MEMORY_MAGAZINE_KEY_COUNT (4u)
+#define VKD3D_MEMORY_MAGAZINE_CLASS_COUNT (4u)
+#define VKD3D_MEMORY_MAGAZINE_CLASS_SIZE (D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+#define VKD3D_MEMORY_MAGAZINE_ENTRY_COUNT (8u)
+#define VKD3D_MEMORY_MAGAZINE_BATCH_SIZE (4u)
+/* Upper bound on the number of bytes all magazines of an allocator may keep
+ * cached. Without it, every key and class of every shard can pin a range. */
+#define VKD3D_MEMORY_MAGAZINE_MAX_CACHED_SIZE (16u * 1024u * 1024u)
+/* Idleness is measured in allocator epochs, which advance every time the
+ * allocator mutex is taken on a slow path. Magazines that have not been used
+ * for VKD3D_MEMORY_MAGAZINE_IDLE_EPOCHS are returned to their chunks. */
+#define VKD3D_MEMORY_MAGAZINE_IDLE_EPOCHS (256u)
+#define VKD3D_MEMORY_MAGAZINE_TRIM_INTERVAL (64u)
+
+struct vkd3d_memory_magazine_entry
+{
+    struct vkd3d_memory_chunk *chunk;
+    uint32_t chunk_block;
+    VkDeviceSize offset;
+};
+
+struct vkd3d_memory_magazine
+{
+    D3D12_HEAP_TYPE heap_type;
+    D3D12_HEAP_FLAGS heap_flags;
+    uint32_t last_use_epoch;
+    uint32_t entry_count[VKD3D_MEMORY_MAGAZINE_CLASS_COUNT];
+    struct vkd3d_memory_magazine_entry entries[VKD3D_MEMORY_MAGAZINE_CLASS_COUNT][VKD3D_MEMORY_MAGAZINE_ENTRY_COUNT];
+};
+
+struct vkd3d_memory_magazine_shard
+{
+    spinlock_t lock;
+    uint32_t magazine_count;
+    struct vkd3d_memory_magazine magazines[VKD3D_MEMORY_MAGAZINE_KEY_COUNT];
+};
+
+struct vkd3d_memory_allocator_stats
+{
+    uint32_t chunk_count;
+    uint32_t free_block_count;
+    VkDeviceSize chunk_size;
+    VkDeviceSize used_size;
+    VkDeviceSize largest_free_block;
 };
 
 #define VKD3D_MEMORY_CLEAR_COMMAND_BUFFER_COUNT (16u)
@@ -735,9 +893,14 @@ struct vkd3d_memory_allocator
 {
     pthread_mutex_t mutex;
 
-    struct vkd3d_memory_chunk **chunks;
-    size_t chunks_size;
-    size_t chunks_count;
+    struct vkd3d_memory_chunk_bucket **buckets;
+    size_t buckets_size;
+    size_t buckets_count;
+
+    struct vkd3d_memory_magazine_shard magazine_shards[VKD3D_MEMORY_MAGAZINE_SHARD_COUNT];
+    uint32_t magazine_cached_size;
+    uint32_t magazine_epoch;
+    uint32_t magazine_trim_epoch;
 
     struct vkd3d_va_map va_map;
 
@@ -755,6 +918,8 @@ HRESULT vkd3d_allocate_heap_memory(struct d3d12_device *device, struct vkd3d_mem
 HRESULT vkd3d_memory_allocator_init(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device);
 void vkd3d_memory_allocator_cleanup(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device);
 HRESULT vkd3d_memory_allocator_flush_clears(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device);
+void vkd3d_memory_allocator_get_stats(struct vkd3d_memory_allocator *allocator,
+        struct vkd3d_memory_allocator_stats *stats);
 
 /* ID3D12Heap */
 typedef ID3D12Heap1 d3d12_heap_iface;
@@ -840,8 +1005,15 @@ struct d3d12_sparse_info
 
 struct vkd3d_view_map
 {
+    /* Serializes writers. The map is read-mostly, so lookups do not lock. */
     spinlock_t spinlock;
     struct hash_map map;
+    /* Bounded maps only. Descriptor updates hold evict_lock as readers,
+     * so that views cannot be evicted between lookup and the descriptor
+     * taking its reference. */
+    spinlock_t evict_lock;
+    uint32_t max_entries;
+    uint32_t clock_hand;
 #ifdef VKD3D_ENABLE_DESCRIPTOR_QA
     uint64_t resource_cookie;
 #endif
@@ -945,6 +1117,32 @@ static inline struct d3d12_resource *impl_from_ID3D12Resource(ID3D12Resource *if
     return impl_from_ID3D12Resource2((ID3D12Resource2 *)iface);
 }
 
+#define VKD3D_COPY_WORKER_THREAD_COUNT 3
+
+/* Splits large CPU copies into row chunks which are serviced by the worker threads
+ * and the calling thread. Only one copy is in flight; concurrent callers copy inline. */
+struct vkd3d_copy_workers
+{
+    union vkd3d_thread_handle threads[VKD3D_COPY_WORKER_THREAD_COUNT];
+    uint32_t thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_cond_t done_cond;
+    bool should_exit;
+
+    const struct vkd3d_memcpy_rows *copy;
+    unsigned int chunk_row_count;
+    unsigned int chunk_count;
+    unsigned int next_chunk;
+    unsigned int pending_chunk_count;
+
+    struct d3d12_device *device;
+};
+
+void vkd3d_copy_workers_start(struct vkd3d_copy_workers *workers, struct d3d12_device *device);
+void vkd3d_copy_workers_stop(struct vkd3d_copy_workers *workers, struct d3d12_device *device);
+void vkd3d_copy_workers_copy(struct vkd3d_copy_workers *workers, const struct vkd3d_memcpy_rows *copy);
+
 HRESULT vkd3d_allocate_device_memory(struct d3d12_device *device,
         VkDeviceSize size, VkMemoryPropertyFlags type_flags, uint32_t type_mask,
         void *pNext, struct vkd3d_device_memory_allocation *allocation);
@@ -970,10 +1168,19 @@ enum vkd3d_view_type
     VKD3D_VIEW_TYPE_ACCELERATION_STRUCTURE
 };
 
+enum vkd3d_view_flag
+{
+    /* Set once the view is referenced by a cached framebuffer. */
+    VKD3D_VIEW_FRAMEBUFFER_ATTACHMENT = (1u << 0),
+    /* Set if the view is used without a reference, e.g. as a UAV counter, and must not be evicted. */
+    VKD3D_VIEW_NO_EVICT = (1u << 1),
+};
+
 struct vkd3d_view
 {
     LONG refcount;
     enum vkd3d_view_type type;
+    uint32_t flags; /* vkd3d_view_flag */
     uint64_t cookie;
 
     union
@@ -1069,16 +1276,23 @@ struct d3d12_desc
      * - Can avoid false sharing on cache lines if multiple threads
      *   modify adjacent descriptors somehow. */
     DECLSPEC_ALIGN(D3D12_DESC_ALIGNMENT) struct vkd3d_descriptor_data metadata;
-    struct d3d12_descriptor_heap *heap;
-    uint32_t heap_offset;
     union
     {
         VkDescriptorBufferInfo buffer;
         struct vkd3d_view *view;
     } info;
+    /* Everything above is copied by CopyDescriptors, everything
+     * below is tied to the descriptor's location in its heap. */
+    struct d3d12_descriptor_heap *heap;
+    uint32_t heap_offset;
 };
 STATIC_ASSERT(sizeof(struct d3d12_desc) == 64);
 
+/* Change detection compares cookie, set_info_mask and flags as one 16-byte block */
+STATIC_ASSERT(offsetof(struct vkd3d_descriptor_data, current_null_type) == 16);
+
+#define D3D12_DESC_PAYLOAD_SIZE (offsetof(struct d3d12_desc, heap))
+
 static inline struct d3d12_desc *d3d12_desc_from_cpu_handle(D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle)
 {
     return (struct d3d12_desc *)cpu_handle.ptr;
@@ -1089,8 +1303,21 @@ static inline struct d3d12_desc *d3d12_desc_from_gpu_handle(D3D12_GPU_DESCRIPTOR
     return (struct d3d12_desc *)(intptr_t)gpu_handle.ptr;
 }
 
-void d3d12_desc_copy(struct d3d12_desc *dst, struct d3d12_desc *src,
-        unsigned int count, D3D12_DESCRIPTOR_HEAP_TYPE heap_type, struct d3d12_device *device);
+/* Accumulates descriptor copies across all ranges of a CopyDescriptors call,
+ * merging copies of adjacent ranges, so that they reach the driver at once. */
+#define VKD3D_DESCRIPTOR_COPY_BATCH_SIZE (64u)
+#define VKD3D_DESCRIPTOR_COPY_BATCH_LOOKBACK (VKD3D_MAX_BINDLESS_DESCRIPTOR_SETS + 1u)
+
+struct vkd3d_descriptor_copy_batch
+{
+    VkCopyDescriptorSet copies[VKD3D_DESCRIPTOR_COPY_BATCH_SIZE];
+    uint32_t copy_count;
+};
+
+void vkd3d_descriptor_copy_batch_flush(struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device);
+
+void d3d12_desc_copy(struct d3d12_desc *dst, struct d3d12_desc *src, unsigned int count,
+        D3D12_DESCRIPTOR_HEAP_TYPE heap_type, struct vkd3d_descriptor_copy_batch *batch, struct d3d12_device *device);
 void d3d12_desc_create_cbv(struct d3d12_desc *descriptor,
         struct d3d12_device *device, const D3D12_CONSTANT_BUFFER_VIEW_DESC *desc);
 void d3d12_desc_create_srv(struct d3d12_desc *descriptor,
@@ -1102,6 +1329,14 @@ void d3d12_desc_create_uav(struct d3d12_desc *descriptor, struct d3d12_device *d
 void d3d12_desc_create_sampler(struct d3d12_desc *sampler,
         struct d3d12_device *device, const D3D12_SAMPLER_DESC *desc);
 
+/* With a view map limit, descriptors own a reference to their view, so that views
+ * are only evicted from resource view maps once no descriptor refers to them.
+ * Descriptor writes must be bracketed by begin/end_update. */
+struct vkd3d_view *d3d12_desc_begin_update(struct d3d12_desc *descriptor,
+        struct d3d12_resource *resource, struct d3d12_device *device);
+void d3d12_desc_end_update(struct d3d12_desc *descriptor, struct vkd3d_view *old_view,
+        struct d3d12_resource *resource, struct d3d12_device *device);
+
 bool vkd3d_create_raw_buffer_view(struct d3d12_device *device,
         D3D12_GPU_VIRTUAL_ADDRESS gpu_address, VkBufferView *vk_buffer_view);
 HRESULT d3d12_create_static_sampler(struct d3d12_device *device,
@@ -1119,7 +1354,8 @@ struct d3d12_rtv_desc
 };
 STATIC_ASSERT(sizeof(struct d3d12_rtv_desc) == 64);
 
-void d3d12_rtv_desc_copy(struct d3d12_rtv_desc *dst, struct d3d12_rtv_desc *src, unsigned int count);
+void d3d12_rtv_desc_copy(struct d3d12_rtv_desc *dst, struct d3d12_rtv_desc *src, unsigned int count,
+        struct d3d12_device *device);
 
 static inline struct d3d12_rtv_desc *d3d12_rtv_desc_from_cpu_handle(D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle)
 {
@@ -1131,6 +1367,10 @@ void d3d12_rtv_desc_create_rtv(struct d3d12_rtv_desc *rtv_desc, struct d3d12_dev
 
 void d3d12_rtv_desc_create_dsv(struct d3d12_rtv_desc *dsv_desc, struct d3d12_device *device,
         struct d3d12_resource *resource, const D3D12_DEPTH_STENCIL_VIEW_DESC *desc);
+struct vkd3d_view *d3d12_rtv_desc_begin_update(struct d3d12_rtv_desc *rtv_desc,
+        struct d3d12_resource *resource, struct d3d12_device *device);
+void d3d12_rtv_desc_end_update(struct d3d12_rtv_desc *rtv_desc, struct vkd3d_view *old_view,
+        struct d3d12_resource *resource, struct d3d12_device *device);
 
 struct vkd3d_bound_buffer_range
 {
@@ -1357,6 +1597,11 @@ struct d3d12_root_signature
 
     struct vkd3d_descriptor_hoist_info hoist_info;
 
+    /* Key in the device root signature cache. */
+    uint64_t bytecode_hash;
+    void *bytecode;
+    size_t bytecode_length;
+
     struct d3d12_device *device;
 
     struct vkd3d_private_store private_store;
@@ -1365,6 +1610,17 @@ struct d3d12_root_signature
 HRESULT d3d12_root_signature_create(struct d3d12_device *device, const void *bytecode,
         size_t bytecode_length, struct d3d12_root_signature **root_signature);
 
+/* Weak references to all live root signatures of a device, so that identical
+ * blobs return the same object and share their Vulkan layouts. */
+struct vkd3d_root_signature_cache
+{
+    spinlock_t spinlock;
+    struct hash_map map;
+};
+
+void vkd3d_root_signature_cache_init(struct vkd3d_root_signature_cache *cache);
+void vkd3d_root_signature_cache_cleanup(struct vkd3d_root_signature_cache *cache);
+
 static inline struct d3d12_root_signature *impl_from_ID3D12RootSignature(ID3D12RootSignature *iface)
 {
     extern CONST_VTBL struct ID3D12RootSignatureVtbl d3d12_root_signature_vtbl;
@@ -1490,7 +1746,10 @@ struct d3d12_graphics_pipeline_state
 
     VkPipelineLayout pipeline_layout;
     VkPipeline pipeline[VKD3D_GRAPHICS_PIPELINE_STATIC_VARIANT_COUNT];
-    struct list compiled_fallback_pipelines;
+    struct vkd3d_lockfree_table compiled_fallback_pipelines;
+    /* Number of variants queued on or being compiled by the device's pipeline variant worker.
+     * Protected by the worker mutex. */
+    uint32_t pending_variant_count;
 
     bool xfb_enabled;
 };
@@ -1622,6 +1881,45 @@ VkPipeline d3d12_pipeline_state_create_pipeline_variant(struct d3d12_pipeline_st
         struct vkd3d_render_pass_compatibility *render_pass_compat,
         uint32_t *dynamic_state_flags, uint32_t variant_flags);
 
+struct vkd3d_pipeline_variant_job
+{
+    struct d3d12_pipeline_state *state;
+    struct vkd3d_compiled_pipeline *pipeline;
+    const struct vkd3d_format *dsv_format;
+};
+
+struct vkd3d_pipeline_variant_job_queue
+{
+    struct vkd3d_pipeline_variant_job *jobs;
+    size_t jobs_size;
+    size_t head;
+    size_t count;
+};
+
+#define VKD3D_PIPELINE_VARIANT_WORKER_THREAD_COUNT 2
+
+/* Compiles pipeline variants off the recording threads. Variants which are requested
+ * at draw time are compiled before variants which are speculatively queued on PSO creation. */
+struct vkd3d_pipeline_variant_worker
+{
+    union vkd3d_thread_handle threads[VKD3D_PIPELINE_VARIANT_WORKER_THREAD_COUNT];
+    uint32_t thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_cond_t done_cond;
+    bool should_exit;
+
+    struct vkd3d_pipeline_variant_job_queue urgent_jobs;
+    struct vkd3d_pipeline_variant_job_queue speculative_jobs;
+
+    struct d3d12_device *device;
+};
+
+void vkd3d_pipeline_variant_worker_start(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_device *device);
+void vkd3d_pipeline_variant_worker_stop(struct vkd3d_pipeline_variant_worker *worker,
+        struct d3d12_device *device);
+
 static inline struct d3d12_pipeline_state *impl_from_ID3D12PipelineState(ID3D12PipelineState *iface)
 {
     extern CONST_VTBL struct ID3D12PipelineStateVtbl d3d12_pipeline_state_vtbl;
@@ -1656,6 +1954,26 @@ HRESULT vkd3d_create_pipeline_cache_from_d3d12_desc(struct d3d12_device *device,
         const struct d3d12_cached_pipeline_state *state, VkPipelineCache *cache);
 VkResult vkd3d_serialize_pipeline_state(const struct d3d12_pipeline_state *state, size_t *size, void *data);
 
+struct vkd3d_shader_disk_cache
+{
+    char path[VKD3D_PATH_MAX];
+    pthread_mutex_t lock;
+    uint64_t total_size;
+    uint64_t max_size;
+    uint32_t store_counter;
+    bool active;
+};
+
+void vkd3d_shader_disk_cache_init(struct vkd3d_shader_disk_cache *cache);
+void vkd3d_shader_disk_cache_cleanup(struct vkd3d_shader_disk_cache *cache);
+uint64_t vkd3d_shader_disk_cache_compute_key(struct d3d12_device *device,
+        const struct vkd3d_shader_code *dxbc, const struct vkd3d_shader_interface_info *shader_interface,
+        const struct vkd3d_shader_compile_arguments *compile_args);
+bool vkd3d_shader_disk_cache_load(struct vkd3d_shader_disk_cache *cache, uint64_t key,
+        const struct vkd3d_shader_code *dxbc, struct vkd3d_shader_code *spirv);
+void vkd3d_shader_disk_cache_store(struct vkd3d_shader_disk_cache *cache, uint64_t key,
+        const struct vkd3d_shader_code *dxbc, const struct vkd3d_shader_code *spirv);
+
 struct vkd3d_buffer
 {
     VkBuffer vk_buffer;
@@ -1695,6 +2013,10 @@ struct vkd3d_scratch_buffer
 #define VKD3D_QUERY_TYPE_INDEX_RT_COMPACTED_SIZE (3u)
 #define VKD3D_QUERY_TYPE_INDEX_RT_SERIALIZE_SIZE (4u)
 #define VKD3D_VIRTUAL_QUERY_TYPE_COUNT (5u)
+
+#define VKD3D_QUERY_ARENA_BLOCK_SIZE (64 * 1024)
+#define VKD3D_COMMAND_BUFFER_MIN_BATCH_SIZE (4u)
+#define VKD3D_COMMAND_BUFFER_MAX_BATCH_SIZE (64u)
 #define VKD3D_VIRTUAL_QUERY_POOL_COUNT (128u)
 
 struct vkd3d_query_pool
@@ -1726,6 +2048,10 @@ struct d3d12_command_allocator
     size_t framebuffers_size;
     size_t framebuffer_count;
 
+    struct vkd3d_framebuffer **cached_framebuffers;
+    size_t cached_framebuffers_size;
+    size_t cached_framebuffer_count;
+
     struct vkd3d_view **views;
     size_t views_size;
     size_t view_count;
@@ -1734,10 +2060,18 @@ struct d3d12_command_allocator
     size_t buffer_views_size;
     size_t buffer_view_count;
 
+    /* Command buffers which were used by a command list since the last reset. */
     VkCommandBuffer *command_buffers;
     size_t command_buffers_size;
     size_t command_buffer_count;
 
+    /* Command buffers which are ready to be handed out. Both lists have room
+     * for command_buffer_total_count entries. */
+    VkCommandBuffer *free_command_buffers;
+    size_t free_command_buffers_size;
+    size_t free_command_buffer_count;
+    size_t command_buffer_total_count;
+
     struct vkd3d_scratch_buffer *scratch_buffers;
     size_t scratch_buffers_size;
     size_t scratch_buffer_count;
@@ -1748,6 +2082,9 @@ struct d3d12_command_allocator
 
     struct vkd3d_query_pool active_query_pools[VKD3D_VIRTUAL_QUERY_TYPE_COUNT];
 
+    /* Scratch memory for resolving pending queries, reset with the allocator. */
+    struct vkd3d_arena query_arena;
+
     LONG outstanding_submissions_count;
 
     struct d3d12_command_list *current_command_list;
@@ -2023,6 +2360,7 @@ struct d3d12_bundle_allocator
     size_t chunks_size;
     size_t chunks_count;
     size_t chunk_offset;
+    size_t chunk_size;
 
     struct d3d12_bundle *current_bundle;
     struct d3d12_device *device;
@@ -2033,12 +2371,27 @@ struct d3d12_bundle_allocator
 HRESULT d3d12_bundle_allocator_create(struct d3d12_device *device,
         struct d3d12_bundle_allocator **allocator);
 
-typedef void (*pfn_d3d12_bundle_command)(d3d12_command_list_iface *command_list, const void *args);
-
+/* Bundles are recorded into a packed stream of commands. Each command starts
+ * with this header, followed by its payload inline. size is the aligned size
+ * of the entire command, so the next command follows immediately. */
 struct d3d12_bundle_command
 {
-    pfn_d3d12_bundle_command proc;
-    struct d3d12_bundle_command *next;
+    uint32_t opcode;
+    uint32_t size;
+};
+
+/* State slots used to fold redundant state commands at record time. */
+enum d3d12_bundle_state_slot
+{
+    VKD3D_BUNDLE_STATE_PIPELINE,
+    VKD3D_BUNDLE_STATE_PRIMITIVE_TOPOLOGY,
+    VKD3D_BUNDLE_STATE_BLEND_FACTOR,
+    VKD3D_BUNDLE_STATE_STENCIL_REF,
+    VKD3D_BUNDLE_STATE_GRAPHICS_ROOT_SIGNATURE,
+    VKD3D_BUNDLE_STATE_COMPUTE_ROOT_SIGNATURE,
+    VKD3D_BUNDLE_STATE_GRAPHICS_ROOT_PARAMETERS,
+    VKD3D_BUNDLE_STATE_COMPUTE_ROOT_PARAMETERS = VKD3D_BUNDLE_STATE_GRAPHICS_ROOT_PARAMETERS + D3D12_MAX_ROOT_COST,
+    VKD3D_BUNDLE_STATE_COUNT = VKD3D_BUNDLE_STATE_COMPUTE_ROOT_PARAMETERS + D3D12_MAX_ROOT_COST,
 };
 
 struct d3d12_bundle
@@ -2053,6 +2406,10 @@ struct d3d12_bundle
     struct d3d12_bundle_command *head;
     struct d3d12_bundle_command *tail;
 
+    /* Last command recorded for each state slot, or NULL if the
+     * state has not been set or was invalidated since. */
+    struct d3d12_bundle_command *state[VKD3D_BUNDLE_STATE_COUNT];
+
     struct vkd3d_private_store private_store;
 };
 
@@ -2208,7 +2565,6 @@ struct d3d12_command_queue
     uint64_t drain_count;
     uint64_t queue_drain_count;
 
-    struct vkd3d_fence_worker fence_worker;
     struct vkd3d_private_store private_store;
 
 #ifdef VKD3D_BUILD_STANDALONE_D3D12
@@ -2227,6 +2583,11 @@ struct d3d12_command_signature
     LONG refcount;
 
     D3D12_COMMAND_SIGNATURE_DESC desc;
+    /* Byte offset of the draw or dispatch arguments within each command. */
+    uint32_t argument_offset;
+    /* Number of bytes each command reads from the argument buffer. */
+    uint32_t command_size;
+    bool has_state_arguments;
 
     struct d3d12_device *device;
 
@@ -2646,6 +3007,51 @@ HRESULT vkd3d_predicate_ops_init(struct vkd3d_predicate_ops *meta_predicate_ops,
 void vkd3d_predicate_ops_cleanup(struct vkd3d_predicate_ops *meta_predicate_ops,
         struct d3d12_device *device);
 
+struct vkd3d_execute_indirect_args
+{
+    VkDeviceAddress src_arg_va;
+    VkDeviceAddress dst_arg_va;
+    VkDeviceAddress count_va;
+    VkDeviceAddress predicate_va;
+    uint32_t src_arg_stride;
+    uint32_t max_command_count;
+    uint32_t has_count;
+    uint32_t has_predicate;
+};
+
+enum vkd3d_execute_indirect_type
+{
+    VKD3D_EXECUTE_INDIRECT_DRAW,
+    VKD3D_EXECUTE_INDIRECT_DRAW_INDEXED,
+    VKD3D_EXECUTE_INDIRECT_DISPATCH,
+    VKD3D_EXECUTE_INDIRECT_COUNT
+};
+
+struct vkd3d_execute_indirect_info
+{
+    VkPipelineLayout vk_pipeline_layout;
+    VkPipeline vk_pipeline;
+    uint32_t command_size;
+};
+
+struct vkd3d_execute_indirect_ops
+{
+    VkPipelineLayout vk_pipeline_layout;
+    VkPipeline vk_pipelines[VKD3D_EXECUTE_INDIRECT_COUNT];
+    uint32_t command_sizes[VKD3D_EXECUTE_INDIRECT_COUNT];
+};
+
+HRESULT vkd3d_execute_indirect_ops_init(struct vkd3d_execute_indirect_ops *meta_indirect_ops,
+        struct d3d12_device *device);
+void vkd3d_execute_indirect_ops_cleanup(struct vkd3d_execute_indirect_ops *meta_indirect_ops,
+        struct d3d12_device *device);
+
+static inline VkExtent3D vkd3d_meta_get_execute_indirect_workgroup_size(void)
+{
+    VkExtent3D result = { 64, 1, 1 };
+    return result;
+}
+
 struct vkd3d_meta_ops_common
 {
     VkShaderModule vk_module_fullscreen_vs;
@@ -2661,6 +3067,7 @@ struct vkd3d_meta_ops
     struct vkd3d_swapchain_ops swapchain;
     struct vkd3d_query_ops query;
     struct vkd3d_predicate_ops predicate;
+    struct vkd3d_execute_indirect_ops execute_indirect;
 };
 
 HRESULT vkd3d_meta_ops_init(struct vkd3d_meta_ops *meta_ops, struct d3d12_device *device);
@@ -2692,6 +3099,8 @@ bool vkd3d_meta_get_query_gather_pipeline(struct vkd3d_meta_ops *meta_ops,
 
 void vkd3d_meta_get_predicate_pipeline(struct vkd3d_meta_ops *meta_ops,
         enum vkd3d_predicate_command_type command_type, struct vkd3d_predicate_command_info *info);
+void vkd3d_meta_get_execute_indirect_pipeline(struct vkd3d_meta_ops *meta_ops,
+        enum vkd3d_execute_indirect_type type, struct vkd3d_execute_indirect_info *info);
 
 enum vkd3d_time_domain_flag
 {
@@ -2833,6 +3242,13 @@ struct d3d12_device
 
     pthread_mutex_t mutex;
     struct vkd3d_render_pass_cache render_pass_cache;
+    struct vkd3d_framebuffer_cache framebuffer_cache;
+    struct vkd3d_root_signature_cache root_signature_cache;
+    struct vkd3d_pipeline_variant_worker pipeline_variant_worker;
+    struct vkd3d_fence_worker fence_worker;
+    struct vkd3d_copy_workers copy_workers;
+    /* Maximum number of cached views per resource, 0 if unbounded. */
+    uint32_t view_map_limit;
 
     VkPhysicalDeviceMemoryProperties memory_properties;
 
@@ -2882,6 +3298,7 @@ struct d3d12_device
 #endif
     VkPipelineCache global_pipeline_cache;
     uint64_t shader_interface_key;
+    struct vkd3d_shader_disk_cache disk_shader_cache;
 };
 
 HRESULT d3d12_device_create(struct vkd3d_instance *instance,
@@ -3051,10 +3468,11 @@ struct d3d12_state_object
     D3D12_STATE_OBJECT_FLAGS flags;
     struct d3d12_device *device;
 
-    /* Could potentially be a hashmap. */
     struct d3d12_state_object_identifier *exports;
     size_t exports_size;
     size_t exports_count;
+    /* Maps both mangled and plain export names to an index in exports. */
+    struct hash_map export_map;
 
     struct vkd3d_shader_library_entry_point *entry_points;
     size_t entry_points_count;
@@ -3138,9 +3556,10 @@ static inline bool vkd3d_format_is_compressed(const struct vkd3d_format *format)
     return format->block_byte_count != 1;
 }
 
-void vkd3d_format_copy_data(const struct vkd3d_format *format, const uint8_t *src,
-        unsigned int src_row_pitch, unsigned int src_slice_pitch, uint8_t *dst, unsigned int dst_row_pitch,
-        unsigned int dst_slice_pitch, unsigned int w, unsigned int h, unsigned int d);
+void vkd3d_format_init_copy_rows(const struct vkd3d_format *format, struct vkd3d_memcpy_rows *copy,
+        const uint8_t *src, size_t src_row_pitch, size_t src_slice_pitch,
+        uint8_t *dst, size_t dst_row_pitch, size_t dst_slice_pitch,
+        unsigned int w, unsigned int h, unsigned int d);
 
 const struct vkd3d_format *vkd3d_get_format(const struct d3d12_device *device,
         DXGI_FORMAT dxgi_format, bool depth_stencil);
@@ -41,6 +41,7 @@ enum vkd3d_meta_copy_mode
 #include <cs_clear_uav_image_2d_uint.h>
 #include <cs_clear_uav_image_3d_float.h>
 #include <cs_clear_uav_image_3d_uint.h>
+#include <cs_execute_indirect_expand.h>
 #include <cs_predicate_command.h>
 #include <cs_resolve_binary_queries.h>
 #include <cs_resolve_predicate.h>
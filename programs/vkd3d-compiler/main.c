@@ -18,14 +18,39 @@
 
 #define VKD3D_DBG_CHANNEL VKD3D_DBG_CHANNEL_API
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 #include "vkd3d_common.h"
 #include "vkd3d_shader.h"
+#include "vkd3d_threads.h"
+
+#define MAX_COMPILE_THREADS 64
+
+static uint64_t get_time_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER li, lf;
+    QueryPerformanceCounter(&li);
+    QueryPerformanceFrequency(&lf);
+    return (li.QuadPart / lf.QuadPart) * 1000000000ull +
+            ((li.QuadPart % lf.QuadPart) * 1000000000ull) / lf.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
 
 static bool read_shader(struct vkd3d_shader_code *shader, const char *filename)
 {
@@ -102,7 +127,11 @@ static void print_usage(const char *program_name)
     fprintf(stderr, "usage: %s", program_name);
     for (i = 0; i < ARRAY_SIZE(compiler_options); ++i)
         fprintf(stderr, " [%s]", compiler_options[i].name);
-    fprintf(stderr, " [-o <out_spirv_filename>] <dxbc_filename>\n");
+    fprintf(stderr, " [--time <iterations>] [--dxil-library] [--threads <count>]"
+            " [-o <out_spirv_filename>] <dxbc_filename>\n");
+    fprintf(stderr, "With --time, <dxbc_filename> may be a directory of DXBC blobs.\n");
+    fprintf(stderr, "With --dxil-library, every export of a DXIL library is compiled to SPIR-V "
+            "on up to <count> threads and timed, without any GPU involvement.\n");
 }
 
 struct options
@@ -110,6 +139,9 @@ struct options
     const char *filename;
     const char *output_filename;
     unsigned int compiler_options;
+    unsigned int time_iterations;
+    unsigned int thread_count;
+    bool dxil_library;
 };
 
 static bool parse_command_line(int argc, char **argv, struct options *options)
@@ -121,6 +153,7 @@ static bool parse_command_line(int argc, char **argv, struct options *options)
         return false;
 
     memset(options, 0, sizeof(*options));
+    options->thread_count = 1;
 
     for (i = 1; i < argc - 1; ++i)
     {
@@ -132,6 +165,31 @@ static bool parse_command_line(int argc, char **argv, struct options *options)
             continue;
         }
 
+        if (!strcmp(argv[i], "--time"))
+        {
+            if (i + 1 >= argc - 1)
+                return false;
+            if (!(options->time_iterations = strtoul(argv[++i], NULL, 0)))
+                return false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--dxil-library"))
+        {
+            options->dxil_library = true;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--threads"))
+        {
+            if (i + 1 >= argc - 1)
+                return false;
+            options->thread_count = strtoul(argv[++i], NULL, 0);
+            if (!options->thread_count || options->thread_count > MAX_COMPILE_THREADS)
+                return false;
+            continue;
+        }
+
         for (j = 0; j < ARRAY_SIZE(compiler_options); ++j)
         {
             if (!strcmp(argv[i], compiler_options[j].name))
@@ -148,11 +206,203 @@ static bool parse_command_line(int argc, char **argv, struct options *options)
     return true;
 }
 
+static HRESULT time_shader(const struct vkd3d_shader_code *dxbc, const struct options *options, uint64_t *total_ns)
+{
+    struct vkd3d_shader_code spirv;
+    uint64_t start_ns;
+    unsigned int i;
+    HRESULT hr;
+
+    /* Measure the full DXBC -> SPIR-V path, i.e. decode, scan and compile. */
+    for (i = 0; i < options->time_iterations; ++i)
+    {
+        start_ns = get_time_ns();
+        hr = vkd3d_shader_compile_dxbc(dxbc, &spirv, options->compiler_options, NULL, NULL);
+        *total_ns += get_time_ns() - start_ns;
+
+        if (FAILED(hr))
+            return hr;
+        vkd3d_shader_free_shader_code(&spirv);
+    }
+
+    return S_OK;
+}
+
+static int time_directory(const char *path, const struct options *options)
+{
+    unsigned int shader_count = 0, failure_count = 0;
+    struct vkd3d_shader_code dxbc;
+    uint64_t total_ns = 0;
+    char filename[4096];
+    struct dirent *e;
+    struct stat st;
+    DIR *dir;
+
+    if (!(dir = opendir(path)))
+    {
+        fprintf(stderr, "Cannot open directory: '%s'.\n", path);
+        return 1;
+    }
+
+    while ((e = readdir(dir)))
+    {
+        snprintf(filename, sizeof(filename), "%s/%s", path, e->d_name);
+        if (stat(filename, &st) == -1 || !S_ISREG(st.st_mode))
+            continue;
+
+        if (!read_shader(&dxbc, filename))
+            continue;
+
+        if (SUCCEEDED(time_shader(&dxbc, options, &total_ns)))
+            shader_count++;
+        else
+            failure_count++;
+
+        vkd3d_shader_free_shader_code(&dxbc);
+    }
+
+    closedir(dir);
+
+    if (shader_count)
+    {
+        fprintf(stderr, "Compiled %u shaders %u times, %.3f us per compile, %.3f ms total.\n",
+                shader_count, options->time_iterations,
+                (double)total_ns / ((uint64_t)shader_count * options->time_iterations * 1000.0),
+                (double)total_ns / 1000000.0);
+    }
+    if (failure_count)
+        fprintf(stderr, "Failed to compile %u shaders.\n", failure_count);
+
+    return failure_count ? 1 : 0;
+}
+
+struct library_compile_context
+{
+    const struct vkd3d_shader_code *dxil;
+    const struct vkd3d_shader_library_entry_point *entry_points;
+    size_t entry_point_count;
+    size_t next_entry_point;
+    unsigned int failure_count;
+    pthread_mutex_t lock;
+};
+
+static void *library_compile_main(void *userdata)
+{
+    struct vkd3d_shader_interface_local_info shader_interface_local_info;
+    struct vkd3d_shader_interface_info shader_interface_info;
+    struct library_compile_context *context = userdata;
+    struct vkd3d_shader_compile_arguments compile_args;
+    struct vkd3d_shader_code spirv;
+    size_t index;
+    int ret;
+
+    /* Compile against an empty interface, we only care about the CPU cost of translation. */
+    memset(&shader_interface_info, 0, sizeof(shader_interface_info));
+    memset(&shader_interface_local_info, 0, sizeof(shader_interface_local_info));
+    memset(&compile_args, 0, sizeof(compile_args));
+    compile_args.target = VKD3D_SHADER_TARGET_SPIRV_VULKAN_1_0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&context->lock);
+        index = context->next_entry_point++;
+        pthread_mutex_unlock(&context->lock);
+
+        if (index >= context->entry_point_count)
+            break;
+
+        ret = vkd3d_shader_compile_dxil_export(context->dxil, context->entry_points[index].real_entry_point,
+                &spirv, &shader_interface_info, &shader_interface_local_info, &compile_args);
+
+        if (ret == VKD3D_OK)
+            vkd3d_shader_free_shader_code(&spirv);
+        else
+        {
+            fprintf(stderr, "Failed to compile export '%s', ret %d.\n",
+                    context->entry_points[index].real_entry_point, ret);
+            pthread_mutex_lock(&context->lock);
+            context->failure_count++;
+            pthread_mutex_unlock(&context->lock);
+        }
+    }
+
+    return NULL;
+}
+
+static int compile_dxil_library(const struct vkd3d_shader_code *dxil, const struct options *options)
+{
+    struct vkd3d_shader_library_entry_point *entry_points = NULL;
+    size_t entry_point_size = 0, entry_point_count = 0;
+    struct library_compile_context context;
+    pthread_t threads[MAX_COMPILE_THREADS];
+    unsigned int iterations, i, j;
+    D3D12_DXIL_LIBRARY_DESC desc;
+    uint64_t start_ns, total_ns;
+
+    /* With no explicit exports, every export in the library is enumerated. */
+    memset(&desc, 0, sizeof(desc));
+    desc.DXILLibrary.pShaderBytecode = dxil->code;
+    desc.DXILLibrary.BytecodeLength = dxil->size;
+
+    if (vkd3d_shader_dxil_append_library_entry_points(&desc, 0,
+            &entry_points, &entry_point_size, &entry_point_count) != VKD3D_OK)
+    {
+        fprintf(stderr, "Failed to parse DXIL library.\n");
+        return 1;
+    }
+
+    memset(&context, 0, sizeof(context));
+    context.dxil = dxil;
+    context.entry_points = entry_points;
+    context.entry_point_count = entry_point_count;
+    pthread_mutex_init(&context.lock, NULL);
+
+    iterations = max(options->time_iterations, 1u);
+    total_ns = 0;
+
+    for (i = 0; i < iterations; ++i)
+    {
+        context.next_entry_point = 0;
+        start_ns = get_time_ns();
+
+        for (j = 0; j < options->thread_count; ++j)
+        {
+            if (pthread_create(&threads[j], NULL, library_compile_main, &context))
+            {
+                fprintf(stderr, "Failed to create thread.\n");
+                break;
+            }
+        }
+
+        /* If no thread could be created, compile on the main thread instead. */
+        if (!j)
+            library_compile_main(&context);
+
+        while (j)
+            pthread_join(threads[--j], NULL);
+
+        total_ns += get_time_ns() - start_ns;
+    }
+
+    fprintf(stderr, "Compiled %zu exports on %u threads %u times, %.3f ms per library.\n",
+            entry_point_count, options->thread_count, iterations,
+            (double)total_ns / (iterations * 1000000.0));
+    if (context.failure_count)
+        fprintf(stderr, "Failed to compile %u exports.\n", context.failure_count);
+
+    pthread_mutex_destroy(&context.lock);
+    vkd3d_shader_dxil_free_library_entry_points(entry_points, entry_point_count);
+    return context.failure_count ? 1 : 0;
+}
+
 int main(int argc, char **argv)
 {
     struct vkd3d_shader_code dxbc, spirv;
     struct options options;
+    uint64_t total_ns;
+    struct stat st;
     HRESULT hr;
+    int ret;
 
     if (!parse_command_line(argc, argv, &options))
     {
@@ -160,12 +410,32 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    if (options.time_iterations && !stat(options.filename, &st) && S_ISDIR(st.st_mode))
+        return time_directory(options.filename, &options);
+
     if (!read_shader(&dxbc, options.filename))
     {
         fprintf(stderr, "Failed to read DXBC shader.\n");
         return 1;
     }
 
+    if (options.dxil_library)
+    {
+        ret = compile_dxil_library(&dxbc, &options);
+        vkd3d_shader_free_shader_code(&dxbc);
+        return ret;
+    }
+
+    if (options.time_iterations)
+    {
+        total_ns = 0;
+        if (SUCCEEDED(time_shader(&dxbc, &options, &total_ns)))
+        {
+            fprintf(stderr, "Compiled %u times, %.3f us per compile.\n",
+                    options.time_iterations, (double)total_ns / (options.time_iterations * 1000.0));
+        }
+    }
+
     hr = vkd3d_shader_compile_dxbc(&dxbc, &spirv, options.compiler_options, NULL, NULL);
     vkd3d_shader_free_shader_code(&dxbc);
     if (FAILED(hr))
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* CPU-only benchmark for the row copy paths used by WriteToSubresource and
+ * ReadFromSubresource. Does not require a device. */
+
+#include "performance_utils.h"
+
+struct copy_format
+{
+    const char *name;
+    unsigned int block_width;
+    unsigned int block_height;
+    unsigned int block_size;
+};
+
+static const struct copy_format copy_formats[] =
+{
+    {"R8G8B8A8",      1, 1,  4},
+    {"R16G16B16A16F", 1, 1,  8},
+    {"BC1",           4, 4,  8},
+    {"BC7",           4, 4, 16},
+};
+
+struct copy_extent
+{
+    unsigned int width;
+    unsigned int height;
+    unsigned int depth;
+};
+
+static const struct copy_extent copy_extents[] =
+{
+    {1024, 1024,   1},
+    {4096, 4096,   1},
+    { 256,  256, 256},
+};
+
+static size_t align_size(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static void copy_rows_reference(const struct vkd3d_memcpy_rows *copy)
+{
+    unsigned int slice, row;
+
+    for (slice = 0; slice < copy->slice_count; slice++)
+    {
+        for (row = 0; row < copy->row_count; row++)
+        {
+            memcpy(copy->dst + slice * copy->dst_slice_pitch + row * copy->dst_row_pitch,
+                    copy->src + slice * copy->src_slice_pitch + row * copy->src_row_pitch,
+                    copy->row_size);
+        }
+    }
+}
+
+static bool compare_rows(const struct vkd3d_memcpy_rows *copy)
+{
+    unsigned int slice, row;
+
+    for (slice = 0; slice < copy->slice_count; slice++)
+    {
+        for (row = 0; row < copy->row_count; row++)
+        {
+            if (memcmp(copy->dst + slice * copy->dst_slice_pitch + row * copy->dst_row_pitch,
+                    copy->src + slice * copy->src_slice_pitch + row * copy->src_row_pitch,
+                    copy->row_size))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+enum copy_mode
+{
+    COPY_MODE_REFERENCE,
+    COPY_MODE_ROWS,
+    COPY_MODE_ROWS_NON_TEMPORAL,
+    COPY_MODE_COUNT,
+};
+
+static const char * const copy_mode_names[COPY_MODE_COUNT] =
+{
+    "per-row memcpy",
+    "vkd3d_memcpy_rows",
+    "vkd3d_memcpy_rows (non-temporal)",
+};
+
+static double run_copy(struct vkd3d_memcpy_rows *copy, enum copy_mode mode, unsigned int iterations)
+{
+    double start_time, end_time;
+    unsigned int i;
+
+    copy->non_temporal = mode == COPY_MODE_ROWS_NON_TEMPORAL;
+
+    start_time = get_time();
+    for (i = 0; i < iterations; i++)
+    {
+        if (mode == COPY_MODE_REFERENCE)
+            copy_rows_reference(copy);
+        else
+            vkd3d_memcpy_rows(copy, 0, vkd3d_memcpy_rows_get_total_row_count(copy));
+    }
+    end_time = get_time();
+
+    return end_time - start_time;
+}
+
+static bool run_benchmark(const struct copy_format *format, const struct copy_extent *extent, size_t pitch_alignment)
+{
+    struct vkd3d_memcpy_rows copy;
+    size_t src_size, dst_size;
+    unsigned int iterations;
+    uint8_t *src, *dst;
+    double total_size;
+    enum copy_mode mode;
+    bool success = true;
+    double time;
+    size_t i;
+
+    memset(&copy, 0, sizeof(copy));
+    copy.row_size = (size_t)((extent->width + format->block_width - 1) / format->block_width) * format->block_size;
+    copy.row_count = (extent->height + format->block_height - 1) / format->block_height;
+    copy.slice_count = extent->depth;
+
+    /* Source is the application's tightly packed data, the destination is the mapped linear image. */
+    copy.src_row_pitch = copy.row_size;
+    copy.src_slice_pitch = copy.src_row_pitch * copy.row_count;
+    copy.dst_row_pitch = align_size(copy.row_size, pitch_alignment);
+    copy.dst_slice_pitch = copy.dst_row_pitch * copy.row_count;
+
+    src_size = copy.src_slice_pitch * copy.slice_count;
+    dst_size = copy.dst_slice_pitch * copy.slice_count;
+
+    if (!(src = vkd3d_malloc_aligned(src_size, 64)) || !(dst = vkd3d_malloc_aligned(dst_size, 64)))
+    {
+        fprintf(stderr, "Failed to allocate %zu + %zu bytes.\n", src_size, dst_size);
+        vkd3d_free_aligned(src);
+        return false;
+    }
+
+    for (i = 0; i < src_size; i++)
+        src[i] = (uint8_t)(i * 7 + (i >> 12));
+    memset(dst, 0, dst_size);
+
+    copy.src = src;
+    copy.dst = dst;
+
+    total_size = (double)copy.row_size * vkd3d_memcpy_rows_get_total_row_count(&copy);
+    iterations = max(1u, (unsigned int)((1u << 30) / total_size));
+
+    printf("%s %ux%ux%u, dst pitch alignment %zu:\n", format->name,
+            extent->width, extent->height, extent->depth, pitch_alignment);
+
+    for (mode = 0; mode < COPY_MODE_COUNT; mode++)
+    {
+        memset(dst, 0, dst_size);
+        time = run_copy(&copy, mode, iterations);
+
+        if (!compare_rows(&copy))
+        {
+            fprintf(stderr, "  %s: mismatch.\n", copy_mode_names[mode]);
+            success = false;
+        }
+
+        printf("  %-34s %8.3f ms/copy, %8.2f GiB/s\n", copy_mode_names[mode],
+                1e3 * time / iterations, total_size * iterations / (time * (1u << 30)));
+    }
+
+    vkd3d_free_aligned(dst);
+    vkd3d_free_aligned(src);
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t pitch_alignments[] = {1, 256};
+    unsigned int i, j, k;
+    bool success = true;
+
+    for (i = 0; i < ARRAY_SIZE(copy_formats); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(copy_extents); j++)
+        {
+            for (k = 0; k < ARRAY_SIZE(pitch_alignments); k++)
+                success &= run_benchmark(&copy_formats[i], &copy_extents[j], pitch_alignments[k]);
+        }
+    }
+
+    return success ? 0 : 1;
+}
@@ -1164,6 +1164,128 @@ void test_bundle_state_inheritance(void)
     destroy_test_context(&context);
 }
 
+void test_bundle_redundant_state(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    ID3D12GraphicsCommandList *command_list, *bundle;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc;
+    ID3D12CommandAllocator *bundle_allocator;
+    ID3D12PipelineState *masked_pso;
+    struct test_context context;
+    ID3D12CommandQueue *queue;
+    double start_time, elapsed;
+    ID3D12Device *device;
+    unsigned int i;
+    HRESULT hr;
+
+    if (!init_test_context(&context, NULL))
+        return;
+    device = context.device;
+    command_list = context.list;
+    queue = context.queue;
+
+    init_pipeline_state_desc(&pso_desc, context.root_signature,
+            context.render_target_desc.Format, NULL, NULL, NULL);
+    pso_desc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0;
+    hr = ID3D12Device_CreateGraphicsPipelineState(device, &pso_desc,
+            &IID_ID3D12PipelineState, (void **)&masked_pso);
+    ok(SUCCEEDED(hr), "Failed to create pipeline state, hr %#x.\n", hr);
+
+    hr = ID3D12Device_CreateCommandAllocator(device, D3D12_COMMAND_LIST_TYPE_BUNDLE,
+            &IID_ID3D12CommandAllocator, (void **)&bundle_allocator);
+    ok(SUCCEEDED(hr), "Failed to create command allocator, hr %#x.\n", hr);
+    hr = ID3D12Device_CreateCommandList(device, 0, D3D12_COMMAND_LIST_TYPE_BUNDLE,
+            bundle_allocator, NULL, &IID_ID3D12GraphicsCommandList, (void **)&bundle);
+    ok(SUCCEEDED(hr), "Failed to create command list, hr %#x.\n", hr);
+
+    /* Only the last of several consecutive state changes must take effect. */
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(bundle, context.root_signature);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(bundle, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(bundle, masked_pso);
+    ID3D12GraphicsCommandList_SetPipelineState(bundle, context.pipeline_state);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(bundle, D3D_PRIMITIVE_TOPOLOGY_POINTLIST);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(bundle, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_DrawInstanced(bundle, 3, 1, 0, 0);
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(SUCCEEDED(hr), "Failed to close bundle, hr %#x.\n", hr);
+
+    ID3D12GraphicsCommandList_ExecuteBundle(command_list, bundle);
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xff00ff00, 0);
+
+    reset_command_list(command_list, context.allocator);
+    reset_command_list(bundle, bundle_allocator);
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(bundle, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(bundle, context.pipeline_state);
+    ID3D12GraphicsCommandList_SetPipelineState(bundle, masked_pso);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(bundle, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_DrawInstanced(bundle, 3, 1, 0, 0);
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(SUCCEEDED(hr), "Failed to close bundle, hr %#x.\n", hr);
+
+    ID3D12GraphicsCommandList_ExecuteBundle(command_list, bundle);
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xffffffff, 0);
+
+    reset_command_list(command_list, context.allocator);
+    reset_command_list(bundle, bundle_allocator);
+
+    /* Redundant state changes between draws must not be dropped incorrectly,
+     * and the bundle must replay correctly across multiple memory chunks. */
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(bundle, context.root_signature);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(bundle, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    for (i = 0; i < 16384; i++)
+    {
+        ID3D12GraphicsCommandList_SetPipelineState(bundle, (i & 1) ? context.pipeline_state : masked_pso);
+        ID3D12GraphicsCommandList_SetPipelineState(bundle, (i & 1) ? context.pipeline_state : masked_pso);
+        ID3D12GraphicsCommandList_DrawInstanced(bundle, 3, 1, 0, 0);
+    }
+
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(SUCCEEDED(hr), "Failed to close bundle, hr %#x.\n", hr);
+
+    /* Only traced, so that the cost of replay can be compared across changes and drivers. */
+    start_time = vkd3d_get_time();
+    ID3D12GraphicsCommandList_ExecuteBundle(command_list, bundle);
+    elapsed = vkd3d_get_time() - start_time;
+    trace("Replaying a bundle with %u draws took %.3f ms, %.1f ns/draw.\n",
+            i, 1e3 * elapsed, 1e9 * elapsed / i);
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xff00ff00, 0);
+
+    ID3D12PipelineState_Release(masked_pso);
+    ID3D12CommandAllocator_Release(bundle_allocator);
+    ID3D12GraphicsCommandList_Release(bundle);
+    destroy_test_context(&context);
+}
+
 void test_null_vbv(void)
 {
     ID3D12GraphicsCommandList *command_list;
@@ -1451,7 +1573,9 @@ void test_vbv_stride_edge_cases(void)
 
 void test_execute_indirect(void)
 {
-    ID3D12Resource *argument_buffer, *count_buffer, *uav;
+    ID3D12Resource *argument_buffer, *count_buffer, *uav, *multi_dispatch_buffer, *multi_uav;
+    ID3D12Resource *large_dispatch_buffer;
+    D3D12_DISPATCH_ARGUMENTS *large_dispatch_data;
     D3D12_ROOT_SIGNATURE_DESC root_signature_desc;
     ID3D12CommandSignature *command_signature;
     ID3D12GraphicsCommandList *command_list;
@@ -1465,6 +1589,7 @@ void test_execute_indirect(void)
     struct resource_readback rb;
     struct test_context context;
     ID3D12CommandQueue *queue;
+    uint32_t uav_init_data[24];
     ID3D12Resource *vb, *ib;
     unsigned int i;
     D3D12_BOX box;
@@ -1584,6 +1709,12 @@ void test_execute_indirect(void)
         {2, 3, 4},
         {{6, 1, 0, 0, 0}, {6, 1, 0, 4, 0}},
     };
+    static const D3D12_DISPATCH_ARGUMENTS multi_dispatch_data[] =
+    {
+        {2, 1, 1},
+        {1, 1, 2},
+        {2, 3, 1},
+    };
     static const uint32_t count_data[] = {2, 1};
     static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
 
@@ -1689,6 +1820,70 @@ void test_execute_indirect(void)
     }
     release_resource_readback(&rb);
 
+    /* Multiple dispatches, limited by the count buffer. */
+    reset_command_list(command_list, context.allocator);
+
+    memset(uav_init_data, 0xff, sizeof(uav_init_data));
+    multi_uav = create_default_buffer(context.device, sizeof(uav_init_data),
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST);
+    upload_buffer_data(multi_uav, 0, sizeof(uav_init_data), uav_init_data, queue, command_list);
+    reset_command_list(command_list, context.allocator);
+    transition_sub_resource_state(command_list, multi_uav, 0,
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    multi_dispatch_buffer = create_upload_buffer(context.device, sizeof(multi_dispatch_data), multi_dispatch_data);
+
+    ID3D12GraphicsCommandList_SetComputeRootSignature(command_list, root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, pipeline_state);
+    ID3D12GraphicsCommandList_SetComputeRootUnorderedAccessView(command_list,
+            0, ID3D12Resource_GetGPUVirtualAddress(multi_uav));
+    ID3D12GraphicsCommandList_ExecuteIndirect(command_list, command_signature,
+            ARRAY_SIZE(multi_dispatch_data), multi_dispatch_buffer, 0, count_buffer, 0);
+
+    transition_sub_resource_state(command_list, multi_uav, 0,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    get_buffer_readback_with_command_list(multi_uav, DXGI_FORMAT_R32_UINT, &rb, queue, command_list);
+    for (i = 0; i < rb.width; ++i)
+    {
+        unsigned int expected = (i == 0 || i == 1 || i == 6) ? i : 0xffffffff;
+        unsigned int ret = get_readback_uint(&rb, i, 0, 0);
+        ok(ret == expected, "Got unexpected result %#x at index %u.\n", ret, i);
+    }
+    release_resource_readback(&rb);
+
+    /* GPU-driven renderers pass a large upper bound along with the count buffer. */
+    reset_command_list(command_list, context.allocator);
+    transition_sub_resource_state(command_list, multi_uav, 0,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+    upload_buffer_data(multi_uav, 0, sizeof(uav_init_data), uav_init_data, queue, command_list);
+    reset_command_list(command_list, context.allocator);
+    transition_sub_resource_state(command_list, multi_uav, 0,
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    large_dispatch_data = calloc(65536, sizeof(*large_dispatch_data));
+    memcpy(large_dispatch_data, multi_dispatch_data, sizeof(multi_dispatch_data));
+    large_dispatch_buffer = create_upload_buffer(context.device,
+            65536 * sizeof(*large_dispatch_data), large_dispatch_data);
+    free(large_dispatch_data);
+
+    ID3D12GraphicsCommandList_SetComputeRootSignature(command_list, root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, pipeline_state);
+    ID3D12GraphicsCommandList_SetComputeRootUnorderedAccessView(command_list,
+            0, ID3D12Resource_GetGPUVirtualAddress(multi_uav));
+    ID3D12GraphicsCommandList_ExecuteIndirect(command_list, command_signature,
+            65536, large_dispatch_buffer, 0, count_buffer, 0);
+
+    transition_sub_resource_state(command_list, multi_uav, 0,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    get_buffer_readback_with_command_list(multi_uav, DXGI_FORMAT_R32_UINT, &rb, queue, command_list);
+    for (i = 0; i < rb.width; ++i)
+    {
+        unsigned int expected = (i == 0 || i == 1 || i == 6) ? i : 0xffffffff;
+        unsigned int ret = get_readback_uint(&rb, i, 0, 0);
+        ok(ret == expected, "Got unexpected result %#x at index %u.\n", ret, i);
+    }
+    release_resource_readback(&rb);
+
     reset_command_list(command_list, context.allocator);
     transition_resource_state(command_list, context.render_target,
             D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -1747,6 +1942,9 @@ void test_execute_indirect(void)
     ID3D12RootSignature_Release(root_signature);
     ID3D12Resource_Release(ib);
     ID3D12Resource_Release(uav);
+    ID3D12Resource_Release(multi_uav);
+    ID3D12Resource_Release(multi_dispatch_buffer);
+    ID3D12Resource_Release(large_dispatch_buffer);
     ID3D12Resource_Release(vb);
     ID3D12CommandSignature_Release(command_signature);
     ID3D12Resource_Release(argument_buffer);
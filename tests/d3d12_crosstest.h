@@ -130,6 +130,21 @@ static inline void vkd3d_sleep(unsigned int ms)
 }
 #endif
 
+/* Wall clock time in seconds, for tests which trace how long they took. */
+static inline double vkd3d_get_time(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER lc, lf;
+    QueryPerformanceCounter(&lc);
+    QueryPerformanceFrequency(&lf);
+    return (double)lc.QuadPart / (double)lf.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#endif
+}
+
 typedef void (*thread_main_pfn)(void *data);
 
 struct test_thread_data
@@ -837,3 +837,49 @@ void test_multisample_rendering(void)
     destroy_test_context(&context);
 }
 
+
+void test_framebuffer_cache_eviction(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    ID3D12GraphicsCommandList *command_list;
+    struct test_context context;
+    ID3D12CommandQueue *queue;
+    unsigned int i, j;
+
+    if (!init_test_context(&context, NULL))
+        return;
+    command_list = context.list;
+    queue = context.queue;
+
+    /* Framebuffers are cached per device and must be evicted when their views go away.
+     * Replace the render target behind the same RTV descriptor a few times and render
+     * twice per iteration, so that both the creation and the lookup path are exercised. */
+    for (i = 0; i < 4; i++)
+    {
+        if (i)
+        {
+            ID3D12Resource_Release(context.render_target);
+            create_render_target(&context, NULL, &context.render_target, &context.rtv);
+        }
+
+        for (j = 0; j < 2; j++)
+        {
+            ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+            ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+            ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+            ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+            ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+            ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+            ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+        }
+
+        transition_resource_state(command_list, context.render_target,
+                D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+        check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xff00ff00, 0);
+        reset_command_list(command_list, context.allocator);
+    }
+
+    destroy_test_context(&context);
+}
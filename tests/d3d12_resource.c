@@ -2927,6 +2927,83 @@ void test_stress_suballocation_multithread(void)
     destroy_test_context(&context);
 }
 
+void test_stress_suballocation_fragmentation(void)
+{
+#define FRAGMENTATION_TEST_NUM_BUFFERS 1024
+    ID3D12Resource *buffers[FRAGMENTATION_TEST_NUM_BUFFERS] = { NULL };
+    D3D12_GPU_VIRTUAL_ADDRESS va[FRAGMENTATION_TEST_NUM_BUFFERS];
+    UINT sizes[FRAGMENTATION_TEST_NUM_BUFFERS];
+    struct test_context context;
+    unsigned int iter, i, j;
+    bool found_error;
+    UINT *mapped;
+    HRESULT hr;
+
+    if (!init_compute_test_context(&context))
+        return;
+
+    /* Allocate many small buffers with odd sizes, free them in an interleaved
+     * pattern and reallocate, so that chunks get fragmented and free ranges
+     * have to be split and merged. Verify that live buffers never overlap
+     * and that their contents survive the churn. */
+
+    for (iter = 0; iter < 4; iter++)
+    {
+        for (i = 0; i < ARRAY_SIZE(buffers); i++)
+        {
+            if (buffers[i])
+                continue;
+
+            sizes[i] = 4 * (1 + (i * 7919 + iter * 104729) % 16384);
+            buffers[i] = create_upload_buffer(context.device, sizes[i], NULL);
+            ok(!!buffers[i], "Failed to create buffer.\n");
+            va[i] = ID3D12Resource_GetGPUVirtualAddress(buffers[i]);
+
+            hr = ID3D12Resource_Map(buffers[i], 0, NULL, (void **)&mapped);
+            ok(SUCCEEDED(hr), "Failed to map buffer.\n");
+            for (j = 0; j < sizes[i] / 4; j++)
+                mapped[j] = i;
+            ID3D12Resource_Unmap(buffers[i], 0, NULL);
+        }
+
+        for (i = 0; i < ARRAY_SIZE(buffers); i++)
+        {
+            for (j = i + 1; j < ARRAY_SIZE(buffers); j++)
+            {
+                if (va[i] < va[j] + sizes[j] && va[j] < va[i] + sizes[i])
+                {
+                    ok(false, "Buffer %u overlaps buffer %u.\n", i, j);
+                    break;
+                }
+            }
+
+            found_error = false;
+            hr = ID3D12Resource_Map(buffers[i], 0, NULL, (void **)&mapped);
+            ok(SUCCEEDED(hr), "Failed to map buffer.\n");
+            for (j = 0; j < sizes[i] / 4 && !found_error; j++)
+                found_error = mapped[j] != i;
+            ID3D12Resource_Unmap(buffers[i], 0, NULL);
+            ok(!found_error, "Buffer %u was corrupted.\n", i);
+        }
+
+        for (i = 0; i < ARRAY_SIZE(buffers); i++)
+        {
+            if ((i + iter) % 3)
+            {
+                ID3D12Resource_Release(buffers[i]);
+                buffers[i] = NULL;
+            }
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(buffers); i++)
+        if (buffers[i])
+            ID3D12Resource_Release(buffers[i]);
+
+    destroy_test_context(&context);
+#undef FRAGMENTATION_TEST_NUM_BUFFERS
+}
+
 void test_placed_image_alignment(void)
 {
     ID3D12Resource *readback_buffers[4096] = { NULL };
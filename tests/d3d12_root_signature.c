@@ -167,6 +167,62 @@ void test_create_root_signature(void)
     ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
 }
 
+void test_root_signature_deduplication(void)
+{
+    ID3D12RootSignature *root_signatures[3];
+    D3D12_ROOT_SIGNATURE_DESC root_signature_desc;
+    D3D12_ROOT_PARAMETER root_parameter;
+    ID3D12Device *device;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    root_parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    root_parameter.Constants.ShaderRegister = 0;
+    root_parameter.Constants.RegisterSpace = 0;
+    root_parameter.Constants.Num32BitValues = 4;
+    root_parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    root_signature_desc.NumParameters = 1;
+    root_signature_desc.pParameters = &root_parameter;
+    root_signature_desc.NumStaticSamplers = 0;
+    root_signature_desc.pStaticSamplers = NULL;
+    root_signature_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+    hr = create_root_signature(device, &root_signature_desc, &root_signatures[0]);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+    hr = create_root_signature(device, &root_signature_desc, &root_signatures[1]);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+    ok(root_signatures[0] == root_signatures[1], "Got different root signatures %p, %p.\n",
+            root_signatures[0], root_signatures[1]);
+
+    root_parameter.Constants.Num32BitValues = 8;
+    hr = create_root_signature(device, &root_signature_desc, &root_signatures[2]);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+    ok(root_signatures[2] != root_signatures[0], "Got the same root signature for a different blob.\n");
+
+    refcount = ID3D12RootSignature_Release(root_signatures[2]);
+    ok(!refcount, "ID3D12RootSignature has %u references left.\n", (unsigned int)refcount);
+    refcount = ID3D12RootSignature_Release(root_signatures[1]);
+    ok(refcount == 1, "Got unexpected refcount %u.\n", (unsigned int)refcount);
+    refcount = ID3D12RootSignature_Release(root_signatures[0]);
+    ok(!refcount, "ID3D12RootSignature has %u references left.\n", (unsigned int)refcount);
+
+    /* Creating the root signature again after the last reference is gone must work. */
+    root_parameter.Constants.Num32BitValues = 4;
+    hr = create_root_signature(device, &root_signature_desc, &root_signatures[0]);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+    refcount = ID3D12RootSignature_Release(root_signatures[0]);
+    ok(!refcount, "ID3D12RootSignature has %u references left.\n", (unsigned int)refcount);
+
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
 void test_root_signature_limits(void)
 {
     D3D12_DESCRIPTOR_RANGE descriptor_ranges[D3D12_MAX_ROOT_COST + 1];
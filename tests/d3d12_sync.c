@@ -1137,6 +1137,200 @@ void test_multithread_fence_wait(void)
     ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
 }
 
+struct multithread_queue_submission_data
+{
+    ID3D12Device *device;
+    ID3D12CommandQueue *queue;
+    ID3D12Fence *fence;
+    unsigned int iteration_count;
+};
+
+static void queue_submission_main(void *untyped_data)
+{
+    struct multithread_queue_submission_data *data = untyped_data;
+    ID3D12GraphicsCommandList *command_list;
+    ID3D12CommandAllocator *allocator;
+    uint64_t completed, last_completed;
+    unsigned int i;
+    HANDLE event;
+    HRESULT hr;
+
+    hr = ID3D12Device_CreateCommandAllocator(data->device, D3D12_COMMAND_LIST_TYPE_DIRECT,
+            &IID_ID3D12CommandAllocator, (void **)&allocator);
+    ok(hr == S_OK, "Failed to create command allocator, hr %#x.\n", hr);
+    hr = ID3D12Device_CreateCommandList(data->device, 0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+            allocator, NULL, &IID_ID3D12GraphicsCommandList, (void **)&command_list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+    hr = ID3D12GraphicsCommandList_Close(command_list);
+    ok(hr == S_OK, "Failed to close command list, hr %#x.\n", hr);
+
+    last_completed = 0;
+
+    for (i = 1; i <= data->iteration_count; i++)
+    {
+        exec_command_list(data->queue, command_list);
+        queue_signal(data->queue, data->fence, i);
+
+        /* Signals on one thread must complete in order, so the fence can never go backwards. */
+        completed = ID3D12Fence_GetCompletedValue(data->fence);
+        ok(completed >= last_completed && completed <= i,
+                "Got completed value %"PRIu64", previous %"PRIu64", last signal %u.\n",
+                completed, last_completed, i);
+        last_completed = completed;
+    }
+
+    event = create_event();
+    ok(event, "Failed to create event.\n");
+    hr = ID3D12Fence_SetEventOnCompletion(data->fence, data->iteration_count, event);
+    ok(hr == S_OK, "Failed to set event on completion, hr %#x.\n", hr);
+    ok(wait_event(event, INFINITE) == WAIT_OBJECT_0, "Failed to wait for fence.\n");
+    destroy_event(event);
+
+    completed = ID3D12Fence_GetCompletedValue(data->fence);
+    ok(completed == data->iteration_count, "Got completed value %"PRIu64", expected %u.\n",
+            completed, data->iteration_count);
+
+    ID3D12GraphicsCommandList_Release(command_list);
+    ID3D12CommandAllocator_Release(allocator);
+}
+
+void test_multithread_queue_submission(void)
+{
+    struct multithread_queue_submission_data thread_data[8];
+    HANDLE threads[ARRAY_SIZE(thread_data)];
+    unsigned int submission_count = 0;
+    double start_time, elapsed;
+    ID3D12CommandQueue *queue;
+    ID3D12Device *device;
+    ULONG refcount;
+    unsigned int i;
+    HRESULT hr;
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    queue = create_command_queue(device, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_QUEUE_PRIORITY_NORMAL);
+
+    for (i = 0; i < ARRAY_SIZE(thread_data); i++)
+    {
+        thread_data[i].device = device;
+        thread_data[i].queue = queue;
+        thread_data[i].iteration_count = 2000;
+        hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE,
+                &IID_ID3D12Fence, (void **)&thread_data[i].fence);
+        ok(hr == S_OK, "Failed to create fence, hr %#x.\n", hr);
+        submission_count += thread_data[i].iteration_count;
+    }
+
+    start_time = vkd3d_get_time();
+
+    for (i = 0; i < ARRAY_SIZE(thread_data); i++)
+    {
+        threads[i] = create_thread(queue_submission_main, &thread_data[i]);
+        ok(threads[i], "Failed to create thread %u.\n", i);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(thread_data); i++)
+        ok(join_thread(threads[i]), "Failed to join thread %u.\n", i);
+
+    /* Every submission is one ExecuteCommandLists and one Signal. Only traced,
+     * since throughput depends too much on the driver to be tested. */
+    elapsed = vkd3d_get_time() - start_time;
+    trace("%u submissions from %u threads took %.3f ms, %.0f submissions/s.\n",
+            submission_count, (unsigned int)ARRAY_SIZE(thread_data), 1e3 * elapsed,
+            elapsed > 0.0 ? submission_count / elapsed : 0.0);
+
+    for (i = 0; i < ARRAY_SIZE(thread_data); i++)
+        ID3D12Fence_Release(thread_data[i].fence);
+
+    ID3D12CommandQueue_Release(queue);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
+void test_multi_queue_fence_completion(void)
+{
+    static const D3D12_COMMAND_LIST_TYPE queue_types[] =
+    {
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        D3D12_COMMAND_LIST_TYPE_COMPUTE,
+        D3D12_COMMAND_LIST_TYPE_COPY,
+    };
+    ID3D12CommandQueue *queues[ARRAY_SIZE(queue_types)];
+    ID3D12Fence *fences[ARRAY_SIZE(queue_types)];
+    ID3D12Fence *blocking_fence;
+    unsigned int i, j, ret;
+    ID3D12Device *device;
+    uint64_t value;
+    HANDLE event;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    event = create_event();
+    ok(event, "Failed to create event.\n");
+
+    hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE, &IID_ID3D12Fence, (void **)&blocking_fence);
+    ok(hr == S_OK, "Failed to create fence, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(queue_types); i++)
+    {
+        queues[i] = create_command_queue(device, queue_types[i], D3D12_COMMAND_QUEUE_PRIORITY_NORMAL);
+        hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE, &IID_ID3D12Fence, (void **)&fences[i]);
+        ok(hr == S_OK, "Failed to create fence, hr %#x.\n", hr);
+    }
+
+    /* The first queue is stalled on a fence only the CPU will signal. Completions
+     * on the other queues must not be held up behind it. */
+    queue_wait(queues[0], blocking_fence, 1);
+    queue_signal(queues[0], fences[0], 1);
+
+    for (i = 1; i < ARRAY_SIZE(queue_types); i++)
+    {
+        for (j = 1; j <= 16; j++)
+            queue_signal(queues[i], fences[i], j);
+
+        hr = ID3D12Fence_SetEventOnCompletion(fences[i], 16, event);
+        ok(hr == S_OK, "Failed to set event on completion, hr %#x.\n", hr);
+        ret = wait_event(event, 5000);
+        ok(ret == WAIT_OBJECT_0, "Got unexpected return value %#x for queue %u.\n", ret, i);
+        value = ID3D12Fence_GetCompletedValue(fences[i]);
+        ok(value == 16, "Got unexpected value %"PRIu64" for queue %u.\n", value, i);
+    }
+
+    value = ID3D12Fence_GetCompletedValue(fences[0]);
+    ok(value == 0, "Got unexpected value %"PRIu64".\n", value);
+
+    hr = ID3D12Fence_Signal(blocking_fence, 1);
+    ok(hr == S_OK, "Failed to signal fence, hr %#x.\n", hr);
+
+    hr = ID3D12Fence_SetEventOnCompletion(fences[0], 1, event);
+    ok(hr == S_OK, "Failed to set event on completion, hr %#x.\n", hr);
+    ret = wait_event(event, 5000);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected return value %#x.\n", ret);
+    value = ID3D12Fence_GetCompletedValue(fences[0]);
+    ok(value == 1, "Got unexpected value %"PRIu64".\n", value);
+
+    for (i = 0; i < ARRAY_SIZE(queue_types); i++)
+    {
+        ID3D12Fence_Release(fences[i]);
+        ID3D12CommandQueue_Release(queues[i]);
+    }
+
+    ID3D12Fence_Release(blocking_fence);
+    destroy_event(event);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
 void test_create_fence(void)
 {
     ID3D12Device *device, *tmp_device;
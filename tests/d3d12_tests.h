@@ -37,6 +37,7 @@ decl_test(test_create_descriptor_heap);
 decl_test(test_create_sampler);
 decl_test(test_create_unordered_access_view);
 decl_test(test_create_root_signature);
+decl_test(test_root_signature_deduplication);
 decl_test(test_root_signature_limits);
 decl_test(test_create_compute_pipeline_state);
 decl_test(test_create_graphics_pipeline_state);
@@ -48,6 +49,8 @@ decl_test(test_reset_command_allocator);
 decl_test(test_cpu_signal_fence);
 decl_test(test_gpu_signal_fence);
 decl_test(test_multithread_fence_wait);
+decl_test(test_multithread_queue_submission);
+decl_test(test_multi_queue_fence_completion);
 decl_test(test_fence_values);
 decl_test(test_clear_depth_stencil_view);
 decl_test(test_clear_render_target_view);
@@ -73,6 +76,7 @@ decl_test(test_device_removed_reason);
 decl_test(test_map_resource);
 decl_test(test_map_placed_resources);
 decl_test(test_bundle_state_inheritance);
+decl_test(test_bundle_redundant_state);
 decl_test(test_shader_instructions);
 decl_test(test_shader_instructions_dxil);
 decl_test(test_compute_shader_instructions);
@@ -102,6 +106,8 @@ decl_test(test_update_compute_descriptor_tables);
 decl_test(test_update_descriptor_tables_after_root_signature_change);
 decl_test(test_copy_descriptors);
 decl_test(test_copy_descriptors_range_sizes);
+decl_test(test_copy_descriptors_same_destination);
+decl_test(test_copy_descriptors_same_heap_chain);
 decl_test(test_copy_rtv_descriptors);
 decl_test(test_descriptors_visibility);
 decl_test(test_create_null_descriptors);
@@ -230,6 +236,7 @@ decl_test(test_stencil_export_dxil);
 decl_test(test_raytracing);
 decl_test(test_get_resource_tiling);
 decl_test(test_update_tile_mappings);
+decl_test(test_update_tile_mappings_batched);
 decl_test(test_sampler_border_color);
 decl_test(test_copy_tiles);
 decl_test(test_buffer_feedback_instructions_sm51);
@@ -257,6 +264,7 @@ decl_test(test_vrs_image);
 decl_test(test_stress_suballocation);
 decl_test(test_stress_suballocation_multithread);
 decl_test(test_stress_suballocation_rebar);
+decl_test(test_stress_suballocation_fragmentation);
 decl_test(test_stress_fallback_render_target_allocation_device);
 decl_test(test_placed_image_alignment);
 decl_test(test_root_parameter_preservation);
@@ -291,6 +299,7 @@ decl_test(test_read_subresource_rt);
 decl_test(test_integer_blending_pipeline_state);
 decl_test(test_discard_resource_uav);
 decl_test(test_unbound_rtv_rendering);
+decl_test(test_framebuffer_cache_eviction);
 decl_test(test_raytracing_local_rs_static_sampler);
 decl_test(test_rayquery);
 decl_test(test_typed_srv_uav_cast);
@@ -74,15 +74,59 @@ static void copy_descriptor_heap(ID3D12Device *device, ID3D12DescriptorHeap *gpu
             D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 }
 
+static void copy_descriptor_heap_single_ranges(ID3D12Device *device, ID3D12DescriptorHeap *gpu_heap,
+        ID3D12DescriptorHeap *cpu_heap, unsigned int count)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE *dst_handles, *src_handles;
+    D3D12_CPU_DESCRIPTOR_HANDLE dst_start, src_start;
+    UINT stride, i;
+
+    dst_handles = malloc(count * sizeof(*dst_handles));
+    src_handles = malloc(count * sizeof(*src_handles));
+
+    stride = ID3D12Device_GetDescriptorHandleIncrementSize(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    dst_start = ID3D12DescriptorHeap_GetCPUDescriptorHandleForHeapStart(gpu_heap);
+    src_start = ID3D12DescriptorHeap_GetCPUDescriptorHandleForHeapStart(cpu_heap);
+
+    for (i = 0; i < count; i++)
+    {
+        dst_handles[i].ptr = dst_start.ptr + i * stride;
+        src_handles[i].ptr = src_start.ptr + i * stride;
+    }
+
+    /* NULL range sizes means every range holds a single descriptor. */
+    ID3D12Device_CopyDescriptors(device, count, dst_handles, NULL, count, src_handles, NULL,
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    free(dst_handles);
+    free(src_handles);
+}
+
 static void zero_descriptor_heap(ID3D12Device *device, ID3D12DescriptorHeap *heap,
         ID3D12Resource *resource, unsigned int count)
 {
     fill_descriptor_heap_srv(device, heap, resource, NULL, count);
 }
 
+static void dirty_descriptor_heap_srv(ID3D12Device *device, ID3D12DescriptorHeap *heap,
+        ID3D12Resource *resource, const D3D12_SHADER_RESOURCE_VIEW_DESC *desc,
+        unsigned int count, unsigned int interval)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle;
+    UINT stride, i;
+
+    stride = ID3D12Device_GetDescriptorHandleIncrementSize(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    cpu_handle = ID3D12DescriptorHeap_GetCPUDescriptorHandleForHeapStart(heap);
+    for (i = 0; i < count; i += interval)
+    {
+        ID3D12Device_CreateShaderResourceView(device, resource, desc, cpu_handle);
+        cpu_handle.ptr += stride * interval;
+    }
+}
+
 static void do_benchmark_run(ID3D12Device *device)
 {
-    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc;
+    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc, swizzle_srv_desc;
     D3D12_DESCRIPTOR_HEAP_DESC heap_desc;
     ID3D12DescriptorHeap *gpu_heap;
     ID3D12DescriptorHeap *cpu_heap;
@@ -114,6 +158,9 @@ static void do_benchmark_run(ID3D12Device *device)
     srv_desc.Texture2D.PlaneSlice = 0;
     srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
 
+    swizzle_srv_desc = srv_desc;
+    swizzle_srv_desc.Shader4ComponentMapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 0, 0, 0);
+
     /* Benchmark creation of 1 million SRVs in CPU-only heaps. */
     {
         start_time = get_time();
@@ -178,6 +225,34 @@ static void do_benchmark_run(ID3D12Device *device)
         printf("Copying 1M SRVs to zeroed GPU visible heap took: %.3f ms.\n", 1e3 * (end_time - start_time));
     }
 
+    /* Copy on top of a heap where only a small fraction of descriptors differ,
+     * which is the common case for apps that re-copy entire tables every frame. */
+    {
+        dirty_descriptor_heap_srv(device, cpu_heap, texture, &swizzle_srv_desc, 1000000, 16);
+        start_time = get_time();
+        copy_descriptor_heap(device, gpu_heap, cpu_heap, 1000000);
+        end_time = get_time();
+        printf("Copying 1M SRVs with 1/16 changed took: %.3f ms.\n", 1e3 * (end_time - start_time));
+    }
+
+    /* Same, but with contiguous blocks of changed descriptors. */
+    {
+        fill_descriptor_heap_srv(device, cpu_heap, texture, &swizzle_srv_desc, 1000000 / 16);
+        start_time = get_time();
+        copy_descriptor_heap(device, gpu_heap, cpu_heap, 1000000);
+        end_time = get_time();
+        printf("Copying 1M SRVs with first 1/16 changed took: %.3f ms.\n", 1e3 * (end_time - start_time));
+    }
+
+    /* Copy with one range per descriptor, which apps commonly do when gathering tables. */
+    {
+        zero_descriptor_heap(device, gpu_heap, texture, 1000000);
+        start_time = get_time();
+        copy_descriptor_heap_single_ranges(device, gpu_heap, cpu_heap, 1000000);
+        end_time = get_time();
+        printf("Copying 1M SRVs in single-descriptor ranges took: %.3f ms.\n", 1e3 * (end_time - start_time));
+    }
+
     ID3D12Resource_Release(texture);
     ID3D12DescriptorHeap_Release(cpu_heap);
     ID3D12DescriptorHeap_Release(gpu_heap);
@@ -0,0 +1,861 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* CPU-only benchmark and fuzz test for hashmap.h. Compares against the
+ * previous linear probing implementation, which also serves as the
+ * reference for the fuzz test. Does not require a device. */
+
+#include "performance_utils.h"
+
+#include "hashmap.h"
+#include "vkd3d_threads.h"
+
+/* Linear probing over odd table sizes with a modulo per probe,
+ * and backward shift deletion. */
+struct legacy_hash_map
+{
+    pfn_hash_func hash_func;
+    pfn_hash_compare_func compare_func;
+    void *entries;
+    size_t entry_size;
+    uint32_t entry_count;
+    uint32_t used_count;
+};
+
+static struct hash_map_entry *legacy_hash_map_get_entry(const struct legacy_hash_map *hash_map, uint32_t entry_idx)
+{
+    return void_ptr_offset(hash_map->entries, hash_map->entry_size * entry_idx);
+}
+
+static uint32_t legacy_hash_map_next_entry_idx(const struct legacy_hash_map *hash_map, uint32_t entry_idx)
+{
+    uint32_t next_idx = entry_idx + 1;
+    return next_idx < hash_map->entry_count ? next_idx : 0;
+}
+
+static bool legacy_hash_map_grow(struct legacy_hash_map *hash_map)
+{
+    uint32_t i, entry_idx, old_count, new_count;
+    struct hash_map_entry *old_entry, *new_entry;
+    void *new_entries, *old_entries;
+
+    old_count = hash_map->entry_count;
+    old_entries = hash_map->entries;
+    new_count = old_count ? old_count * 2 + 5 : 37;
+
+    if (!(new_entries = vkd3d_calloc(new_count, hash_map->entry_size)))
+        return false;
+
+    hash_map->entry_count = new_count;
+    hash_map->entries = new_entries;
+
+    for (i = 0; i < old_count; i++)
+    {
+        old_entry = void_ptr_offset(old_entries, i * hash_map->entry_size);
+
+        if (old_entry->flags & HASH_MAP_ENTRY_OCCUPIED)
+        {
+            entry_idx = old_entry->hash_value % new_count;
+            new_entry = legacy_hash_map_get_entry(hash_map, entry_idx);
+
+            while (new_entry->flags & HASH_MAP_ENTRY_OCCUPIED)
+            {
+                entry_idx = legacy_hash_map_next_entry_idx(hash_map, entry_idx);
+                new_entry = legacy_hash_map_get_entry(hash_map, entry_idx);
+            }
+
+            memcpy(new_entry, old_entry, hash_map->entry_size);
+        }
+    }
+
+    vkd3d_free(old_entries);
+    return true;
+}
+
+static struct hash_map_entry *legacy_hash_map_find(const struct legacy_hash_map *hash_map, const void *key)
+{
+    struct hash_map_entry *entry;
+    uint32_t hash_value, entry_idx;
+
+    if (!hash_map->entries)
+        return NULL;
+
+    hash_value = hash_map->hash_func(key);
+    entry_idx = hash_value % hash_map->entry_count;
+
+    while (true)
+    {
+        entry = legacy_hash_map_get_entry(hash_map, entry_idx);
+
+        if (!(entry->flags & HASH_MAP_ENTRY_OCCUPIED))
+            return NULL;
+
+        if (entry->hash_value == hash_value && hash_map->compare_func(key, entry))
+            return entry;
+
+        entry_idx = legacy_hash_map_next_entry_idx(hash_map, entry_idx);
+    }
+}
+
+static struct hash_map_entry *legacy_hash_map_insert(struct legacy_hash_map *hash_map, const void *key, const struct hash_map_entry *entry)
+{
+    struct hash_map_entry *target = NULL, *current;
+    uint32_t hash_value, entry_idx;
+
+    if (10 * hash_map->used_count >= 7 * hash_map->entry_count)
+    {
+        if (!legacy_hash_map_grow(hash_map))
+            return NULL;
+    }
+
+    hash_value = hash_map->hash_func(key);
+    entry_idx = hash_value % hash_map->entry_count;
+
+    while (!target)
+    {
+        current = legacy_hash_map_get_entry(hash_map, entry_idx);
+
+        if (!(current->flags & HASH_MAP_ENTRY_OCCUPIED) ||
+                (current->hash_value == hash_value && hash_map->compare_func(key, current)))
+            target = current;
+        else
+            entry_idx = legacy_hash_map_next_entry_idx(hash_map, entry_idx);
+    }
+
+    if (!(target->flags & HASH_MAP_ENTRY_OCCUPIED))
+    {
+        hash_map->used_count += 1;
+        memcpy(target, entry, hash_map->entry_size);
+        target->flags = HASH_MAP_ENTRY_OCCUPIED;
+        target->hash_value = hash_value;
+    }
+
+    return target;
+}
+
+static void legacy_hash_map_remove(struct legacy_hash_map *hash_map, struct hash_map_entry *entry)
+{
+    uint32_t entry_idx, next_idx, home_idx;
+    struct hash_map_entry *next;
+
+    entry_idx = ((char *)entry - (char *)hash_map->entries) / hash_map->entry_size;
+    next_idx = entry_idx;
+
+    while (true)
+    {
+        next_idx = legacy_hash_map_next_entry_idx(hash_map, next_idx);
+        next = legacy_hash_map_get_entry(hash_map, next_idx);
+
+        if (!(next->flags & HASH_MAP_ENTRY_OCCUPIED))
+            break;
+
+        home_idx = next->hash_value % hash_map->entry_count;
+
+        if (entry_idx <= next_idx
+                ? (entry_idx < home_idx && home_idx <= next_idx)
+                : (entry_idx < home_idx || home_idx <= next_idx))
+            continue;
+
+        memcpy(entry, next, hash_map->entry_size);
+        entry = next;
+        entry_idx = next_idx;
+    }
+
+    entry->flags = 0;
+    hash_map->used_count -= 1;
+}
+
+static void legacy_hash_map_init(struct legacy_hash_map *hash_map, pfn_hash_func hash_func,
+        pfn_hash_compare_func compare_func, size_t entry_size)
+{
+    memset(hash_map, 0, sizeof(*hash_map));
+    hash_map->hash_func = hash_func;
+    hash_map->compare_func = compare_func;
+    hash_map->entry_size = entry_size;
+}
+
+static void legacy_hash_map_clear(struct legacy_hash_map *hash_map)
+{
+    vkd3d_free(hash_map->entries);
+    hash_map->entries = NULL;
+    hash_map->entry_count = 0;
+    hash_map->used_count = 0;
+}
+
+/* Key shapes modelled after the maps vkd3d actually uses. */
+struct test_key
+{
+    uint64_t handle;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t type;
+    uint32_t padding;
+};
+
+struct test_entry
+{
+    struct hash_map_entry entry;
+    struct test_key key;
+    uint64_t value;
+};
+
+static bool test_key_compare(const void *key, const struct hash_map_entry *entry)
+{
+    const struct test_entry *e = (const struct test_entry *)entry;
+    return !memcmp(key, &e->key, sizeof(e->key));
+}
+
+static uint32_t view_key_hash(const void *key)
+{
+    const struct test_key *k = key;
+    uint32_t hash;
+
+    /* Same as buffer views in the view map. */
+    hash = hash_uint64(k->handle);
+    hash = hash_combine(hash, hash_uint64(k->offset));
+    hash = hash_combine(hash, hash_uint64(k->size));
+    hash = hash_combine(hash, k->type);
+    return hash;
+}
+
+static void view_key_generate(struct test_key *key, uint32_t index)
+{
+    /* Many views of a few large buffers, like descriptor heaps full of
+     * structured buffer views into suballocated memory. */
+    memset(key, 0, sizeof(*key));
+    key->handle = 0x5a5a0000000ull + (uint64_t)(index / 256) * 0x1000;
+    key->offset = (uint64_t)(index % 256) * 256;
+    key->size = 256;
+    key->type = 42;
+}
+
+static uint32_t pipeline_key_hash(const void *key)
+{
+    const struct test_key *k = key;
+    return hash_uint64(k->handle);
+}
+
+static uint64_t xorshift64(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static void pipeline_key_generate(struct test_key *key, uint32_t index)
+{
+    /* Pipeline caches are keyed by strong 64-bit hashes. */
+    uint64_t state = 0x9e3779b97f4a7c15ull * (index + 1);
+
+    memset(key, 0, sizeof(*key));
+    key->handle = xorshift64(&state);
+}
+
+static uint32_t symbol_key_hash(const void *key)
+{
+    const struct test_key *k = key;
+
+    /* Same as shader compiler symbols. */
+    return hash_combine(hash_combine(k->type, (uint32_t)k->offset), (uint32_t)k->handle);
+}
+
+static void symbol_key_generate(struct test_key *key, uint32_t index)
+{
+    /* Shader compiler symbols are small register indices of a few
+     * register types and symbol types. */
+    memset(key, 0, sizeof(*key));
+    key->type = index % 4;
+    key->offset = (index / 4) % 8;
+    key->handle = index / 32;
+}
+
+struct key_shape
+{
+    const char *name;
+    pfn_hash_func hash_func;
+    void (*generate)(struct test_key *key, uint32_t index);
+    /* The legacy table degrades badly on clustered hashes,
+     * so limit those to realistic sizes. */
+    uint32_t max_key_count;
+};
+
+static const struct key_shape key_shapes[] =
+{
+    {"view",     view_key_hash,     view_key_generate,     UINT32_MAX},
+    {"pipeline", pipeline_key_hash, pipeline_key_generate, UINT32_MAX},
+    {"symbol",   symbol_key_hash,   symbol_key_generate,   4096},
+};
+
+enum bench_op
+{
+    BENCH_OP_INSERT,
+    BENCH_OP_FIND_HIT,
+    BENCH_OP_FIND_MISS,
+    BENCH_OP_REMOVE_INSERT,
+    BENCH_OP_COUNT,
+};
+
+static const char * const bench_op_names[BENCH_OP_COUNT] =
+{
+    "insert",
+    "find (hit)",
+    "find (miss)",
+    "remove + insert",
+};
+
+static bool run_benchmark_legacy(const struct key_shape *shape, const struct test_key *keys,
+        uint32_t key_count, unsigned int iterations, double *times)
+{
+    struct legacy_hash_map map;
+    struct test_entry entry;
+    struct test_entry *e;
+    bool success = true;
+    double start_time;
+    unsigned int it;
+    uint32_t i;
+
+    memset(times, 0, BENCH_OP_COUNT * sizeof(*times));
+    memset(&entry, 0, sizeof(entry));
+
+    for (it = 0; it < iterations; it++)
+    {
+        legacy_hash_map_init(&map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+
+        start_time = get_time();
+        for (i = 0; i < key_count; i++)
+        {
+            entry.key = keys[i];
+            entry.value = i;
+            legacy_hash_map_insert(&map, &keys[i], &entry.entry);
+        }
+        times[BENCH_OP_INSERT] += get_time() - start_time;
+
+        start_time = get_time();
+        for (i = 0; i < key_count; i++)
+        {
+            if (!(e = (struct test_entry *)legacy_hash_map_find(&map, &keys[i])) || e->value != i)
+                success = false;
+        }
+        times[BENCH_OP_FIND_HIT] += get_time() - start_time;
+
+        start_time = get_time();
+        for (i = key_count; i < 2 * key_count; i++)
+        {
+            if (legacy_hash_map_find(&map, &keys[i]))
+                success = false;
+        }
+        times[BENCH_OP_FIND_MISS] += get_time() - start_time;
+
+        start_time = get_time();
+        for (i = 0; i < key_count; i++)
+        {
+            if ((e = (struct test_entry *)legacy_hash_map_find(&map, &keys[i])))
+                legacy_hash_map_remove(&map, &e->entry);
+            entry.key = keys[key_count + i];
+            entry.value = key_count + i;
+            legacy_hash_map_insert(&map, &keys[key_count + i], &entry.entry);
+        }
+        times[BENCH_OP_REMOVE_INSERT] += get_time() - start_time;
+
+        if (map.used_count != key_count)
+            success = false;
+
+        legacy_hash_map_clear(&map);
+    }
+
+    return success;
+}
+
+static bool run_benchmark_swiss(const struct key_shape *shape, const struct test_key *keys,
+        uint32_t key_count, unsigned int iterations, double *times)
+{
+    struct test_entry entry;
+    struct hash_map map;
+    struct test_entry *e;
+    bool success = true;
+    double start_time;
+    unsigned int it;
+    uint32_t i;
+
+    memset(times, 0, BENCH_OP_COUNT * sizeof(*times));
+    memset(&entry, 0, sizeof(entry));
+
+    for (it = 0; it < iterations; it++)
+    {
+        hash_map_init(&map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+
+        start_time = get_time();
+        for (i = 0; i < key_count; i++)
+        {
+            entry.key = keys[i];
+            entry.value = i;
+            hash_map_insert(&map, &keys[i], &entry.entry);
+        }
+        times[BENCH_OP_INSERT] += get_time() - start_time;
+
+        start_time = get_time();
+        for (i = 0; i < key_count; i++)
+        {
+            if (!(e = (struct test_entry *)hash_map_find(&map, &keys[i])) || e->value != i)
+                success = false;
+        }
+        times[BENCH_OP_FIND_HIT] += get_time() - start_time;
+
+        start_time = get_time();
+        for (i = key_count; i < 2 * key_count; i++)
+        {
+            if (hash_map_find(&map, &keys[i]))
+                success = false;
+        }
+        times[BENCH_OP_FIND_MISS] += get_time() - start_time;
+
+        start_time = get_time();
+        for (i = 0; i < key_count; i++)
+        {
+            if ((e = (struct test_entry *)hash_map_find(&map, &keys[i])))
+                hash_map_remove(&map, &e->entry);
+            entry.key = keys[key_count + i];
+            entry.value = key_count + i;
+            hash_map_insert(&map, &keys[key_count + i], &entry.entry);
+        }
+        times[BENCH_OP_REMOVE_INSERT] += get_time() - start_time;
+
+        if (map.used_count != key_count)
+            success = false;
+
+        hash_map_clear(&map);
+    }
+
+    return success;
+}
+
+static bool run_benchmark(const struct key_shape *shape, uint32_t key_count)
+{
+    double legacy_times[BENCH_OP_COUNT], swiss_times[BENCH_OP_COUNT];
+    unsigned int iterations;
+    struct test_key *keys;
+    bool success = true;
+    double op_count;
+    uint32_t i;
+
+    if (!(keys = vkd3d_malloc(2 * key_count * sizeof(*keys))))
+        return false;
+
+    /* The second half of the keys is never inserted up front, for misses. */
+    for (i = 0; i < 2 * key_count; i++)
+        shape->generate(&keys[i], i);
+
+    iterations = max(1u, (1u << 22) / key_count);
+    op_count = (double)key_count * iterations;
+
+    if (!run_benchmark_legacy(shape, keys, key_count, iterations, legacy_times))
+    {
+        fprintf(stderr, "  legacy: lookup mismatch.\n");
+        success = false;
+    }
+
+    if (!run_benchmark_swiss(shape, keys, key_count, iterations, swiss_times))
+    {
+        fprintf(stderr, "  hashmap.h: lookup mismatch.\n");
+        success = false;
+    }
+
+    printf("%s keys, %u entries:\n", shape->name, key_count);
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        printf("  %-16s legacy %7.2f ns/op, hashmap.h %7.2f ns/op\n", bench_op_names[i],
+                1e9 * legacy_times[i] / op_count, 1e9 * swiss_times[i] / op_count);
+    }
+
+    vkd3d_free(keys);
+    return success;
+}
+
+#define FUZZ_KEY_SPACE 2048
+#define FUZZ_OP_COUNT 500000
+
+static bool check_iteration(const struct hash_map *map, const struct legacy_hash_map *reference)
+{
+    const struct test_entry *e, *r;
+    uint32_t i, count = 0;
+
+    for (i = 0; i < map->entry_count; i++)
+    {
+        e = (const struct test_entry *)hash_map_get_entry(map, i);
+
+        if (!(e->entry.flags & HASH_MAP_ENTRY_OCCUPIED))
+            continue;
+
+        if (!(r = (const struct test_entry *)legacy_hash_map_find(reference, &e->key)) || r->value != e->value)
+            return false;
+
+        count++;
+    }
+
+    return count == map->used_count && count == reference->used_count;
+}
+
+static bool run_fuzz(const struct key_shape *shape, bool read_mostly)
+{
+    struct legacy_hash_map reference;
+    struct test_entry entry, *e, *r;
+    struct test_key key;
+    uint64_t state = 1;
+    struct hash_map map;
+    uint32_t i, index;
+    unsigned int op;
+
+    legacy_hash_map_init(&reference, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+    if (read_mostly)
+        hash_map_init_read_mostly(&map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+    else
+        hash_map_init(&map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+
+    memset(&entry, 0, sizeof(entry));
+
+    for (i = 0; i < FUZZ_OP_COUNT; i++)
+    {
+        op = xorshift64(&state) % 8;
+        index = xorshift64(&state) % FUZZ_KEY_SPACE;
+
+        /* Periodically shrink the key space so that the map drains
+         * and refills, which exercises tombstones and rehashing. */
+        if ((i / 50000) & 1)
+            index %= FUZZ_KEY_SPACE / 16;
+
+        shape->generate(&key, index);
+
+        e = (struct test_entry *)hash_map_find(&map, &key);
+        r = (struct test_entry *)legacy_hash_map_find(&reference, &key);
+
+        if (!e != !r || (e && e->value != r->value))
+        {
+            fprintf(stderr, "  op %u: lookup mismatch for key %u.\n", i, index);
+            return false;
+        }
+
+        if (op < 3)
+        {
+            entry.key = key;
+            entry.value = i;
+
+            e = (struct test_entry *)hash_map_insert(&map, &key, &entry.entry);
+            r = (struct test_entry *)legacy_hash_map_insert(&reference, &key, &entry.entry);
+
+            if (!e || !r || e->value != r->value || memcmp(&e->key, &key, sizeof(key)))
+            {
+                fprintf(stderr, "  op %u: insert mismatch for key %u.\n", i, index);
+                return false;
+            }
+        }
+        else if (op < 6 && e)
+        {
+            hash_map_remove(&map, &e->entry);
+            legacy_hash_map_remove(&reference, &r->entry);
+
+            if (hash_map_find(&map, &key))
+            {
+                fprintf(stderr, "  op %u: key %u still present after removal.\n", i, index);
+                return false;
+            }
+        }
+
+        if (map.used_count != reference.used_count)
+        {
+            fprintf(stderr, "  op %u: used count %u, expected %u.\n", i, map.used_count, reference.used_count);
+            return false;
+        }
+
+        if (!(i % 10000) && !check_iteration(&map, &reference))
+        {
+            fprintf(stderr, "  op %u: iteration mismatch.\n", i);
+            return false;
+        }
+    }
+
+    hash_map_clear(&map);
+    legacy_hash_map_clear(&reference);
+    return true;
+}
+
+#define CHURN_KEY_COUNT 4096
+#define CHURN_ROUND_COUNT 64
+/* Read-mostly maps reach 7/8 occupancy including tombstones right before
+ * they get rehashed, where clustered symbol keys need about 6 groups. */
+#define CHURN_MAX_AVERAGE_PROBE_LENGTH 8.0
+
+/* Averages the number of groups that a lookup which misses probes over all
+ * home groups, and counts tombstones. */
+static double get_miss_probe_length(const struct hash_map *map, uint32_t *max_length, uint32_t *tombstone_count)
+{
+    uint32_t group_count, group_idx, length, total_length = 0, i;
+
+    group_count = map->entry_count / HASH_MAP_GROUP_SIZE;
+    *max_length = 0;
+    *tombstone_count = 0;
+
+    for (i = 0; i < map->entry_count; i++)
+    {
+        if (map->ctrl[i] == HASH_MAP_CTRL_DELETED)
+            (*tombstone_count)++;
+    }
+
+    for (i = 0; i < group_count; i++)
+    {
+        group_idx = i;
+        length = 1;
+
+        while (!hash_map_group_match(&map->ctrl[group_idx * HASH_MAP_GROUP_SIZE], HASH_MAP_CTRL_EMPTY))
+        {
+            group_idx = (group_idx + 1) % group_count;
+            length++;
+        }
+
+        *max_length = max(*max_length, length);
+        total_length += length;
+    }
+
+    return (double)total_length / group_count;
+}
+
+/* Keeps the number of live entries constant while replacing all of them
+ * many times over, and checks that lookups do not get longer. Ordinary maps
+ * must not accumulate tombstones. Read-mostly maps do, until they use up
+ * the growth budget and the table gets rehashed at the same size. */
+static bool run_churn(const struct key_shape *shape, bool read_mostly)
+{
+    uint32_t max_length, worst_max_length = 0, tombstone_count, worst_tombstone_count = 0;
+    double length, worst_length = 0.0;
+    struct test_entry entry, *e;
+    struct test_key key;
+    struct hash_map map;
+    bool success = true;
+    uint32_t round, i;
+
+    if (read_mostly)
+        hash_map_init_read_mostly(&map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+    else
+        hash_map_init(&map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+
+    memset(&entry, 0, sizeof(entry));
+
+    for (i = 0; i < CHURN_KEY_COUNT; i++)
+    {
+        shape->generate(&entry.key, i);
+        entry.value = i;
+        hash_map_insert(&map, &entry.key, &entry.entry);
+    }
+
+    for (round = 0; round < CHURN_ROUND_COUNT; round++)
+    {
+        for (i = 0; i < CHURN_KEY_COUNT; i++)
+        {
+            shape->generate(&key, round * CHURN_KEY_COUNT + i);
+
+            if (!(e = (struct test_entry *)hash_map_find(&map, &key)))
+            {
+                fprintf(stderr, "  round %u: key %u not found.\n", round, i);
+                success = false;
+                break;
+            }
+
+            hash_map_remove(&map, &e->entry);
+
+            shape->generate(&entry.key, (round + 1) * CHURN_KEY_COUNT + i);
+            entry.value = (round + 1) * CHURN_KEY_COUNT + i;
+            hash_map_insert(&map, &entry.key, &entry.entry);
+        }
+
+        length = get_miss_probe_length(&map, &max_length, &tombstone_count);
+        worst_length = max(worst_length, length);
+        worst_max_length = max(worst_max_length, max_length);
+        worst_tombstone_count = max(worst_tombstone_count, tombstone_count);
+    }
+
+    printf("%s keys%s, %u entries, %u rounds of remove + insert: %.2f groups per miss on average, "
+            "%u at most, %u tombstones at most, %u slots.\n", shape->name, read_mostly ? " (read-mostly)" : "",
+            CHURN_KEY_COUNT, CHURN_ROUND_COUNT, worst_length, worst_max_length, worst_tombstone_count, map.entry_count);
+
+    if (map.used_count != CHURN_KEY_COUNT || worst_length > CHURN_MAX_AVERAGE_PROBE_LENGTH ||
+            (!read_mostly && worst_tombstone_count))
+        success = false;
+
+    hash_map_clear(&map);
+    return success;
+}
+
+#define CONCURRENT_READER_COUNT 4
+#define CONCURRENT_STABLE_KEY_COUNT 1024
+#define CONCURRENT_WRITER_OP_COUNT 200000
+
+struct concurrent_test
+{
+    const struct key_shape *shape;
+    struct hash_map map;
+    uint32_t done;
+    uint32_t error_count;
+};
+
+struct concurrent_reader
+{
+    struct concurrent_test *test;
+    pthread_t thread;
+    uint64_t lookup_count;
+};
+
+static void *concurrent_reader_main(void *arg)
+{
+    struct concurrent_reader *reader = arg;
+    struct concurrent_test *test = reader->test;
+    const struct test_entry *e;
+    uint64_t lookup_count = 0;
+    struct test_key key;
+    uint32_t read_slot;
+    uint32_t index = 0;
+
+    while (!vkd3d_atomic_uint32_load_explicit(&test->done, vkd3d_memory_order_acquire))
+    {
+        /* Stable keys use even indices and are never removed. */
+        index = (index + 1) % CONCURRENT_STABLE_KEY_COUNT;
+        test->shape->generate(&key, 2 * index);
+
+        read_slot = hash_map_read_begin(&test->map);
+
+        if (!(e = (const struct test_entry *)hash_map_find_read_mostly(&test->map, &key)) || e->value != 2 * index)
+            vkd3d_atomic_uint32_increment(&test->error_count, vkd3d_memory_order_relaxed);
+
+        hash_map_read_end(&test->map, read_slot);
+        lookup_count++;
+    }
+
+    reader->lookup_count = lookup_count;
+    return NULL;
+}
+
+static bool run_concurrent(const struct key_shape *shape)
+{
+    struct concurrent_reader readers[CONCURRENT_READER_COUNT];
+    struct concurrent_test test;
+    uint64_t lookup_count = 0;
+    struct test_entry entry, *e;
+    uint64_t state = 7;
+    double start_time;
+    struct test_key key;
+    uint32_t i, index;
+
+    memset(&test, 0, sizeof(test));
+    test.shape = shape;
+    hash_map_init_read_mostly(&test.map, shape->hash_func, test_key_compare, sizeof(struct test_entry));
+
+    memset(&entry, 0, sizeof(entry));
+
+    for (i = 0; i < CONCURRENT_STABLE_KEY_COUNT; i++)
+    {
+        shape->generate(&entry.key, 2 * i);
+        entry.value = 2 * i;
+        hash_map_insert(&test.map, &entry.key, &entry.entry);
+    }
+
+    for (i = 0; i < CONCURRENT_READER_COUNT; i++)
+    {
+        readers[i].test = &test;
+        readers[i].lookup_count = 0;
+        pthread_create(&readers[i].thread, NULL, concurrent_reader_main, &readers[i]);
+    }
+
+    start_time = get_time();
+
+    /* Volatile keys use odd indices, and keep the writer growing the map
+     * and filling it with tombstones, so that tables get retired while
+     * readers are active. */
+    for (i = 0; i < CONCURRENT_WRITER_OP_COUNT; i++)
+    {
+        index = 2 * (uint32_t)(xorshift64(&state) % (16 * CONCURRENT_STABLE_KEY_COUNT)) + 1;
+        shape->generate(&key, index);
+
+        if ((e = (struct test_entry *)hash_map_find(&test.map, &key)))
+        {
+            hash_map_remove(&test.map, &e->entry);
+        }
+        else
+        {
+            entry.key = key;
+            entry.value = index;
+            hash_map_insert(&test.map, &key, &entry.entry);
+        }
+    }
+
+    vkd3d_atomic_uint32_store_explicit(&test.done, 1, vkd3d_memory_order_release);
+
+    for (i = 0; i < CONCURRENT_READER_COUNT; i++)
+    {
+        pthread_join(readers[i].thread, NULL);
+        lookup_count += readers[i].lookup_count;
+    }
+
+    printf("%s keys, %u readers: %u writes, %.0f lookups/s, %u errors.\n", shape->name,
+            CONCURRENT_READER_COUNT, CONCURRENT_WRITER_OP_COUNT,
+            (double)lookup_count / (get_time() - start_time), test.error_count);
+
+    hash_map_clear(&test.map);
+    return !test.error_count;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t key_counts[] = {64, 4096, 262144};
+    bool success = true;
+    unsigned int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(key_shapes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(key_counts) && key_counts[j] <= key_shapes[i].max_key_count; j++)
+            success &= run_benchmark(&key_shapes[i], key_counts[j]);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(key_shapes); i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            if (!run_fuzz(&key_shapes[i], !!j))
+            {
+                fprintf(stderr, "Fuzz test failed for %s keys%s.\n", key_shapes[i].name, j ? " (read-mostly)" : "");
+                success = false;
+            }
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(key_shapes); i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            if (!run_churn(&key_shapes[i], !!j))
+            {
+                fprintf(stderr, "Churn test failed for %s keys%s.\n", key_shapes[i].name, j ? " (read-mostly)" : "");
+                success = false;
+            }
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(key_shapes); i++)
+        success &= run_concurrent(&key_shapes[i]);
+
+    return success ? 0 : 1;
+}
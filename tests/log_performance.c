@@ -0,0 +1,167 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Multithreaded logging stress test. Compares vkd3d_dbg_printf() against
+ * a lock, format and flush per message logger, which is what it used to do.
+ * Rates only count messages which actually made it to the log file. */
+
+#include "performance_utils.h"
+
+#include "vkd3d_debug.h"
+#include "vkd3d_threads.h"
+#include "vkd3d_spinlock.h"
+
+#define LOG_THREAD_COUNT 8
+#define LOG_MESSAGE_COUNT 100000
+
+static FILE *reference_log_file;
+
+static void reference_printf(const char *function, const char *fmt, ...) VKD3D_PRINTF_FUNC(2, 3);
+
+static void reference_printf(const char *function, const char *fmt, ...)
+{
+    static spinlock_t spin;
+    va_list args;
+
+    va_start(args, fmt);
+    spinlock_acquire(&spin);
+    fprintf(reference_log_file, "%04x:trace:%s: ", vkd3d_get_current_thread_id(), function);
+    vfprintf(reference_log_file, fmt, args);
+    spinlock_release(&spin);
+    va_end(args);
+    fflush(reference_log_file);
+}
+
+static void *reference_thread_main(void *arg)
+{
+    unsigned int i;
+
+    for (i = 0; i < LOG_MESSAGE_COUNT; i++)
+        reference_printf(__FUNCTION__, "iface %p, index %u, value %#x.\n", arg, i, i * 3);
+
+    return NULL;
+}
+
+static void *vkd3d_thread_main(void *arg)
+{
+    unsigned int i;
+
+    for (i = 0; i < LOG_MESSAGE_COUNT; i++)
+        TRACE("iface %p, index %u, value %#x.\n", arg, i, i * 3);
+
+    return NULL;
+}
+
+static void run_threads(void *(*thread_main)(void *))
+{
+    pthread_t threads[LOG_THREAD_COUNT];
+    unsigned int i;
+
+    for (i = 0; i < LOG_THREAD_COUNT; i++)
+    {
+        if (pthread_create(&threads[i], NULL, thread_main, (void *)(uintptr_t)(i + 1)))
+        {
+            fprintf(stderr, "Failed to create thread.\n");
+            exit(1);
+        }
+    }
+
+    for (i = 0; i < LOG_THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+}
+
+/* Counts the lines written by thread_main, which tells apart messages that were
+ * delivered from ones that were dropped or truncated. */
+static unsigned int count_messages(const char *path, const char *thread_main)
+{
+    unsigned int count = 0;
+    char line[1024];
+    FILE *file;
+
+    if (!(file = fopen(path, "r")))
+    {
+        fprintf(stderr, "Failed to open %s.\n", path);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        if (strstr(line, thread_main))
+            count++;
+    }
+
+    fclose(file);
+    return count;
+}
+
+static void report(const char *name, double time, unsigned int delivered_count)
+{
+    unsigned int message_count = LOG_THREAD_COUNT * LOG_MESSAGE_COUNT;
+
+    printf("%-20s %8.3f s, %10.0f delivered messages/s, %u dropped\n", name, time,
+            delivered_count / time, message_count - min(delivered_count, message_count));
+}
+
+int main(int argc, char **argv)
+{
+    const char *log_path;
+    double start_time;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <reference log file>\n"
+                "Run with VKD3D_DEBUG=trace and VKD3D_LOG_FILE set. "
+                "Set VKD3D_LOG_ASYNC=1 to measure asynchronous logging.\n", argv[0]);
+        return 1;
+    }
+
+    if (!TRACE_ON())
+    {
+        fprintf(stderr, "VKD3D_DEBUG=trace is required.\n");
+        return 1;
+    }
+
+    if (!(log_path = getenv("VKD3D_LOG_FILE")))
+    {
+        fprintf(stderr, "VKD3D_LOG_FILE is required.\n");
+        return 1;
+    }
+
+    if (!(reference_log_file = fopen(argv[1], "w")))
+    {
+        fprintf(stderr, "Failed to open %s.\n", argv[1]);
+        return 1;
+    }
+
+    printf("%u threads, %u messages per thread, %s logging:\n", LOG_THREAD_COUNT, LOG_MESSAGE_COUNT,
+            vkd3d_env_var_as_uint("VKD3D_LOG_ASYNC", 0) ? "asynchronous" : "synchronous");
+
+    start_time = get_time();
+    run_threads(reference_thread_main);
+    fclose(reference_log_file);
+    report("reference", get_time() - start_time, count_messages(argv[1], "reference_thread_main"));
+
+    /* Include the time it takes for the writer to catch up, so that both
+     * loggers have written the same messages when the clock stops. */
+    start_time = get_time();
+    run_threads(vkd3d_thread_main);
+    vkd3d_dbg_flush();
+    report("vkd3d_dbg_printf", get_time() - start_time, count_messages(log_path, "vkd3d_thread_main"));
+
+    return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* CPU-only benchmark for pipeline variant lookups. Compares the linked list
+ * memcmp scan under a read lock that d3d12_pipeline_state_find_compiled_pipeline
+ * used to do against the lock-free table it uses now, as the number of
+ * variants of a single PSO grows. Does not require a device. */
+
+#include "performance_utils.h"
+
+#include "list.h"
+#include "vkd3d_threads.h"
+#include "vkd3d_rw_spinlock.h"
+#include "vkd3d_lockfree_table.h"
+
+#define LOOKUP_TOTAL_COUNT 20000000
+#define LOOKUP_THREAD_COUNT 8
+#define VERTEX_INPUT_SLOT_COUNT 32
+
+/* Same layout as struct vkd3d_pipeline_key. */
+struct test_pipeline_key
+{
+    uint32_t topology;
+    uint32_t viewport_count;
+    uint32_t strides[VERTEX_INPUT_SLOT_COUNT];
+    uint32_t rtv_active_mask;
+    uint32_t variant_flags;
+    uint32_t dsv_format;
+
+    bool dynamic_stride;
+    bool dynamic_viewport;
+    bool dynamic_topology;
+};
+
+struct test_compiled_pipeline
+{
+    struct list entry;
+    struct test_pipeline_key key;
+    uint64_t vk_pipeline;
+};
+
+/* Variants of one PSO mostly differ in a few vertex strides, the
+ * topology and the RTV mask, so a memcmp has to look at most of the key. */
+static void generate_keys(struct test_pipeline_key *keys, size_t count)
+{
+    uint32_t seed = 0x1234;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        memset(&keys[i], 0, sizeof(keys[i]));
+        keys[i].topology = 4 + (i % 3);
+        keys[i].viewport_count = 1;
+        keys[i].strides[0] = 12 + 4 * (test_random(&seed) % 8);
+        keys[i].strides[1] = 8 + 4 * (test_random(&seed) % 4);
+        keys[i].rtv_active_mask = 1u | ((test_random(&seed) & 1u) << 1);
+        keys[i].dsv_format = 126;
+        /* Guarantee uniqueness through a stream which only some variants use. */
+        keys[i].strides[2] = 16 * (uint32_t)(i / 3);
+    }
+}
+
+/* Same hash as vkd3d_pipeline_key_hash. */
+static uint32_t test_pipeline_key_hash(const struct test_pipeline_key *key)
+{
+    const uint8_t *data = (const uint8_t *)key;
+    uint32_t hash = 0, word;
+    size_t i;
+
+    for (i = 0; i < sizeof(*key); i += sizeof(word))
+    {
+        memcpy(&word, data + i, sizeof(word));
+        hash = hash_combine(hash, word);
+    }
+
+    return hash;
+}
+
+static bool test_compiled_pipeline_compare(const void *key, const void *entry)
+{
+    const struct test_compiled_pipeline *compiled_pipeline = entry;
+    return !memcmp(&compiled_pipeline->key, key, sizeof(compiled_pipeline->key));
+}
+
+static void test_compiled_pipeline_destroy(void *entry, void *userdata)
+{
+}
+
+static uint64_t find_list(const struct list *pipelines, spinlock_t *lock, const struct test_pipeline_key *key)
+{
+    const struct test_compiled_pipeline *current;
+    uint64_t vk_pipeline = 0;
+
+    rw_spinlock_acquire_read(lock);
+    LIST_FOR_EACH_ENTRY(current, pipelines, const struct test_compiled_pipeline, entry)
+    {
+        if (!memcmp(&current->key, key, sizeof(*key)))
+        {
+            vk_pipeline = current->vk_pipeline;
+            break;
+        }
+    }
+    rw_spinlock_release_read(lock);
+
+    return vk_pipeline;
+}
+
+static uint64_t find_hashed(const struct vkd3d_lockfree_table *table, const struct test_pipeline_key *key)
+{
+    const struct test_compiled_pipeline *compiled_pipeline;
+
+    if ((compiled_pipeline = vkd3d_lockfree_table_find(table, key, test_pipeline_key_hash(key),
+            test_compiled_pipeline_compare)))
+        return compiled_pipeline->vk_pipeline;
+
+    return 0;
+}
+
+/* Command lists are usually recorded on several threads,
+ * which then all look up variants of the same PSOs. */
+struct lookup_thread
+{
+    pthread_t thread;
+    const struct test_pipeline_key *keys;
+    size_t count;
+    unsigned int iterations;
+    const struct list *list;
+    spinlock_t *lock;
+    const struct vkd3d_lockfree_table *table;
+    uint64_t sum;
+};
+
+static void *lookup_thread_main(void *arg)
+{
+    struct lookup_thread *thread = arg;
+    uint64_t sum = 0;
+    unsigned int i;
+    size_t j;
+
+    for (i = 0; i < thread->iterations; i++)
+    {
+        for (j = 0; j < thread->count; j++)
+        {
+            if (thread->table)
+                sum += find_hashed(thread->table, &thread->keys[(j * 7919) % thread->count]);
+            else
+                sum += find_list(thread->list, thread->lock, &thread->keys[(j * 7919) % thread->count]);
+        }
+    }
+
+    thread->sum = sum;
+    return NULL;
+}
+
+static double run_threads(const struct test_pipeline_key *keys, size_t count, unsigned int iterations,
+        const struct list *list, spinlock_t *lock, const struct vkd3d_lockfree_table *table, uint64_t *sum)
+{
+    struct lookup_thread threads[LOOKUP_THREAD_COUNT];
+    double start_time;
+    unsigned int i;
+
+    start_time = get_time();
+
+    for (i = 0; i < LOOKUP_THREAD_COUNT; i++)
+    {
+        threads[i].keys = keys;
+        threads[i].count = count;
+        threads[i].iterations = iterations;
+        threads[i].list = list;
+        threads[i].lock = lock;
+        threads[i].table = table;
+        threads[i].sum = 0;
+        pthread_create(&threads[i].thread, NULL, lookup_thread_main, &threads[i]);
+    }
+
+    *sum = 0;
+    for (i = 0; i < LOOKUP_THREAD_COUNT; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+        *sum += threads[i].sum;
+    }
+
+    return get_time() - start_time;
+}
+
+static bool run_benchmark(size_t count)
+{
+    struct test_compiled_pipeline *pipelines;
+    struct vkd3d_lockfree_table table;
+    struct test_pipeline_key *keys;
+    uint64_t list_sum, hashed_sum;
+    unsigned int iterations, thread_iterations, i;
+    double t0, t1, t2, list_time, hashed_time;
+    bool success = true;
+    struct list list;
+    spinlock_t lock;
+    size_t j;
+
+    keys = vkd3d_malloc(count * sizeof(*keys));
+    pipelines = vkd3d_malloc(count * sizeof(*pipelines));
+
+    if (!keys || !pipelines)
+    {
+        fprintf(stderr, "Failed to allocate %zu keys.\n", count);
+        vkd3d_free(pipelines);
+        vkd3d_free(keys);
+        return false;
+    }
+
+    generate_keys(keys, count);
+    list_init(&list);
+    spinlock_init(&lock);
+    vkd3d_lockfree_table_init(&table, 16);
+
+    for (j = 0; j < count; j++)
+    {
+        pipelines[j].key = keys[j];
+        pipelines[j].vk_pipeline = j + 1;
+        list_add_tail(&list, &pipelines[j].entry);
+
+        if (vkd3d_lockfree_table_find(&table, &keys[j], test_pipeline_key_hash(&keys[j]),
+                test_compiled_pipeline_compare))
+        {
+            fprintf(stderr, "Duplicate key %zu.\n", j);
+            success = false;
+            goto done;
+        }
+
+        if (!vkd3d_lockfree_table_insert_locked(&table, &pipelines[j], test_pipeline_key_hash(&keys[j])))
+        {
+            fprintf(stderr, "Failed to insert key %zu.\n", j);
+            success = false;
+            goto done;
+        }
+    }
+
+    iterations = LOOKUP_TOTAL_COUNT / count;
+    list_sum = 0;
+    hashed_sum = 0;
+
+    /* Draws switch between variants in no particular order. */
+    t0 = get_time();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < count; j++)
+            list_sum += find_list(&list, &lock, &keys[(j * 7919) % count]);
+    }
+    t1 = get_time();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < count; j++)
+            hashed_sum += find_hashed(&table, &keys[(j * 7919) % count]);
+    }
+    t2 = get_time();
+
+    if (!(success = list_sum == hashed_sum && list_sum == (uint64_t)iterations * count * (count + 1) / 2))
+        fprintf(stderr, "  hashed: lookups returned wrong pipelines for %zu variants.\n", count);
+
+    thread_iterations = iterations / LOOKUP_THREAD_COUNT;
+    list_time = run_threads(keys, count, thread_iterations, &list, &lock, NULL, &list_sum);
+    hashed_time = run_threads(keys, count, thread_iterations, NULL, NULL, &table, &hashed_sum);
+
+    if (list_sum != hashed_sum ||
+            list_sum != (uint64_t)LOOKUP_THREAD_COUNT * thread_iterations * count * (count + 1) / 2)
+    {
+        fprintf(stderr, "  hashed: threaded lookups returned wrong pipelines for %zu variants.\n", count);
+        success = false;
+    }
+
+    printf("%zu variants:\n", count);
+    printf("  %-24s %10.2f ns/lookup, %12.0f lookups/s with %u threads\n", "list + rw lock",
+            1e9 * (t1 - t0) / ((double)iterations * count),
+            (double)LOOKUP_THREAD_COUNT * thread_iterations * count / list_time, LOOKUP_THREAD_COUNT);
+    printf("  %-24s %10.2f ns/lookup, %12.0f lookups/s with %u threads\n", "lock-free table",
+            1e9 * (t2 - t1) / ((double)iterations * count),
+            (double)LOOKUP_THREAD_COUNT * thread_iterations * count / hashed_time, LOOKUP_THREAD_COUNT);
+
+done:
+    vkd3d_lockfree_table_cleanup(&table, test_compiled_pipeline_destroy, NULL);
+    vkd3d_free(pipelines);
+    vkd3d_free(keys);
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t variant_counts[] = {1, 4, 16, 64, 256};
+    bool success = true;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(variant_counts); i++)
+        success &= run_benchmark(variant_counts[i]);
+
+    return success ? 0 : 1;
+}
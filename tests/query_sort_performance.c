@@ -0,0 +1,343 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* CPU-only benchmark for sorting pending queries before they are resolved.
+ * Compares qsort with heap allocated temporaries against the rank keys,
+ * radix sort and arena used by d3d12_command_list_gather_pending_queries.
+ * Does not require a device. */
+
+#include "performance_utils.h"
+
+#include "vkd3d_sort.h"
+
+#define QUERY_HEAP_COUNT 8
+#define QUERY_HEAP_SIZE 4096
+#define QUERY_TOTAL_COUNT 20000000
+
+/* Same layout as struct vkd3d_active_query. */
+struct test_query
+{
+    const void *heap;
+    uint32_t index;
+    uint32_t type;
+    uint64_t vk_pool;
+    uint32_t vk_index;
+    uint32_t state;
+    uint32_t resolve_index;
+};
+
+/* Mirrors the per-heap and per-range entries built while gathering. */
+struct test_dispatch
+{
+    const void *heap;
+    uint32_t virtual_query_count;
+    uint32_t unique_query_count;
+    uint32_t min_index;
+    uint32_t max_index;
+    uint64_t resolve_buffer_offset;
+    uint64_t resolve_buffer_size;
+};
+
+struct test_resolve
+{
+    uint64_t query_pool;
+    uint32_t first_query;
+    uint32_t query_count;
+    uint64_t offset;
+    uint64_t stride;
+};
+
+struct test_query_entry
+{
+    uint32_t dst_index;
+    uint32_t src_index;
+    uint32_t next;
+};
+
+struct test_query_map
+{
+    struct test_query_entry *entry;
+    unsigned int dispatch_id;
+};
+
+/* Emulates a frame that interleaves occlusion queries, which come from
+ * large Vulkan pools, with pipeline statistics queries from small pools. */
+static void generate_queries(struct test_query *queries, size_t count, const char *heaps)
+{
+    static const uint32_t pool_sizes[] = {4096, 128};
+    uint32_t pool_ids[ARRAY_SIZE(pool_sizes)];
+    uint32_t pool_next[ARRAY_SIZE(pool_sizes)];
+    uint32_t seed = 0x1234, type, next_pool_id = 1;
+    size_t i;
+
+    for (type = 0; type < ARRAY_SIZE(pool_sizes); type++)
+    {
+        pool_ids[type] = next_pool_id++;
+        pool_next[type] = 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        struct test_query *q = &queries[i];
+
+        type = (test_random(&seed) % 4) == 0 ? 1 : 0;
+
+        if (pool_next[type] == pool_sizes[type])
+        {
+            pool_ids[type] = next_pool_id++;
+            pool_next[type] = 0;
+        }
+
+        /* Heaps are switched every few hundred queries and indices are
+         * sometimes reused within a heap, like the real workload. */
+        q->heap = &heaps[type * (QUERY_HEAP_COUNT / 2) + (i / 256) % (QUERY_HEAP_COUNT / 2)];
+        q->index = test_random(&seed) % QUERY_HEAP_SIZE;
+        q->type = type;
+        q->vk_pool = 0x1000 * (uint64_t)pool_ids[type];
+        q->vk_index = pool_next[type]++;
+        q->state = 0;
+        q->resolve_index = 0;
+    }
+}
+
+static int compare_query(const void *query_a, const void *query_b)
+{
+    const struct test_query *a = query_a;
+    const struct test_query *b = query_b;
+
+    if (a->heap < b->heap) return -1;
+    if (a->heap > b->heap) return 1;
+
+    if (a->vk_pool > b->vk_pool) return -1;
+    if (a->vk_pool < b->vk_pool) return 1;
+
+    return (int)(a->vk_index - b->vk_index);
+}
+
+static void count_entries(const struct test_query *queries, size_t count,
+        size_t *dispatch_count, size_t *resolve_count)
+{
+    size_t i;
+
+    *dispatch_count = 0;
+    *resolve_count = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        const struct test_query *prev = i ? &queries[i - 1] : NULL;
+        const struct test_query *q = &queries[i];
+
+        if (!prev || prev->heap != q->heap)
+        {
+            (*dispatch_count)++;
+            (*resolve_count)++;
+        }
+        else if (prev->vk_pool != q->vk_pool || prev->vk_index + 1 != q->vk_index)
+            (*resolve_count)++;
+    }
+}
+
+static bool gather_reference(struct test_query *queries, size_t count)
+{
+    struct test_dispatch *dispatches = NULL;
+    struct test_resolve *resolves = NULL;
+    size_t dispatch_size = 0, resolve_size = 0;
+    size_t dispatch_count, resolve_count, i;
+    struct test_query_entry *query_list;
+    struct test_query_map *query_map;
+    bool success;
+
+    qsort(queries, count, sizeof(*queries), &compare_query);
+    count_entries(queries, count, &dispatch_count, &resolve_count);
+
+    /* The old code grew both arrays one entry at a time. */
+    for (i = 0; i < dispatch_count; i++)
+        vkd3d_array_reserve((void **)&dispatches, &dispatch_size, i + 1, sizeof(*dispatches));
+    for (i = 0; i < resolve_count; i++)
+        vkd3d_array_reserve((void **)&resolves, &resolve_size, i + 1, sizeof(*resolves));
+
+    query_map = vkd3d_calloc(QUERY_HEAP_SIZE, sizeof(*query_map));
+    query_list = vkd3d_malloc(sizeof(*query_list) * count);
+    success = dispatches && resolves && query_map && query_list;
+
+    vkd3d_free(resolves);
+    vkd3d_free(dispatches);
+    vkd3d_free(query_list);
+    vkd3d_free(query_map);
+    return success;
+}
+
+static struct test_query *gather_radix(struct vkd3d_arena *arena, const struct test_query *queries, size_t count)
+{
+    size_t dispatch_count, resolve_count, i;
+    struct test_query_map *query_map;
+    struct vkd3d_rank_table *heaps, *pools;
+    uint32_t heap_rank, pool_rank;
+    struct test_query *sorted;
+    uint32_t *values;
+    uint64_t *keys;
+
+    if (!(keys = vkd3d_arena_alloc(arena, 2 * count * sizeof(*keys))) ||
+            !(values = vkd3d_arena_alloc(arena, 2 * count * sizeof(*values))) ||
+            !(sorted = vkd3d_arena_alloc(arena, count * sizeof(*sorted))) ||
+            !(heaps = vkd3d_arena_alloc(arena, sizeof(*heaps))) ||
+            !(pools = vkd3d_arena_alloc(arena, sizeof(*pools))))
+        return NULL;
+
+    vkd3d_rank_table_init(heaps);
+    vkd3d_rank_table_init(pools);
+
+    for (i = 0; i < count; i++)
+    {
+        if (!vkd3d_rank_table_get(heaps, (uint64_t)(uintptr_t)queries[i].heap, &heap_rank) ||
+                !vkd3d_rank_table_get(pools, queries[i].vk_pool, &pool_rank))
+            return NULL;
+
+        keys[i] = vkd3d_rank_sort_key(heap_rank, pool_rank, queries[i].vk_index);
+        values[i] = i;
+    }
+
+    vkd3d_radix_sort_u64(keys, values, keys + count, values + count, count);
+
+    for (i = 0; i < count; i++)
+        sorted[i] = queries[values[i]];
+
+    count_entries(sorted, count, &dispatch_count, &resolve_count);
+
+    if (!vkd3d_arena_alloc(arena, dispatch_count * sizeof(struct test_dispatch)) ||
+            !vkd3d_arena_alloc(arena, resolve_count * sizeof(struct test_resolve)) ||
+            !vkd3d_arena_alloc(arena, count * sizeof(struct test_query_entry)))
+        return NULL;
+
+    if (!(query_map = vkd3d_arena_alloc(arena, QUERY_HEAP_SIZE * sizeof(*query_map))))
+        return NULL;
+    memset(query_map, 0, QUERY_HEAP_SIZE * sizeof(*query_map));
+
+    return sorted;
+}
+
+/* Every heap and every pool within a heap must form a single run,
+ * and Vulkan query indices must increase within each pool. */
+static bool validate_sorted(const struct test_query *input, const struct test_query *sorted, size_t count)
+{
+    const void *seen_heaps[QUERY_HEAP_COUNT];
+    size_t seen_heap_count = 0, i, j;
+    uint64_t input_sum = 0, sorted_sum = 0;
+    uint64_t *seen_pools;
+    size_t seen_pool_count = 0;
+    bool success = true;
+
+    if (!(seen_pools = vkd3d_malloc(count * sizeof(*seen_pools))))
+        return false;
+
+    for (i = 0; i < count && success; i++)
+    {
+        input_sum += (uint64_t)(uintptr_t)input[i].heap ^ (input[i].vk_pool * 31 + input[i].vk_index) ^ ((uint64_t)input[i].index << 40);
+        sorted_sum += (uint64_t)(uintptr_t)sorted[i].heap ^ (sorted[i].vk_pool * 31 + sorted[i].vk_index) ^ ((uint64_t)sorted[i].index << 40);
+
+        if (!i || sorted[i - 1].heap != sorted[i].heap)
+        {
+            for (j = 0; j < seen_heap_count; j++)
+                success &= seen_heaps[j] != sorted[i].heap;
+            if (seen_heap_count < ARRAY_SIZE(seen_heaps))
+                seen_heaps[seen_heap_count++] = sorted[i].heap;
+            seen_pool_count = 0;
+            seen_pools[seen_pool_count++] = sorted[i].vk_pool;
+        }
+        else if (sorted[i - 1].vk_pool != sorted[i].vk_pool)
+        {
+            for (j = 0; j < seen_pool_count; j++)
+                success &= seen_pools[j] != sorted[i].vk_pool;
+            seen_pools[seen_pool_count++] = sorted[i].vk_pool;
+        }
+        else
+            success &= sorted[i - 1].vk_index < sorted[i].vk_index;
+    }
+
+    vkd3d_free(seen_pools);
+    return success && input_sum == sorted_sum;
+}
+
+static bool run_benchmark(size_t count)
+{
+    static const char heaps[QUERY_HEAP_COUNT];
+    double reference_time = 0.0, radix_time = 0.0, start_time;
+    struct test_query *input, *queries, *sorted;
+    unsigned int iterations, i;
+    struct vkd3d_arena arena;
+    bool success = true;
+
+    input = vkd3d_malloc(count * sizeof(*input));
+    queries = vkd3d_malloc(count * sizeof(*queries));
+    if (!input || !queries)
+    {
+        fprintf(stderr, "Failed to allocate %zu queries.\n", count);
+        vkd3d_free(input);
+        vkd3d_free(queries);
+        return false;
+    }
+
+    generate_queries(input, count, heaps);
+    vkd3d_arena_init(&arena, 64 * 1024);
+
+    iterations = max(1u, (unsigned int)(QUERY_TOTAL_COUNT / count));
+
+    for (i = 0; i < iterations; i++)
+    {
+        memcpy(queries, input, count * sizeof(*queries));
+        start_time = get_time();
+        success &= gather_reference(queries, count);
+        reference_time += get_time() - start_time;
+
+        /* The command allocator resets its arena on Reset(). */
+        vkd3d_arena_reset(&arena);
+        start_time = get_time();
+        sorted = gather_radix(&arena, input, count);
+        radix_time += get_time() - start_time;
+
+        if (!sorted || (!i && !validate_sorted(input, sorted, count)))
+        {
+            fprintf(stderr, "  radix: invalid result for %zu queries.\n", count);
+            success = false;
+            break;
+        }
+    }
+
+    printf("%zu pending queries, %u iterations:\n", count, iterations);
+    printf("  %-24s %10.3f us/gather, %8.2f Mqueries/s\n", "qsort + malloc",
+            1e6 * reference_time / iterations, 1e-6 * count * iterations / reference_time);
+    printf("  %-24s %10.3f us/gather, %8.2f Mqueries/s\n", "radix sort + arena",
+            1e6 * radix_time / iterations, 1e-6 * count * iterations / radix_time);
+
+    vkd3d_arena_destroy(&arena);
+    vkd3d_free(queries);
+    vkd3d_free(input);
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t query_counts[] = {1000, 10000, 100000};
+    bool success = true;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(query_counts); i++)
+        success &= run_benchmark(query_counts[i]);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* CPU-only benchmark for render pass cache lookups. Compares the linear
+ * memcmp scan under a read lock that vkd3d_render_pass_cache_find used to
+ * do against the lock-free table it uses now. Does not require a device. */
+
+#include "performance_utils.h"
+
+#include "vkd3d_rw_spinlock.h"
+#include "vkd3d_lockfree_table.h"
+
+#define LOOKUP_TOTAL_COUNT 20000000
+
+/* Same layout as struct vkd3d_render_pass_key. */
+struct test_render_pass_key
+{
+    uint32_t attachment_count;
+    uint32_t rtv_active_mask;
+    uint32_t flags;
+    uint32_t sample_count;
+    uint32_t vk_formats[9];
+};
+
+struct test_render_pass_entry
+{
+    struct test_render_pass_key key;
+    uint64_t vk_render_pass;
+};
+
+/* Keys mostly differ in a few formats and the sample count, like the ones
+ * games generate, so a linear scan has to compare most of each key. */
+static void generate_keys(struct test_render_pass_key *keys, size_t count)
+{
+    uint32_t seed = 0x1234, rt_count;
+    size_t i, j;
+
+    for (i = 0; i < count; i++)
+    {
+        memset(&keys[i], 0, sizeof(keys[i]));
+        rt_count = 1 + (i % 4);
+        keys[i].attachment_count = rt_count + 1;
+        keys[i].rtv_active_mask = (1u << rt_count) - 1;
+        keys[i].flags = 0x3;
+        keys[i].sample_count = 1u << ((i / 4) % 3);
+        for (j = 0; j < rt_count; j++)
+            keys[i].vk_formats[j] = 37 + (test_random(&seed) % 8);
+        /* Guarantee uniqueness through the depth format. */
+        keys[i].vk_formats[rt_count] = 1000 + (uint32_t)(i / 12);
+    }
+}
+
+/* Same hash as vkd3d_render_pass_key_hash. */
+static uint32_t test_render_pass_key_hash(const struct test_render_pass_key *key)
+{
+    uint64_t hash = hash_fnv1_init();
+    unsigned int i;
+
+    hash = hash_fnv1_iterate_u32(hash, key->attachment_count);
+    hash = hash_fnv1_iterate_u32(hash, key->rtv_active_mask);
+    hash = hash_fnv1_iterate_u32(hash, key->flags);
+    hash = hash_fnv1_iterate_u32(hash, key->sample_count);
+    for (i = 0; i < ARRAY_SIZE(key->vk_formats); i++)
+        hash = hash_fnv1_iterate_u32(hash, key->vk_formats[i]);
+
+    return hash_uint64(hash);
+}
+
+static bool test_render_pass_entry_compare(const void *key, const void *entry)
+{
+    const struct test_render_pass_entry *render_pass = entry;
+    return !memcmp(&render_pass->key, key, sizeof(render_pass->key));
+}
+
+static void test_render_pass_entry_destroy(void *entry, void *userdata)
+{
+}
+
+static uint64_t find_linear(struct test_render_pass_entry *entries, size_t count,
+        spinlock_t *lock, const struct test_render_pass_key *key)
+{
+    uint64_t vk_render_pass = 0;
+    size_t i;
+
+    rw_spinlock_acquire_read(lock);
+    for (i = 0; i < count; i++)
+    {
+        if (!memcmp(&entries[i].key, key, sizeof(*key)))
+        {
+            vk_render_pass = entries[i].vk_render_pass;
+            break;
+        }
+    }
+    rw_spinlock_release_read(lock);
+
+    return vk_render_pass;
+}
+
+static uint64_t find_hashed(const struct vkd3d_lockfree_table *table, const struct test_render_pass_key *key)
+{
+    const struct test_render_pass_entry *entry;
+
+    if ((entry = vkd3d_lockfree_table_find(table, key, test_render_pass_key_hash(key),
+            test_render_pass_entry_compare)))
+        return entry->vk_render_pass;
+
+    return 0;
+}
+
+static bool run_benchmark(size_t count)
+{
+    struct test_render_pass_entry *entries;
+    struct vkd3d_lockfree_table table;
+    struct test_render_pass_key *keys;
+    uint64_t linear_sum, hashed_sum;
+    unsigned int iterations, i;
+    double t0, t1, t2;
+    bool success;
+    spinlock_t lock;
+    size_t j;
+
+    keys = vkd3d_malloc(count * sizeof(*keys));
+    entries = vkd3d_malloc(count * sizeof(*entries));
+
+    if (!keys || !entries)
+    {
+        fprintf(stderr, "Failed to allocate %zu keys.\n", count);
+        vkd3d_free(entries);
+        vkd3d_free(keys);
+        return false;
+    }
+
+    generate_keys(keys, count);
+    spinlock_init(&lock);
+    vkd3d_lockfree_table_init(&table, 64);
+
+    for (j = 0; j < count; j++)
+    {
+        entries[j].key = keys[j];
+        entries[j].vk_render_pass = j + 1;
+
+        if (vkd3d_lockfree_table_find(&table, &keys[j], test_render_pass_key_hash(&keys[j]),
+                test_render_pass_entry_compare))
+        {
+            fprintf(stderr, "Duplicate key %zu.\n", j);
+            success = false;
+            goto done;
+        }
+
+        if (!vkd3d_lockfree_table_insert_locked(&table, &entries[j], test_render_pass_key_hash(&keys[j])))
+        {
+            fprintf(stderr, "Failed to insert key %zu.\n", j);
+            success = false;
+            goto done;
+        }
+    }
+
+    iterations = LOOKUP_TOTAL_COUNT / count;
+    linear_sum = 0;
+    hashed_sum = 0;
+
+    /* Look keys up in a scrambled order, as draws rarely follow creation order. */
+    t0 = get_time();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < count; j++)
+            linear_sum += find_linear(entries, count, &lock, &keys[(j * 7919) % count]);
+    }
+    t1 = get_time();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < count; j++)
+            hashed_sum += find_hashed(&table, &keys[(j * 7919) % count]);
+    }
+    t2 = get_time();
+
+    if (!(success = linear_sum == hashed_sum && linear_sum == (uint64_t)iterations * count * (count + 1) / 2))
+        fprintf(stderr, "  hashed: lookups returned wrong render passes for %zu keys.\n", count);
+
+    printf("%zu render pass keys, %u iterations:\n", count, iterations);
+    printf("  %-24s %10.2f ns/lookup\n", "linear + rw lock",
+            1e9 * (t1 - t0) / ((double)iterations * count));
+    printf("  %-24s %10.2f ns/lookup\n", "lock-free table",
+            1e9 * (t2 - t1) / ((double)iterations * count));
+
+done:
+    vkd3d_lockfree_table_cleanup(&table, test_render_pass_entry_destroy, NULL);
+    vkd3d_free(entries);
+    vkd3d_free(keys);
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t key_counts[] = {10, 100, 1000};
+    bool success = true;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(key_counts); i++)
+        success &= run_benchmark(key_counts[i]);
+
+    return success ? 0 : 1;
+}
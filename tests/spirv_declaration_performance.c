@@ -0,0 +1,288 @@
+/*
+ * Copyright 2024 vkd3d-proton contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* CPU-only benchmark for SPIR-V type and constant deduplication in
+ * vkd3d_spirv_build_once*(). Compares the arena allocated rb-tree the
+ * builder used to have against the inline hash_map it uses now, including
+ * setting up and tearing down the builder for every shader. Does not
+ * require SPIR-V headers or a device. */
+
+#include "performance_utils.h"
+
+#include "hashmap.h"
+#include "rbtree.h"
+
+#define LOOKUP_TOTAL_COUNT 20000000
+#define LOOKUPS_PER_DECLARATION 8
+#define HOT_DECLARATION_COUNT 32
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+#define MAX_SPIRV_DECLARATION_PARAMETER_COUNT 7
+
+/* SpvOp values of the declarations the builder deduplicates the most. */
+enum test_spirv_op
+{
+    TEST_SPV_OP_TYPE_INT = 21,
+    TEST_SPV_OP_TYPE_FLOAT = 22,
+    TEST_SPV_OP_TYPE_VECTOR = 23,
+    TEST_SPV_OP_TYPE_POINTER = 32,
+    TEST_SPV_OP_CONSTANT = 43,
+    TEST_SPV_OP_CONSTANT_COMPOSITE = 44,
+};
+
+/* Same layout as struct vkd3d_spirv_declaration before and after the change. */
+struct test_rb_declaration
+{
+    struct rb_entry entry;
+
+    uint32_t op;
+    unsigned int parameter_count;
+    uint32_t parameters[MAX_SPIRV_DECLARATION_PARAMETER_COUNT];
+    uint32_t id;
+};
+
+struct test_declaration
+{
+    struct hash_map_entry entry;
+
+    uint32_t op;
+    unsigned int parameter_count;
+    uint32_t parameters[MAX_SPIRV_DECLARATION_PARAMETER_COUNT];
+    uint32_t id;
+};
+
+/* Same compare as the old vkd3d_spirv_declaration_compare. */
+static int test_rb_declaration_compare(const void *key, const struct rb_entry *e)
+{
+    const struct test_declaration *a = key;
+    const struct test_rb_declaration *b = RB_ENTRY_VALUE(e, const struct test_rb_declaration, entry);
+
+    if (a->op != b->op)
+        return a->op - b->op;
+    if (a->parameter_count != b->parameter_count)
+        return a->parameter_count - b->parameter_count;
+    return memcmp(&a->parameters, &b->parameters, a->parameter_count * sizeof(*a->parameters));
+}
+
+/* Same hash and compare as the current vkd3d_spirv_declaration_hash and _compare. */
+static uint32_t test_declaration_hash(const void *key)
+{
+    const struct test_declaration *d = key;
+    uint32_t hash;
+    unsigned int i;
+
+    hash = hash_combine(d->op, d->parameter_count);
+    for (i = 0; i < d->parameter_count; ++i)
+        hash = hash_combine(hash, d->parameters[i]);
+    return hash;
+}
+
+static bool test_declaration_compare(const void *key, const struct hash_map_entry *entry)
+{
+    const struct test_declaration *a = key;
+    const struct test_declaration *b = (const struct test_declaration *)entry;
+
+    return a->op == b->op && a->parameter_count == b->parameter_count &&
+            !memcmp(&a->parameters, &b->parameters, a->parameter_count * sizeof(*a->parameters));
+}
+
+/* A handful of types, a few pointer types per storage class, and mostly
+ * scalar and vec4 constants, like the declarations of a DXBC shader. */
+static void generate_declaration(struct test_declaration *d, uint32_t index)
+{
+    memset(d, 0, sizeof(*d));
+
+    if (index < 4)
+    {
+        d->op = index < 2 ? TEST_SPV_OP_TYPE_INT : TEST_SPV_OP_TYPE_FLOAT;
+        d->parameters[d->parameter_count++] = index == 3 ? 64 : 32;
+        if (d->op == TEST_SPV_OP_TYPE_INT)
+            d->parameters[d->parameter_count++] = index & 1;
+    }
+    else if (index < 16)
+    {
+        d->op = TEST_SPV_OP_TYPE_VECTOR;
+        d->parameters[d->parameter_count++] = 1 + (index & 3);
+        d->parameters[d->parameter_count++] = 2 + (index - 4) / 4;
+    }
+    else if (index < 64)
+    {
+        d->op = TEST_SPV_OP_TYPE_POINTER;
+        d->parameters[d->parameter_count++] = (index - 16) / 12;
+        d->parameters[d->parameter_count++] = 1 + (index - 16) % 12;
+    }
+    else if (index % 4)
+    {
+        d->op = TEST_SPV_OP_CONSTANT;
+        d->parameters[d->parameter_count++] = 1 + (index & 3);
+        d->parameters[d->parameter_count++] = 0x3f800000u + index;
+    }
+    else
+    {
+        d->op = TEST_SPV_OP_CONSTANT_COMPOSITE;
+        d->parameters[d->parameter_count++] = 16;
+        d->parameters[d->parameter_count++] = 100 + index;
+        d->parameters[d->parameter_count++] = 101 + index;
+        d->parameters[d->parameter_count++] = 102 + index;
+        d->parameters[d->parameter_count++] = 103 + index;
+    }
+}
+
+/* Half of the lookups go to a few hot types, the rest are spread over all
+ * declarations. Each declaration is looked up for the first time in order. */
+static void generate_lookups(struct test_declaration *lookups, size_t lookup_count, uint32_t declaration_count)
+{
+    uint32_t seed = 0x1234, next = 0, index;
+    size_t i;
+
+    for (i = 0; i < lookup_count; i++)
+    {
+        if (next < declaration_count && (i % LOOKUPS_PER_DECLARATION) == 0)
+            index = next++;
+        else if (test_random(&seed) & 1)
+            index = test_random(&seed) % min(next, HOT_DECLARATION_COUNT);
+        else
+            index = test_random(&seed) % next;
+
+        generate_declaration(&lookups[i], index);
+    }
+}
+
+/* Arena statistics are those of the last shader, since every shader compiles the same lookups.
+ * Nothing is freed before the arena is destroyed, so the reserved size is also the peak. */
+static uint32_t compile_rb(const struct test_declaration *lookups, size_t lookup_count,
+        size_t *arena_allocation_count, size_t *arena_reserved_size)
+{
+    struct test_rb_declaration *d;
+    uint32_t current_id = 1, sum = 0;
+    struct vkd3d_arena arena;
+    struct rb_entry *entry;
+    struct rb_tree tree;
+    size_t i;
+
+    vkd3d_arena_init(&arena, ARENA_BLOCK_SIZE);
+    rb_init(&tree, test_rb_declaration_compare);
+
+    for (i = 0; i < lookup_count; i++)
+    {
+        if ((entry = rb_get(&tree, &lookups[i])))
+        {
+            sum += RB_ENTRY_VALUE(entry, struct test_rb_declaration, entry)->id;
+            continue;
+        }
+
+        if (!(d = vkd3d_arena_alloc(&arena, sizeof(*d))))
+            break;
+        d->op = lookups[i].op;
+        d->parameter_count = lookups[i].parameter_count;
+        memcpy(d->parameters, lookups[i].parameters, sizeof(d->parameters));
+        d->id = current_id++;
+        rb_put(&tree, &lookups[i], &d->entry);
+        sum += d->id;
+    }
+
+    *arena_allocation_count = arena.allocation_count;
+    *arena_reserved_size = arena.reserved_size;
+    vkd3d_arena_destroy(&arena);
+    return sum;
+}
+
+static uint32_t compile_hash(const struct test_declaration *lookups, size_t lookup_count)
+{
+    uint32_t current_id = 1, sum = 0;
+    const struct test_declaration *d;
+    struct test_declaration declaration;
+    struct hash_map map;
+    size_t i;
+
+    hash_map_init(&map, test_declaration_hash, test_declaration_compare, sizeof(struct test_declaration));
+
+    for (i = 0; i < lookup_count; i++)
+    {
+        if ((d = (const struct test_declaration *)hash_map_find(&map, &lookups[i])))
+        {
+            sum += d->id;
+            continue;
+        }
+
+        declaration = lookups[i];
+        declaration.id = current_id++;
+        if (!hash_map_insert(&map, &declaration, &declaration.entry))
+            break;
+        sum += declaration.id;
+    }
+
+    hash_map_clear(&map);
+    return sum;
+}
+
+static bool run_benchmark(uint32_t declaration_count)
+{
+    size_t lookup_count = (size_t)declaration_count * LOOKUPS_PER_DECLARATION;
+    size_t arena_allocation_count = 0, arena_reserved_size = 0;
+    struct test_declaration *lookups;
+    unsigned int iterations, i;
+    uint32_t rb_sum, hash_sum;
+    double t0, t1, t2;
+    bool success;
+
+    if (!(lookups = vkd3d_malloc(lookup_count * sizeof(*lookups))))
+    {
+        fprintf(stderr, "Failed to allocate %zu lookups.\n", lookup_count);
+        return false;
+    }
+
+    generate_lookups(lookups, lookup_count, declaration_count);
+    iterations = LOOKUP_TOTAL_COUNT / lookup_count;
+    rb_sum = 0;
+    hash_sum = 0;
+
+    t0 = get_time();
+    for (i = 0; i < iterations; i++)
+        rb_sum += compile_rb(lookups, lookup_count, &arena_allocation_count, &arena_reserved_size);
+    t1 = get_time();
+    for (i = 0; i < iterations; i++)
+        hash_sum += compile_hash(lookups, lookup_count);
+    t2 = get_time();
+
+    if (!(success = rb_sum == hash_sum))
+        fprintf(stderr, "  hash_map: declaration ids differ for %u declarations.\n", declaration_count);
+
+    printf("%u declarations, %zu lookups per shader, %u shaders:\n", declaration_count, lookup_count, iterations);
+    printf("  %-24s %10.2f ns/lookup, %10.3f us/shader\n", "rb_tree + arena",
+            1e9 * (t1 - t0) / ((double)iterations * lookup_count), 1e6 * (t1 - t0) / iterations);
+    printf("  %-24s %10zu allocations, %10zu bytes peak per shader\n", "arena",
+            arena_allocation_count, arena_reserved_size);
+    printf("  %-24s %10.2f ns/lookup, %10.3f us/shader\n", "hash_map",
+            1e9 * (t2 - t1) / ((double)iterations * lookup_count), 1e6 * (t2 - t1) / iterations);
+
+    vkd3d_free(lookups);
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t declaration_counts[] = {100, 1000, 10000};
+    bool success = true;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(declaration_counts); i++)
+        success &= run_benchmark(declaration_counts[i]);
+
+    return success ? 0 : 1;
+}